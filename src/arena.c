@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+
+// Everything is aligned for the largest type we put in there. (doubles and pointers)
+#define ALIGNMENT 8
+#define ALIGN(size) (((size) + ALIGNMENT - 1) & ~(size_t)(ALIGNMENT - 1))
+
+static void* allocate(size_t size) {
+  void* result = malloc(size);
+  if(result == NULL) {
+    fprintf(stderr, "Out of memory.\n");
+    exit(1);
+  }
+  return result;
+}
+
+pd_arena* pd_arena_new(void) {
+  pd_arena* arena = allocate(sizeof(pd_arena));
+  arena->head = NULL;
+  arena->refs = 1;
+  return arena;
+}
+
+void pd_arena_retain(pd_arena* arena) {
+  arena->refs++;
+}
+
+void pd_arena_release(pd_arena* arena) {
+  if(--arena->refs > 0) return;
+  pd_arena_block* block = arena->head;
+  while(block != NULL) {
+    pd_arena_block* next = block->next;
+    free(block);
+    block = next;
+  }
+  free(arena);
+}
+
+static pd_arena_block* newBlock(pd_arena* arena, size_t size) {
+  pd_arena_block* block = allocate(sizeof(pd_arena_block) + size);
+  block->size = size;
+  block->used = 0;
+  // Oversized blocks go behind the head so the space left in it isn't wasted.
+  if(arena->head != NULL && size > PD_ARENA_BLOCK_SIZE) {
+    block->next = arena->head->next;
+    arena->head->next = block;
+  } else {
+    block->next = arena->head;
+    arena->head = block;
+  }
+  return block;
+}
+
+void* pd_arena_alloc(pd_arena* arena, size_t size) {
+  size = ALIGN(size);
+  pd_arena_block* block = arena->head;
+  if(block == NULL || block->size - block->used < size) {
+    size_t blockSize = PD_ARENA_FIRST_BLOCK_SIZE;
+    if(block != NULL) blockSize = block->size * 2 < PD_ARENA_BLOCK_SIZE ? block->size * 2 : PD_ARENA_BLOCK_SIZE;
+    block = newBlock(arena, size > blockSize ? size : blockSize);
+  }
+  void* result = block->data + block->used;
+  block->used += size;
+  return result;
+}
+
+char* pd_arena_strndup(pd_arena* arena, const char* chars, size_t len) {
+  char* copy = pd_arena_alloc(arena, len + 1);
+  memcpy(copy, chars, len);
+  copy[len] = 0;
+  return copy;
+}
+
+void* pd_arena_append(pd_arena* arena, void* array, int count, size_t size) {
+  // Capacities go 4, 8, 16... so it's full when the count is one of them.
+  if(count != 0 && (count < 4 || (count & (count - 1)) != 0)) return array;
+  size_t capacity = count < 4 ? 4 : (size_t)count * 2;
+  void* grown = pd_arena_alloc(arena, capacity * size);
+  if(count > 0) memcpy(grown, array, count * size);
+  return grown;
+}
@@ -0,0 +1,43 @@
+#ifndef _PERIDOT_ARENA_H
+#define _PERIDOT_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// A bump allocator for things that all die at the same time, used for the AST and the token text of a parse.
+// Allocating is just moving a pointer forward, nothing is freed on its own, the whole arena is freed in one go.
+// Functions compiled lazily keep pointing into the tree of the parse so arenas are reference counted,
+// the parse holds one reference and every function that wasn't compiled yet holds another. (see pd_compile_lazy())
+
+// Blocks start small and double up to the max size so parsing a single line in the REPL stays cheap.
+// Allocations bigger than the max size get a block of their own.
+#define PD_ARENA_FIRST_BLOCK_SIZE 1024
+#define PD_ARENA_BLOCK_SIZE (32 * 1024)
+
+typedef struct pd_arena_block {
+  struct pd_arena_block* next;
+  size_t size;
+  size_t used;
+  uint8_t data[];
+} pd_arena_block;
+
+typedef struct pd_arena {
+  pd_arena_block* head; // The block being allocated from, previous blocks follow it.
+  int refs;
+} pd_arena;
+
+// Creates an arena with a single reference.
+pd_arena* pd_arena_new(void);
+void pd_arena_retain(pd_arena* arena);
+// Drops a reference, the arena and everything allocated in it is freed with the last one.
+void pd_arena_release(pd_arena* arena);
+// Allocates [size] bytes aligned for any type, never returns NULL. (it exits if we run out of memory)
+void* pd_arena_alloc(pd_arena* arena, size_t size);
+// Copies [len] bytes of [chars] with a null terminator.
+char* pd_arena_strndup(pd_arena* arena, const char* chars, size_t len);
+// Makes room for one more element in an array of [count] elements of [size] bytes that lives in the arena.
+// The capacity is not stored anywhere, arrays grow by doubling so it's implied by the count.
+// Returns the array which may have moved, the old one is just left behind until the arena is freed.
+void* pd_arena_append(pd_arena* arena, void* array, int count, size_t size);
+
+#endif // _PERIDOT_ARENA_H
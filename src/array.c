@@ -0,0 +1,22 @@
+#include <string.h>
+#include "array.h"
+#include "gc.h"
+
+pd_array* pd_array_new(pvm_t* vm, pd_value* values, int count) {
+  // Allocate the storage in one go before the array so a GC triggered by either allocation never sees a half built array.
+  // This also means we don't push anything, [values] is usually the top of the VM stack which could move if we did.
+  pd_value* data = count == 0 ? NULL : PD_GROW_ARRAY(vm, NULL, pd_value, 0, count);
+  pd_array* array = ALLOC_OBJECT(vm, pd_array, PD_OBJ_ARRAY);
+  pd_value_array_init(&array->values);
+  if(count == 0) return array;
+
+  memcpy(data, values, sizeof(pd_value) * count);
+  array->values.data = data;
+  array->values.capacity = count;
+  array->values.count = count;
+  return array;
+}
+
+void pd_array_push(pvm_t* vm, pd_array* array, pd_value value) {
+  pd_value_array_write(vm, &array->values, value);
+}
@@ -0,0 +1,25 @@
+#ifndef _PERIDOT_ARRAY_H
+#define _PERIDOT_ARRAY_H
+
+#include "object.h"
+#include "value.h"
+
+// Array type, a growable list of values.
+// The elements live in a pd_value_array, the same dynamic array chunks use for their constants.
+typedef struct {
+  pd_object obj;
+  pd_value_array values;
+} pd_array;
+
+// Creates an array holding a copy of the first [count] values in [values]
+// The values are usually sitting on the VM stack (e.g for array literals) so they stay reachable by the GC.
+pd_array* pd_array_new(pvm_t* vm, pd_value* values, int count);
+
+// Appends a value at the end of the array.
+// This may grow the storage and trigger the GC, so the array and the value must be reachable.
+void pd_array_push(pvm_t* vm, pd_array* array, pd_value value);
+
+#define PD_IS_ARRAY(val) (OBJECT_TYPE(AS_OBJECT(val)) == PD_OBJ_ARRAY)
+#define PD_AS_ARRAY(val) ((pd_array*)AS_OBJECT(val))
+
+#endif // _PERIDOT_ARRAY_H
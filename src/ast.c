@@ -12,103 +12,95 @@ bool pd_ast_is_expr(pd_ast_node* node) {
   // NOTE: update this everytime you add a new expression in ast types.
   return t == PD_AST_UNARY || t == PD_AST_CALL || t == PD_AST_BOOLEAN || t == PD_AST_STRING ||
     t == PD_AST_NUMBER || t == PD_AST_ASSIGN || t == PD_AST_BIN_OP || t == PD_AST_FILE || t == PD_AST_NULL ||
-    t == PD_AST_VARIABLE || t == PD_AST_TERNARY;
+    t == PD_AST_VARIABLE || t == PD_AST_TERNARY || t == PD_AST_ARRAY || t == PD_AST_INDEX ||
+    t == PD_AST_DICT || t == PD_AST_DELETE || t == PD_AST_PROPERTY || t == PD_AST_IMPORT;
 }
 
-pd_ast_node* pd_ast_empty_create(void) {
-  pd_ast_node* node = malloc(sizeof(pd_ast_node));
-  node->type = PD_AST_EMPTY;
-  node->line = 0;
+static pd_ast_node* newNode(pd_arena* arena, pd_ast_type type, int line) {
+  pd_ast_node* node = pd_arena_alloc(arena, sizeof(pd_ast_node));
+  node->type = type;
+  node->line = line;
   return node;
 }
 
-pd_ast_node* pd_ast_while_create(int line, pd_ast_node* condition, pd_ast_node* body) {
-  pd_ast_node* node = malloc(sizeof(pd_ast_node));
-  node->type = PD_AST_WHILE;
-  node->line = line;
+pd_ast_node* pd_ast_empty_create(pd_arena* arena) {
+  return newNode(arena, PD_AST_EMPTY, 0);
+}
+
+pd_ast_node* pd_ast_while_create(pd_arena* arena, int line, pd_ast_node* condition, pd_ast_node* body) {
+  pd_ast_node* node = newNode(arena, PD_AST_WHILE, line);
   node->while_loop.condition = condition;
   node->while_loop.body = body;
   return node;
 }
 
-pd_ast_node* pd_ast_string_create(int line, char* value) {
-  pd_ast_node* node = malloc(sizeof(pd_ast_node));
-  node->type = PD_AST_STRING;
-  node->line = line;
-  node->string.value = strdup(value);
+pd_ast_node* pd_ast_for_create(pd_arena* arena, int line, pd_ast_text name, pd_ast_node* start, pd_ast_node* limit, pd_ast_node* step, pd_ast_node* body) {
+  pd_ast_node* node = newNode(arena, PD_AST_FOR, line);
+  node->for_loop.name = name.chars;
+  node->for_loop.len = name.len;
+  node->for_loop.start = start;
+  node->for_loop.limit = limit;
+  node->for_loop.step = step;
+  node->for_loop.body = body;
   return node;
 }
 
-pd_ast_node* pd_ast_number_create(int line, double value) {
-  pd_ast_node* node = malloc(sizeof(pd_ast_node));
-  node->type = PD_AST_NUMBER;
-  node->line = line;
+pd_ast_node* pd_ast_string_create(pd_arena* arena, int line, pd_ast_text value) {
+  pd_ast_node* node = newNode(arena, PD_AST_STRING, line);
+  node->string.value = value.chars;
+  node->string.len = value.len;
+  return node;
+}
+
+pd_ast_node* pd_ast_number_create(pd_arena* arena, int line, double value) {
+  pd_ast_node* node = newNode(arena, PD_AST_NUMBER, line);
   node->number.value = value;
   return node;
 }
 
-pd_ast_node* pd_ast_assign_create(int line, char* name, pd_ast_node* expr) {
-  pd_ast_node* node = malloc(sizeof(pd_ast_node));
-  node->type = PD_AST_ASSIGN;
-  node->line = line;
-  node->assign.name = strdup(name);
+pd_ast_node* pd_ast_assign_create(pd_arena* arena, int line, pd_ast_text name, pd_ast_node* expr) {
+  pd_ast_node* node = newNode(arena, PD_AST_ASSIGN, line);
+  node->assign.name = name.chars;
+  node->assign.len = name.len;
   node->assign.expr = expr;
   return node;
 }
 
-pd_ast_node* pd_ast_unary_op_create(int line, pd_unary_op_type type, pd_ast_node* rhs) {
-  pd_ast_node* node = malloc(sizeof(pd_ast_node));
-  node->type = PD_AST_UNARY;
-  node->line = line;
+pd_ast_node* pd_ast_unary_op_create(pd_arena* arena, int line, pd_unary_op_type type, pd_ast_node* rhs) {
+  pd_ast_node* node = newNode(arena, PD_AST_UNARY, line);
   node->unary.type = type;
   node->unary.rhs = rhs;
   return node;
 }
 
-pd_ast_node* pd_ast_block_create(pd_ast_node* statement) {
-  pd_ast_node* node = malloc(sizeof(pd_ast_node));
-  node->type = PD_AST_BLOCK;
-  node->line = 0;
-  node->block.statements = malloc(sizeof(pd_ast_node*));
+pd_ast_node* pd_ast_block_create(pd_arena* arena, pd_ast_node* statement) {
+  pd_ast_node* node = newNode(arena, PD_AST_BLOCK, 0);
+  node->block.statements = NULL;
+  node->block.count = 0;
   // Empty Block.
-  if(statement == NULL) {
-    node->block.count = 0;
-    return node;
-  }
-  node->block.statements[0] = statement;
-  node->block.count = 1;
-  return node;
+  if(statement == NULL) return node;
+  return pd_ast_block_append(arena, node, statement);
 }
 
 // __FILE__ ident resolves to the current executing file.
-pd_ast_node* pd_ast_file_create(int line) {
-  pd_ast_node* node = malloc(sizeof(pd_ast_node));
-  node->type = PD_AST_FILE;
-  node->line = line;
-  return node;
+pd_ast_node* pd_ast_file_create(pd_arena* arena, int line) {
+  return newNode(arena, PD_AST_FILE, line);
 }
 
-pd_ast_node* pd_ast_null_create(int line) {
-  pd_ast_node* node = malloc(sizeof(pd_ast_node));
-  node->type = PD_AST_NULL;
-  node->line = line;
-  return node;
+pd_ast_node* pd_ast_null_create(pd_arena* arena, int line) {
+  return newNode(arena, PD_AST_NULL, line);
 }
 
-pd_ast_node* pd_ast_conditional_create(int line, pd_ast_node* condition, pd_ast_node* trueNode, pd_ast_node* falseNode) {
-  pd_ast_node* node = malloc(sizeof(pd_ast_node));
-  node->type = PD_AST_CONDITIONAL;
-  node->line = line;
+pd_ast_node* pd_ast_conditional_create(pd_arena* arena, int line, pd_ast_node* condition, pd_ast_node* trueNode, pd_ast_node* falseNode) {
+  pd_ast_node* node = newNode(arena, PD_AST_CONDITIONAL, line);
   node->conditional.condition = condition;
   node->conditional.trueNode = trueNode;
   node->conditional.falseNode = falseNode;
   return node;
 }
 
-pd_ast_node* pd_ast_ternary_create(int line, pd_ast_node* cond, pd_ast_node* trueNode, pd_ast_node* falseNode) {
-  pd_ast_node* node = malloc(sizeof(pd_ast_node));
-  node->type = PD_AST_TERNARY;
-  node->line = line;
+pd_ast_node* pd_ast_ternary_create(pd_arena* arena, int line, pd_ast_node* cond, pd_ast_node* trueNode, pd_ast_node* falseNode) {
+  pd_ast_node* node = newNode(arena, PD_AST_TERNARY, line);
   // Ternary has the same concept of if-statements except that the nodes are expressions instead of blocks
   // but we can still reuse the same node for ternaries. (node->conditional instead of a new node->ternary)
   node->conditional.condition = cond;
@@ -117,161 +109,111 @@ pd_ast_node* pd_ast_ternary_create(int line, pd_ast_node* cond, pd_ast_node* tru
   return node;
 }
 
-pd_ast_node* pd_ast_boolean_create(int line, bool value) {
-  pd_ast_node* node = malloc(sizeof(pd_ast_node));
-  node->type = PD_AST_BOOLEAN;
-  node->line = line;
+pd_ast_node* pd_ast_boolean_create(pd_arena* arena, int line, bool value) {
+  pd_ast_node* node = newNode(arena, PD_AST_BOOLEAN, line);
   node->boolean.value = value;
   return node;
 }
 
-pd_ast_node* pd_ast_binary_op_create(int line, pd_binary_op_type op, pd_ast_node* lhs, pd_ast_node* rhs) {
-  pd_ast_node* node = malloc(sizeof(pd_ast_node));
-  node->type = PD_AST_BIN_OP;
-  node->line = line;
+pd_ast_node* pd_ast_binary_op_create(pd_arena* arena, int line, pd_binary_op_type op, pd_ast_node* lhs, pd_ast_node* rhs) {
+  pd_ast_node* node = newNode(arena, PD_AST_BIN_OP, line);
   node->binop.op = op;
   node->binop.lhs = lhs;
   node->binop.rhs = rhs;
   return node;
 }
 
-pd_ast_node* pd_ast_call_create(int line, char* name, pd_ast_node** args, int argc) {
-  pd_ast_node* node = malloc(sizeof(pd_ast_node));
-  node->type = PD_AST_CALL;
-  node->line = line;
-  node->call.name = strdup(name);
-  node->call.args = malloc(sizeof(pd_ast_node*) * argc);
-  memcpy(node->call.args, args, sizeof(pd_ast_node*) * argc);
+pd_ast_node* pd_ast_call_create(pd_arena* arena, int line, pd_ast_text name, pd_ast_node** args, int argc) {
+  pd_ast_node* node = newNode(arena, PD_AST_CALL, line);
+  node->call.name = name.chars;
+  node->call.len = name.len;
+  node->call.args = args;
   node->call.argc = argc;
+  node->call.inlined = NULL;
+  node->call.callee = NULL;
   return node;
 }
 
-pd_ast_node* pd_ast_prototype_create(int line, char* name, char** args, int argc) {
-  pd_ast_node* node = malloc(sizeof(pd_ast_node));
-  node->type = PD_AST_PROTOTYPE;
-  node->line = line;
-  node->prototype.name = strdup(name);
-  node->prototype.args = malloc(sizeof(char*) * argc);
-  for(int x = 0; x < argc; x++)
-    node->prototype.args[x] = strdup(args[x]);
+pd_ast_node* pd_ast_prototype_create(pd_arena* arena, int line, pd_ast_text name, pd_ast_text* args, int argc) {
+  pd_ast_node* node = newNode(arena, PD_AST_PROTOTYPE, line);
+  node->prototype.name = name.chars;
+  node->prototype.len = name.len;
+  node->prototype.args = args;
   node->prototype.argc = argc;
   return node;
 }
 
-pd_ast_node* pd_ast_block_append(pd_ast_node* block, pd_ast_node* node) {
-  block->block.count++;
-  block->block.statements = realloc(block->block.statements, sizeof(pd_ast_node*) * block->block.count);
-  block->block.statements[block->block.count - 1] = node;
+pd_ast_node* pd_ast_block_append(pd_arena* arena, pd_ast_node* block, pd_ast_node* node) {
+  block->block.statements = pd_arena_append(arena, block->block.statements, block->block.count, sizeof(pd_ast_node*));
+  block->block.statements[block->block.count++] = node;
   return block;
 }
 
-pd_ast_node* pd_ast_function_create(int line, pd_ast_node* prototype, pd_ast_node* body) {
-  pd_ast_node* node = malloc(sizeof(pd_ast_node));
-  node->type = PD_AST_FUNCTION;
-  node->line = line;
+pd_ast_node* pd_ast_function_create(pd_arena* arena, int line, pd_ast_node* prototype, pd_ast_node* body) {
+  pd_ast_node* node = newNode(arena, PD_AST_FUNCTION, line);
   node->function.prototype = prototype;
   node->function.body = body;
+  node->function.inline_hash = 0;
+  node->function.async = false;
   return node;
 }
 
-pd_ast_node* pd_ast_variable_create(int line, char* name) {
-  pd_ast_node* node = malloc(sizeof(pd_ast_node));
-  node->type = PD_AST_VARIABLE;
-  node->line = line;
-  node->variable.name = strdup(name);
+pd_ast_node* pd_ast_variable_create(pd_arena* arena, int line, pd_ast_text name) {
+  pd_ast_node* node = newNode(arena, PD_AST_VARIABLE, line);
+  node->variable.name = name.chars;
+  node->variable.len = name.len;
   return node;
 }
 
-pd_ast_node* pd_ast_return_create(int line, pd_ast_node* expr) {
-  pd_ast_node* node = malloc(sizeof(pd_ast_node));
-  node->type = PD_AST_RETURN;
-  node->line = line;
+pd_ast_node* pd_ast_return_create(pd_arena* arena, int line, pd_ast_node* expr) {
+  pd_ast_node* node = newNode(arena, PD_AST_RETURN, line);
   node->ret.expr = expr;
   return node;
 }
 
-pd_ast_node* pd_ast_class_create(int line, char* name) {
-  pd_ast_node* node = malloc(sizeof(pd_ast_node));
-  node->type = PD_AST_CLASS;
-  node->line = line;
-  node->klass.name = strdup(name);
+pd_ast_node* pd_ast_class_create(pd_arena* arena, int line, pd_ast_text name) {
+  pd_ast_node* node = newNode(arena, PD_AST_CLASS, line);
+  node->klass.name = name.chars;
+  node->klass.len = name.len;
   return node;
 }
 
-void pd_ast_node_free(pd_ast_node* node) {
-#define FREE(pointer) if(pointer != NULL) free(pointer)
-  if(node == NULL) return;
-  switch(node->type) {
-    case PD_AST_CLASS:
-      FREE(node->klass.name);
-      break;
-    case PD_AST_PROPERTY:
-      pd_ast_node_free(node->property.expr);
-      // TODO: node->ident (after turning it to string.)
-      break;
-    case PD_AST_EMPTY:
-      break;
-    case PD_AST_FILE:
-    case PD_AST_NUMBER:
-    case PD_AST_BOOLEAN:
-    case PD_AST_NULL:
-      break; // doesn't need to be freed.
-    case PD_AST_VARIABLE:
-      FREE(node->variable.name);
-      break;
-    case PD_AST_WHILE:
-      pd_ast_node_free(node->while_loop.condition);
-      pd_ast_node_free(node->while_loop.body);
-      break;
-    case PD_AST_UNARY:
-      pd_ast_node_free(node->unary.rhs);
-      break;
-    case PD_AST_CONDITIONAL:
-    case PD_AST_TERNARY:
-      pd_ast_node_free(node->conditional.trueNode);
-      pd_ast_node_free(node->conditional.falseNode);
-      pd_ast_node_free(node->conditional.condition);
-      break;
-    case PD_AST_STRING:
-      FREE(node->string.value);
-      break;
-    case PD_AST_BIN_OP:
-      pd_ast_node_free(node->binop.lhs);
-      pd_ast_node_free(node->binop.rhs);
-      break;
-    case PD_AST_CALL:
-      FREE(node->call.name);
-      for(int x = 0; x < node->call.argc; x++)
-        pd_ast_node_free(node->call.args[x]);
-      FREE(node->call.args);
-      break;
-    case PD_AST_FUNCTION:
-      pd_ast_node_free(node->function.body);
-      pd_ast_node_free(node->function.prototype);
-      break;
-    case PD_AST_PROTOTYPE:
-      FREE(node->prototype.name);
-      for(int x = 0; x < node->prototype.argc; x++)
-        FREE(node->prototype.args[x]);
-      FREE(node->prototype.args);
-      break;
-    case PD_AST_BLOCK:
-      for(int x = 0; x < node->block.count; x++)
-        pd_ast_node_free(node->block.statements[x]);
-      //FREE(node->block.statements);
-      break;
-    case PD_AST_ASSIGN:
-      FREE(node->assign.name);
-      pd_ast_node_free(node->assign.expr);
-      break;
-    case PD_AST_RETURN:
-      pd_ast_node_free(node->ret.expr);
-      break;
-  }
-#undef FREE
-  free(node);
+pd_ast_node* pd_ast_array_create(pd_arena* arena, int line, pd_ast_node** elements, int count) {
+  pd_ast_node* node = newNode(arena, PD_AST_ARRAY, line);
+  node->array.elements = elements;
+  node->array.count = count;
+  return node;
+}
+
+pd_ast_node* pd_ast_index_create(pd_arena* arena, int line, pd_ast_node* expr, pd_ast_node* index, pd_ast_node* value) {
+  pd_ast_node* node = newNode(arena, PD_AST_INDEX, line);
+  node->index.expr = expr;
+  node->index.index = index;
+  node->index.value = value;
+  return node;
 }
 
+pd_ast_node* pd_ast_property_create(pd_arena* arena, int line, pd_ast_node* expr, pd_ast_text name) {
+  pd_ast_node* node = newNode(arena, PD_AST_PROPERTY, line);
+  node->property.expr = expr;
+  node->property.ident = pd_ast_variable_create(arena, line, name);
+  return node;
+}
+
+pd_ast_node* pd_ast_import_create(pd_arena* arena, int line, pd_ast_text name) {
+  pd_ast_node* node = newNode(arena, PD_AST_IMPORT, line);
+  node->import.name = name.chars;
+  node->import.len = name.len;
+  return node;
+}
+
+pd_ast_node* pd_ast_dict_create(pd_arena* arena, int line, pd_ast_node** keys, pd_ast_node** values, int count) {
+  pd_ast_node* node = newNode(arena, PD_AST_DICT, line);
+  node->dict.keys = keys;
+  node->dict.values = values;
+  node->dict.count = count;
+  return node;
+}
 
 static void printIndents(int count) {
   for(int x = 0; x < count; x++) printf(" ");
@@ -282,12 +224,22 @@ static void printIndents(int count) {
 static void _pd_ast_node_dump(pd_ast_node node, int indent) {
   switch(node.type) {
     case PD_AST_PROPERTY:
-      break; // TODO
+      printIndents(indent);
+      printf("<property name=\"%s\">\n", node.property.ident->variable.name);
+      _pd_ast_node_dump(*node.property.expr, indent + 2);
+      printIndents(indent);
+      printf("</property>\n");
+      break;
+    case PD_AST_IMPORT:
+      printIndents(indent);
+      printf("<import name=\"%s\"/>\n", node.import.name);
+      break;
     case PD_AST_CLASS:
       break; // TODO
     case PD_AST_EMPTY:
       break;
     case PD_AST_WHILE:
+    case PD_AST_FOR:
       break; // TODO: implement this.
     case PD_AST_RETURN:
       printIndents(indent);
@@ -300,6 +252,7 @@ static void _pd_ast_node_dump(pd_ast_node node, int indent) {
       }
       printIndents(indent);
       printf("</return>\n");
+      break;
     case PD_AST_BLOCK:
       for(int x = 0; x < node.block.count; x++)
         _pd_ast_node_dump(*node.block.statements[x], indent);
@@ -337,6 +290,9 @@ static void _pd_ast_node_dump(pd_ast_node node, int indent) {
         case PD_UNARY_BNOT:
           printf("  <bnot/>\n");
           break;
+        case PD_UNARY_AWAIT:
+          printf("  <await/>\n");
+          break;
       }
       printIndents(indent);
       printf("  <rhs>\n");
@@ -460,6 +416,7 @@ static void _pd_ast_node_dump(pd_ast_node node, int indent) {
       printf("<call>\n");
       printIndents(indent);
       printf("  <name value=\"%s\">\n", node.call.name);
+      if(node.call.callee != NULL) _pd_ast_node_dump(*node.call.callee, indent + 2);
       printIndents(indent);
       printf("  <args>\n");
       for(int x = 0; x < node.call.argc; x++) {
@@ -473,7 +430,7 @@ static void _pd_ast_node_dump(pd_ast_node node, int indent) {
       break;
     case PD_AST_FUNCTION:
       printIndents(indent);
-      printf("<function>\n");
+      printf(node.function.async ? "<function async=\"true\">\n" : "<function>\n");
       _pd_ast_node_dump(*node.function.prototype, indent + 2);
       printIndents(indent);
       printf("  <body>\n");
@@ -484,12 +441,65 @@ static void _pd_ast_node_dump(pd_ast_node node, int indent) {
       printIndents(indent);
       printf("</function>\n");
       break;
+    case PD_AST_ARRAY:
+      printIndents(indent);
+      printf("<array>\n");
+      for(int x = 0; x < node.array.count; x++)
+        _pd_ast_node_dump(*node.array.elements[x], indent + 2);
+      printIndents(indent);
+      printf("</array>\n");
+      break;
+    case PD_AST_DICT:
+      printIndents(indent);
+      printf("<dict>\n");
+      for(int x = 0; x < node.dict.count; x++) {
+        printIndents(indent);
+        printf("  <key>\n");
+        _pd_ast_node_dump(*node.dict.keys[x], indent + 4);
+        printIndents(indent);
+        printf("  </key>\n");
+        printIndents(indent);
+        printf("  <value>\n");
+        _pd_ast_node_dump(*node.dict.values[x], indent + 4);
+        printIndents(indent);
+        printf("  </value>\n");
+      }
+      printIndents(indent);
+      printf("</dict>\n");
+      break;
+    case PD_AST_DELETE:
+      printIndents(indent);
+      printf("<delete>\n");
+      _pd_ast_node_dump(*node.index.expr, indent + 2);
+      _pd_ast_node_dump(*node.index.index, indent + 2);
+      printIndents(indent);
+      printf("</delete>\n");
+      break;
+    case PD_AST_INDEX:
+      printIndents(indent);
+      printf("<index>\n");
+      _pd_ast_node_dump(*node.index.expr, indent + 2);
+      printIndents(indent);
+      printf("  <at>\n");
+      _pd_ast_node_dump(*node.index.index, indent + 4);
+      printIndents(indent);
+      printf("  </at>\n");
+      if(node.index.value != NULL) {
+        printIndents(indent);
+        printf("  <value>\n");
+        _pd_ast_node_dump(*node.index.value, indent + 4);
+        printIndents(indent);
+        printf("  </value>\n");
+      }
+      printIndents(indent);
+      printf("</index>\n");
+      break;
     case PD_AST_PROTOTYPE:
       printIndents(indent);
       printf("<prototype argc=\"%d\" name=\"%s\">\n", node.prototype.argc, node.prototype.name);
       for(int x = 0; x < node.prototype.argc; x++) {
         printIndents(indent);
-        printf("  <arg>%s</arg>\n", node.prototype.args[x]);
+        printf("  <arg>%s</arg>\n", node.prototype.args[x].chars);
       }
       printIndents(indent);
       printf("</prototype>\n");
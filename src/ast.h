@@ -4,9 +4,18 @@
 extern "C" {
 #endif // __cplusplus
 #include <stdbool.h>
+#include <stdint.h>
+#include "arena.h"
 
 typedef struct pd_ast_node pd_ast_node;
 
+// An identifier or the contents of a string literal, the text is null terminated and lives in the arena of the parse.
+// The length is kept along so the compiler doesn't have to strlen() every name it looks up.
+typedef struct {
+  char* chars;
+  int len;
+} pd_ast_text;
+
 typedef enum {
   PD_AST_NUMBER, // numbers
   PD_AST_STRING, // "strings"
@@ -27,7 +36,13 @@ typedef enum {
   PD_AST_WHILE, // while cond; body; end
   PD_AST_EMPTY, // Used when the input is empty, nothing to parse at all.
   PD_AST_PROPERTY, // object.property getter
-  PD_AST_CLASS
+  PD_AST_CLASS,
+  PD_AST_ARRAY, // [1, 2, 3]
+  PD_AST_INDEX, // array[index] or array[index] = value
+  PD_AST_DICT, // { key: value }
+  PD_AST_DELETE, // delete dict[key]
+  PD_AST_FOR, // for i in start..limit; body; end
+  PD_AST_IMPORT // import name, only ever the value of an assign to the same name.
 } pd_ast_type;
 
 // Represents a number.
@@ -41,6 +56,17 @@ typedef struct {
   pd_ast_node* body;
 } pd_ast_while;
 
+// Represents a numeric for loop like for i in 1..10
+// step is NULL when not given in which case it's 1.
+typedef struct {
+  char* name;
+  int len;
+  pd_ast_node* start;
+  pd_ast_node* limit;
+  pd_ast_node* step;
+  pd_ast_node* body;
+} pd_ast_for;
+
 // Represents a block of statements.
 typedef struct {
   pd_ast_node** statements;
@@ -50,6 +76,7 @@ typedef struct {
 // Represents a string.
 typedef struct {
   char* value;
+  int len;
 } pd_ast_string;
 
 // Represents a conditional, the trueNode is the body of the truthy-case and likewise falseNode is for the falsy-case
@@ -70,8 +97,13 @@ typedef struct {
 // argc is the length of arguments.
 typedef struct {
   char* name;
+  int len;
   pd_ast_node** args;
   int argc;
+  pd_ast_node* inlined; // Function the call can be inlined to or NULL, see pd_optimize_inline()
+  // What gives the function to call when it's not a plain name, the property in x.name(args). NULL otherwise.
+  // name is still set to the last name for errors and dumps.
+  pd_ast_node* callee;
 } pd_ast_call;
 
 // Represents the type of the binary expression.
@@ -100,6 +132,7 @@ typedef enum {
   PD_UNARY_MINUS, // -5
   PD_UNARY_NOT, // !condition
   PD_UNARY_BNOT, // Bitewise ~
+  PD_UNARY_AWAIT, // await task
 } pd_unary_op_type;
 
 // Represents a unary expression like -5
@@ -119,7 +152,8 @@ typedef struct {
 // Represents the function's prototype, which is the name and arguments without the body.
 typedef struct {
   char* name;
-  char** args;
+  int len;
+  pd_ast_text* args;
   int argc;
 } pd_ast_prototype;
 
@@ -127,17 +161,21 @@ typedef struct {
 typedef struct {
   pd_ast_node* prototype;
   pd_ast_node* body;
+  uint64_t inline_hash; // Set for functions calls can be inlined to, 0 otherwise. (see pd_function.inline_hash)
+  bool async; // async function, calling it starts a task.
 } pd_ast_function;
 
 // Represents a variable access.
 typedef struct {
   char* name;
+  int len;
 } pd_ast_variable;
 
 // Represents an assignment like x = 5
 // Variables in Peridot are implicitly declared.
 typedef struct {
   char* name;
+  int len;
   pd_ast_node* expr;
 } pd_ast_assign;
 
@@ -157,10 +195,40 @@ typedef struct {
   pd_ast_node* ident;
 } pd_ast_property;
 
+// Represents an import of a builtin module, import net
+typedef struct {
+  char* name;
+  int len;
+} pd_ast_import;
+
 typedef struct {
   char* name;
+  int len;
 } pd_ast_class;
 
+// Represents an array literal like [1, 2, 3]
+typedef struct {
+  pd_ast_node** elements;
+  int count;
+} pd_ast_array;
+
+// Represents a dictionary literal like { "a": 1, "b": 2 }
+// keys and values are parallel arrays of count expressions.
+typedef struct {
+  pd_ast_node** keys;
+  pd_ast_node** values;
+  int count;
+} pd_ast_dict;
+
+// Represents indexing like array[index]
+// If value is not NULL then it's an assignment like array[index] = value
+// This node is also used for delete dict[key] except that the node's type is PD_AST_DELETE.
+typedef struct {
+  pd_ast_node* expr;
+  pd_ast_node* index;
+  pd_ast_node* value;
+} pd_ast_index;
+
 // Represents a node in the abstract syntax tree. (AST)
 typedef struct pd_ast_node {
   pd_ast_type type; // Type of this node
@@ -180,41 +248,51 @@ typedef struct pd_ast_node {
     pd_ast_return ret;
     pd_ast_unary_op unary;
     pd_ast_while while_loop;
+    pd_ast_for for_loop;
     pd_ast_property property;
     pd_ast_class klass;
+    pd_ast_array array;
+    pd_ast_index index;
+    pd_ast_dict dict;
+    pd_ast_import import;
   };
 } pd_ast_node;
 
 // Functions to create ast nodes.
-pd_ast_node* pd_ast_number_create(int line, double value);
-pd_ast_node* pd_ast_assign_create(int line, char* name, pd_ast_node* expr);
-pd_ast_node* pd_ast_block_create(pd_ast_node* statement);
-pd_ast_node* pd_ast_string_create(int line, char* value);
-pd_ast_node* pd_ast_boolean_create(int line, bool value);
-pd_ast_node* pd_ast_prototype_create(int line, char* name, char** args, int argc);
-pd_ast_node* pd_ast_function_create(int line, pd_ast_node* prototype, pd_ast_node* body);
-pd_ast_node* pd_ast_conditional_create(int line, pd_ast_node* condition, pd_ast_node* trueNode, pd_ast_node* falseNode);
-pd_ast_node* pd_ast_variable_create(int line, char* name);
-pd_ast_node* pd_ast_binary_op_create(int line, pd_binary_op_type op, pd_ast_node* lhs, pd_ast_node* rhs);
-pd_ast_node* pd_ast_call_create(int line, char* name, pd_ast_node** args, int argc);
-pd_ast_node* pd_ast_block_append(pd_ast_node* block, pd_ast_node* node);
-pd_ast_node* pd_ast_return_create(int line, pd_ast_node* expr);
-pd_ast_node* pd_ast_file_create(int line);
-pd_ast_node* pd_ast_null_create(int line);
-pd_ast_node* pd_ast_unary_op_create(int line, pd_unary_op_type type, pd_ast_node* rhs);
-pd_ast_node* pd_ast_ternary_create(int line, pd_ast_node* cond, pd_ast_node* trueNode, pd_ast_node* falseNode);
-pd_ast_node* pd_ast_while_create(int line, pd_ast_node* condition, pd_ast_node* body);
-pd_ast_node* pd_ast_property_create(int line, pd_ast_node* expr, pd_ast_node* ident);
-pd_ast_node* pd_ast_empty_create(void);
-pd_ast_node* pd_ast_class_create(int line, char* name);
+// Nodes are allocated in [arena] and so are the arrays given to them, they are used as is instead of being copied.
+// Names are taken as is too since the lexer put them in the same arena.
+pd_ast_node* pd_ast_number_create(pd_arena* arena, int line, double value);
+pd_ast_node* pd_ast_assign_create(pd_arena* arena, int line, pd_ast_text name, pd_ast_node* expr);
+pd_ast_node* pd_ast_block_create(pd_arena* arena, pd_ast_node* statement);
+pd_ast_node* pd_ast_string_create(pd_arena* arena, int line, pd_ast_text value);
+pd_ast_node* pd_ast_boolean_create(pd_arena* arena, int line, bool value);
+pd_ast_node* pd_ast_prototype_create(pd_arena* arena, int line, pd_ast_text name, pd_ast_text* args, int argc);
+pd_ast_node* pd_ast_function_create(pd_arena* arena, int line, pd_ast_node* prototype, pd_ast_node* body);
+pd_ast_node* pd_ast_conditional_create(pd_arena* arena, int line, pd_ast_node* condition, pd_ast_node* trueNode, pd_ast_node* falseNode);
+pd_ast_node* pd_ast_variable_create(pd_arena* arena, int line, pd_ast_text name);
+pd_ast_node* pd_ast_binary_op_create(pd_arena* arena, int line, pd_binary_op_type op, pd_ast_node* lhs, pd_ast_node* rhs);
+pd_ast_node* pd_ast_call_create(pd_arena* arena, int line, pd_ast_text name, pd_ast_node** args, int argc);
+pd_ast_node* pd_ast_block_append(pd_arena* arena, pd_ast_node* block, pd_ast_node* node);
+pd_ast_node* pd_ast_return_create(pd_arena* arena, int line, pd_ast_node* expr);
+pd_ast_node* pd_ast_file_create(pd_arena* arena, int line);
+pd_ast_node* pd_ast_null_create(pd_arena* arena, int line);
+pd_ast_node* pd_ast_unary_op_create(pd_arena* arena, int line, pd_unary_op_type type, pd_ast_node* rhs);
+pd_ast_node* pd_ast_ternary_create(pd_arena* arena, int line, pd_ast_node* cond, pd_ast_node* trueNode, pd_ast_node* falseNode);
+pd_ast_node* pd_ast_while_create(pd_arena* arena, int line, pd_ast_node* condition, pd_ast_node* body);
+pd_ast_node* pd_ast_for_create(pd_arena* arena, int line, pd_ast_text name, pd_ast_node* start, pd_ast_node* limit, pd_ast_node* step, pd_ast_node* body);
+pd_ast_node* pd_ast_empty_create(pd_arena* arena);
+pd_ast_node* pd_ast_class_create(pd_arena* arena, int line, pd_ast_text name);
+pd_ast_node* pd_ast_array_create(pd_arena* arena, int line, pd_ast_node** elements, int count);
+pd_ast_node* pd_ast_index_create(pd_arena* arena, int line, pd_ast_node* expr, pd_ast_node* index, pd_ast_node* value);
+pd_ast_node* pd_ast_dict_create(pd_arena* arena, int line, pd_ast_node** keys, pd_ast_node** values, int count);
+pd_ast_node* pd_ast_property_create(pd_arena* arena, int line, pd_ast_node* expr, pd_ast_text name);
+pd_ast_node* pd_ast_import_create(pd_arena* arena, int line, pd_ast_text name);
 
 // returns true if the node is an expression statement.
 bool pd_ast_is_expr(pd_ast_node* node);
 
 // Dumps the parsed node for inspecting.
 void pd_ast_node_dump(pd_ast_node node);
-// Frees the memory allocated by a node.
-void pd_ast_node_free(pd_ast_node* node);
 
 #ifdef __cplusplus
 }
@@ -2,8 +2,17 @@
 #include "value.h"
 #include "gc.h"
 #include "runtime.h"
+#include "array.h"
+#include "typed_array.h"
+#include "dict.h"
+#include "str.h"
+#include "task.h"
+#include "timers.h"
+#include "net.h"
+#include "fs.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 static pd_value println(pvm_t* vm, int argc, pd_value* args) {
@@ -34,6 +43,13 @@ static pd_value gc_heap_size(pvm_t* vm, int argc, pd_value* args) {
   return NUMBER_VAL((double)vm->bytes_allocated);
 }
 
+// Free slots left on the stack, for tests that need natives called with it full.
+static pd_value stack_space(pvm_t* vm, int argc, pd_value* args) {
+  (void)argc;
+  (void)args;
+  return NUMBER_VAL((double)(vm->stack_end - vm->stack_top));
+}
+
 // Forces a GC cycle.
 static pd_value gc_collect(pvm_t* vm, int argc, pd_value* args) {
   (void)argc;
@@ -48,7 +64,7 @@ static pd_value pd_exit(pvm_t* vm, int argc, pd_value* args) {
   // Right now we don't have a way to report errors so if the argument isn't a number
   // we simply act like it wasn't even passed, but this is a TODO for when we have exception handling.
   if(argc > 0) {
-    if(IS_DOUBLE(args[0]))
+    if(IS_NUMBER(args[0]))
       status = (int)AS_DOUBLE(args[0]);
   }
   // Destroy the VM and deallocate all objects.
@@ -57,44 +73,265 @@ static pd_value pd_exit(pvm_t* vm, int argc, pd_value* args) {
   return NULL_VALUE; // exit kills the process anyway.
 }
 
-typedef struct {
-  pvm_t* vm;
-  pd_closure* cb;
-} pd_timer_t;
-
-void cb(uv_timer_t* handle) {
-  pd_timer_t* data = handle->data;
-  //pvm_exec(data->vm, data->cb);
-  pvm_push(data->vm, PD_FROM(data->cb));
-  pvm_call(data->vm, PD_FROM(data->cb), 0);
-  pvm_run(data->vm);
-  uv_close((uv_handle_t*)handle, NULL);
-  free(handle);
-  free(data);
-}
-
-pd_value setTimeout(pvm_t* vm, int argc, pd_value* args) {
-  if(argc < 2 || !IS_DOUBLE(args[0]) || !PD_IS_CLOSURE(args[1])) return NULL_VALUE;
-  int ms = (int)AS_DOUBLE(args[0]);
-  pd_closure* fn = PD_AS_CLOSURE(args[1]);
-  uv_timer_t* timer = malloc(sizeof(uv_timer_t));
-  uv_timer_init(vm->loop, timer);
-  //pd_timer_t data = {vm, fn};
-  pd_timer_t* data = malloc(sizeof(pd_timer_t));
-  data->vm = vm;
-  data->cb = fn;
-  timer->data = data;
-  uv_timer_start(timer, cb, ms, 0);
+// Length of an array or a string.
+static pd_value len(pvm_t* vm, int argc, pd_value* args) {
+  (void)vm;
+  if(argc < 1) return NULL_VALUE;
+  if(IS_OBJECT(args[0]) && PD_IS_ARRAY(args[0]))
+    return NUMBER_VAL((double)PD_AS_ARRAY(args[0])->values.count);
+  if(IS_OBJECT(args[0]) && PD_IS_DICT(args[0]))
+    return NUMBER_VAL((double)PD_AS_DICT(args[0])->count);
+  if(IS_OBJECT(args[0]) && PD_IS_TYPED_ARRAY(args[0]))
+    return NUMBER_VAL((double)PD_AS_TYPED_ARRAY(args[0])->count);
+  if(PD_IS_ANY_STRING(args[0]))
+    return NUMBER_VAL((double)pd_str_len(args[0]));
   return NULL_VALUE;
 }
 
+// Appends a value to an array and returns the new length.
+static pd_value push(pvm_t* vm, int argc, pd_value* args) {
+  if(argc < 2 || !IS_OBJECT(args[0]) || !PD_IS_ARRAY(args[0])) return NULL_VALUE;
+  pd_array* array = PD_AS_ARRAY(args[0]);
+  // Arguments are still on the stack so both are safe if this triggers the GC.
+  pd_array_push(vm, array, args[1]);
+  return NUMBER_VAL((double)array->values.count);
+}
+
+// Removes the last value of an array and returns it, null if the array is empty.
+static pd_value pop(pvm_t* vm, int argc, pd_value* args) {
+  (void)vm;
+  if(argc < 1 || !IS_OBJECT(args[0]) || !PD_IS_ARRAY(args[0])) return NULL_VALUE;
+  pd_value_array* values = &PD_AS_ARRAY(args[0])->values;
+  if(values->count == 0) return NULL_VALUE;
+  return values->data[--values->count];
+}
+
+// Collects the keys or values of a dictionary into an array, in insertion order.
+static pd_value dictEntries(pvm_t* vm, int argc, pd_value* args, bool keys) {
+  if(argc < 1 || !IS_OBJECT(args[0]) || !PD_IS_DICT(args[0])) return NULL_VALUE;
+  pd_dict* dict = PD_AS_DICT(args[0]);
+  pd_array* array = pd_array_new(vm, NULL, 0);
+  pvm_push(vm, PD_FROM(array)); // GC guard while we grow it.
+  for(int i = 0; i < dict->used; i++) {
+    pd_dict_entry* entry = &dict->entries[i];
+    if(PD_DICT_ENTRY_DELETED(entry)) continue;
+    pd_array_push(vm, array, keys ? entry->key : entry->value);
+  }
+  pvm_pop(vm);
+  return PD_FROM(array);
+}
+
+static pd_value keys(pvm_t* vm, int argc, pd_value* args) {
+  return dictEntries(vm, argc, args, true);
+}
+
+static pd_value values(pvm_t* vm, int argc, pd_value* args) {
+  return dictEntries(vm, argc, args, false);
+}
+
+// Typed arrays are created either with a length, zero filled, or from an array of numbers to copy.
+static pd_value newTypedArray(pvm_t* vm, pd_typed_kind kind, int argc, pd_value* args) {
+  if(argc < 1) return NULL_VALUE;
+  if(IS_NUMBER(args[0])) {
+    double count = AS_DOUBLE(args[0]);
+    if(!(count >= 0 && count <= INT32_MAX)) return NULL_VALUE;
+    return PD_FROM(pd_typed_array_new(vm, kind, (int)count));
+  }
+  if(!IS_OBJECT(args[0]) || !PD_IS_ARRAY(args[0])) return NULL_VALUE;
+  pd_value_array* values = &PD_AS_ARRAY(args[0])->values;
+  pd_typed_array* array = pd_typed_array_new(vm, kind, values->count);
+  for(int i = 0; i < values->count; i++)
+    pd_typed_array_set(array, i, IS_NUMBER(values->data[i]) ? AS_DOUBLE(values->data[i]) : 0);
+  return PD_FROM(array);
+}
+
+static pd_value float64Array(pvm_t* vm, int argc, pd_value* args) {
+  return newTypedArray(vm, PD_TYPED_FLOAT64, argc, args);
+}
+
+static pd_value int32Array(pvm_t* vm, int argc, pd_value* args) {
+  return newTypedArray(vm, PD_TYPED_INT32, argc, args);
+}
+
+static pd_value uint8Array(pvm_t* vm, int argc, pd_value* args) {
+  return newTypedArray(vm, PD_TYPED_UINT8, argc, args);
+}
+
+// Sum of all elements of a typed array.
+static pd_value sum(pvm_t* vm, int argc, pd_value* args) {
+  (void)vm;
+  if(argc < 1 || !IS_OBJECT(args[0]) || !PD_IS_TYPED_ARRAY(args[0])) return NULL_VALUE;
+  return NUMBER_VAL(pd_typed_array_sum(PD_AS_TYPED_ARRAY(args[0])));
+}
+
+// Dot product of two typed arrays of the same length.
+static pd_value dot(pvm_t* vm, int argc, pd_value* args) {
+  (void)vm;
+  if(argc < 2 || !IS_OBJECT(args[0]) || !PD_IS_TYPED_ARRAY(args[0]) ||
+      !IS_OBJECT(args[1]) || !PD_IS_TYPED_ARRAY(args[1])) return NULL_VALUE;
+  pd_typed_array* a = PD_AS_TYPED_ARRAY(args[0]);
+  pd_typed_array* b = PD_AS_TYPED_ARRAY(args[1]);
+  if(a->count != b->count) return NULL_VALUE;
+  return NUMBER_VAL(pd_typed_array_dot(a, b));
+}
+
+// Sets every element of a typed array to a number and returns the array.
+static pd_value fill(pvm_t* vm, int argc, pd_value* args) {
+  (void)vm;
+  if(argc < 2 || !IS_OBJECT(args[0]) || !PD_IS_TYPED_ARRAY(args[0]) || !IS_NUMBER(args[1])) return NULL_VALUE;
+  if(PD_TYPED_ARRAY_READ_ONLY(PD_AS_TYPED_ARRAY(args[0]))) return NULL_VALUE;
+  pd_typed_array_fill(PD_AS_TYPED_ARRAY(args[0]), AS_DOUBLE(args[1]));
+  return args[0];
+}
+
+// Calls a function on every element of a typed array and returns a new typed array of the same kind with the results.
+// Results that aren't numbers are stored as NaN. (or 0 for integer arrays)
+static pd_value map(pvm_t* vm, int argc, pd_value* args) {
+  if(argc < 2 || !IS_OBJECT(args[0]) || !PD_IS_TYPED_ARRAY(args[0])) return NULL_VALUE;
+  pd_typed_array* source = PD_AS_TYPED_ARRAY(args[0]);
+  pd_value fn = args[1]; // args may move once we call back into the VM.
+  pd_typed_array* result = pd_typed_array_new(vm, source->kind, source->count);
+  pvm_push(vm, PD_FROM(result)); // GC guard, the callback may allocate.
+  for(int i = 0; i < source->count; i++) {
+    pd_value element = DOUBLE_VAL(pd_typed_array_get(source, i));
+    pd_value value;
+    // On errors the VM is already reset, including our guard.
+    if(!pvm_call_value(vm, fn, 1, &element, &value)) return NULL_VALUE;
+    pd_typed_array_set(result, i, IS_NUMBER(value) ? AS_DOUBLE(value) : pd_as_double(0x7ff8000000000000));
+  }
+  pvm_pop(vm);
+  return PD_FROM(result);
+}
+
+static bool isCallable(pd_value value) {
+  return IS_OBJECT(value) && (PD_IS_CLOSURE(value) || OBJECT_TYPE(AS_OBJECT(value)) == PD_OBJ_NATIVE);
+}
+
+// setTimeout(ms, fn) calls fn once after ms milliseconds, returns a handle for clearTimeout()
+static pd_value setTimeout(pvm_t* vm, int argc, pd_value* args) {
+  if(argc < 2 || !IS_NUMBER(args[0]) || !isCallable(args[1])) return NULL_VALUE;
+  return NUMBER_VAL(pd_timers_add(vm, AS_DOUBLE(args[0]), 0, args[1]));
+}
+
+// setInterval(ms, fn) calls fn every ms milliseconds until it's cleared.
+static pd_value setInterval(pvm_t* vm, int argc, pd_value* args) {
+  if(argc < 2 || !IS_NUMBER(args[0]) || !isCallable(args[1])) return NULL_VALUE;
+  double ms = AS_DOUBLE(args[0]);
+  return NUMBER_VAL(pd_timers_add(vm, ms, ms > 1 ? ms : 1, args[1]));
+}
+
+// clearTimeout(handle) and clearInterval(handle) are the same, true if the timer was still waiting.
+static pd_value clearTimeout(pvm_t* vm, int argc, pd_value* args) {
+  if(argc < 1 || !IS_NUMBER(args[0])) return FALSE_VALUE;
+  return BOOL_VAL(pd_timers_cancel(vm, AS_DOUBLE(args[0])));
+}
+
+// sleep(ms) gives a task that is done after [ms] milliseconds, to await in async functions.
+static pd_value pd_sleep(pvm_t* vm, int argc, pd_value* args) {
+  if(argc < 1 || !IS_NUMBER(args[0])) return NULL_VALUE;
+  // The timer keeps the task alive until it completes it.
+  pd_task* task = pd_task_new(vm);
+  pd_timers_add(vm, AS_DOUBLE(args[0]), 0, PD_FROM(task));
+  return PD_FROM(task);
+}
+
+// Every builtin by name, snapshots also use this to find natives again in another process. (see snapshot.c)
+static const pd_builtin builtins[] = {
+  { "println", println },
+  { "print", print },
+  { "clock", pd_clock },
+  { "gc_heap_size", gc_heap_size },
+  { "gc_collect", gc_collect },
+  { "stack_space", stack_space },
+  { "exit", pd_exit },
+  { "setTimeout", setTimeout },
+  { "setInterval", setInterval },
+  { "clearTimeout", clearTimeout },
+  { "clearInterval", clearTimeout },
+  { "sleep", pd_sleep },
+  { "len", len },
+  { "push", push },
+  { "pop", pop },
+  { "Float64Array", float64Array },
+  { "Int32Array", int32Array },
+  { "Uint8Array", uint8Array },
+  { "sum", sum },
+  { "dot", dot },
+  { "fill", fill },
+  { "map", map },
+  { "keys", keys },
+  { "values", values }
+};
+
+#define BUILTIN_COUNT (sizeof(builtins) / sizeof(builtins[0]))
+
+// Builtin modules, what `import name` can give.
+static const struct {
+  const char* name;
+  const pd_builtin* functions;
+} modules[] = {
+  { "net", pd_net_functions },
+  { "fs", pd_fs_functions }
+};
+
+#define MODULE_COUNT (sizeof(modules) / sizeof(modules[0]))
+
 // Registers all builtins.
 void pvm_init_builtins(pvm_t* vm) {
-  pvm_define_function(vm, "println", println);
-  pvm_define_function(vm, "print", print);
-  pvm_define_function(vm, "clock", pd_clock);
-  pvm_define_function(vm, "gc_heap_size", gc_heap_size);
-  pvm_define_function(vm, "gc_collect", gc_collect);
-  pvm_define_function(vm, "exit", pd_exit);
-  pvm_define_function(vm, "setTimeout", setTimeout);
+  for(size_t i = 0; i < BUILTIN_COUNT; i++) {
+    pvm_define_function(vm, (char*)builtins[i].name, builtins[i].function);
+  }
+}
+
+const char* pd_builtin_name(pd_native function) {
+  for(size_t i = 0; i < BUILTIN_COUNT; i++) {
+    if(builtins[i].function == function) return builtins[i].name;
+  }
+  for(size_t i = 0; i < MODULE_COUNT; i++) {
+    for(const pd_builtin* entry = modules[i].functions; entry->name != NULL; entry++) {
+      if(entry->function == function) return entry->name;
+    }
+  }
+  return NULL;
+}
+
+pd_native pd_builtin_find(const char* name, size_t len) {
+  for(size_t i = 0; i < BUILTIN_COUNT; i++) {
+    if(strlen(builtins[i].name) == len && memcmp(builtins[i].name, name, len) == 0) return builtins[i].function;
+  }
+  for(size_t i = 0; i < MODULE_COUNT; i++) {
+    for(const pd_builtin* entry = modules[i].functions; entry->name != NULL; entry++) {
+      if(strlen(entry->name) == len && memcmp(entry->name, name, len) == 0) return entry->function;
+    }
+  }
+  return NULL;
+}
+
+bool pd_builtin_import(pvm_t* vm, pd_value name, pd_value* module) {
+  char bytes[PD_SSTR_MAX + 1];
+  const char* chars = bytes;
+  size_t len;
+  if(IS_SHORT_STRING(name)) {
+    len = pd_sstr_read(name, bytes);
+  } else {
+    chars = PD_AS_CSTRING(name);
+    len = PD_STRLEN(name);
+  }
+  for(size_t i = 0; i < MODULE_COUNT; i++) {
+    if(strlen(modules[i].name) != len || memcmp(modules[i].name, chars, len) != 0) continue;
+    // A new dictionary every time, modules are only imported once per program anyway.
+    pd_dict* dict = pd_dict_new(vm);
+    pvm_push(vm, PD_FROM(dict)); // GC guard
+    for(const pd_builtin* entry = modules[i].functions; entry->name != NULL; entry++) {
+      // The key is the name without the "module." prefix.
+      const char* key = entry->name + len + 1;
+      pvm_push(vm, pd_str_new(vm, (char*)key, strlen(key)));
+      pvm_push(vm, PD_FROM(pd_native_function_new(vm, entry->function)));
+      pd_dict_set(vm, dict, vm->stack_top[-2], vm->stack_top[-1]);
+      vm->stack_top -= 2;
+    }
+    *module = pvm_pop(vm);
+    return true;
+  }
+  return false;
 }
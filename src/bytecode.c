@@ -0,0 +1,462 @@
+// Implements the .pvm file format, see the bytecodefile for the layout.
+// Everything is little-endian regardless of the machine, numbers are stored as the bits of a double.
+
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif // _WIN32
+#include "bytecode.h"
+#include "pvm.h"
+#include "str.h"
+#include "table.h"
+#include "gc.h"
+
+// Tags of the constant pool entries.
+typedef enum {
+  CONST_STRING = 0,
+  CONST_NUMBER = 1,
+  CONST_FUNCTION = 2
+} constantTag;
+
+// Size of the fixed part of the header: magic, versions, hash and mtime.
+#define HEADER_SIZE (4 + 1 + 1 + 8 + 8)
+
+uint64_t pd_bytecode_hash(const uint8_t* data, size_t size) {
+  uint64_t hash = 14695981039346656037ull;
+  for(size_t i = 0; i < size; i++) {
+    hash ^= data[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+// == Writer ==
+
+// fwrite failures are sticky in the FILE so we only check ferror() once at the end.
+static void writeU1(FILE* out, uint8_t value) {
+  fputc(value, out);
+}
+
+static void writeU2(FILE* out, uint16_t value) {
+  writeU1(out, value & 0xff);
+  writeU1(out, (value >> 8) & 0xff);
+}
+
+static void writeU4(FILE* out, uint32_t value) {
+  writeU2(out, value & 0xffff);
+  writeU2(out, (value >> 16) & 0xffff);
+}
+
+static void writeU8(FILE* out, uint64_t value) {
+  writeU4(out, value & 0xffffffff);
+  writeU4(out, (value >> 32) & 0xffffffff);
+}
+
+static void writeString(FILE* out, const char* bytes, size_t len) {
+  writeU4(out, (uint32_t)len);
+  fwrite(bytes, 1, len, out);
+}
+
+static void writeFunction(FILE* out, pd_function* function) {
+  pd_assert(!function->chunk.external, "Functions loaded from a mapped file can't be written back.");
+  pd_assert(function->ast == NULL, "Code written to a file must not be compiled lazily.");
+  writeU1(out, function->name != NULL);
+  if(function->name != NULL) writeString(out, function->name->bytes, function->name->len);
+  writeU2(out, (uint16_t)function->arity);
+  writeU2(out, (uint16_t)function->upvalue_count);
+  writeU2(out, (uint16_t)function->scope);
+  writeU8(out, function->inline_hash);
+  writeU1(out, function->async);
+
+  pvm_chunk* chunk = &function->chunk;
+  writeU4(out, (uint32_t)chunk->count);
+  fwrite(chunk->code, 1, chunk->count, out);
+
+  // Lines are stored per byte in memory but long runs share the same line, so we store runs of them.
+  uint32_t runs = 0;
+  for(int i = 0; i < chunk->count; i++) {
+    if(i == 0 || chunk->lines[i] != chunk->lines[i - 1]) runs++;
+  }
+  writeU4(out, runs);
+  for(int i = 0; i < chunk->count;) {
+    int start = i;
+    while(i < chunk->count && chunk->lines[i] == chunk->lines[start]) i++;
+    writeU4(out, (uint32_t)chunk->lines[start]);
+    writeU4(out, (uint32_t)(i - start));
+  }
+
+  writeU2(out, (uint16_t)chunk->constants.count);
+  for(int i = 0; i < chunk->constants.count; i++) {
+    pd_value value = chunk->constants.data[i];
+    if(IS_NUMBER(value)) {
+      union pd_double_bits bits;
+      bits.num = AS_DOUBLE(value);
+      writeU1(out, CONST_NUMBER);
+      writeU8(out, bits.bits);
+    } else if(IS_SHORT_STRING(value)) {
+      char bytes[PD_SSTR_MAX + 1];
+      int len = pd_sstr_read(value, bytes);
+      writeU1(out, CONST_STRING);
+      writeString(out, bytes, len);
+    } else if(PD_IS_STRING(value)) {
+      writeU1(out, CONST_STRING);
+      writeString(out, PD_AS_CSTRING(value), PD_STRLEN(value));
+    } else {
+      pd_assert(PD_IS_FUNCTION(value), "Unexpected constant type.");
+      writeU1(out, CONST_FUNCTION);
+      writeFunction(out, PD_AS_FUNCTION(value));
+    }
+  }
+}
+
+bool pd_bytecode_write(pvm_t* vm, pd_function* script, FILE* out, uint64_t sourceHash, int64_t sourceMtime) {
+  writeU4(out, PD_BYTECODE_MAGIC);
+  writeU1(out, PD_BYTECODE_MAJOR);
+  writeU1(out, PD_BYTECODE_MINOR);
+  writeU8(out, sourceHash);
+  writeU8(out, (uint64_t)sourceMtime);
+
+  // The table doesn't keep any order so we put the names back in index order first.
+  int count = vm->global_values.count;
+  if(count > UINT16_MAX) return false;
+  pd_str** names = calloc(count, sizeof(pd_str*));
+  for(int i = 0; i < vm->globals.capacity; i++) {
+    pd_table_entry* entry = &vm->globals.entries[i];
+    if(entry->key == NULL) continue;
+    names[(int)AS_DOUBLE(entry->value)] = entry->key;
+  }
+  writeU2(out, (uint16_t)count);
+  for(int i = 0; i < count; i++) {
+    writeString(out, names[i]->bytes, names[i]->len);
+  }
+  free(names);
+
+  writeFunction(out, script);
+  return !ferror(out);
+}
+
+// == Reader ==
+
+typedef struct {
+  pvm_t* vm;
+  const uint8_t* data;
+  size_t size;
+  size_t offset;
+  // Set when reading past the end, from then on every read returns 0 so we only check this at the end of a function.
+  bool error;
+  // Functions point into [data] instead of copying their code and their constants are loaded later.
+  bool mapped;
+} reader;
+
+static bool ensure(reader* r, size_t count) {
+  if(r->error || r->size - r->offset < count) {
+    r->error = true;
+    return false;
+  }
+  return true;
+}
+
+static uint8_t readU1(reader* r) {
+  if(!ensure(r, 1)) return 0;
+  return r->data[r->offset++];
+}
+
+static uint16_t readU2(reader* r) {
+  uint16_t low = readU1(r);
+  return low | (uint16_t)readU1(r) << 8;
+}
+
+static uint32_t readU4(reader* r) {
+  uint32_t low = readU2(r);
+  return low | (uint32_t)readU2(r) << 16;
+}
+
+static uint64_t readU8(reader* r) {
+  uint64_t low = readU4(r);
+  return low | (uint64_t)readU4(r) << 32;
+}
+
+// Returns a pointer to [len] bytes in the file, NULL if there isn't enough.
+static const char* readBytes(reader* r, size_t len) {
+  if(!ensure(r, len)) return NULL;
+  const char* bytes = (const char*)r->data + r->offset;
+  r->offset += len;
+  return bytes;
+}
+
+// Walks over a function without loading anything, checking that it is all there.
+// Mapped files go through this once so loading their constants later on can't fail halfway.
+static void skipFunction(reader* r, int depth) {
+  // Only corrupted files nest this deep, don't let them blow up the C stack.
+  if(depth > 256) {
+    r->error = true;
+    return;
+  }
+  if(readU1(r)) readBytes(r, readU4(r));
+  readBytes(r, 15); // arity, upvalues, scope, inline hash and async.
+  uint32_t count = readU4(r);
+  readBytes(r, count);
+  uint32_t runs = readU4(r);
+  uint64_t covered = 0;
+  for(uint32_t i = 0; i < runs && !r->error; i++) {
+    readU4(r);
+    covered += readU4(r);
+  }
+  if(covered != count) r->error = true;
+
+  uint16_t constants = readU2(r);
+  for(uint16_t i = 0; i < constants && !r->error; i++) {
+    switch(readU1(r)) {
+      case CONST_NUMBER: readBytes(r, 8); break;
+      case CONST_STRING: readBytes(r, readU4(r)); break;
+      case CONST_FUNCTION: skipFunction(r, depth + 1); break;
+      default: r->error = true; break;
+    }
+  }
+}
+
+static pd_function* readFunction(reader* r, int depth);
+
+// Reads the constant pool of [function] which is on the stack.
+static void readConstants(reader* r, pd_function* function, int depth) {
+  pvm_t* vm = r->vm;
+  uint16_t constants = readU2(r);
+  for(uint16_t i = 0; i < constants && !r->error; i++) {
+    switch(readU1(r)) {
+      case CONST_NUMBER: {
+        union pd_double_bits bits;
+        bits.bits = readU8(r);
+        pvm_add_constant(vm, &function->chunk, NUMBER_VAL(bits.num));
+        break;
+      }
+      case CONST_STRING: {
+        uint32_t len = readU4(r);
+        const char* bytes = readBytes(r, len);
+        if(bytes == NULL) break;
+        pvm_add_constant(vm, &function->chunk, pd_str_new(vm, (char*)bytes, len));
+        break;
+      }
+      case CONST_FUNCTION: {
+        pd_function* nested = readFunction(r, depth + 1);
+        if(nested == NULL) break;
+        pvm_add_constant(vm, &function->chunk, PD_FROM(nested));
+        break;
+      }
+      default:
+        r->error = true;
+        break;
+    }
+  }
+}
+
+static pd_function* readFunction(reader* r, int depth) {
+  if(depth > 256) {
+    r->error = true;
+    return NULL;
+  }
+  pvm_t* vm = r->vm;
+  pd_function* function = pd_function_new(vm);
+  // The function stays on the stack while we fill it so the GC can see everything it holds.
+  pvm_push(vm, PD_FROM(function));
+
+  if(readU1(r)) {
+    uint32_t len = readU4(r);
+    const char* name = readBytes(r, len);
+    if(name != NULL) function->name = pd_str_intern(vm, (char*)name, len);
+  }
+  function->arity = readU2(r);
+  function->upvalue_count = readU2(r);
+  function->scope = readU2(r);
+  function->inline_hash = readU8(r);
+  function->async = readU1(r);
+
+  pvm_chunk* chunk = &function->chunk;
+  uint32_t count = readU4(r);
+  const char* code = readBytes(r, count);
+  if(r->mapped) {
+    // Everything was checked by skipFunction() already.
+    chunk->external = true;
+    chunk->code = (uint8_t*)code;
+    chunk->count = count;
+    chunk->line_runs = r->data + r->offset;
+    readBytes(r, 8 * (size_t)readU4(r));
+    // The constants can wait until the function is used, we only need to get past them for now.
+    chunk->pending = r->data + r->offset;
+    uint16_t constants = readU2(r);
+    for(uint16_t i = 0; i < constants; i++) {
+      switch(readU1(r)) {
+        case CONST_NUMBER: readBytes(r, 8); break;
+        case CONST_STRING: readBytes(r, readU4(r)); break;
+        case CONST_FUNCTION: skipFunction(r, depth + 1); break;
+      }
+    }
+    pvm_pop(vm);
+    return function;
+  }
+
+  if(code != NULL && count > 0) {
+    chunk->code = PD_GROW_ARRAY(vm, chunk->code, uint8_t, 0, count);
+    chunk->lines = PD_GROW_ARRAY(vm, chunk->lines, int, 0, count);
+    chunk->capacity = count;
+    chunk->count = count;
+    memcpy(chunk->code, code, count);
+  }
+
+  uint32_t runs = readU4(r);
+  uint32_t filled = 0;
+  for(uint32_t i = 0; i < runs && !r->error; i++) {
+    int line = (int)readU4(r);
+    uint32_t length = readU4(r);
+    if(length > (uint32_t)chunk->count - filled) {
+      r->error = true;
+      break;
+    }
+    for(uint32_t j = 0; j < length; j++) chunk->lines[filled++] = line;
+  }
+  if(filled != (uint32_t)chunk->count) r->error = true;
+
+  readConstants(r, function, depth);
+  pvm_pop(vm);
+  return r->error ? NULL : function;
+}
+
+void pd_bytecode_load_constants(pvm_t* vm, pd_function* function) {
+  // The file was fully checked when mapped so there is no end to watch for.
+  reader r = { vm, function->chunk.pending, SIZE_MAX, 0, false, true };
+  function->chunk.pending = NULL;
+  pvm_push(vm, PD_FROM(function));
+  readConstants(&r, function, 0);
+  pvm_pop(vm);
+}
+
+bool pd_bytecode_is(const uint8_t* data, size_t size) {
+  return size >= 4 && (data[0] | data[1] << 8 | data[2] << 16 | (uint32_t)data[3] << 24) == PD_BYTECODE_MAGIC;
+}
+
+bool pd_bytecode_fresh(const uint8_t* data, size_t size, uint64_t sourceHash, int64_t sourceMtime) {
+  if(size < HEADER_SIZE || !pd_bytecode_is(data, size)) return false;
+  reader r = { NULL, data, size, 4, false, false };
+  if(readU1(&r) != PD_BYTECODE_MAJOR || readU1(&r) != PD_BYTECODE_MINOR) return false;
+  return readU8(&r) == sourceHash && (int64_t)readU8(&r) == sourceMtime;
+}
+
+static pd_function* readFile(reader* r) {
+  pvm_t* vm = r->vm;
+  if(r->size < HEADER_SIZE || !pd_bytecode_is(r->data, r->size)) return NULL;
+  r->offset = 4;
+  uint8_t major = readU1(r);
+  uint8_t minor = readU1(r);
+  if(major != PD_BYTECODE_MAJOR || minor > PD_BYTECODE_MINOR) return NULL;
+  // The source hash and mtime are only for the cache.
+  readU8(r);
+  readU8(r);
+
+  // Check the rest of the file before registering any globals, mapped functions trust it from here on.
+  size_t globalsOffset = r->offset;
+  uint16_t globals = readU2(r);
+  for(uint16_t i = 0; i < globals && !r->error; i++) readBytes(r, readU4(r));
+  if(r->mapped) skipFunction(r, 0);
+  if(r->error) return NULL;
+  r->offset = globalsOffset;
+  readU2(r);
+
+  // The code refers to globals by index so each name must land on the same index it had when compiled.
+  for(uint16_t i = 0; i < globals; i++) {
+    uint32_t len = readU4(r);
+    pd_str* identifier = pd_str_intern(vm, (char*)readBytes(r, len), len);
+    pd_value index;
+    if(pd_table_get(&vm->globals, identifier, &index)) {
+      if(AS_DOUBLE(index) != i) return NULL;
+      continue;
+    }
+    if(vm->global_values.count != i) return NULL;
+    pvm_push(vm, PD_FROM(identifier));
+    pd_value_array_write(vm, &vm->global_values, UNDEFINED_VALUE);
+    pd_table_set(vm, &vm->globals, identifier, NUMBER_VAL((double)i));
+    pvm_pop(vm);
+  }
+
+  return readFunction(r, 0);
+}
+
+pd_function* pd_bytecode_read(pvm_t* vm, const uint8_t* data, size_t size) {
+  reader r = { vm, data, size, 0, false, false };
+  return readFile(&r);
+}
+
+// == Mapped files ==
+
+// Mapped files are kept in a list in the VM since their functions point into them, they are unmapped with the VM.
+struct pd_mapping {
+  struct pd_mapping* next;
+  uint8_t* data;
+  size_t size;
+};
+
+static void unmap(pd_mapping* mapping) {
+#ifdef _WIN32
+  free(mapping->data);
+#else
+  munmap(mapping->data, mapping->size);
+#endif // _WIN32
+  free(mapping);
+}
+
+pd_function* pd_bytecode_map(pvm_t* vm, const char* path, const uint64_t* sourceHash, int64_t sourceMtime) {
+  pd_mapping* mapping = malloc(sizeof(pd_mapping));
+#ifdef _WIN32
+  // No mmap() here, reading the file keeps the same behaviour minus the sharing.
+  FILE* f = fopen(path, "rb");
+  if(f == NULL) {
+    free(mapping);
+    return NULL;
+  }
+  fseek(f, 0, SEEK_END);
+  long length = ftell(f);
+  rewind(f);
+  mapping->data = malloc(length > 0 ? length : 1);
+  mapping->size = fread(mapping->data, 1, length, f);
+  fclose(f);
+#else
+  int fd = open(path, O_RDONLY);
+  struct stat info;
+  if(fd < 0 || fstat(fd, &info) != 0 || info.st_size == 0) {
+    if(fd >= 0) close(fd);
+    free(mapping);
+    return NULL;
+  }
+  mapping->size = info.st_size;
+  // Private and read-only, the pages are shared with every other process running the same file.
+  mapping->data = mmap(NULL, mapping->size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if(mapping->data == MAP_FAILED) {
+    free(mapping);
+    return NULL;
+  }
+#endif // _WIN32
+
+  pd_function* function = NULL;
+  if(sourceHash == NULL || pd_bytecode_fresh(mapping->data, mapping->size, *sourceHash, sourceMtime)) {
+    reader r = { vm, mapping->data, mapping->size, 0, false, true };
+    function = readFile(&r);
+  }
+  if(function == NULL) {
+    unmap(mapping);
+    return NULL;
+  }
+  mapping->next = vm->mappings;
+  vm->mappings = mapping;
+  return function;
+}
+
+void pd_bytecode_unmap_all(pvm_t* vm) {
+  while(vm->mappings != NULL) {
+    pd_mapping* next = vm->mappings->next;
+    unmap(vm->mappings);
+    vm->mappings = next;
+  }
+}
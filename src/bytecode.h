@@ -0,0 +1,56 @@
+#ifndef _PERIDOT_BYTECODE_H
+#define _PERIDOT_BYTECODE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "peridot.h"
+#include "function.h"
+PERIDOT_EXTERN_C_BEGIN
+
+// Reading and writing compiled code as .pvm files, the format is documented in the bytecodefile in this directory.
+
+// "Fast Bytecode"
+#define PD_BYTECODE_MAGIC 0xFA57BC
+
+// Version of the file format, this includes the instruction set.
+// Bump the minor version whenever an opcode is added or changes its operands so older files and caches get refused.
+// The major version is bumped when the layout of the file itself changes since older files can't be read at all then.
+#define PD_BYTECODE_MAJOR 3
+#define PD_BYTECODE_MINOR 1
+
+// Writes the top-level [script] and every function nested in it to [out] along with the globals of the VM.
+// [sourceHash] and [sourceMtime] identify the source file it was compiled from, they are only used by the cache and can be 0.
+// Returns false if writing failed.
+bool pd_bytecode_write(pvm_t* vm, pd_function* script, FILE* out, uint64_t sourceHash, int64_t sourceMtime);
+
+// Loads a file written by pd_bytecode_write() and registers its globals in the VM, the result can be given to pvm_exec()
+// The globals must line up with the ones the VM already has (a fresh VM has none) since the code refers to them by index.
+// Returns NULL if the file is not valid, truncated or from a newer version.
+pd_function* pd_bytecode_read(pvm_t* vm, const uint8_t* data, size_t size);
+
+// Loads a file like pd_bytecode_read() but maps it in memory instead, the code of every function points straight
+// into the mapping and the constants of a function are only loaded the first time it is used. (see pd_bytecode_load_constants())
+// The mapping lives until the VM is freed, processes running the same file share its pages through the page cache.
+// If [sourceHash] isn't NULL the file is only loaded if it's a fresh cache entry for that source, see pd_bytecode_fresh()
+// Returns NULL if the file can't be mapped or isn't valid.
+pd_function* pd_bytecode_map(pvm_t* vm, const char* path, const uint64_t* sourceHash, int64_t sourceMtime);
+
+// Loads the constants of a function from a mapped file, the VM calls this before a function is first used.
+// Check for chunk.pending before calling.
+void pd_bytecode_load_constants(pvm_t* vm, pd_function* function);
+
+// Unmaps every file mapped in the VM, only when it's being freed since the code of its functions points there.
+void pd_bytecode_unmap_all(pvm_t* vm);
+
+// Checks if [data] starts like a bytecode file, used to tell .pvm files apart from source code.
+bool pd_bytecode_is(const uint8_t* data, size_t size);
+
+// Checks if the file in [data] was compiled from a source with the given hash and modification time by this version.
+bool pd_bytecode_fresh(const uint8_t* data, size_t size, uint64_t sourceHash, int64_t sourceMtime);
+
+// 64 bit FNV-1a hash of a source file, used as the cache key.
+uint64_t pd_bytecode_hash(const uint8_t* data, size_t size);
+
+PERIDOT_EXTERN_C_END
+
+#endif // _PERIDOT_BYTECODE_H
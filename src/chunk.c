@@ -13,12 +13,18 @@ void pvm_chunk_init(pvm_chunk* chunk) {
   chunk->capacity = 0;
   chunk->code = NULL;
   chunk->lines = NULL;
+  chunk->external = false;
+  chunk->line_runs = NULL;
+  chunk->pending = NULL;
   pd_value_array_init(&chunk->constants);
 }
 
 void pvm_chunk_free(pvm_t* vm, pvm_chunk* chunk) {
-  PD_FREE_ARRAY(vm, uint8_t, chunk->code, chunk->capacity);
-  PD_FREE_ARRAY(vm, int, chunk->lines, chunk->capacity);
+  // External code belongs to the mapping, it goes away with the VM.
+  if(!chunk->external) {
+    PD_FREE_ARRAY(vm, uint8_t, chunk->code, chunk->capacity);
+    PD_FREE_ARRAY(vm, int, chunk->lines, chunk->capacity);
+  }
   pd_value_array_clear(vm, &chunk->constants);
   pvm_chunk_init(chunk);
 }
@@ -45,4 +51,20 @@ int pvm_add_constant(pvm_t* vm, pvm_chunk* chunk, pd_value value) {
   pvm_pop(vm);
   return chunk->constants.count - 1;
 }
+
+int pvm_chunk_line(pvm_chunk* chunk, int offset) {
+  if(!chunk->external) return chunk->lines[offset];
+  // u4 count followed by (u4 line, u4 length) pairs, see the bytecodefile.
+  // This is only needed for error messages so walking the runs is fine.
+  const uint8_t* p = chunk->line_runs;
+  uint32_t runs = p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+  p += 4;
+  for(uint32_t i = 0; i < runs; i++, p += 8) {
+    int line = (int)(p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24);
+    int length = (int)(p[4] | p[5] << 8 | p[6] << 16 | (uint32_t)p[7] << 24);
+    if(offset < length) return line;
+    offset -= length;
+  }
+  return -1;
+}
 //< add-constant
@@ -16,11 +16,19 @@ typedef struct pvm_chunk {
   uint8_t* code;
   int* lines;
   pd_value_array constants;
+  // Chunks loaded from a mapped bytecode file (see pd_bytecode_map()) don't own their code, it points into the mapping.
+  // Their lines stay in the run-length encoded form of the file, use pvm_chunk_line() to read them.
+  // The constants are only loaded when the function is first used, until then [pending] points at them in the file.
+  bool external;
+  const uint8_t* line_runs;
+  const uint8_t* pending;
 } pvm_chunk;
 
 void pvm_chunk_init(pvm_chunk* chunk);
 void pvm_chunk_free(pvm_t* vm, pvm_chunk* chunk);
 void pvm_chunk_write(pvm_t* vm, pvm_chunk* chunk, uint8_t byte, int line);
 int pvm_add_constant(pvm_t* vm, pvm_chunk* chunk, pd_value value);
+// Line of the instruction at [offset], works for external chunks too.
+int pvm_chunk_line(pvm_chunk* chunk, int offset);
 
 #endif // _PERIDOT_CHUNK_H
@@ -1,14 +1,25 @@
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
 #include "compiler.h"
 #include "opcodes.h"
 #include "value.h"
 #include "str.h"
 #include "pvm.h"
+#include "optimizer.h"
 
 // TODO: The compiler is extremely messed up.
 // I just wanted to quickly get some progress, this will need a massive cleanup soon.
 // Also read the TODO comments in each section of this file to get a better idea of what needs to be cleaned up.
 
+// An inlined call being compiled, see compileInlined()
+typedef struct pd_inline_call {
+  pd_ast_node* function;
+  pd_ast_node** args;
+  // How far each argument is from the top of the stack when the expression starts, -1 for the ones used as they are.
+  int depth[PD_INLINE_MAX_ARGS];
+} pd_inline_call;
+
 // Given a context, returns the chunk for writing the resulting bytecode.
 static pvm_chunk* currentChunk(pd_code_ctx* ctx) {
   return &ctx->function->chunk;
@@ -27,13 +38,14 @@ static void emitBytes(pd_code_ctx* ctx, uint8_t byte1, uint8_t byte2) {
 
 // Add a compile error, at end of compilation these errors are reported and code won't execute.
 static void error(pd_code_ctx* ctx, const char* format, ...) {
+  ctx->errors++;
+  if(ctx->quiet) return;
   va_list args;
   fprintf(stderr, "[line %d] Error: ", ctx->line);
   va_start(args, format);
   vfprintf(stderr, format, args);
   va_end(args);
   fputs("\n", stderr);
-  ctx->errors++;
 }
 
 // Emits an empty return. TODO: just why have this?
@@ -67,64 +79,103 @@ static void emitConstant(pd_code_ctx* ctx, pd_value value) {
   }
 }
 
-// TODO: handle long constants.
-// For now we are limited to 256 globals per compiler.
-// Also mirror the same change at defineNative() in the VM.
-static uint8_t identifierConstant(pd_code_ctx* ctx, char* name, size_t len) {
+// Returns the index of a global variable, creating it if it doesn't exist yet.
+// Indices past 255 are accessed with the LONG variants of the global instructions, see emitGlobal()
+// Also mirror any change here at pvm_define_function() in the VM.
+static uint16_t identifierConstant(pd_code_ctx* ctx, char* name, size_t len) {
   pd_value index;
-  pd_str* identifier = PD_AS_STRING(pd_str_new(ctx->vm, name, len));
+  pd_str* identifier = pd_str_intern(ctx->vm, name, len);
   if (pd_table_get(&ctx->vm->globals, identifier, &index)) {
-    return (uint8_t)AS_DOUBLE(index);
+    return (uint16_t)AS_DOUBLE(index);
   }
 
+  if(ctx->vm->global_values.count > UINT16_MAX) {
+    error(ctx, "Too many global variables.");
+    return 0;
+  }
+  // Nothing holds the name until it's in the table.
+  pvm_push(ctx->vm, PD_FROM(identifier));
   pd_value_array_write(ctx->vm, &ctx->vm->global_values, UNDEFINED_VALUE);
-  uint8_t newIndex = (uint8_t)ctx->vm->global_values.count - 1;
+  uint16_t newIndex = (uint16_t)(ctx->vm->global_values.count - 1);
 
   pd_table_set(ctx->vm, &ctx->vm->globals, identifier, NUMBER_VAL((double)newIndex));
+  pvm_pop(ctx->vm);
   return newIndex;
 }
 
-// TODO: deprecate this? i have a little idea to handle scopes in a better way, more info soon.
+// Emits an instruction that takes a global index or a constant index.
+// Small indices use the single byte [op] and the rest use [longOp] with 2 bytes in little-endian.
+static void emitIndexed(pd_code_ctx* ctx, uint8_t op, uint8_t longOp, uint16_t index) {
+  if(index <= UINT8_MAX) {
+    emitBytes(ctx, op, (uint8_t)index);
+  } else {
+    emitByte(ctx, longOp);
+    emitBytes(ctx, index & 0xff, (index >> 8) & 0xff);
+  }
+}
+
+static void emitGetGlobal(pd_code_ctx* ctx, char* name, size_t len) {
+  emitIndexed(ctx, PVM_OP_GET_GLOBAL, PVM_OP_GET_GLOBAL_LONG, identifierConstant(ctx, name, len));
+}
+
+static void emitSetGlobal(pd_code_ctx* ctx, uint16_t index) {
+  emitIndexed(ctx, PVM_OP_SET_GLOBAL, PVM_OP_SET_GLOBAL_LONG, index);
+}
+
+// Scopes are real lexical blocks inside functions: the bodies of if/else, while and do blocks.
+// At the top-level there's no block scope, variables assigned in there are globals like before.
 static void beginScope(pd_code_ctx* ctx) {
   ctx->scopeDepth++;
 }
 
-// TODO: get rid of this if we don't need it. (see beginScope())
-// Though i'm not sure about the OP_CLOSE_UPVALUE part if i do it the other way.
-void endScope(pd_code_ctx* ctx) {
-  ctx->scopeDepth--;
-  //int pop = 0;
-  while(ctx->localCount > 0 && ctx->locals[ctx->localCount - 1].depth > ctx->scopeDepth) {
-    if (ctx->locals[ctx->localCount - 1].isCaptured) {
+// Unlinks the newest local from its hash bucket and drops it.
+// Locals always go away in the reverse order they were added so it's always the head of its bucket.
+static void removeLocal(pd_code_ctx* ctx) {
+  pd_compiler_local* local = &ctx->locals[--ctx->localCount];
+  ctx->buckets[local->hash & (PD_LOCAL_BUCKETS - 1)] = local->next;
+}
+
+// Pops the locals above [count], captured ones are closed instead.
+static void popLocals(pd_code_ctx* ctx, int count) {
+  while(ctx->localCount > count) {
+    if(ctx->locals[ctx->localCount - 1].isCaptured) {
       emitByte(ctx, PVM_OP_CLOSE_UPVALUE);
     } else {
       emitByte(ctx, PVM_OP_POP);
     }
-    ctx->localCount--;
-    //pop++;
-  }
-  // Optimize popping
-  // When we go out of scope all locals get popped, dispatch is expensive so we avoid emitting multiple pop instructions
-  // and reduce them to a single POPN but if we only have to pop a single value then
-  // A single pop is better than popn 1 since it doesn't need an operand and results in faster execution.
-  // TODO: Craftinginterpreters makes it harder to follow the book if you add optimizations early.
-  // turns out when adding closures we need a conditional pop, damn it.
-  /*if(pop == 1) emitByte(ctx, PVM_OP_POP);
-  else if(pop != 0) emitBytes(ctx, PVM_OP_POPN, pop);*/
-}                         
+    removeLocal(ctx);
+  }
+  // Runs of pops are merged into a single POPN later by the peephole optimizer (see pd_optimize_chunk())
+  // doing it here gets in the way when some of the locals are captured and need a CLOSE_UPVALUE instead.
+}
+
+// Ends a block, the locals declared in it are popped so their slots get reused by whatever comes next.
+static void endScope(pd_code_ctx* ctx) {
+  ctx->scopeDepth--;
+  int count = ctx->localCount;
+  while(count > 0 && ctx->locals[count - 1].depth > ctx->scopeDepth) count--;
+  popLocals(ctx, count);
+}
 
 // Adds a local variable given a [name]
-static void addLocal(pd_code_ctx* ctx, char* name) {
+static void addLocal(pd_code_ctx* ctx, char* name, size_t len) {
   if (ctx->localCount == 256) {
     error(ctx, "Too many local variables in function.");
     return;
   }
-  pd_compiler_local* local = &ctx->locals[ctx->localCount++];
+  int index = ctx->localCount++;
+  pd_compiler_local* local = &ctx->locals[index];
   local->name = name;
-  // TODO get length info from the parser.
-  local->len = strlen(name);
+  local->len = len;
   local->depth = -1;
   local->isCaptured = false;
+  local->implicit = false;
+  local->copyable = -1;
+  local->scope = ctx->body;
+  local->hash = pd_str_hash_bytes(name, len);
+  int16_t* bucket = &ctx->buckets[local->hash & (PD_LOCAL_BUCKETS - 1)];
+  local->next = *bucket;
+  *bucket = (int16_t)index;
 }
 
 // Checks if the two identifiers are equal.
@@ -134,36 +185,33 @@ static bool identifiersEqual(char* a, size_t alen, char* b, size_t blen) {
   return memcmp(a, b, alen) == 0;
 }
 
-// Resolves a local variable.
-static int resolveLocal(pd_code_ctx* ctx, char* name, size_t len) {
-  for(int i = ctx->localCount - 1; i >= 0; i--) {
+// Finds the newest local visible with [name] or returns -1, through the hash buckets so big functions don't scan every local.
+// Shadowed locals come later in the chain than the ones shadowing them so the first match is the right one.
+static int findLocal(pd_code_ctx* ctx, char* name, size_t len) {
+  uint32_t hash = pd_str_hash_bytes(name, len);
+  for(int i = ctx->buckets[hash & (PD_LOCAL_BUCKETS - 1)]; i != -1; i = ctx->locals[i].next) {
     pd_compiler_local* local = &ctx->locals[i];
-    if(identifiersEqual(name, len, local->name, local->len)) {
-      if (local->depth == -1) {
-        error(ctx, "Cannot read local variable in its own initializer.");
-      }
-      return i;
-    }
+    if(local->hash == hash && identifiersEqual(name, len, local->name, local->len)) return i;
   }
   return -1;
 }
 
-// Declares a local variable.
-static bool declareLocal(pd_code_ctx* ctx, char* name, size_t len) {
-  bool found = 0;
-  for(int i = ctx->localCount - 1; i >= 0; i--) {
-    pd_compiler_local* local = &ctx->locals[i];
-    if(local->depth != -1 && local->depth < ctx->scopeDepth) {
-      break;
-    }
-    
-    if(identifiersEqual(name, len, local->name, local->len)) {
-      found = true;
-      break;
-    }
+// Resolves a local variable.
+static int resolveLocal(pd_code_ctx* ctx, char* name, size_t len) {
+  int i = findLocal(ctx, name, len);
+  if(i != -1 && ctx->locals[i].depth == -1) {
+    error(ctx, "Cannot read local variable in its own initializer.");
   }
-  if(!found) addLocal(ctx, name);
-  return !found;
+  return i;
+}
+
+// Declares a local variable in the current block.
+// Returns false if there's a local with that name visible already, assigning to it then just sets it.
+// Locals of enclosing functions don't count, upvalues are read-only so assigning declares a new local instead.
+static bool declareLocal(pd_code_ctx* ctx, char* name, size_t len) {
+  if(findLocal(ctx, name, len) != -1) return false;
+  addLocal(ctx, name, len);
+  return true;
 }
 
 // Marks a variable initialized.
@@ -208,7 +256,7 @@ static void emitLoop(pd_code_ctx* ctx, int loopStart) {
   emitByte(ctx, (offset >> 8) & 0xff);
 }
 
-static int addUpvalue(pd_code_ctx* ctx, uint8_t index, bool isLocal) {
+static int addUpvalue(pd_code_ctx* ctx, uint8_t index, bool isLocal, bool copied) {
   int upvalueCount = ctx->function->upvalue_count;
   for(int i = 0; i < upvalueCount; i++) {
     pd_compiler_upvalue* upvalue = &ctx->upvalues[i];
@@ -224,35 +272,114 @@ static int addUpvalue(pd_code_ctx* ctx, uint8_t index, bool isLocal) {
 
   ctx->upvalues[upvalueCount].isLocal = isLocal;
   ctx->upvalues[upvalueCount].index = index;
+  ctx->upvalues[upvalueCount].copied = copied;
   return ctx->function->upvalue_count++;
 }
 
+// Counts the assignments and function declarations of [name] in [node], nested functions have their own locals so they are skipped.
+static int countAssignments(pd_ast_node* node, char* name, size_t len) {
+  if(node == NULL) return 0;
+  int count = 0;
+  switch(node->type) {
+    case PD_AST_ASSIGN:
+      if(identifiersEqual(name, len, node->assign.name, node->assign.len)) count++;
+      return count + countAssignments(node->assign.expr, name, len);
+    case PD_AST_FUNCTION: {
+      pd_ast_node* prototype = node->function.prototype;
+      return identifiersEqual(name, len, prototype->prototype.name, prototype->prototype.len);
+    }
+    case PD_AST_BLOCK:
+      for(int x = 0; x < node->block.count; x++)
+        count += countAssignments(node->block.statements[x], name, len);
+      return count;
+    case PD_AST_CONDITIONAL:
+    case PD_AST_TERNARY:
+      return countAssignments(node->conditional.condition, name, len) +
+        countAssignments(node->conditional.trueNode, name, len) +
+        countAssignments(node->conditional.falseNode, name, len);
+    case PD_AST_WHILE:
+      return countAssignments(node->while_loop.condition, name, len) + countAssignments(node->while_loop.body, name, len);
+    case PD_AST_FOR:
+      return countAssignments(node->for_loop.start, name, len) + countAssignments(node->for_loop.limit, name, len) +
+        countAssignments(node->for_loop.step, name, len) + countAssignments(node->for_loop.body, name, len);
+    case PD_AST_CALL:
+      count += countAssignments(node->call.callee, name, len);
+      for(int x = 0; x < node->call.argc; x++)
+        count += countAssignments(node->call.args[x], name, len);
+      return count;
+    case PD_AST_RETURN:
+      return countAssignments(node->ret.expr, name, len);
+    case PD_AST_BIN_OP:
+      return countAssignments(node->binop.lhs, name, len) + countAssignments(node->binop.rhs, name, len);
+    case PD_AST_UNARY:
+      return countAssignments(node->unary.rhs, name, len);
+    case PD_AST_ARRAY:
+      for(int x = 0; x < node->array.count; x++)
+        count += countAssignments(node->array.elements[x], name, len);
+      return count;
+    case PD_AST_DICT:
+      for(int x = 0; x < node->dict.count; x++)
+        count += countAssignments(node->dict.keys[x], name, len) + countAssignments(node->dict.values[x], name, len);
+      return count;
+    case PD_AST_INDEX:
+    case PD_AST_DELETE:
+      return countAssignments(node->index.expr, name, len) + countAssignments(node->index.index, name, len) +
+        countAssignments(node->index.value, name, len);
+    case PD_AST_PROPERTY:
+      return countAssignments(node->property.expr, name, len);
+    default:
+      return 0;
+  }
+}
+
+// A local that is never assigned after its declaration can't change once a closure sees it,
+// so closures copy its value instead of sharing it through an upvalue.
+// That's most of them, a callback given to map() or setTimeout() rarely writes what it reads,
+// and it saves allocating the upvalue, looking it up in the list of open ones and closing it.
+static bool isCopyable(pd_compiler_local* local) {
+  if(local->copyable == -1) {
+    // The scope is missing for locals of code given to the compiler without one, just share those.
+    int declarations = local->implicit ? 0 : 1;
+    local->copyable = local->scope != NULL && countAssignments(local->scope, local->name, local->len) == declarations;
+  }
+  return local->copyable;
+}
+
 static int resolveUpvalue(pd_code_ctx* ctx, char* name, size_t len) {
   if(ctx->enclosing == NULL) return -1;
   
   int local = resolveLocal(ctx->enclosing, name, len);
   if(local != -1) {
-    ctx->enclosing->locals[local].isCaptured = true;
-    return addUpvalue(ctx, (uint8_t)local, true);
+    bool copied = isCopyable(&ctx->enclosing->locals[local]);
+    // Copied ones don't need closing so their slot is just popped at the end of the scope.
+    if(!copied) ctx->enclosing->locals[local].isCaptured = true;
+    return addUpvalue(ctx, (uint8_t)local, true, copied);
   }
   int upvalue = resolveUpvalue(ctx->enclosing, name, len);
   if(upvalue != -1) {
-    return addUpvalue(ctx, (uint8_t)upvalue, false);
+    return addUpvalue(ctx, (uint8_t)upvalue, false, ctx->enclosing->upvalues[upvalue].copied);
   }
   return -1;                                                
 }
 
+static void emitGetUpvalue(pd_code_ctx* ctx, int index) {
+  emitBytes(ctx, ctx->upvalues[index].copied ? PVM_OP_GET_UPVALUE_COPY : PVM_OP_GET_UPVALUE, (uint8_t)index);
+}
+
 // Compiles a number node.
 void pd_compile_number(pd_code_ctx* ctx, pd_ast_node* node) {
   // Optimizing small numbers to be a single instruction.
   // This is also what JVM does.
-  // -1 is handled in unary compilation.
+  // -1 is also handled in unary compilation for when optimizations are off.
   double num = node->number.value;
   // TODO: Is there a cleaner way to do this check?
   // Before i used a switch case but after introducing float numbers
   // switch case does not allow doubles.
-  if(num == 0) {
+  // -0 == 0 so check the sign, otherwise a folded -0 would turn into a 0.
+  if(num == 0 && !signbit(num)) {
     emitByte(ctx, PVM_OP_PUSH_ZERO);
+  } else if(num == -1) {
+    emitByte(ctx, PVM_OP_PUSH_NEG_ONE);
   } else if(num == 1) {
     emitByte(ctx, PVM_OP_PUSH_ONE);
   } else if(num == 2) {
@@ -269,8 +396,7 @@ void pd_compile_number(pd_code_ctx* ctx, pd_ast_node* node) {
 }
 
 void pd_compile_string(pd_code_ctx* ctx, pd_ast_node* node) {
-  // TODO: store length in the node, find a way to get them on the parser side.
-  emitConstant(ctx, PD_FROM(pd_str_new(ctx->vm, node->string.value, strlen(node->string.value))));
+  emitConstant(ctx, pd_str_new(ctx->vm, node->string.value, node->string.len));
 }
 
 void pd_compile_boolean(pd_code_ctx* ctx, pd_ast_node* node) {
@@ -292,7 +418,10 @@ void pd_compile_bin_op(pd_code_ctx* ctx, pd_ast_node* node) {
   // Logical operators compile their operands manually.
   if(node->binop.op != PD_BIN_AND && node->binop.op != PD_BIN_OR) {
     pd_compile(ctx, node->binop.lhs);
+    // The lhs is on the stack while the rhs runs, matters for inlined parameters. (see pd_compile_variable())
+    ctx->inlineDepth++;
     pd_compile(ctx, node->binop.rhs);
+    ctx->inlineDepth--;
   }
 
   /*
@@ -404,13 +533,151 @@ void pd_compile_unary(pd_code_ctx* ctx, pd_ast_node* node) {
     case PD_UNARY_BNOT:
       emitByte(ctx, PVM_OP_BNOT);
       break;
+    case PD_UNARY_AWAIT:
+      // Only tasks have a stack of their own to suspend, the script and regular functions run on whatever called them.
+      if(!ctx->function->async) error(ctx, "Can only await inside async functions.");
+      emitByte(ctx, PVM_OP_AWAIT);
+      break;
   }
 }
 
+// Is [name] read anywhere in [node]? Functions declared in there count too, they read it through a closure.
+static bool isRead(pd_ast_node* node, char* name, size_t len) {
+  if(node == NULL) return false;
+  switch(node->type) {
+    case PD_AST_VARIABLE:
+      return identifiersEqual(name, len, node->variable.name, node->variable.len);
+    case PD_AST_ASSIGN:
+      return isRead(node->assign.expr, name, len);
+    case PD_AST_FUNCTION:
+      return isRead(node->function.body, name, len);
+    case PD_AST_BLOCK:
+      for(int x = 0; x < node->block.count; x++) {
+        if(isRead(node->block.statements[x], name, len)) return true;
+      }
+      return false;
+    case PD_AST_CONDITIONAL:
+    case PD_AST_TERNARY:
+      return isRead(node->conditional.condition, name, len) || isRead(node->conditional.trueNode, name, len) ||
+        isRead(node->conditional.falseNode, name, len);
+    case PD_AST_WHILE:
+      return isRead(node->while_loop.condition, name, len) || isRead(node->while_loop.body, name, len);
+    case PD_AST_FOR:
+      return isRead(node->for_loop.start, name, len) || isRead(node->for_loop.limit, name, len) ||
+        isRead(node->for_loop.step, name, len) || isRead(node->for_loop.body, name, len);
+    case PD_AST_CALL:
+      if(node->call.callee == NULL && identifiersEqual(name, len, node->call.name, node->call.len)) return true;
+      if(isRead(node->call.callee, name, len)) return true;
+      for(int x = 0; x < node->call.argc; x++) {
+        if(isRead(node->call.args[x], name, len)) return true;
+      }
+      return false;
+    case PD_AST_RETURN:
+      return isRead(node->ret.expr, name, len);
+    case PD_AST_BIN_OP:
+      return isRead(node->binop.lhs, name, len) || isRead(node->binop.rhs, name, len);
+    case PD_AST_UNARY:
+      return isRead(node->unary.rhs, name, len);
+    case PD_AST_ARRAY:
+      for(int x = 0; x < node->array.count; x++) {
+        if(isRead(node->array.elements[x], name, len)) return true;
+      }
+      return false;
+    case PD_AST_DICT:
+      for(int x = 0; x < node->dict.count; x++) {
+        if(isRead(node->dict.keys[x], name, len) || isRead(node->dict.values[x], name, len)) return true;
+      }
+      return false;
+    case PD_AST_INDEX:
+    case PD_AST_DELETE:
+      return isRead(node->index.expr, name, len) || isRead(node->index.index, name, len) || isRead(node->index.value, name, len);
+    case PD_AST_PROPERTY:
+      return isRead(node->property.expr, name, len);
+    default:
+      return false;
+  }
+}
+
+// Declares [name] as null before the block about to be compiled if it's not a local yet and one of the [count] statements
+// after the block reads it.
+static void hoistLocal(pd_code_ctx* ctx, char* name, size_t len, pd_ast_node** after, int count) {
+  if(findLocal(ctx, name, len) != -1) return;
+  for(int x = 0; x < count; x++) {
+    if(!isRead(after[x], name, len)) continue;
+    emitByte(ctx, PVM_OP_NULL);
+    addLocal(ctx, name, len);
+    ctx->locals[ctx->localCount - 1].depth = ctx->scopeDepth;
+    // The null doesn't count as an assignment, the one in the block does. (see isCopyable())
+    ctx->locals[ctx->localCount - 1].implicit = true;
+    return;
+  }
+}
+
+// Locals assigned in a block only live until its end, so the ones first assigned in a block and read after it
+// are declared in the enclosing scope before it instead. e.g y here, which either branch may assign:
+//
+//   if c
+//     y = 1
+//   else
+//     y = 2
+//   end
+//   return y
+//
+// The rest keep their slots to themselves and those get reused after the block.
+// [node] is the if, while, for or do block statement about to be compiled and [after] the statements that follow it.
+static void hoistLocals(pd_code_ctx* ctx, pd_ast_node* node, pd_ast_node** after, int count) {
+  if(node == NULL) return;
+  switch(node->type) {
+    case PD_AST_ASSIGN:
+      hoistLocal(ctx, node->assign.name, node->assign.len, after, count);
+      break;
+    case PD_AST_FUNCTION: {
+      pd_ast_node* prototype = node->function.prototype;
+      hoistLocal(ctx, prototype->prototype.name, prototype->prototype.len, after, count);
+      break;
+    }
+    case PD_AST_BLOCK:
+      for(int x = 0; x < node->block.count; x++)
+        hoistLocals(ctx, node->block.statements[x], after, count);
+      break;
+    case PD_AST_CONDITIONAL:
+      hoistLocals(ctx, node->conditional.trueNode, after, count);
+      hoistLocals(ctx, node->conditional.falseNode, after, count);
+      break;
+    case PD_AST_WHILE:
+      hoistLocals(ctx, node->while_loop.body, after, count);
+      break;
+    case PD_AST_FOR:
+      hoistLocals(ctx, node->for_loop.body, after, count);
+      break;
+    default:
+      break;
+  }
+}
+
+// Compiles the body of an if, while or do block in its own scope when inside a function.
+static void compileScoped(pd_code_ctx* ctx, pd_ast_node* node) {
+  if(ctx->scopeDepth == 0) {
+    pd_compile(ctx, node);
+    return;
+  }
+  beginScope(ctx);
+  pd_compile(ctx, node);
+  endScope(ctx);
+}
+
 void pd_compile_block(pd_code_ctx* ctx, pd_ast_node* block) {
   for(int x = 0; x < block->block.count; x++) {
     pd_ast_node* node = block->block.statements[x];
-    pd_compile(ctx, node);
+    if(ctx->scopeDepth > 0 && (node->type == PD_AST_BLOCK || node->type == PD_AST_CONDITIONAL ||
+        node->type == PD_AST_WHILE || node->type == PD_AST_FOR)) {
+      hoistLocals(ctx, node, block->block.statements + x + 1, block->block.count - x - 1);
+    }
+    // A block inside a block is a do block.
+    if(node->type == PD_AST_BLOCK)
+      compileScoped(ctx, node);
+    else
+      pd_compile(ctx, node);
 
     // If we compiled an expression statement, pop it after
     // This expressions are expressions that we don't need the results but only the side effects they do, such as
@@ -420,52 +687,76 @@ void pd_compile_block(pd_code_ctx* ctx, pd_ast_node* block) {
   }
 }
 
-// TODO store length of strings in the node themselves from the information we get at lex time.
 void pd_compile_assign(pd_code_ctx* ctx, pd_ast_node* node) {
   pd_compile(ctx, node->assign.expr);
   if(ctx->scopeDepth > 0) {
     // handle locals.
-    if(declareLocal(ctx, node->assign.name, strlen(node->assign.name))) {
+    if(declareLocal(ctx, node->assign.name, node->assign.len)) {
       markInitialized(ctx);
       ctx->nopop = 1;
       return;
     }
-    int arg = resolveLocal(ctx, node->assign.name, strlen(node->assign.name));
+    int arg = resolveLocal(ctx, node->assign.name, node->assign.len);
     pd_assert(arg != -1, "Should never be -1");
     emitBytes(ctx, PVM_OP_SET_LOCAL, (uint8_t)arg);
     return;
   }
+  // Assigning to a for loop variable at the top-level.
+  int arg = resolveLocal(ctx, node->assign.name, node->assign.len);
+  if(arg != -1) {
+    emitBytes(ctx, PVM_OP_SET_LOCAL, (uint8_t)arg);
+    return;
+  }
   // handle globals
-  emitBytes(ctx, PVM_OP_SET_GLOBAL, identifierConstant(ctx, node->assign.name, strlen(node->assign.name)));
+  emitSetGlobal(ctx, identifierConstant(ctx, node->assign.name, node->assign.len));
 }
 
 void pd_compile_variable(pd_code_ctx* ctx, pd_ast_node* node) {
-  if(ctx->scopeDepth > 0) {
-    // handle locals.
-    int arg = resolveLocal(ctx, node->variable.name, strlen(node->variable.name));
-    if(arg != -1) {
-      emitBytes(ctx, PVM_OP_GET_LOCAL, (uint8_t)arg);
-      return;
-    } else if((arg = resolveUpvalue(ctx, node->variable.name, strlen(node->variable.name))) != -1) {
-      emitBytes(ctx, PVM_OP_GET_UPVALUE, (uint8_t)arg);
+  if(ctx->inlined != NULL) {
+    // Inlined code only sees the parameters, anything else is a global like it is in the function it came from.
+    pd_inline_call* call = ctx->inlined;
+    pd_ast_node* prototype = call->function->function.prototype;
+    for(int x = prototype->prototype.argc - 1; x >= 0; x--) {
+      pd_ast_text arg = prototype->prototype.args[x];
+      if(!identifiersEqual(node->variable.name, node->variable.len, arg.chars, arg.len)) continue;
+      if(call->depth[x] == -1) {
+        ctx->inlined = NULL;
+        pd_compile(ctx, call->args[x]);
+        ctx->inlined = call;
+      } else {
+        emitBytes(ctx, PVM_OP_PEEK, (uint8_t)(call->depth[x] + ctx->inlineDepth));
+      }
       return;
     }
+    emitGetGlobal(ctx, node->variable.name, node->variable.len);
+    return;
+  }
+  // Locals are checked even at the top-level since for loop variables are locals there too.
+  int arg = resolveLocal(ctx, node->variable.name, node->variable.len);
+  if(arg != -1) {
+    emitBytes(ctx, PVM_OP_GET_LOCAL, (uint8_t)arg);
+    return;
+  } else if(ctx->scopeDepth > 0 && (arg = resolveUpvalue(ctx, node->variable.name, node->variable.len)) != -1) {
+    emitGetUpvalue(ctx, arg);
+    return;
   }
   // handle globals.
-  emitBytes(ctx, PVM_OP_GET_GLOBAL, identifierConstant(ctx, node->variable.name, strlen(node->variable.name)));
+  emitGetGlobal(ctx, node->variable.name, node->variable.len);
 }
 
 void pd_compile_conditional(pd_code_ctx* ctx, pd_ast_node* node) {
   // compile the condition
   pd_compile(ctx, node->conditional.condition);
   int then = emitJump(ctx, PVM_OP_JUMP_IF_FALSE);
-  pd_compile(ctx, node->conditional.trueNode);
+  // The branches of a ternary are expressions, only if statements have blocks.
+  void (*compileBranch)(pd_code_ctx*, pd_ast_node*) = node->type == PD_AST_CONDITIONAL ? compileScoped : pd_compile;
+  compileBranch(ctx, node->conditional.trueNode);
   int elseJump;
   if(node->conditional.falseNode != NULL) elseJump = emitJump(ctx, PVM_OP_JUMP);
   patchJump(ctx, then);
 
   if(node->conditional.falseNode != NULL) { // else clause is optional.
-    pd_compile(ctx, node->conditional.falseNode);
+    compileBranch(ctx, node->conditional.falseNode);
     patchJump(ctx, elseJump);
   }
 }
@@ -475,75 +766,327 @@ void pd_compile_while(pd_code_ctx* ctx, pd_ast_node* node) {
   pd_compile(ctx, node->while_loop.condition);
   
   int exitJump = emitJump(ctx, PVM_OP_JUMP_IF_FALSE);
-  if(node->while_loop.body != NULL) pd_compile(ctx, node->while_loop.body);
+  // Locals declared in the body only live for one iteration.
+  if(node->while_loop.body != NULL) compileScoped(ctx, node->while_loop.body);
   emitLoop(ctx, loopStart);
   patchJump(ctx, exitJump);
 }
 
-void pd_compile_function(pd_code_ctx* ctx, pd_ast_node* node) {
-  uint8_t global = 0;
-  // this is awful
-  char* name = node->function.prototype->prototype.name;
-  size_t len = strlen(name);
-  if(ctx->scopeDepth > 0)
-    declareLocal(ctx, name, len);
+// Adds one of the slots used by a for loop as an already initialized local.
+static void addLoopLocal(pd_code_ctx* ctx, char* name, size_t len) {
+  addLocal(ctx, name, len);
+  ctx->locals[ctx->localCount - 1].depth = ctx->scopeDepth;
+  ctx->locals[ctx->localCount - 1].implicit = true;
+}
+
+// Numeric for loops, like Lua's.
+// The counter, limit and step live in hidden local slots followed by the loop variable
+// then FOR_PREP/FOR_LOOP do the checking, stepping and jumping so each iteration only costs a single extra dispatch
+// compared to the ~10 a while loop with a manual counter needs.
+// These are locals even at the top-level, pd_compile_variable() checks locals first for that reason.
+void pd_compile_for(pd_code_ctx* ctx, pd_ast_node* node) {
+  int base = ctx->localCount;
+  if(base + 4 > 256) {
+    error(ctx, "Too many local variables in function.");
+    return;
+  }
+  pd_compile(ctx, node->for_loop.start);
+  pd_compile(ctx, node->for_loop.limit);
+  if(node->for_loop.step != NULL)
+    pd_compile(ctx, node->for_loop.step);
   else
-    global = identifierConstant(ctx, name, len);
-  markInitialized(ctx);
+    emitByte(ctx, PVM_OP_PUSH_ONE);
+  ctx->line = node->line;
+  pd_ast_node* body = ctx->body;
+  ctx->body = node;
 
-  pd_code_ctx fnctx;
-  pd_compile_ctx_init(&fnctx, ctx->vm, PD_TYPE_FUNCTION);
-  fnctx.enclosing = ctx;
-  fnctx.function->name = PD_AS_STRING(pd_str_new(ctx->vm, name, len));
+  // Empty names can never be resolved so the hidden slots aren't accessible by the user.
+  addLoopLocal(ctx, "", 0);
+  addLoopLocal(ctx, "", 0);
+  addLoopLocal(ctx, "", 0);
+  emitBytes(ctx, PVM_OP_FOR_PREP, (uint8_t)base);
+  emitBytes(ctx, 0xff, 0xff);
+  int exitJump = currentChunk(ctx)->count - 2;
+  addLoopLocal(ctx, node->for_loop.name, node->for_loop.len);
+
+  int bodyStart = currentChunk(ctx)->count;
+  pd_compile(ctx, node->for_loop.body);
+  // Locals declared in the body only live for one iteration.
+  popLocals(ctx, base + 4);
+
+  ctx->line = node->line;
+  emitBytes(ctx, PVM_OP_FOR_LOOP, (uint8_t)base);
+  int offset = currentChunk(ctx)->count - bodyStart + 2;
+  if(offset > UINT16_MAX) error(ctx, "Loop body too large.");
+  emitBytes(ctx, offset & 0xff, (offset >> 8) & 0xff);
+  patchJump(ctx, exitJump);
+  popLocals(ctx, base);
+  ctx->body = body;
+}
+
+// Compiles the parameters and body of a function [node] into [fnctx]
+static void compileFunctionBody(pd_code_ctx* fnctx, pd_ast_node* node) {
   // Init ctx is built with top-level block in mind so scope is actually -1, begin two scopes to fix it.
   // TODO: We have access to fn type in init avoid the hack if we are making a function ctx.
-  beginScope(&fnctx);
-  // beginScope(&fnctx);
+  beginScope(fnctx);
+  // beginScope(fnctx);
   // Compile the parameter list.                                
   /* consume(TOKEN_LEFT_PAREN, "Expect '(' after function name."); */
   if(node->function.prototype->prototype.argc > 255)
-    error(&fnctx, "Cannot have more than 255 parameters.");
+    error(fnctx, "Cannot have more than 255 parameters.");
+  fnctx->function->arity = 0;
+  fnctx->body = node->function.body;
   for(int x = 0; x < node->function.prototype->prototype.argc; x++) {
-    char* name = node->function.prototype->prototype.args[x];
-    fnctx.function->arity++;
-    if(declareLocal(&fnctx, name, strlen(name)))
-      markInitialized(&fnctx);
+    pd_ast_text arg = node->function.prototype->prototype.args[x];
+    fnctx->function->arity++;
+    // Every parameter needs its slot, a repeated name just shadows the earlier one.
+    addLocal(fnctx, arg.chars, arg.len);
+    fnctx->locals[fnctx->localCount - 1].implicit = true;
+    markInitialized(fnctx);
+  }
+  //fnctx->scopeDepth -= 1; // hack, cuz compiling body starts a new scope which gets us out of the current one we made here.
+  pd_compile(fnctx, node->function.body);
+}
+
+// Functions declared where there is nothing they could capture are compiled lazily, see pd_compile_lazy()
+// That's the script itself outside of for loops (the only locals it has) which is where libraries define pretty much everything.
+// Anything nested in other functions is compiled along with them since resolving its upvalues
+// marks locals of the enclosing function as captured which changes the code emitted for it.
+static bool canCompileLazily(pd_code_ctx* ctx) {
+  return ctx->arena != NULL && ctx->type == PD_TYPE_SCRIPT && ctx->localCount == 1;
+}
+
+// Emits the closure for a lazy function, the function keeps its node and the arena it lives in alive.
+static pd_function* lazyFunction(pd_code_ctx* ctx, pd_ast_node* node, char* name, size_t len) {
+  pd_function* function = pd_function_new(ctx->vm);
+  pvm_push(ctx->vm, PD_FROM(function));
+  function->name = pd_str_intern(ctx->vm, name, len);
+  function->arity = node->function.prototype->prototype.argc;
+  function->inline_hash = node->function.inline_hash;
+  function->async = node->function.async;
+  function->ast = node;
+  function->arena = ctx->arena;
+  pd_arena_retain(ctx->arena);
+  emitIndexed(ctx, PVM_OP_CLOSURE, PVM_OP_CLOSURE_LONG, makeConstant(ctx, PD_FROM(function)));
+  pvm_pop(ctx->vm);
+  return function;
+}
+
+void pd_compile_function(pd_code_ctx* ctx, pd_ast_node* node) {
+  uint16_t global = 0;
+  int existing = -1; // local the function is assigned to if one with its name is already visible.
+  // this is awful
+  char* name = node->function.prototype->prototype.name;
+  size_t len = node->function.prototype->prototype.len;
+  if(ctx->scopeDepth > 0) {
+    if(declareLocal(ctx, name, len))
+      markInitialized(ctx);
+    else
+      existing = findLocal(ctx, name, len);
+  } else {
+    global = identifierConstant(ctx, name, len);
   }
-  //fnctx.scopeDepth -= 1; // hack, cuz compiling body starts a new scope which gets us out of the current one we made here.
-  pd_compile(&fnctx, node->function.body);
+
+  if(canCompileLazily(ctx)) {
+    lazyFunction(ctx, node, name, len);
+    emitSetGlobal(ctx, global);
+    emitByte(ctx, PVM_OP_POP);
+    return;
+  }
+
+  pd_code_ctx fnctx;
+  pd_compile_ctx_init(&fnctx, ctx->vm, PD_TYPE_FUNCTION);
+  fnctx.enclosing = ctx;
+  fnctx.quiet = ctx->quiet;
+  fnctx.function->name = pd_str_intern(ctx->vm, name, len);
+  fnctx.function->inline_hash = node->function.inline_hash;
+  fnctx.function->async = node->function.async;
+  compileFunctionBody(&fnctx, node);
   
   // Create the function object.
   pd_function* function = pd_compile_ctx_end(&fnctx);
   ctx->errors += fnctx.errors; // We want to keep track of all nested context errors in the top-most one.
-  emitBytes(ctx, PVM_OP_CLOSURE, makeConstant(ctx, PD_FROM(function)));
+  emitIndexed(ctx, PVM_OP_CLOSURE, PVM_OP_CLOSURE_LONG, makeConstant(ctx, PD_FROM(function)));
   for(int i = 0; i < function->upvalue_count; i++) {
-    emitByte(ctx, fnctx.upvalues[i].isLocal ? 1 : 0);
+    // See OP_CLOSURE for the kinds.
+    emitByte(ctx, !fnctx.upvalues[i].isLocal ? 0 : fnctx.upvalues[i].copied ? 2 : 1);
     emitByte(ctx, fnctx.upvalues[i].index);
   }
   if(ctx->scopeDepth == 0) {
-    emitBytes(ctx, PVM_OP_SET_GLOBAL, global);
+    emitSetGlobal(ctx, global);
     // On globals the results shouldn't stay on the stack, we are manually creating the variable so we have to pop ourselves
     // if it was a regular var assignment the compiler already pops temporaries.
     emitByte(ctx, PVM_OP_POP);
+  } else if(existing != -1) {
+    emitBytes(ctx, PVM_OP_SET_LOCAL, (uint8_t)existing);
+    emitByte(ctx, PVM_OP_POP);
+  }
+}
+
+// Is [name] a local here or in any of the enclosing functions?
+static bool isLocalName(pd_code_ctx* ctx, char* name, size_t len) {
+  for(; ctx != NULL; ctx = ctx->enclosing) {
+    if(findLocal(ctx, name, len) != -1) return true;
+  }
+  return false;
+}
+
+// Does the expression [node] assign a variable anywhere in it?
+static bool hasAssignment(pd_ast_node* node) {
+  if(node == NULL) return false;
+  switch(node->type) {
+    case PD_AST_ASSIGN:
+      return true;
+    case PD_AST_CALL:
+      if(hasAssignment(node->call.callee)) return true;
+      for(int x = 0; x < node->call.argc; x++) {
+        if(hasAssignment(node->call.args[x])) return true;
+      }
+      return false;
+    case PD_AST_CONDITIONAL:
+    case PD_AST_TERNARY:
+      return hasAssignment(node->conditional.condition) || hasAssignment(node->conditional.trueNode) ||
+        hasAssignment(node->conditional.falseNode);
+    case PD_AST_BIN_OP:
+      return hasAssignment(node->binop.lhs) || hasAssignment(node->binop.rhs);
+    case PD_AST_UNARY:
+      return hasAssignment(node->unary.rhs);
+    case PD_AST_ARRAY:
+      for(int x = 0; x < node->array.count; x++) {
+        if(hasAssignment(node->array.elements[x])) return true;
+      }
+      return false;
+    case PD_AST_DICT:
+      for(int x = 0; x < node->dict.count; x++) {
+        if(hasAssignment(node->dict.keys[x]) || hasAssignment(node->dict.values[x])) return true;
+      }
+      return false;
+    case PD_AST_INDEX:
+    case PD_AST_DELETE:
+      return hasAssignment(node->index.expr) || hasAssignment(node->index.index) || hasAssignment(node->index.value);
+    case PD_AST_PROPERTY:
+      return hasAssignment(node->property.expr);
+    default:
+      return false;
+  }
+}
+
+// Checks if the call [node] is compiled inline, it must have been bound to a function by pd_optimize_inline()
+// and its name must still refer to the global, a local or upvalue with the same name is something else.
+static bool canInline(pd_code_ctx* ctx, pd_ast_node* node) {
+  if(node->call.inlined == NULL || isLocalName(ctx, node->call.name, node->call.len)) return false;
+  // Plain arguments are read where the parameter is used, after the arguments that come later
+  // so none of them may assign anything. (an assignment as the argument itself also declares a local)
+  for(int x = 0; x < node->call.argc; x++) {
+    if(hasAssignment(node->call.args[x])) return false;
+  }
+  return true;
+}
+
+// Arguments that are constants or locals are used as they are wherever the parameter is read,
+// evaluating them has no side effects so it doesn't matter how many times that happens.
+static bool isPlainArgument(pd_code_ctx* ctx, pd_ast_node* node) {
+  switch(node->type) {
+    case PD_AST_NUMBER:
+    case PD_AST_STRING:
+    case PD_AST_BOOLEAN:
+    case PD_AST_NULL:
+      return true;
+    case PD_AST_VARIABLE: {
+      int local = findLocal(ctx, node->variable.name, node->variable.len);
+      return local != -1 && ctx->locals[local].depth != -1;
+    }
+    default:
+      return false;
   }
 }
 
+// Compiles a call to a small function as the expression it returns, see pd_optimize_inline()
+// The other arguments stay on the stack where a call would have them and the expression reads its parameters
+// from there instead of going through a new frame. The global is checked before running it in case it was changed
+// by code compiled separately, then it's called like usual:
+//
+//   <arguments>
+//   INLINE_GUARD <global> <hash> -> inlined
+//   GET_GLOBAL <global>
+//   PEEK <distance> (for each argument, copies them above the function)
+//   CALL <argc>
+//   JUMP -> end
+// inlined:
+//   <expression>
+// end:
+//   POP_UNDER <arguments>
+static void compileInlined(pd_code_ctx* ctx, pd_ast_node* node) {
+  pd_ast_node* function = node->call.inlined;
+  pd_ast_node* expr = function->function.body->block.statements[0]->ret.expr;
+  int argc = node->call.argc;
+  pd_inline_call call;
+  call.function = function;
+  call.args = node->call.args;
+
+  int pushed = 0;
+  for(int x = 0; x < argc; x++) {
+    if(isPlainArgument(ctx, node->call.args[x])) {
+      call.depth[x] = -1;
+    } else {
+      pd_compile(ctx, node->call.args[x]);
+      call.depth[x] = pushed++;
+    }
+  }
+  // Distance from the top once they're all pushed.
+  for(int x = 0; x < argc; x++) {
+    if(call.depth[x] != -1) call.depth[x] = pushed - 1 - call.depth[x];
+  }
+
+  ctx->line = node->line;
+  uint16_t global = identifierConstant(ctx, node->call.name, node->call.len);
+  uint64_t hash = function->function.inline_hash;
+  emitByte(ctx, PVM_OP_INLINE_GUARD);
+  emitBytes(ctx, global & 0xff, (global >> 8) & 0xff);
+  for(int x = 0; x < 8; x++) emitByte(ctx, (hash >> (x * 8)) & 0xff);
+  emitBytes(ctx, 0xff, 0xff);
+  int inlinedJump = currentChunk(ctx)->count - 2;
+
+  emitIndexed(ctx, PVM_OP_GET_GLOBAL, PVM_OP_GET_GLOBAL_LONG, global);
+  for(int x = 0; x < argc; x++) {
+    // The function and the x arguments before this one are above the pushed ones now.
+    if(call.depth[x] == -1)
+      pd_compile(ctx, node->call.args[x]);
+    else
+      emitBytes(ctx, PVM_OP_PEEK, (uint8_t)(call.depth[x] + 1 + x));
+  }
+  ctx->line = node->line;
+  emitBytes(ctx, PVM_OP_CALL, argc);
+  int endJump = emitJump(ctx, PVM_OP_JUMP);
+
+  // Errors in the expression are reported on the line of the call. (see pd_compile())
+  // The expression has no calls in it so this never nests.
+  patchJump(ctx, inlinedJump);
+  ctx->inlined = &call;
+  ctx->inlineDepth = 0;
+  pd_compile(ctx, expr);
+  ctx->inlined = NULL;
+  patchJump(ctx, endJump);
+
+  if(pushed > 0) emitBytes(ctx, PVM_OP_POP_UNDER, pushed);
+}
+
 void pd_compile_call(pd_code_ctx* ctx, pd_ast_node* node) {
+  if(canInline(ctx, node)) {
+    compileInlined(ctx, node);
+    return;
+  }
   // We are duplicating the code inside compile var, this is bad practice, we will need to do a huge cleanup sometimes
   // but for now we'll say "it works so don't touch it"
-  if(ctx->scopeDepth > 0) {
-    // handle locals.
-    int arg = resolveLocal(ctx, node->call.name, strlen(node->call.name));
-    if(arg != -1)
-      emitBytes(ctx, PVM_OP_GET_LOCAL, (uint8_t)arg);
-    else if((arg = resolveUpvalue(ctx, node->call.name, strlen(node->call.name))) != -1)
-      emitBytes(ctx, PVM_OP_GET_UPVALUE, (uint8_t)arg);
-    else // try globals
-      emitBytes(ctx, PVM_OP_GET_GLOBAL, identifierConstant(ctx, node->call.name, strlen(node->call.name)));
-  } else {
-    // handle globals.
-    emitBytes(ctx, PVM_OP_GET_GLOBAL, identifierConstant(ctx, node->variable.name, strlen(node->variable.name)));
-  }
+  int arg;
+  if(node->call.callee != NULL) // x.name(args), the property gives the function.
+    pd_compile(ctx, node->call.callee);
+  else if((arg = resolveLocal(ctx, node->call.name, node->call.len)) != -1)
+    emitBytes(ctx, PVM_OP_GET_LOCAL, (uint8_t)arg);
+  else if(ctx->scopeDepth > 0 && (arg = resolveUpvalue(ctx, node->call.name, node->call.len)) != -1)
+    emitGetUpvalue(ctx, arg);
+  else // try globals
+    emitGetGlobal(ctx, node->call.name, node->call.len);
   if(node->call.argc > 255) error(ctx, "Cannot have more than 255 arguments.");
   for(int x = 0; x < node->call.argc; x++)
     pd_compile(ctx, node->call.args[x]);
@@ -557,6 +1100,12 @@ void pd_compile_return(pd_code_ctx* ctx, pd_ast_node* node) {
 
   if(node->ret.expr == NULL) {
     emitReturn(ctx);
+  } else if(node->ret.expr->type == PD_AST_CALL && ctx->type == PD_TYPE_FUNCTION && !canInline(ctx, node->ret.expr)) {
+    // return f(args) is a tail call, the current frame is reused so deep tail recursion doesn't overflow.
+    // The call is compiled as usual then the CALL is patched into a TAIL_CALL.
+    pd_compile(ctx, node->ret.expr);
+    currentChunk(ctx)->code[currentChunk(ctx)->count - 2] = PVM_OP_TAIL_CALL;
+    emitByte(ctx, PVM_OP_RETURN);
   } else {
     pd_compile(ctx, node->ret.expr);
     emitByte(ctx, PVM_OP_RETURN);
@@ -565,9 +1114,67 @@ void pd_compile_return(pd_code_ctx* ctx, pd_ast_node* node) {
 
 void pd_compile_class(pd_code_ctx* ctx, pd_ast_node* node) {}
 
+// Array literals push all the elements and then collect them in a single instruction.
+void pd_compile_array(pd_code_ctx* ctx, pd_ast_node* node) {
+  int count = node->array.count;
+  if(count > UINT16_MAX) error(ctx, "Cannot have more than %d elements in an array literal.", UINT16_MAX);
+  for(int x = 0; x < count; x++)
+    pd_compile(ctx, node->array.elements[x]);
+  emitByte(ctx, PVM_OP_ARRAY);
+  emitBytes(ctx, count & 0xff, (count >> 8) & 0xff);
+}
+
+// Dictionary literals push key/value pairs and then collect them in a single instruction like arrays.
+void pd_compile_dict(pd_code_ctx* ctx, pd_ast_node* node) {
+  int count = node->dict.count;
+  if(count > UINT16_MAX) error(ctx, "Cannot have more than %d entries in a dictionary literal.", UINT16_MAX);
+  for(int x = 0; x < count; x++) {
+    pd_compile(ctx, node->dict.keys[x]);
+    pd_compile(ctx, node->dict.values[x]);
+  }
+  emitByte(ctx, PVM_OP_DICT);
+  emitBytes(ctx, count & 0xff, (count >> 8) & 0xff);
+}
+
+void pd_compile_delete(pd_code_ctx* ctx, pd_ast_node* node) {
+  pd_compile(ctx, node->index.expr);
+  pd_compile(ctx, node->index.index);
+  emitByte(ctx, PVM_OP_DELETE_INDEX);
+}
+
+void pd_compile_index(pd_code_ctx* ctx, pd_ast_node* node) {
+  pd_compile(ctx, node->index.expr);
+  ctx->inlineDepth++;
+  pd_compile(ctx, node->index.index);
+  ctx->inlineDepth--;
+  if(node->index.value != NULL) {
+    pd_compile(ctx, node->index.value);
+    emitByte(ctx, PVM_OP_SET_INDEX);
+  } else {
+    emitByte(ctx, PVM_OP_GET_INDEX);
+  }
+}
+
+// Emits an instruction with a string constant operand, always 2 bytes.
+static void emitNamed(pd_code_ctx* ctx, uint8_t op, char* name, int len) {
+  uint16_t constant = makeConstant(ctx, pd_str_new(ctx->vm, name, len));
+  emitByte(ctx, op);
+  emitBytes(ctx, constant & 0xFF, (constant >> 8) & 0xFF);
+}
+
+void pd_compile_property(pd_code_ctx* ctx, pd_ast_node* node) {
+  pd_compile(ctx, node->property.expr);
+  pd_ast_node* ident = node->property.ident;
+  emitNamed(ctx, PVM_OP_GET_PROPERTY, ident->variable.name, ident->variable.len);
+}
+
+void pd_compile_import(pd_code_ctx* ctx, pd_ast_node* node) {
+  emitNamed(ctx, PVM_OP_IMPORT, node->import.name, node->import.len);
+}
+
 void pd_compile(pd_code_ctx* ctx, pd_ast_node* node) {
   if(node == NULL) return;
-  ctx->line = node->line;
+  if(ctx->inlined == NULL) ctx->line = node->line;
   switch(node->type) {
     case PD_AST_CLASS:
       pd_compile_class(ctx, node);
@@ -577,6 +1184,9 @@ void pd_compile(pd_code_ctx* ctx, pd_ast_node* node) {
     case PD_AST_WHILE:
       pd_compile_while(ctx, node);
       break;
+    case PD_AST_FOR:
+      pd_compile_for(ctx, node);
+      break;
     case PD_AST_NUMBER:
       pd_compile_number(ctx, node);
       break;
@@ -603,9 +1213,7 @@ void pd_compile(pd_code_ctx* ctx, pd_ast_node* node) {
       pd_compile_unary(ctx, node);
       break;
     case PD_AST_BLOCK:
-      //beginScope(ctx);
       pd_compile_block(ctx, node);
-      //endScope(ctx);
       break;
     case PD_AST_RETURN:
       pd_compile_return(ctx, node);
@@ -619,6 +1227,24 @@ void pd_compile(pd_code_ctx* ctx, pd_ast_node* node) {
     case PD_AST_VARIABLE:
       pd_compile_variable(ctx, node);
       break;
+    case PD_AST_ARRAY:
+      pd_compile_array(ctx, node);
+      break;
+    case PD_AST_INDEX:
+      pd_compile_index(ctx, node);
+      break;
+    case PD_AST_DICT:
+      pd_compile_dict(ctx, node);
+      break;
+    case PD_AST_DELETE:
+      pd_compile_delete(ctx, node);
+      break;
+    case PD_AST_PROPERTY:
+      pd_compile_property(ctx, node);
+      break;
+    case PD_AST_IMPORT:
+      pd_compile_import(ctx, node);
+      break;
     default:
       pd_unreachable();
   }
@@ -628,8 +1254,10 @@ void pd_compile(pd_code_ctx* ctx, pd_ast_node* node) {
 void pd_compile_ctx_init(pd_code_ctx* ctx, pvm_t* vm, pd_function_type type) {
   ctx->enclosing = NULL;
   ctx->vm = vm;
+  // The function is allocated while the enclosing compiler is still the one the GC sees
+  // this one doesn't know its enclosing compiler yet so the outer functions wouldn't be marked.
+  ctx->function = pd_function_new(vm);
   ctx->vm->compiler = ctx;
-  ctx->function = NULL;
   ctx->type = type;
   ctx->line = 0;
   ctx->localCount = 0;
@@ -637,14 +1265,17 @@ void pd_compile_ctx_init(pd_code_ctx* ctx, pvm_t* vm, pd_function_type type) {
   // To fix this we make it -1 and when the top level block is compiling it would make it 0
   ctx->scopeDepth = 0 /*-1*/;
   ctx->errors = 0;
+  ctx->quiet = false;
   ctx->nopop = 0;
-  ctx->function = pd_function_new(vm);
+  ctx->inlined = NULL;
+  ctx->inlineDepth = 0;
+  ctx->arena = NULL;
+  ctx->body = NULL;
+  memset(ctx->buckets, 0xff, sizeof(ctx->buckets)); // all -1
 
-  pd_compiler_local* local = &ctx->locals[ctx->localCount++];
-  local->depth = 0;
-  local->name = "";
-  local->len = 0;
-  local->isCaptured = false;
+  // Slot 0 is the function being called.
+  addLocal(ctx, "", 0);
+  ctx->locals[0].depth = 0;
 }
 
 // End compilation.
@@ -652,9 +1283,35 @@ void pd_compile_ctx_init(pd_code_ctx* ctx, pvm_t* vm, pd_function_type type) {
 pd_function* pd_compile_ctx_end(pd_code_ctx* ctx) {
   ctx->line = 0;
   emitReturn(ctx); // Add the implicit return, this will be written using line 0 as it's an internally inserted code.
+  pd_optimize_chunk(currentChunk(ctx));
   pd_function* fn = ctx->function;
   // Now is also a good time to disassemble the function.
   //pvm_disassemble_chunk(currentChunk(ctx), fn->name != NULL ? fn->name->bytes : "<script>");
-  if(ctx->enclosing != NULL) ctx->vm->compiler = ctx->enclosing;
+  ctx->vm->compiler = ctx->enclosing;
   return fn;
 }
+
+bool pd_compile_lazy(pvm_t* vm, pd_function* function, bool quiet) {
+  pd_ast_node* node = function->ast;
+  // Compilers only nest at compile time, this always runs from the VM.
+  pd_code_ctx* previous = vm->compiler;
+  pd_code_ctx fnctx;
+  pd_compile_ctx_init(&fnctx, vm, PD_TYPE_FUNCTION);
+  // Compile straight into the function, closures of it already exist.
+  // The one init allocated is garbage now.
+  fnctx.function = function;
+  fnctx.quiet = quiet;
+  function->ast = NULL;
+  compileFunctionBody(&fnctx, node);
+  pd_compile_ctx_end(&fnctx);
+  vm->compiler = previous;
+  pd_arena_release(function->arena);
+  function->arena = NULL;
+  if(fnctx.errors != 0) {
+    // Whatever got emitted before the error must never run.
+    pvm_chunk_free(vm, &function->chunk);
+    function->failed = true;
+    return false;
+  }
+  return true;
+}
@@ -11,16 +11,25 @@
  * This file is the compiler part and will emit bytecode for the VM to execute.
  */
 
+// Number of hash buckets locals are looked up from, a power of two.
+#define PD_LOCAL_BUCKETS 256
+
 typedef struct {
   char* name;
   size_t len; // length of name.
+  uint32_t hash; // hash of name.
+  int16_t next; // next local in the same bucket (see pd_code_ctx.buckets) or -1.
   int depth;
   bool isCaptured;
+  bool implicit; // declared without an assignment, parameters and for loop variables.
+  int8_t copyable; // whether closures can copy it instead of sharing it, -1 until it's first captured. (see isCopyable())
+  struct pd_ast_node* scope; // the function body or for loop it was declared in, nothing outside can assign it.
 } pd_compiler_local;
 
 typedef struct {
   uint8_t index;
   bool isLocal; 
+  bool copied; // holds the value itself instead of an upvalue object, see OP_GET_UPVALUE_COPY
 } pd_compiler_upvalue;
 
 typedef enum {
@@ -44,7 +53,11 @@ typedef struct pd_code_ctx {
   // Local variables information.
   pd_compiler_local locals[256];
   int localCount;
+  // Index of the newest local whose name hashes to each bucket, -1 if none, the others are chained through pd_compiler_local.next
+  int16_t buckets[PD_LOCAL_BUCKETS];
   pd_compiler_upvalue upvalues[256];
+  // Innermost function body or for loop being compiled, the scope of new locals.
+  struct pd_ast_node* body;
   // Depth of the scope, 0 is the global scope, 1 is an inner block 2 is a nested inner block and so on.
   int scopeDepth;
 
@@ -53,10 +66,23 @@ typedef struct pd_code_ctx {
   // Tracks how many compile errors we have seen.
   // We shall not proceed to executing if there are errors.
   int errors;
+  // Count errors without reporting them, nested functions inherit it.
+  bool quiet;
 
   // Signals the compiler to not pop the top of the value when compiling an expression statement
   // Used for variable assignment because we don't have a declare statement.
   int nopop;
+
+  // Inlined call whose expression is being compiled or NULL, see compileInlined()
+  struct pd_inline_call* inlined;
+  // How many values the expression has on the stack above the arguments of the inlined call.
+  // The arguments are read relative to the top of the stack since the compiler doesn't know how deep they are in the frame.
+  int inlineDepth;
+
+  // Arena of the tree being compiled, set by the caller before compiling the script to allow compiling functions lazily.
+  // Lazy functions keep their part of the tree in there and hold a reference to it. (see pd_compile_lazy())
+  // `peridot compile` leaves this NULL so it's all compiled and checked for errors upfront.
+  struct pd_arena* arena;
 } pd_code_ctx;
 
 // Compiles the root [node] in context of [ctx]
@@ -64,5 +90,8 @@ typedef struct pd_code_ctx {
 void pd_compile(pd_code_ctx* ctx, pd_ast_node* node);
 void pd_compile_ctx_init(pd_code_ctx* ctx, pvm_t* vm, pd_function_type type);
 pd_function* pd_compile_ctx_end(pd_code_ctx* ctx);
+// Compiles a function that was left for later (see pd_function.ast) the VM does this the first time it's called.
+// Returns false if there were compile errors, they are reported already unless [quiet] is set.
+bool pd_compile_lazy(pvm_t* vm, pd_function* function, bool quiet);
 
 #endif // _PERIDOT_COMPILER_H
@@ -48,19 +48,39 @@ static int jumpInstruction(const char* name, int sign, pvm_chunk* chunk, int off
   return offset + 3;
 }
 
+static int forInstruction(const char* name, int sign, pvm_chunk* chunk, int offset) {
+  uint8_t slot = chunk->code[offset + 1];
+  uint16_t jump = chunk->code[offset + 2] | (chunk->code[offset + 3] << 8);
+  printf("\x1b[33m%-16s\x1b[0m %4d %4d -> %d\n", name, slot, offset, offset + 4 + sign * jump);
+  return offset + 4;
+}
+
 static int byteInstruction(const char* name, pvm_chunk* chunk, int offset) {
   uint8_t slot = chunk->code[offset + 1];
   printf("\x1b[33m%-16s\x1b[0m %4d\n", name, slot);
   return offset + 2;
 }
 
+static int shortInstruction(const char* name, pvm_chunk* chunk, int offset) {
+  uint16_t operand = chunk->code[offset + 1] | (chunk->code[offset + 2] << 8);
+  printf("\x1b[33m%-16s\x1b[0m %4d\n", name, operand);
+  return offset + 3;
+}
+
+static int guardInstruction(const char* name, pvm_chunk* chunk, int offset) {
+  uint16_t global = chunk->code[offset + 1] | (chunk->code[offset + 2] << 8);
+  uint16_t jump = chunk->code[offset + 11] | (chunk->code[offset + 12] << 8);
+  printf("\x1b[33m%-16s\x1b[0m %4d %4d -> %d\n", name, global, offset, offset + 13 + jump);
+  return offset + 13;
+}
+
 int pvm_disassemble_instruction(pvm_chunk* chunk, int offset) {
   printf("\x1b[1m\x1b[36m%04d\x1b[0m ", offset);
 
-  if (offset > 0 && chunk->lines[offset] == chunk->lines[offset - 1]) {
+  if (offset > 0 && pvm_chunk_line(chunk, offset) == pvm_chunk_line(chunk, offset - 1)) {
     printf("   \x1b[32m|\x1b[0m ");
   } else {
-    printf("\x1b[35m\x1b[1m%4d\x1b[0m ", chunk->lines[offset]);
+    printf("\x1b[35m\x1b[1m%4d\x1b[0m ", pvm_chunk_line(chunk, offset));
   }
 
   uint8_t instruction = chunk->code[offset];
@@ -73,6 +93,10 @@ int pvm_disassemble_instruction(pvm_chunk* chunk, int offset) {
       return byteInstruction("OP_GET_GLOBAL", chunk, offset);
     case PVM_OP_SET_GLOBAL:
       return byteInstruction("OP_SET_GLOBAL", chunk, offset);
+    case PVM_OP_GET_GLOBAL_LONG:
+      return shortInstruction("OP_GET_GLOBAL_LONG", chunk, offset);
+    case PVM_OP_SET_GLOBAL_LONG:
+      return shortInstruction("OP_SET_GLOBAL_LONG", chunk, offset);
     case PVM_OP_GET_LOCAL:
       return byteInstruction("OP_GET_LOCAL", chunk, offset);
     case PVM_OP_SET_LOCAL:
@@ -81,6 +105,22 @@ int pvm_disassemble_instruction(pvm_chunk* chunk, int offset) {
       return byteInstruction("OP_GET_UPVALUE", chunk, offset);
     case PVM_OP_SET_UPVALUE:
       return byteInstruction("OP_SET_UPVALUE", chunk, offset);
+    case PVM_OP_GET_UPVALUE_COPY:
+      return byteInstruction("OP_GET_UPVALUE_COPY", chunk, offset);
+    case PVM_OP_ARRAY:
+      return shortInstruction("OP_ARRAY", chunk, offset);
+    case PVM_OP_DICT:
+      return shortInstruction("OP_DICT", chunk, offset);
+    case PVM_OP_DELETE_INDEX:
+      return simpleInstruction("OP_DELETE_INDEX", offset);
+    case PVM_OP_GET_INDEX:
+      return simpleInstruction("OP_GET_INDEX", offset);
+    case PVM_OP_GET_PROPERTY:
+      return longConstantInstruction("OP_GET_PROPERTY", chunk, offset);
+    case PVM_OP_IMPORT:
+      return longConstantInstruction("OP_IMPORT", chunk, offset);
+    case PVM_OP_SET_INDEX:
+      return simpleInstruction("OP_SET_INDEX", offset);
     case PVM_OP_JUMP:
       return jumpInstruction("OP_JUMP", 1, chunk, offset);
     case PVM_OP_CLOSE_UPVALUE:                                 
@@ -93,10 +133,20 @@ int pvm_disassemble_instruction(pvm_chunk* chunk, int offset) {
       return jumpInstruction("OP_OR", 1, chunk, offset);
     case PVM_OP_LOOP:                                                  
       return jumpInstruction("OP_LOOP", -1, chunk, offset);
+    case PVM_OP_FOR_PREP:
+      return forInstruction("OP_FOR_PREP", 1, chunk, offset);
+    case PVM_OP_FOR_LOOP:
+      return forInstruction("OP_FOR_LOOP", -1, chunk, offset);
     case PVM_OP_POP:
       return simpleInstruction("OP_POP", offset);
     case PVM_OP_POPN:
       return byteInstruction("OP_POPN", chunk, offset);
+    case PVM_OP_PEEK:
+      return byteInstruction("OP_PEEK", chunk, offset);
+    case PVM_OP_POP_UNDER:
+      return byteInstruction("OP_POP_UNDER", chunk, offset);
+    case PVM_OP_INLINE_GUARD:
+      return guardInstruction("OP_INLINE_GUARD", chunk, offset);
     case PVM_OP_NULL:
       return simpleInstruction("OP_NULL", offset);
     case PVM_OP_TRUE:
@@ -147,6 +197,10 @@ int pvm_disassemble_instruction(pvm_chunk* chunk, int offset) {
       return simpleInstruction("OP_BAND", offset);
     case PVM_OP_CALL:
       return byteInstruction("OP_CALL", chunk, offset);
+    case PVM_OP_TAIL_CALL:
+      return byteInstruction("OP_TAIL_CALL", chunk, offset);
+    case PVM_OP_AWAIT:
+      return simpleInstruction("OP_AWAIT", offset);
     case PVM_OP_MULTIPLY:
       return simpleInstruction("OP_MULTIPLY", offset);
     case PVM_OP_DIVIDE:
@@ -159,17 +213,20 @@ int pvm_disassemble_instruction(pvm_chunk* chunk, int offset) {
       return simpleInstruction("OP_RETURN", offset);
     case PVM_OP_RETURN_NULL:
       return simpleInstruction("OP_RETURN_NULL", offset);
-    case PVM_OP_CLOSURE: {
+    case PVM_OP_CLOSURE:
+    case PVM_OP_CLOSURE_LONG: {
       offset++;
-      uint8_t constant = chunk->code[offset++];
-      printf("\x1b[33m%-16s\x1b[0m %4d ", "OP_CLOSURE", constant);
+      int constant = chunk->code[offset++];
+      if(instruction == PVM_OP_CLOSURE_LONG) constant |= chunk->code[offset++] << 8;
+      printf("\x1b[33m%-16s\x1b[0m %4d ", instruction == PVM_OP_CLOSURE ? "OP_CLOSURE" : "OP_CLOSURE_LONG", constant);
       pd_value_print(chunk->constants.data[constant]);
       printf("\n");
       pd_function* function = PD_AS_FUNCTION(chunk->constants.data[constant]);
       for(int j = 0; j < function->upvalue_count; j++) {
-        int isLocal = chunk->code[offset++];
+        int kind = chunk->code[offset++];
         int index = chunk->code[offset++];
-        printf("\x1b[1m\x1b[36m%04d\x1b[0m      \x1b[32m|\x1b[0m                     %s %d\n", offset - 2, isLocal ? "local" : "upvalue", index);
+        const char* kinds[] = { "upvalue", "local", "copy" };
+        printf("\x1b[1m\x1b[36m%04d\x1b[0m      \x1b[32m|\x1b[0m                     %s %d\n", offset - 2, kinds[kind > 2 ? 0 : kind], index);
       }
       return offset;
     }
@@ -0,0 +1,143 @@
+#include <string.h>
+#include "dict.h"
+#include "gc.h"
+
+// Markers for index slots, anything else is a position in the entries.
+#define DICT_EMPTY -1
+#define DICT_DELETED -2
+
+// How many entries fit for an index capacity, this is the same 0.75 load factor pd_table uses.
+#define DICT_USABLE(capacity) ((capacity) * 3 / 4)
+
+pd_dict* pd_dict_new(pvm_t* vm) {
+  pd_dict* dict = ALLOC_OBJECT(vm, pd_dict, PD_OBJ_DICT);
+  dict->entries = NULL;
+  dict->count = 0;
+  dict->used = 0;
+  dict->index = NULL;
+  dict->capacity = 0;
+  return dict;
+}
+
+// Keys are compared by their bits just like the == operator, strings are either interned or packed
+// in the value so equal strings always have equal bits too.
+// The exception is -0 which we want to find the same entry as 0
+static PD_INLINE pd_value normalizeKey(pd_value key) {
+  if(IS_DOUBLE(key) && AS_DOUBLE(key) == 0) return DOUBLE_VAL(0);
+  return key;
+}
+
+// Since equal keys have equal bits, hashing the bits covers every kind of key:
+// numbers by value, strings by contents (thanks to interning) and any other object by identity.
+// This is Thomas Wang's 64 bit to 32 bit integer hash.
+static PD_INLINE uint32_t hashValue(pd_value value) {
+  uint64_t hash = value;
+  hash = ~hash + (hash << 18);
+  hash ^= hash >> 31;
+  hash *= 21;
+  hash ^= hash >> 11;
+  hash += hash << 6;
+  hash ^= hash >> 22;
+  return (uint32_t)hash;
+}
+
+// Finds the index slot that points to [key], -1 if it isn't in the dictionary.
+static int findSlot(pd_dict* dict, pd_value key, uint32_t hash) {
+  uint32_t mask = dict->capacity - 1;
+  uint32_t slot = hash & mask;
+  for(;;) {
+    int32_t position = dict->index[slot];
+    if(position == DICT_EMPTY) return -1;
+    if(position >= 0 && dict->entries[position].key == key) return (int)slot;
+    slot = (slot + 1) & mask;
+  }
+}
+
+// Points the first free slot in the probe sequence of [hash] to [position]
+static void insertIndex(int32_t* index, int capacity, uint32_t hash, int position) {
+  uint32_t mask = capacity - 1;
+  uint32_t slot = hash & mask;
+  while(index[slot] >= 0) slot = (slot + 1) & mask;
+  index[slot] = position;
+}
+
+// Rebuilds the dictionary when the entries are full.
+// Every used entry takes at most one index slot (deleted markers get reused by inserts) so a full
+// entries array also means the index is at its load limit, there are always empty slots to end probing.
+// Deleted holes are dropped here so if enough entries were deleted this just compacts without growing.
+static void resize(pvm_t* vm, pd_dict* dict) {
+  int needed = dict->count + 1;
+  int capacity = dict->capacity < 8 ? 8 : dict->capacity;
+  // Leave some room after the rebuild so we don't resize again right away.
+  while(DICT_USABLE(capacity) < needed + needed / 2) capacity *= 2;
+
+  pd_dict_entry* entries = pd_gc_malloc(vm, sizeof(pd_dict_entry) * DICT_USABLE(capacity));
+  int32_t* index = pd_gc_malloc(vm, sizeof(int32_t) * capacity);
+  memset(index, 0xff, sizeof(int32_t) * capacity); // All DICT_EMPTY (-1)
+
+  int used = 0;
+  for(int i = 0; i < dict->used; i++) {
+    pd_dict_entry* entry = &dict->entries[i];
+    if(PD_DICT_ENTRY_DELETED(entry)) continue;
+    entries[used] = *entry;
+    insertIndex(index, capacity, entry->hash, used);
+    used++;
+  }
+
+  PD_FREE_ARRAY(vm, pd_dict_entry, dict->entries, DICT_USABLE(dict->capacity));
+  PD_FREE_ARRAY(vm, int32_t, dict->index, dict->capacity);
+  dict->entries = entries;
+  dict->index = index;
+  dict->capacity = capacity;
+  dict->used = used;
+}
+
+bool pd_dict_get(pd_dict* dict, pd_value key, pd_value* value) {
+  if(dict->count == 0) return false;
+  key = normalizeKey(key);
+  int slot = findSlot(dict, key, hashValue(key));
+  if(slot == -1) return false;
+  *value = dict->entries[dict->index[slot]].value;
+  return true;
+}
+
+bool pd_dict_set(pvm_t* vm, pd_dict* dict, pd_value key, pd_value value) {
+  key = normalizeKey(key);
+  uint32_t hash = hashValue(key);
+  if(dict->count > 0) {
+    int slot = findSlot(dict, key, hash);
+    if(slot != -1) {
+      dict->entries[dict->index[slot]].value = value;
+      return false;
+    }
+  }
+
+  if(dict->used + 1 > DICT_USABLE(dict->capacity)) resize(vm, dict);
+  insertIndex(dict->index, dict->capacity, hash, dict->used);
+  pd_dict_entry* entry = &dict->entries[dict->used++];
+  entry->key = key;
+  entry->value = value;
+  entry->hash = hash;
+  dict->count++;
+  return true;
+}
+
+bool pd_dict_delete(pd_dict* dict, pd_value key) {
+  if(dict->count == 0) return false;
+  key = normalizeKey(key);
+  int slot = findSlot(dict, key, hashValue(key));
+  if(slot == -1) return false;
+
+  int position = dict->index[slot];
+  // The slot must stay occupied so probing continues past it.
+  dict->index[slot] = DICT_DELETED;
+  dict->entries[position].key = UNDEFINED_VALUE;
+  dict->entries[position].value = NULL_VALUE;
+  dict->count--;
+  return true;
+}
+
+void pd_dict_free(pvm_t* vm, pd_dict* dict) {
+  PD_FREE_ARRAY(vm, pd_dict_entry, dict->entries, DICT_USABLE(dict->capacity));
+  PD_FREE_ARRAY(vm, int32_t, dict->index, dict->capacity);
+}
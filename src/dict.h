@@ -0,0 +1,58 @@
+#ifndef _PERIDOT_DICT_H
+#define _PERIDOT_DICT_H
+
+#include <stdint.h>
+#include "object.h"
+#include "value.h"
+
+// Dictionaries map any value to another value.
+//
+// Unlike pd_table (which is only for internal string keys) this keeps the insertion order
+// the layout follows CPython's compact dict, entries are stored densely in the order they were added
+// and a separate hash index maps into them:
+//
+//   index:   [ -1, 1, -1, 0, -2, -1, 2, -1 ]  (power of two, open addressing)
+//   entries: [ {"a", 1}, {"b", 2}, {"c", 3} ] (insertion order)
+//
+// The index slots are just int32s so probing touches way less memory than a table of full entries
+// and iterating is a straight walk over the entries.
+// Deleted entries leave a hole (key is UNDEFINED_VALUE) that is compacted away on the next resize.
+
+typedef struct {
+  pd_value key;
+  pd_value value;
+  uint32_t hash;
+} pd_dict_entry;
+
+typedef struct {
+  pd_object obj;
+  pd_dict_entry* entries;
+  int count; // Number of live entries.
+  int used; // Number of entries used including deleted holes, new entries are appended here.
+  int32_t* index;
+  int capacity; // Capacity of the index, entries can hold 3/4 of it.
+} pd_dict;
+
+// Creates an empty dictionary.
+pd_dict* pd_dict_new(pvm_t* vm);
+
+// Looks up [key] and writes the value to [value], returns false if the key doesn't exist.
+bool pd_dict_get(pd_dict* dict, pd_value key, pd_value* value);
+
+// Adds or replaces the value for [key], returns true if it's a new key.
+// This may allocate so the dictionary, key and value must be reachable by the GC.
+bool pd_dict_set(pvm_t* vm, pd_dict* dict, pd_value key, pd_value value);
+
+// Removes [key], returns false if it wasn't there.
+bool pd_dict_delete(pd_dict* dict, pd_value key);
+
+// Frees the storage, used by the GC.
+void pd_dict_free(pvm_t* vm, pd_dict* dict);
+
+// Checks if an entry is a deleted hole, iterating code must skip them.
+#define PD_DICT_ENTRY_DELETED(entry) (IS_UNDEFINED((entry)->key))
+
+#define PD_IS_DICT(val) (OBJECT_TYPE(AS_OBJECT(val)) == PD_OBJ_DICT)
+#define PD_AS_DICT(val) ((pd_dict*)AS_OBJECT(val))
+
+#endif // _PERIDOT_DICT_H
@@ -0,0 +1,522 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/mman.h>
+#endif // _WIN32
+#include "fs.h"
+#include "pvm.h"
+#include "gc.h"
+#include "str.h"
+#include "task.h"
+
+#define DEFAULT_CHUNK_SIZE (64 * 1024)
+#define PATH_SIZE 4096
+
+typedef struct {
+  uv_fs_t req;
+  pvm_t* vm;
+  pd_task* task;
+  char small[PD_SSTR_MAX + 1]; // The bytes of a short string being written.
+} fs_req;
+
+static void* allocate(size_t size) {
+  void* result = malloc(size);
+  if(result == NULL) {
+    fprintf(stderr, "Out of memory.\n");
+    exit(1);
+  }
+  return result;
+}
+
+// Copies a string argument to [path] and null terminates it, false if it isn't a string or doesn't fit.
+static bool pathArg(pd_value value, char* path) {
+  if(IS_SHORT_STRING(value)) {
+    pd_sstr_read(value, path);
+    return true;
+  }
+  if(!IS_OBJECT(value) || !PD_IS_STRING(value) || PD_STRLEN(value) >= PATH_SIZE) return false;
+  memcpy(path, PD_AS_CSTRING(value), PD_STRLEN(value));
+  path[PD_STRLEN(value)] = '\0';
+  return true;
+}
+
+static bool fdArg(pd_value value, uv_file* fd) {
+  if(!IS_NUMBER(value)) return false;
+  double number = AS_DOUBLE(value);
+  if(number < 0 || number > INT_MAX || number != (int)number) return false;
+  *fd = (int)number;
+  return true;
+}
+
+// Like Node, "r", "r+", "w", "w+", "a" and "a+". -1 for anything else.
+static int openFlags(int argc, pd_value* args) {
+  if(argc < 2) return UV_FS_O_RDONLY;
+  char mode[PD_SSTR_MAX + 1];
+  if(!IS_SHORT_STRING(args[1])) return -1;
+  pd_sstr_read(args[1], mode);
+  if(strcmp(mode, "r") == 0) return UV_FS_O_RDONLY;
+  if(strcmp(mode, "r+") == 0) return UV_FS_O_RDWR;
+  if(strcmp(mode, "w") == 0) return UV_FS_O_WRONLY | UV_FS_O_CREAT | UV_FS_O_TRUNC;
+  if(strcmp(mode, "w+") == 0) return UV_FS_O_RDWR | UV_FS_O_CREAT | UV_FS_O_TRUNC;
+  if(strcmp(mode, "a") == 0) return UV_FS_O_WRONLY | UV_FS_O_CREAT | UV_FS_O_APPEND;
+  if(strcmp(mode, "a+") == 0) return UV_FS_O_RDWR | UV_FS_O_CREAT | UV_FS_O_APPEND;
+  return -1;
+}
+
+// An optional position argument, -1 reads or writes at the current position of the file.
+static int64_t positionArg(int argc, pd_value* args, int index) {
+  if(argc <= index || !IS_NUMBER(args[index])) return -1;
+  double number = AS_DOUBLE(args[index]);
+  return number < 0 ? -1 : (int64_t)number;
+}
+
+// Trims a chunk to what a read actually got, null at the end of the file or on errors.
+static pd_value readResult(pvm_t* vm, pd_typed_array* array, ssize_t result) {
+  if(result <= 0) return NULL_VALUE;
+  if(result < array->count) {
+    // Shrinking never triggers the GC.
+    array->data = pd_gc_realloc(vm, array->data, array->count, result);
+    array->count = (int)result;
+  }
+  return PD_FROM(array);
+}
+
+// The task of an async request, retained until its callback completes it.
+static fs_req* newRequest(pvm_t* vm, pd_task* task) {
+  fs_req* req = allocate(sizeof(fs_req));
+  req->vm = vm;
+  req->task = task;
+  req->req.data = req;
+  pvm_retain(vm, PD_FROM(task));
+  return req;
+}
+
+static void complete(fs_req* req, pd_value value) {
+  pvm_t* vm = req->vm;
+  pd_task_complete(vm, req->task, value);
+  pvm_release(vm, PD_FROM(req->task));
+  uv_fs_req_cleanup(&req->req);
+  free(req);
+  pvm_run_tasks(vm);
+}
+
+// For requests that failed to start, the callback never comes.
+static void failed(fs_req* req, pd_value value) {
+  pd_task_complete(req->vm, req->task, value);
+  pvm_release(req->vm, PD_FROM(req->task));
+  uv_fs_req_cleanup(&req->req);
+  free(req);
+}
+
+static void onOpen(uv_fs_t* handle) {
+  complete(handle->data, handle->result >= 0 ? NUMBER_VAL((double)handle->result) : NULL_VALUE);
+}
+
+static void onRead(uv_fs_t* handle) {
+  fs_req* req = handle->data;
+  // The chunk rides along in the result of the task until it's done.
+  complete(req, readResult(req->vm, PD_AS_TYPED_ARRAY(req->task->result), handle->result));
+}
+
+static void onWrite(uv_fs_t* handle) {
+  complete(handle->data, handle->result >= 0 ? NUMBER_VAL((double)handle->result) : NULL_VALUE);
+}
+
+static void onClose(uv_fs_t* handle) {
+  complete(handle->data, BOOL_VAL(handle->result == 0));
+}
+
+// open(path, mode) gives a task for the file descriptor, null if it couldn't be opened. The mode defaults to "r"
+static pd_value fsOpen(pvm_t* vm, int argc, pd_value* args) {
+  char path[PATH_SIZE];
+  int flags = openFlags(argc, args);
+  if(argc < 1 || !pathArg(args[0], path) || flags == -1) return NULL_VALUE;
+  pd_task* task = pd_task_new(vm);
+  fs_req* req = newRequest(vm, task);
+  if(uv_fs_open(vm->loop, &req->req, path, flags, 0644, onOpen) != 0) failed(req, NULL_VALUE);
+  return PD_FROM(task);
+}
+
+static pd_value fsOpenSync(pvm_t* vm, int argc, pd_value* args) {
+  char path[PATH_SIZE];
+  int flags = openFlags(argc, args);
+  if(argc < 1 || !pathArg(args[0], path) || flags == -1) return NULL_VALUE;
+  uv_fs_t req;
+  int result = uv_fs_open(vm->loop, &req, path, flags, 0644, NULL);
+  uv_fs_req_cleanup(&req);
+  return result >= 0 ? NUMBER_VAL((double)result) : NULL_VALUE;
+}
+
+static bool readArgs(int argc, pd_value* args, uv_file* fd, int* size) {
+  if(argc < 2 || !fdArg(args[0], fd) || !IS_NUMBER(args[1])) return false;
+  double number = AS_DOUBLE(args[1]);
+  if(!(number >= 1 && number <= INT_MAX)) return false;
+  *size = (int)number;
+  return true;
+}
+
+// read(fd, size, position) gives a task for a Uint8Array of up to [size] bytes read right into it,
+// null at the end of the file or on errors. Without a position it reads on from where the file is at.
+static pd_value fsRead(pvm_t* vm, int argc, pd_value* args) {
+  uv_file fd;
+  int size;
+  if(!readArgs(argc, args, &fd, &size)) return NULL_VALUE;
+  int64_t position = positionArg(argc, args, 2);
+  pd_task* task = pd_task_new(vm);
+  pvm_push(vm, PD_FROM(task)); // GC guard
+  pd_typed_array* array = pd_typed_array_new(vm, PD_TYPED_UINT8, size);
+  task->result = PD_FROM(array);
+  fs_req* req = newRequest(vm, task);
+  uv_buf_t buf = uv_buf_init(array->data, size);
+  if(uv_fs_read(vm->loop, &req->req, fd, &buf, 1, position, onRead) != 0) failed(req, NULL_VALUE);
+  return pvm_pop(vm);
+}
+
+static pd_value fsReadSync(pvm_t* vm, int argc, pd_value* args) {
+  uv_file fd;
+  int size;
+  if(!readArgs(argc, args, &fd, &size)) return NULL_VALUE;
+  pd_typed_array* array = pd_typed_array_new(vm, PD_TYPED_UINT8, size);
+  uv_fs_t req;
+  uv_buf_t buf = uv_buf_init(array->data, size);
+  uv_fs_read(vm->loop, &req, fd, &buf, 1, positionArg(argc, args, 2), NULL);
+  uv_fs_req_cleanup(&req);
+  return readResult(vm, array, req.result);
+}
+
+// The bytes of a string or typed array to write, short strings are unpacked to [small]
+static bool writeBuffer(pd_value value, char* small, uv_buf_t* buf) {
+  if(IS_SHORT_STRING(value)) {
+    int len = pd_sstr_read(value, small);
+    *buf = uv_buf_init(small, len);
+    return true;
+  }
+  if(!IS_OBJECT(value)) return false;
+  if(PD_IS_STRING(value)) {
+    *buf = uv_buf_init(PD_AS_CSTRING(value), PD_STRLEN(value));
+    return true;
+  }
+  if(PD_IS_TYPED_ARRAY(value)) {
+    pd_typed_array* array = PD_AS_TYPED_ARRAY(value);
+    *buf = uv_buf_init(array->data, pd_typed_array_element_size(array->kind) * array->count);
+    return true;
+  }
+  return false;
+}
+
+// write(fd, data, position) writes a string or the bytes of a typed array,
+// gives a task for the number of bytes written or null on errors. Without a position it writes where the file is at.
+static pd_value fsWrite(pvm_t* vm, int argc, pd_value* args) {
+  uv_file fd;
+  if(argc < 2 || !fdArg(args[0], &fd)) return NULL_VALUE;
+  // Retaining the task pushes which can move the stack, args are only used before that.
+  pd_value data = args[1];
+  int64_t position = positionArg(argc, args, 2);
+  char small[PD_SSTR_MAX + 1];
+  uv_buf_t buf;
+  if(!writeBuffer(data, small, &buf)) return NULL_VALUE;
+  pd_task* task = pd_task_new(vm);
+  // Keeps the data alive until it's written, libuv gets a pointer to it.
+  task->result = data;
+  fs_req* req = newRequest(vm, task);
+  if(IS_SHORT_STRING(data)) {
+    memcpy(req->small, small, sizeof(small));
+    buf.base = req->small;
+  }
+  if(uv_fs_write(vm->loop, &req->req, fd, &buf, 1, position, onWrite) != 0) failed(req, NULL_VALUE);
+  return PD_FROM(task);
+}
+
+static pd_value fsWriteSync(pvm_t* vm, int argc, pd_value* args) {
+  uv_file fd;
+  if(argc < 2 || !fdArg(args[0], &fd)) return NULL_VALUE;
+  char small[PD_SSTR_MAX + 1];
+  uv_buf_t buf;
+  if(!writeBuffer(args[1], small, &buf)) return NULL_VALUE;
+  uv_fs_t req;
+  uv_fs_write(vm->loop, &req, fd, &buf, 1, positionArg(argc, args, 2), NULL);
+  uv_fs_req_cleanup(&req);
+  return req.result >= 0 ? NUMBER_VAL((double)req.result) : NULL_VALUE;
+}
+
+static void closeFile(pvm_t* vm, uv_file fd) {
+  uv_fs_t req;
+  uv_fs_close(vm->loop, &req, fd, NULL);
+  uv_fs_req_cleanup(&req);
+}
+
+static void startRead(pd_file_stream* stream);
+
+static void onStreamRead(uv_fs_t* req) {
+  pd_file_stream* stream = req->data;
+  pvm_t* vm = stream->vm;
+  ssize_t result = req->result;
+  uv_fs_req_cleanup(req);
+  stream->reading = false;
+  // Closed while reading, that's the end of it too.
+  pd_value chunk = NULL_VALUE;
+  if(!stream->done) {
+    chunk = readResult(vm, stream->chunk, result);
+    if(IS_NULL(chunk)) stream->done = true;
+    else stream->position += result;
+  }
+  if(stream->done && stream->owns_fd && stream->fd != -1) {
+    closeFile(vm, stream->fd);
+    stream->fd = -1;
+  }
+
+  if(stream->waiting != NULL) {
+    pd_task* task = stream->waiting;
+    stream->waiting = NULL;
+    pd_task_complete(vm, task, chunk);
+    stream->chunk = NULL;
+    // It has what it asked for, read ahead while it's busy with it.
+    startRead(stream);
+  } else {
+    stream->ahead = IS_NULL(chunk) ? NULL : stream->chunk;
+    stream->chunk = NULL;
+  }
+  pvm_release(vm, PD_FROM(stream));
+  pvm_run_tasks(vm);
+}
+
+// Starts reading the next chunk unless there's a read going already or nothing left, [stream] must be reachable.
+static void startRead(pd_file_stream* stream) {
+  if(stream->reading || stream->done) return;
+  pvm_t* vm = stream->vm;
+  stream->chunk = pd_typed_array_new(vm, PD_TYPED_UINT8, stream->chunk_size);
+  stream->buf = uv_buf_init(stream->chunk->data, stream->chunk_size);
+  stream->req.data = stream;
+  stream->reading = true;
+  pvm_retain(vm, PD_FROM(stream));
+  if(uv_fs_read(vm->loop, &stream->req, stream->fd, &stream->buf, 1, stream->position, onStreamRead) != 0) {
+    uv_fs_req_cleanup(&stream->req);
+    stream->reading = false;
+    stream->done = true;
+    stream->chunk = NULL;
+    pvm_release(vm, PD_FROM(stream));
+  }
+}
+
+static void closeStream(pd_file_stream* stream) {
+  stream->done = true;
+  stream->ahead = NULL;
+  if(stream->waiting != NULL) {
+    pd_task_complete(stream->vm, stream->waiting, NULL_VALUE);
+    stream->waiting = NULL;
+  }
+  // The read in progress still needs the file, it's closed once it's done.
+  if(!stream->reading && stream->owns_fd && stream->fd != -1) {
+    closeFile(stream->vm, stream->fd);
+    stream->fd = -1;
+  }
+}
+
+void pd_file_stream_free(pvm_t* vm, pd_file_stream* stream) {
+  // Nothing can be reading, that keeps it alive.
+  if(stream->owns_fd && stream->fd != -1) closeFile(vm, stream->fd);
+  PD_FREE(vm, pd_file_stream, stream);
+}
+
+// stream(file, chunkSize) reads a file from the start in chunks of up to chunkSize bytes, 64KB by default.
+// The file is a path or a descriptor, one opened from a path is closed at the end. null if it couldn't be opened.
+static pd_value fsStream(pvm_t* vm, int argc, pd_value* args) {
+  if(argc < 1) return NULL_VALUE;
+  int chunkSize = DEFAULT_CHUNK_SIZE;
+  if(argc > 1 && IS_NUMBER(args[1])) {
+    double number = AS_DOUBLE(args[1]);
+    if(!(number >= 1 && number <= INT_MAX)) return NULL_VALUE;
+    chunkSize = (int)number;
+  }
+  char path[PATH_SIZE];
+  uv_file fd;
+  bool owns = false;
+  if(pathArg(args[0], path)) {
+    // Opening doesn't wait on much, the reads are what's worth doing in the background.
+    uv_fs_t req;
+    fd = uv_fs_open(vm->loop, &req, path, UV_FS_O_RDONLY, 0, NULL);
+    uv_fs_req_cleanup(&req);
+    if(fd < 0) return NULL_VALUE;
+    owns = true;
+  } else if(!fdArg(args[0], &fd)) {
+    return NULL_VALUE;
+  }
+
+  pd_file_stream* stream = ALLOC_OBJECT(vm, pd_file_stream, PD_OBJ_FILE_STREAM);
+  stream->vm = vm;
+  stream->fd = fd;
+  stream->owns_fd = owns;
+  stream->reading = false;
+  stream->done = false;
+  stream->position = 0;
+  stream->chunk_size = chunkSize;
+  stream->chunk = NULL;
+  stream->ahead = NULL;
+  stream->waiting = NULL;
+  pvm_push(vm, PD_FROM(stream)); // GC guard
+  startRead(stream);
+  return pvm_pop(vm);
+}
+
+// next(stream) gives a task for the next chunk as a Uint8Array, null once the whole file was read.
+static pd_value fsNext(pvm_t* vm, int argc, pd_value* args) {
+  if(argc < 1 || !IS_OBJECT(args[0]) || !PD_IS_FILE_STREAM(args[0])) return NULL_VALUE;
+  pd_file_stream* stream = PD_AS_FILE_STREAM(args[0]);
+  // Asking again before the chunk came gives the same one.
+  if(stream->waiting != NULL) return PD_FROM(stream->waiting);
+  pd_task* task = pd_task_new(vm);
+  if(stream->ahead != NULL) {
+    pd_task_complete(vm, task, PD_FROM(stream->ahead));
+    stream->ahead = NULL;
+    pvm_push(vm, PD_FROM(task)); // GC guard
+    startRead(stream);
+    pvm_pop(vm);
+  } else if(stream->reading) {
+    stream->waiting = task;
+  } else {
+    pd_task_complete(vm, task, NULL_VALUE);
+  }
+  return PD_FROM(task);
+}
+
+// close(file) closes a descriptor or a stream, gives a task for whether it worked.
+static pd_value fsClose(pvm_t* vm, int argc, pd_value* args) {
+  if(argc < 1) return NULL_VALUE;
+  // Pushing can move the stack, args are only used before that.
+  pd_file_stream* stream = IS_OBJECT(args[0]) && PD_IS_FILE_STREAM(args[0]) ? PD_AS_FILE_STREAM(args[0]) : NULL;
+  pd_task* task = pd_task_new(vm);
+  uv_file fd;
+  if(stream != NULL) {
+    pvm_push(vm, PD_FROM(task)); // GC guard
+    closeStream(stream);
+    pd_task_complete(vm, task, TRUE_VALUE);
+    return pvm_pop(vm);
+  }
+  if(!fdArg(args[0], &fd)) {
+    pd_task_complete(vm, task, FALSE_VALUE);
+    return PD_FROM(task);
+  }
+  fs_req* req = newRequest(vm, task);
+  if(uv_fs_close(vm->loop, &req->req, fd, onClose) != 0) failed(req, FALSE_VALUE);
+  return PD_FROM(task);
+}
+
+static pd_value fsCloseSync(pvm_t* vm, int argc, pd_value* args) {
+  if(argc < 1) return FALSE_VALUE;
+  if(IS_OBJECT(args[0]) && PD_IS_FILE_STREAM(args[0])) {
+    closeStream(PD_AS_FILE_STREAM(args[0]));
+    return TRUE_VALUE;
+  }
+  uv_file fd;
+  if(!fdArg(args[0], &fd)) return FALSE_VALUE;
+  uv_fs_t req;
+  int result = uv_fs_close(vm->loop, &req, fd, NULL);
+  uv_fs_req_cleanup(&req);
+  return BOOL_VAL(result == 0);
+}
+
+// size(file) is the size in bytes of a path or descriptor, null if there's no such file.
+static pd_value fsSize(pvm_t* vm, int argc, pd_value* args) {
+  if(argc < 1) return NULL_VALUE;
+  char path[PATH_SIZE];
+  uv_file fd;
+  uv_fs_t req;
+  int result;
+  if(pathArg(args[0], path)) result = uv_fs_stat(vm->loop, &req, path, NULL);
+  else if(fdArg(args[0], &fd)) result = uv_fs_fstat(vm->loop, &req, fd, NULL);
+  else return NULL_VALUE;
+  double size = (double)req.statbuf.st_size;
+  uv_fs_req_cleanup(&req);
+  return result == 0 ? NUMBER_VAL(size) : NULL_VALUE;
+}
+
+// map(path, offset, length) maps [length] bytes of a file from [offset] into memory as a read-only Uint8Array.
+// The length defaults to the rest of the file. A view can't be bigger than 2GB, bigger files are walked in windows.
+// The pages are only read when they're touched and the kernel can drop them again, the view is unmapped by the GC.
+static pd_value fsMap(pvm_t* vm, int argc, pd_value* args) {
+  char path[PATH_SIZE];
+  if(argc < 1 || !pathArg(args[0], path)) return NULL_VALUE;
+#ifdef _WIN32
+  // No mmap() here, fs.stream() or fs.read() do the job.
+  (void)vm;
+  return NULL_VALUE;
+#else
+  int64_t offset = positionArg(argc, args, 1);
+  if(offset < 0) offset = 0;
+  uv_fs_t req;
+  uv_file fd = uv_fs_open(vm->loop, &req, path, UV_FS_O_RDONLY, 0, NULL);
+  uv_fs_req_cleanup(&req);
+  if(fd < 0) return NULL_VALUE;
+  int result = uv_fs_fstat(vm->loop, &req, fd, NULL);
+  int64_t fileSize = (int64_t)req.statbuf.st_size;
+  uv_fs_req_cleanup(&req);
+  int64_t length = fileSize - offset;
+  if(argc > 2 && IS_NUMBER(args[2]) && AS_DOUBLE(args[2]) >= 0 && AS_DOUBLE(args[2]) < length) length = (int64_t)AS_DOUBLE(args[2]);
+  if(result != 0 || length > INT_MAX) {
+    closeFile(vm, fd);
+    return NULL_VALUE;
+  }
+  if(length <= 0) {
+    closeFile(vm, fd);
+    return PD_FROM(pd_typed_array_new(vm, PD_TYPED_UINT8, 0));
+  }
+
+  // The mapping has to start on a page, the view starts wherever the offset is within it.
+  int64_t start = offset & ~((int64_t)sysconf(_SC_PAGESIZE) - 1);
+  size_t size = (size_t)(offset - start + length);
+  void* mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, start);
+  closeFile(vm, fd);
+  if(mapping == MAP_FAILED) return NULL_VALUE;
+  pd_typed_array* array = pd_typed_array_new(vm, PD_TYPED_UINT8, 0);
+  array->data = (char*)mapping + (offset - start);
+  array->count = (int)length;
+  array->mapping = mapping;
+  array->mapping_size = size;
+  // Counted like the heap so mapping window after window still gets the old ones collected.
+  vm->bytes_allocated += size;
+  return PD_FROM(array);
+#endif // _WIN32
+}
+
+void pd_fs_unmap(pvm_t* vm, pd_typed_array* array) {
+#ifndef _WIN32
+  munmap(array->mapping, array->mapping_size);
+#endif // _WIN32
+  vm->bytes_allocated -= array->mapping_size;
+  PD_FREE(vm, pd_typed_array, array);
+}
+
+// text(bytes, start, end) makes a string of the bytes of a Uint8Array from start up to end, the whole array by default.
+static pd_value fsText(pvm_t* vm, int argc, pd_value* args) {
+  if(argc < 1 || !IS_OBJECT(args[0]) || !PD_IS_TYPED_ARRAY(args[0])) return NULL_VALUE;
+  pd_typed_array* array = PD_AS_TYPED_ARRAY(args[0]);
+  if(array->kind != PD_TYPED_UINT8) return NULL_VALUE;
+  int start = 0;
+  int end = array->count;
+  if(argc > 1 && IS_NUMBER(args[1])) start = (int)pd_typed_to_int(AS_DOUBLE(args[1]));
+  if(argc > 2 && IS_NUMBER(args[2])) end = (int)pd_typed_to_int(AS_DOUBLE(args[2]));
+  if(start < 0) start = 0;
+  if(end > array->count) end = array->count;
+  if(end < start) end = start;
+  return pd_str_new(vm, (char*)array->data + start, end - start);
+}
+
+const pd_builtin pd_fs_functions[] = {
+  { "fs.open", fsOpen },
+  { "fs.openSync", fsOpenSync },
+  { "fs.read", fsRead },
+  { "fs.readSync", fsReadSync },
+  { "fs.write", fsWrite },
+  { "fs.writeSync", fsWriteSync },
+  { "fs.close", fsClose },
+  { "fs.closeSync", fsCloseSync },
+  { "fs.size", fsSize },
+  { "fs.stream", fsStream },
+  { "fs.next", fsNext },
+  { "fs.map", fsMap },
+  { "fs.text", fsText },
+  { NULL, NULL }
+};
@@ -0,0 +1,69 @@
+#ifndef _PERIDOT_FS_H
+#define _PERIDOT_FS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <uv.h>
+#include "object.h"
+#include "value.h"
+#include "runtime.h"
+#include "typed_array.h"
+
+// The fs module, files on libuv's uv_fs_* functions.
+//
+//   import fs
+//
+//   async function count(path)
+//     lines = 0
+//     stream = fs.stream(path)
+//     chunk = await fs.next(stream)
+//     while chunk != null
+//       for i in 0..len(chunk) - 1
+//         if chunk[i] == 10
+//           lines = lines + 1
+//         end
+//       end
+//       chunk = await fs.next(stream)
+//     end
+//     return lines
+//   end
+//
+// Files are plain descriptor numbers like in Node, fs.open() gives one and fs.close() closes it.
+// Every function that touches the disk has an async version giving a task and a *Sync one that blocks.
+//
+// Data comes out as Uint8Arrays and libuv reads straight into their storage, nothing is copied into strings
+// unless the script asks for it with fs.text(). Writes take strings or typed arrays and hand their bytes to libuv as-is.
+//
+// A stream reads a file front to back in chunks and keeps one read going ahead of the script,
+// so the disk works while the script goes through the previous chunk and memory stays at a couple of chunks.
+// fs.map() is the other way for big files, a read-only view of (part of) a file mapped into memory.
+
+typedef struct pd_file_stream {
+  pd_object obj;
+  pvm_t* vm;
+  uv_fs_t req; // For the read in progress, the stream is retained while there is one.
+  uv_file fd; // -1 once closed.
+  bool owns_fd; // Opened from a path, so closing the stream closes the file.
+  bool reading; // A read is in progress.
+  bool done; // Got to the end of the file, or an error.
+  int64_t position;
+  int chunk_size;
+  uv_buf_t buf;
+  pd_typed_array* chunk; // What the read in progress reads into.
+  pd_typed_array* ahead; // A chunk read ahead that nobody asked for yet.
+  struct pd_task* waiting; // The task of fs.next() waiting for the read in progress.
+} pd_file_stream;
+
+// The functions of the module, see builtin.c
+extern const pd_builtin pd_fs_functions[];
+
+// Closes the file of the stream if it's still open and frees it, used by the GC.
+void pd_file_stream_free(pvm_t* vm, pd_file_stream* stream);
+
+// Unmaps a view from fs.map() and frees it, used by the GC.
+void pd_fs_unmap(pvm_t* vm, pd_typed_array* array);
+
+#define PD_IS_FILE_STREAM(val) (OBJECT_TYPE(AS_OBJECT(val)) == PD_OBJ_FILE_STREAM)
+#define PD_AS_FILE_STREAM(val) ((pd_file_stream*)AS_OBJECT(val))
+
+#endif // _PERIDOT_FS_H
@@ -7,6 +7,11 @@ pd_function* pd_function_new(pvm_t* vm) {
   fn->upvalue_count = 0;
   fn->name = NULL;
   fn->scope = 0;
+  fn->ast = NULL;
+  fn->arena = NULL;
+  fn->failed = false;
+  fn->inline_hash = 0;
+  fn->async = false;
   pvm_chunk_init(&fn->chunk);
   return fn;
 }
@@ -18,21 +23,19 @@ pd_native_function* pd_native_function_new(pvm_t* vm, pd_native function) {
 }
 
 pd_closure* pd_closure_new(pvm_t* vm, pd_function* fn) {
-  pd_upvalue** upvalues = pd_gc_malloc(vm, sizeof(pd_upvalue*) * fn->upvalue_count);
-  for(int i = 0; i < fn->upvalue_count; i++) {
-    upvalues[i] = NULL;
-  }
-  pd_closure* closure = ALLOC_OBJECT(vm, pd_closure, PD_OBJ_CLOSURE);
+  pd_closure* closure = (pd_closure*)pd_alloc_object(vm, sizeof(pd_closure) + sizeof(pd_value) * fn->upvalue_count, PD_OBJ_CLOSURE);
   closure->function = fn;
-  closure->upvalues = upvalues;
   closure->upvalue_count = fn->upvalue_count;
+  for(int i = 0; i < fn->upvalue_count; i++) {
+    closure->upvalues[i] = NULL_VALUE;
+  }
   return closure;
 }
 
 pd_upvalue* pd_upvalue_new(pvm_t* vm, pd_value* slot) {
   pd_upvalue* upvalue = ALLOC_OBJECT(vm, pd_upvalue, PD_OBJ_UPVALUE);
   upvalue->location = slot;
-  upvalue->next = NULL;
   upvalue->closed = NULL_VALUE;
+  upvalue->task = NULL;
   return upvalue;
 }
@@ -12,6 +12,19 @@ typedef struct {
   pvm_chunk chunk;
   pd_str* name;
   int scope; // Scope depth of this function.
+  // Functions that can be compiled on their own are only compiled the first time they are called.
+  // Until then this holds their AST (a PD_AST_FUNCTION node) and the chunk is empty, see pd_compile_lazy()
+  // The tree stays in the arena of the parse, the function holds a reference to it until it's compiled.
+  struct pd_ast_node* ast;
+  struct pd_arena* arena;
+  // Compiling it lazily failed, the chunk is empty and every call reports the error again.
+  bool failed;
+  // Hash of the tree of small functions that calls get inlined to, 0 for anything else.
+  // Inlined code checks that the global it calls still holds a function with this hash and calls it normally otherwise.
+  // It's a hash of the code rather than the function itself so it survives being written to a file.
+  uint64_t inline_hash;
+  // Calling an async function starts a task running it instead of a regular call. (see pd_task)
+  bool async;
 } pd_function;
 
 typedef pd_value (*pd_native)(pvm_t* vm, int argc, pd_value* args);
@@ -25,14 +38,18 @@ typedef struct pd_upvalue {
   pd_object obj;
   pd_value* location;
   pd_value closed;
-  struct pd_upvalue* next;
+  // The task whose stack it points into while open, it keeps the task and so its stack alive. NULL for the main stack.
+  struct pd_task* task;
 } pd_upvalue;
 
 typedef struct {
   pd_object obj;
   pd_function* function;
-  pd_upvalue** upvalues;
   int upvalue_count;
+  // An upvalue object for variables shared with the enclosing function or a copy of the value itself
+  // for variables that are never assigned again, the code reading them knows which one it is. (see OP_GET_UPVALUE_COPY)
+  // They are allocated along with the closure so creating one is a single allocation.
+  pd_value upvalues[];
 } pd_closure;
 
 pd_function* pd_function_new(pvm_t* vm);
@@ -48,5 +65,6 @@ pd_upvalue* pd_upvalue_new(pvm_t* vm, pd_value* slot);
 
 #define PD_IS_CLOSURE(fn) (OBJECT_TYPE(AS_OBJECT(fn)) == PD_OBJ_CLOSURE)
 #define PD_AS_CLOSURE(fn) ((pd_closure*)AS_OBJECT(fn))
+#define PD_AS_UPVALUE(value) ((pd_upvalue*)AS_OBJECT(value))
 
 #endif // _PERIDOT_FUNCTION_H
@@ -2,6 +2,14 @@
 #include <stdlib.h>
 #include "runtime.h"
 #include "class.h"
+#include "array.h"
+#include "typed_array.h"
+#include "dict.h"
+#include "arena.h"
+#include "task.h"
+#include "timers.h"
+#include "net.h"
+#include "fs.h"
 #define GC_HEAP_GROW_FACTOR 2
 
 #ifdef DEBUG_TRACE_GC
@@ -108,7 +116,7 @@ static void blackenObject(pvm_t* vm, pd_object* object) {
       pd_closure* closure = (pd_closure*)object;
       pd_gc_gray_object(vm, (pd_object*)closure->function);
       for(int i = 0; i < closure->upvalue_count; i++) {
-        pd_gc_gray_object(vm, (pd_object*)closure->upvalues[i]);
+        pd_gc_gray_value(vm, closure->upvalues[i]);
       }
       break;
     }
@@ -120,9 +128,47 @@ static void blackenObject(pvm_t* vm, pd_object* object) {
     }
     case PD_OBJ_UPVALUE:
       pd_gc_gray_value(vm, ((pd_upvalue*)object)->closed);
+      pd_gc_gray_object(vm, (pd_object*)((pd_upvalue*)object)->task);
       break;
+    case PD_OBJ_ARRAY:
+      pd_gc_gray_array(vm, &((pd_array*)object)->values);
+      break;
+    case PD_OBJ_DICT: {
+      pd_dict* dict = (pd_dict*)object;
+      // Deleted entries are UNDEFINED/NULL which gray_value skips anyway.
+      for(int i = 0; i < dict->used; i++) {
+        pd_gc_gray_value(vm, dict->entries[i].key);
+        pd_gc_gray_value(vm, dict->entries[i].value);
+      }
+      break;
+    }
+    case PD_OBJ_TASK: {
+      pd_task* task = (pd_task*)object;
+      pd_gc_gray_value(vm, task->result);
+      pd_gc_gray_object(vm, (pd_object*)task->waiters);
+      pd_gc_gray_object(vm, (pd_object*)task->next);
+      // The same as the roots of the VM's own stack, while the task runs this is the stack it was swapped with.
+      for(pd_value* slot = task->stack; slot < task->stack_top; slot++) pd_gc_gray_value(vm, *slot);
+      for(int i = 0; i < task->frame_count; i++) pd_gc_gray_object(vm, (pd_object*)task->frames[i].closure);
+      for(int i = 0; i < task->stack_top - task->stack; i++) pd_gc_gray_object(vm, (pd_object*)task->open_upvalues[i]);
+      break;
+    }
+    case PD_OBJ_SOCKET: {
+      pd_socket* socket = (pd_socket*)object;
+      pd_gc_gray_value(vm, socket->on_connection);
+      pd_gc_gray_object(vm, (pd_object*)socket->reading);
+      break;
+    }
+    case PD_OBJ_FILE_STREAM: {
+      pd_file_stream* stream = (pd_file_stream*)object;
+      pd_gc_gray_object(vm, (pd_object*)stream->chunk);
+      pd_gc_gray_object(vm, (pd_object*)stream->ahead);
+      pd_gc_gray_object(vm, (pd_object*)stream->waiting);
+      break;
+    }
     case PD_OBJ_STRING:
     case PD_OBJ_NATIVE:
+    case PD_OBJ_TYPED_ARRAY:
       // No references.
       break;
   }
@@ -205,6 +251,8 @@ void pd_gc_free_object(pvm_t* vm, pd_object* object) {
     case PD_OBJ_FUNCTION: {
       pd_function* function = (pd_function*)object;
       pvm_chunk_free(vm, &function->chunk);
+      // Never called so it was never compiled, let go of its AST.
+      if(function->arena != NULL) pd_arena_release(function->arena);
       PD_FREE(vm, pd_function, object);
       break;
     }
@@ -216,10 +264,39 @@ void pd_gc_free_object(pvm_t* vm, pd_object* object) {
       break;
     case PD_OBJ_CLOSURE: {
       pd_closure* closure = (pd_closure*)object;
-      PD_FREE_ARRAY(vm, pd_value, closure->upvalues, closure->upvalue_count);
-      PD_FREE(vm, pd_closure, object);
+      pd_gc_realloc(vm, object, sizeof(pd_closure) + sizeof(pd_value) * closure->upvalue_count, 0);
       break;
     }
+    case PD_OBJ_ARRAY: {
+      pd_array* array = (pd_array*)object;
+      pd_value_array_clear(vm, &array->values);
+      PD_FREE(vm, pd_array, object);
+      break;
+    }
+    case PD_OBJ_TYPED_ARRAY: {
+      pd_typed_array* array = (pd_typed_array*)object;
+      if(array->mapping != NULL) {
+        pd_fs_unmap(vm, array);
+        break;
+      }
+      pd_gc_realloc(vm, array->data, pd_typed_array_element_size(array->kind) * array->count, 0);
+      PD_FREE(vm, pd_typed_array, object);
+      break;
+    }
+    case PD_OBJ_DICT:
+      pd_dict_free(vm, (pd_dict*)object);
+      PD_FREE(vm, pd_dict, object);
+      break;
+    case PD_OBJ_TASK:
+      pd_task_free_stack((pd_task*)object);
+      PD_FREE(vm, pd_task, object);
+      break;
+    case PD_OBJ_SOCKET:
+      pd_socket_free(vm, (pd_socket*)object);
+      break;
+    case PD_OBJ_FILE_STREAM:
+      pd_file_stream_free(vm, (pd_file_stream*)object);
+      break;
   }
 /*
 //< Garbage Collection not-yet
@@ -309,11 +386,18 @@ void pd_gc_collect(pvm_t* vm) {
     pd_gc_gray_object(vm, (pd_object*)vm->frames[i].closure);
   }
 
-  // Mark the open upvalues.
-  for(pd_upvalue* upvalue = vm->open_upvalues; upvalue != NULL; upvalue = upvalue->next) {
-    pd_gc_gray_object(vm, (pd_object*)upvalue);
+  // Mark the open upvalues, they can only be on slots that are in use.
+  for(int i = 0; i < vm->stack_top - vm->stack; i++) {
+    if(vm->open_upvalues[i] != NULL) pd_gc_gray_object(vm, (pd_object*)vm->open_upvalues[i]);
   }
 
+  // Mark the tasks, the running one holds the stack it was swapped with and the rest of the queue hangs off the first.
+  pd_gc_gray_object(vm, (pd_object*)vm->task);
+  pd_gc_gray_object(vm, (pd_object*)vm->ready);
+  pd_gc_gray_object(vm, (pd_object*)vm->retained);
+  // And the callbacks of the timers waiting to fire.
+  pd_timers_mark(vm);
+
   // Mark the global roots.
   pd_gc_gray_table(vm, &vm->globals);
   pd_gc_gray_array(vm, &vm->global_values);
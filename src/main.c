@@ -1,14 +1,21 @@
 // Main entry for peridot, this file implements the command line interface and repl
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <sys/stat.h>
 #include <uv.h>
 #include "ast.h"
 #include "parser.h"
 #include "lexer.h"
 #include "pvm.h"
 #include "compiler.h"
+#include "optimizer.h"
 #include "debug.h"
 #include "opcodes.h"
+#include "bytecode.h"
+#include "snapshot.h"
 
 // Returns int so we can do return repl(); in main()
 int repl() {
@@ -23,97 +30,356 @@ int repl() {
       fprintf(stderr, "Error reading from stdin.\n");
       break;
     }
-    pd_lexer_state state;
-    state.last = -1;
-    state.parens = 0;
-    yyscan_t scanner;
-    if(yylex_init(&scanner)) {
-      printf("Failed to initialize scanner.\n");
-      return 1;
-    }
-    yyset_extra(&state, scanner);
-    /* YY_BUFFER_STATE buffer = */ yy_scan_string(input, scanner);
-    pd_ast_node* node = malloc(sizeof(pd_ast_node));
-    int status = yyparse(scanner, node);
+    pd_arena* arena = pd_arena_new();
+    pd_lexer lexer;
+    pd_lexer_init(&lexer, input, strlen(input), arena);
+    pd_ast_node node;
+    int status = yyparse(&lexer, &node);
+    free(input);
     // Parse errors gets printed already.
-    if(status != 0 || node == NULL) continue;
+    if(status != 0) {
+      pd_arena_release(arena);
+      continue;
+    }
+    pd_optimize(&node);
+    pd_optimize_inline(arena, &node);
     pd_code_ctx ctx;
     pd_compile_ctx_init(&ctx, vm, PD_TYPE_SCRIPT);
-    pd_compile(&ctx, node);
+    ctx.arena = arena;
+    pd_compile(&ctx, &node);
+    pd_function* fn = pd_compile_ctx_end(&ctx);
+    pd_arena_release(arena);
     // Compile errors gets printed already.
     if(ctx.errors > 0) continue;
-    free(node);
-    pvm_exec(vm, pd_compile_ctx_end(&ctx));
+    pvm_exec(vm, fn);
   }
   return 0;
 }
 
-int main(int argc, char* argv[]) {
-  // TODO make this flags to be cli flags.
-  // Right now we use getenv as a temporary hack, will need to write a portable argument parser.
-  yydebug = getenv("YYDEBUG") ? 1 : 0; // Debug parser state
-  int dump_ast = getenv("DUMP_AST") ? 1 : 0; // Dump abstract syntax tree
-  int dump_bc = getenv("DUMP_BC") ? 1 : 0; // Dump final bytecode.
-  (void)dump_bc;
-  // Debugging GC and VM will need to be compiled with the proper macro defined, because they add more runtime overhead
-  // since it has to keep checking a condition to whether output debug info, macros are checked at compile time only.
-  
-  if(argc < 2) return repl();
-
-  // TODO such initializations should be wrapped up in a function to ease usage.
-  yyscan_t scanner;
-  if(yylex_init(&scanner)) {
-    printf("Failed to initialize scanner.\n");
-    return 1;
-  }
-
-  FILE* f = fopen(argv[1], "r");
-  if(f == NULL) {
-    printf("Failed to open '%s'\n", argv[1]);
-    return 1;
-  }
+// Reads a whole file in memory, returns NULL if it can't be read.
+static uint8_t* readFile(const char* path, size_t* size) {
+  FILE* f = fopen(path, "rb");
+  if(f == NULL) return NULL;
+  fseek(f, 0, SEEK_END);
+  long length = ftell(f);
+  rewind(f);
+  uint8_t* data = malloc(length > 0 ? length : 1);
+  *size = fread(data, 1, length, f);
+  fclose(f);
+  return data;
+}
 
+// Lexes, parses and compiles a source file into [vm], returns NULL if there were errors.
+// Errors are reported already.
+// Lazy functions (see pd_compile_lazy()) must be compiled before writing the code to a file.
+static pd_function* compileSource(pvm_t* vm, const uint8_t* source, size_t size, int dump_ast, bool lazy) {
   // Lex & Parse
+  // Everything the parse allocates goes in the arena and is freed in one go once it's compiled.
+  // (or once the last lazy function in it is compiled)
   PD_TIMER_START;
-  pd_lexer_state* state = malloc(sizeof(pd_lexer_state));
-  state->last = -1;
-  state->parens = 0;
-  yyset_extra(state, scanner);
-  yyset_in(f, scanner);
-  pd_ast_node* node = malloc(sizeof(pd_ast_node));
-
-  yyparse(scanner, node);
+  pd_arena* arena = pd_arena_new();
+  pd_lexer lexer;
+  pd_lexer_init(&lexer, (const char*)source, size, arena);
+  pd_ast_node node;
+
+  int status = yyparse(&lexer, &node);
   PD_TIMER_STOP;
   PD_TIMER_REPORT("Lexing & Parsing");
-  if(node == NULL) return printf("Failed to parse.\n");
+  if(status != 0) {
+    pd_arena_release(arena);
+    printf("Failed to parse.\n");
+    return NULL;
+  }
 
   // Dump Tree for debugging
-  if(dump_ast) pd_ast_node_dump(*node);
+  if(dump_ast) pd_ast_node_dump(node);
+
+  // Fold constants and dead branches before compiling, then find the calls we can inline.
+  pd_optimize(&node);
+  pd_optimize_inline(arena, &node);
 
   // Compile
   pd_code_ctx ctx;
-  pvm_t* vm = pvm_new();
   pd_compile_ctx_init(&ctx, vm, PD_TYPE_SCRIPT);
-  pd_compile(&ctx, node);
+  if(lazy) ctx.arena = arena;
+  pd_compile(&ctx, &node);
+  pd_arena_release(arena);
+  pd_function* fn = pd_compile_ctx_end(&ctx);
   if(ctx.errors > 0) {
     printf("Found %d compilation errors, aborting.\n", ctx.errors);
-    pd_ast_node_free(node);
-    free(state);
-    yylex_destroy(scanner);
-    fclose(f);
-    pvm_free(ctx.vm);
+    return NULL;
+  }
+  return fn;
+}
+
+// Writes compiled code to [path], going through a temporary file so a reader never sees half a file.
+static bool writeBytecode(pvm_t* vm, pd_function* fn, const char* path, uint64_t hash, int64_t mtime) {
+  char temp[PATH_MAX + 16];
+  snprintf(temp, sizeof(temp), "%s.%d.tmp", path, (int)uv_os_getpid());
+  FILE* out = fopen(temp, "wb");
+  if(out == NULL) return false;
+  bool ok = pd_bytecode_write(vm, fn, out, hash, mtime);
+  ok = fclose(out) == 0 && ok;
+  if(!ok || rename(temp, path) != 0) {
+    remove(temp);
+    return false;
+  }
+  return true;
+}
+
+// The compile cache lives in $PERIDOT_CACHE_DIR, $XDG_CACHE_HOME/peridot or ~/.cache/peridot
+// Each source file gets an entry named after the hash of its absolute path, the entry itself
+// remembers the hash and modification time of the source so editing the file makes it stale.
+// Set PERIDOT_NO_CACHE to skip it.
+static bool cachePath(const char* source, char* out, size_t size) {
+  if(getenv("PERIDOT_NO_CACHE")) return false;
+  char dir[PATH_MAX];
+  const char* env;
+  if((env = getenv("PERIDOT_CACHE_DIR")) != NULL) {
+    snprintf(dir, sizeof(dir), "%s", env);
+  } else if((env = getenv("XDG_CACHE_HOME")) != NULL) {
+    snprintf(dir, sizeof(dir), "%s/peridot", env);
+  } else if((env = getenv("HOME")) != NULL) {
+    snprintf(dir, sizeof(dir), "%s/.cache/peridot", env);
+  } else {
+    return false;
+  }
+  // mkdir -p, errors are ignored since the directory usually exists and if it can't be made then writing fails later anyway.
+  for(char* p = dir + 1; *p; p++) {
+    if(*p != '/') continue;
+    *p = '\0';
+    mkdir(dir, 0755);
+    *p = '/';
+  }
+  mkdir(dir, 0755);
+
+  char absolute[PATH_MAX];
+  if(realpath(source, absolute) == NULL) return false;
+  uint64_t key = pd_bytecode_hash((const uint8_t*)absolute, strlen(absolute));
+  return snprintf(out, size, "%s/%016llx.pvm", dir, (unsigned long long)key) < (int)size;
+}
+
+// peridot compile <file> [output]
+// Compiles a source file to a .pvm file, the output defaults to the same name with a .pvm extension.
+static int compileFile(int argc, char* argv[]) {
+  if(argc < 3) {
+    printf("Usage: %s compile <file> [output]\n", argv[0]);
+    return 1;
+  }
+  const char* path = argv[2];
+  size_t size;
+  uint8_t* source = readFile(path, &size);
+  if(source == NULL) {
+    printf("Failed to open '%s'\n", path);
+    return 1;
+  }
+
+  char output[PATH_MAX];
+  if(argc > 3) {
+    snprintf(output, sizeof(output), "%s", argv[3]);
+  } else {
+    snprintf(output, sizeof(output) - 4, "%s", path);
+    char* dot = strrchr(output, '.');
+    if(dot != NULL && strchr(dot, '/') == NULL) *dot = '\0';
+    strcat(output, ".pvm");
+  }
+
+  pvm_t* vm = pvm_new();
+  pd_function* fn = compileSource(vm, source, size, getenv("DUMP_AST") != NULL, false);
+  int status = 0;
+  if(fn == NULL) {
+    status = 1;
+  } else if(!writeBytecode(vm, fn, output, 0, 0)) {
+    printf("Failed to write '%s'\n", output);
+    status = 1;
+  }
+  pvm_free(vm);
+  free(source);
+  return status;
+}
+
+// Checks the magic number at the start of [path] to tell .pvm files apart from source code.
+static bool isBytecodeFile(const char* path) {
+  FILE* f = fopen(path, "rb");
+  if(f == NULL) return false;
+  uint8_t magic[4];
+  size_t size = fread(magic, 1, sizeof(magic), f);
+  fclose(f);
+  return pd_bytecode_is(magic, size);
+}
+
+// A compile cache entry to write once the script ran, see loadFile()
+typedef struct {
+  bool pending; // Compiled from source, the entry was missing or stale.
+  char path[PATH_MAX];
+  uint64_t hash;
+  int64_t mtime;
+} cache_entry;
+
+// Compiles every function in [fn] that never got called, without reporting errors.
+// Returns false if one of them doesn't compile (or already failed) so it can't be written.
+static bool compileRemaining(pvm_t* vm, pd_function* fn) {
+  for(int i = 0; i < fn->chunk.constants.count; i++) {
+    pd_value value = fn->chunk.constants.data[i];
+    if(!IS_OBJECT(value) || !PD_IS_FUNCTION(value)) continue;
+    pd_function* function = PD_AS_FUNCTION(value);
+    if(function->failed || (function->ast != NULL && !pd_compile_lazy(vm, function, true))) return false;
+    if(!compileRemaining(vm, function)) return false;
+  }
+  return true;
+}
+
+// Writes the cache entry loadFile() left for [fn], if any. Scripts with functions that don't compile are never cached
+// so they fail the same way on every run, when (and only when) the broken function is called.
+static void writeCacheEntry(pvm_t* vm, pd_function* fn, cache_entry* cache) {
+  if(!cache->pending) return;
+  cache->pending = false;
+  // A failed write just means no cache next time.
+  if(compileRemaining(vm, fn)) writeBytecode(vm, fn, cache->path, cache->hash, cache->mtime);
+}
+
+// Loads a source or .pvm file in [vm], source files go through the compile cache unless [cache] is NULL.
+// Bytecode is mapped rather than read, see pd_bytecode_map()
+// Source is always compiled lazily, on a cache miss [cache] is left pending and the caller writes it with
+// writeCacheEntry() after running, by then most functions are compiled already.
+// Returns NULL if it failed, errors are reported already.
+static pd_function* loadFile(pvm_t* vm, const char* path, int dump_ast, cache_entry* cache) {
+  pd_function* fn = NULL;
+  if(isBytecodeFile(path)) {
+    fn = pd_bytecode_map(vm, path, NULL, 0);
+    if(fn == NULL) printf("'%s' is not a valid bytecode file or is from a newer version.\n", path);
+    return fn;
+  }
+
+  size_t size;
+  uint8_t* data = readFile(path, &size);
+  if(data == NULL) {
+    printf("Failed to open '%s'\n", path);
+    return NULL;
+  }
+  struct stat info;
+  int64_t mtime = stat(path, &info) == 0 ? (int64_t)info.st_mtime : 0;
+  uint64_t hash = pd_bytecode_hash(data, size);
+  bool cached = cache != NULL && !dump_ast && cachePath(path, cache->path, sizeof(cache->path));
+
+  if(cached) fn = pd_bytecode_map(vm, cache->path, &hash, mtime);
+  if(fn == NULL) {
+    fn = compileSource(vm, data, size, dump_ast, true);
+    if(fn != NULL && cached) {
+      cache->pending = true;
+      cache->hash = hash;
+      cache->mtime = mtime;
+    }
+  }
+  free(data);
+  return fn;
+}
+
+// Runs a file along with the event loop, if [snapshot] isn't NULL the VM is restored from it first.
+static int runFile(const char* path, const char* snapshot, int dump_ast) {
+  pvm_t* vm = pvm_new();
+  pd_function* fn = NULL;
+  cache_entry cache = { .pending = false };
+  if(snapshot != NULL) {
+    size_t size;
+    uint8_t* data = readFile(snapshot, &size);
+    if(data == NULL || !pd_snapshot_read(vm, data, size)) {
+      printf("'%s' is not a valid snapshot or is from another version.\n", snapshot);
+      free(data);
+      pvm_free(vm);
+      return 1;
+    }
+    free(data);
+    // Cache entries are compiled against a fresh VM, the globals of the snapshot wouldn't line up with them.
+    fn = loadFile(vm, path, dump_ast, NULL);
+  } else {
+    fn = loadFile(vm, path, dump_ast, &cache);
+  }
+
+  if(fn == NULL) {
+    pvm_free(vm);
     return 1;
   }
-  pvm_exec(vm, pd_compile_ctx_end(&ctx));
+  // Nothing holds the script once it returned, keep it for the cache entry.
+  pvm_retain(vm, PD_FROM(fn));
+  pvm_exec(vm, fn);
   uv_run(vm->loop, UV_RUN_DEFAULT);
+  writeCacheEntry(vm, fn, &cache);
+  pvm_release(vm, PD_FROM(fn));
   // Cleanup
-  //pd_compile_ctx_end(&ctx);
   pvm_free(vm);
-  pd_ast_node_free(node);
-  free(state);
-  fclose(f);
-  yylex_destroy(scanner);
-  //pvm_free(ctx.vm);
   uv_tty_reset_mode();
   return 0;
 }
+
+// peridot snapshot <file> [output]
+// Runs a file (e.g one that loads and sets up everything a program needs) and saves the heap afterwards
+// the output defaults to the same name with a .pds extension. Start from it with peridot --snapshot <output> <file>
+static int snapshotFile(int argc, char* argv[]) {
+  if(argc < 3) {
+    printf("Usage: %s snapshot <file> [output]\n", argv[0]);
+    return 1;
+  }
+  const char* path = argv[2];
+  char output[PATH_MAX];
+  if(argc > 3) {
+    snprintf(output, sizeof(output), "%s", argv[3]);
+  } else {
+    snprintf(output, sizeof(output) - 4, "%s", path);
+    char* dot = strrchr(output, '.');
+    if(dot != NULL && strchr(dot, '/') == NULL) *dot = '\0';
+    strcat(output, ".pds");
+  }
+
+  pvm_t* vm = pvm_new();
+  cache_entry cache = { .pending = false };
+  pd_function* fn = loadFile(vm, path, getenv("DUMP_AST") != NULL, &cache);
+  if(fn == NULL) {
+    pvm_free(vm);
+    return 1;
+  }
+  pvm_retain(vm, PD_FROM(fn));
+  pvm_exec(vm, fn);
+  uv_run(vm->loop, UV_RUN_DEFAULT);
+
+  int status = 0;
+  char temp[PATH_MAX + 16];
+  snprintf(temp, sizeof(temp), "%s.%d.tmp", output, (int)uv_os_getpid());
+  FILE* out = fopen(temp, "wb");
+  bool ok = out != NULL && pd_snapshot_write(vm, out);
+  if(out != NULL) ok = fclose(out) == 0 && ok;
+  if(!ok || rename(temp, output) != 0) {
+    remove(temp);
+    printf("Failed to write '%s'\n", output);
+    status = 1;
+  }
+  // After the snapshot so its errors are the ones reported for functions that don't compile.
+  writeCacheEntry(vm, fn, &cache);
+  pvm_release(vm, PD_FROM(fn));
+  pvm_free(vm);
+  uv_tty_reset_mode();
+  return status;
+}
+
+int main(int argc, char* argv[]) {
+  // TODO make this flags to be cli flags.
+  // Right now we use getenv as a temporary hack, will need to write a portable argument parser.
+  yydebug = getenv("YYDEBUG") ? 1 : 0; // Debug parser state
+  int dump_ast = getenv("DUMP_AST") ? 1 : 0; // Dump abstract syntax tree
+  int dump_bc = getenv("DUMP_BC") ? 1 : 0; // Dump final bytecode.
+  (void)dump_bc;
+  // Debugging GC and VM will need to be compiled with the proper macro defined, because they add more runtime overhead
+  // since it has to keep checking a condition to whether output debug info, macros are checked at compile time only.
+  
+  if(argc < 2) return repl();
+  if(strcmp(argv[1], "compile") == 0) return compileFile(argc, argv);
+  if(strcmp(argv[1], "snapshot") == 0) return snapshotFile(argc, argv);
+  if(strcmp(argv[1], "--snapshot") == 0) {
+    if(argc < 4) {
+      printf("Usage: %s --snapshot <snapshot> <file>\n", argv[0]);
+      return 1;
+    }
+    return runFile(argv[3], argv[2], dump_ast);
+  }
+  return runFile(argv[1], NULL, dump_ast);
+}
@@ -0,0 +1,347 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include "net.h"
+#include "pvm.h"
+#include "gc.h"
+#include "str.h"
+#include "array.h"
+#include "task.h"
+
+// Reads go into slabs that are reused instead of a malloc for every read.
+// A socket only holds one while a read is in progress and the data is copied into a string right away,
+// so the pool never needs to be bigger than the number of reads that can be in flight at once.
+#define SLAB_SIZE (64 * 1024)
+#define SLAB_POOL_MAX 32
+
+typedef struct slab {
+  struct slab* next;
+  char data[SLAB_SIZE];
+} slab;
+
+// Shared by every VM, there's only one loop and it's single threaded.
+static slab* pool = NULL;
+static int pooled = 0;
+
+static void* allocate(size_t size) {
+  void* result = malloc(size);
+  if(result == NULL) {
+    fprintf(stderr, "Out of memory.\n");
+    exit(1);
+  }
+  return result;
+}
+
+static void allocSlab(uv_handle_t* handle, size_t suggested, uv_buf_t* buf) {
+  (void)handle;
+  (void)suggested;
+  slab* s = pool;
+  if(s != NULL) {
+    pool = s->next;
+    pooled--;
+  } else {
+    s = allocate(sizeof(slab));
+  }
+  *buf = uv_buf_init(s->data, SLAB_SIZE);
+}
+
+static void releaseSlab(const uv_buf_t* buf) {
+  if(buf->base == NULL) return;
+  slab* s = (slab*)(buf->base - offsetof(slab, data));
+  if(pooled >= SLAB_POOL_MAX) {
+    free(s);
+    return;
+  }
+  s->next = pool;
+  pool = s;
+  pooled++;
+}
+
+static void freeHandle(uv_handle_t* handle) {
+  free(handle);
+}
+
+static pd_socket* newSocket(pvm_t* vm, uv_tcp_t* tcp) {
+  pd_socket* socket = ALLOC_OBJECT(vm, pd_socket, PD_OBJ_SOCKET);
+  socket->vm = vm;
+  socket->tcp = tcp;
+  socket->on_connection = NULL_VALUE;
+  socket->reading = NULL;
+  socket->listening = false;
+  tcp->data = socket;
+  return socket;
+}
+
+// A socket argument that is still open, NULL otherwise.
+static pd_socket* openSocket(pd_value value) {
+  if(!IS_OBJECT(value) || !PD_IS_SOCKET(value)) return NULL;
+  pd_socket* socket = PD_AS_SOCKET(value);
+  return socket->tcp == NULL ? NULL : socket;
+}
+
+// The bytes of a string value, short strings are unpacked to [bytes] which holds PD_SSTR_MAX + 1.
+static const char* stringBytes(pd_value value, char* bytes, size_t* len) {
+  if(IS_SHORT_STRING(value)) {
+    *len = pd_sstr_read(value, bytes);
+    return bytes;
+  }
+  *len = PD_STRLEN(value);
+  return PD_AS_CSTRING(value);
+}
+
+// An IPv4 or IPv6 address from the host and port arguments, no name resolution except localhost.
+static bool parseAddress(pd_value host, pd_value port, struct sockaddr_storage* addr) {
+  if(!PD_IS_ANY_STRING(host) || !IS_NUMBER(port)) return false;
+  double number = AS_DOUBLE(port);
+  if(number < 0 || number > 65535 || number != (int)number) return false;
+  char bytes[PD_SSTR_MAX + 1];
+  size_t len;
+  const char* chars = stringBytes(host, bytes, &len);
+  char ip[64];
+  if(len >= sizeof(ip)) return false;
+  memcpy(ip, chars, len);
+  ip[len] = '\0';
+  if(strcmp(ip, "localhost") == 0) strcpy(ip, "127.0.0.1");
+  if(uv_ip4_addr(ip, (int)number, (struct sockaddr_in*)addr) == 0) return true;
+  return uv_ip6_addr(ip, (int)number, (struct sockaddr_in6*)addr) == 0;
+}
+
+// Completes the read in progress on [socket] with [value], which may be null for the end of the stream.
+static void finishRead(pd_socket* socket, pd_value value) {
+  pd_task* task = socket->reading;
+  socket->reading = NULL;
+  pd_task_complete(socket->vm, task, value);
+  pvm_release(socket->vm, PD_FROM(socket));
+}
+
+static void closeSocket(pd_socket* socket) {
+  if(socket->tcp == NULL) return;
+  if(socket->reading != NULL) finishRead(socket, NULL_VALUE);
+  if(socket->listening) {
+    socket->listening = false;
+    pvm_release(socket->vm, PD_FROM(socket));
+  }
+  // Writes still queued fail with ECANCELED, their callbacks don't need the socket.
+  socket->tcp->data = NULL;
+  uv_close((uv_handle_t*)socket->tcp, freeHandle);
+  socket->tcp = NULL;
+}
+
+void pd_socket_free(pvm_t* vm, pd_socket* socket) {
+  // Nothing can be pending, those keep the socket alive.
+  if(socket->tcp != NULL) {
+    socket->tcp->data = NULL;
+    uv_close((uv_handle_t*)socket->tcp, freeHandle);
+  }
+  PD_FREE(vm, pd_socket, socket);
+}
+
+static void onConnection(uv_stream_t* server, int status) {
+  pd_socket* socket = server->data;
+  if(socket == NULL || status < 0) return;
+  pvm_t* vm = socket->vm;
+  uv_tcp_t* tcp = allocate(sizeof(uv_tcp_t));
+  uv_tcp_init(vm->loop, tcp);
+  if(uv_accept(server, (uv_stream_t*)tcp) != 0) {
+    uv_close((uv_handle_t*)tcp, freeHandle);
+    return;
+  }
+  pd_value connection = PD_FROM(newSocket(vm, tcp));
+  // pvm_call_value() pushes the arguments before anything can allocate, errors are reported by the VM.
+  pd_value result;
+  pvm_call_value(vm, socket->on_connection, 1, &connection, &result);
+  pvm_run_tasks(vm);
+}
+
+// listen(host, port, onConnection) starts a server, onConnection is called with each connection.
+// Returns the server or null if binding failed. A port of 0 picks a free one, see port()
+static pd_value netListen(pvm_t* vm, int argc, pd_value* args) {
+  struct sockaddr_storage addr;
+  if(argc < 3 || !parseAddress(args[0], args[1], &addr)) return NULL_VALUE;
+  if(!IS_OBJECT(args[2]) || (!PD_IS_CLOSURE(args[2]) && OBJECT_TYPE(AS_OBJECT(args[2])) != PD_OBJ_NATIVE)) return NULL_VALUE;
+  uv_tcp_t* tcp = allocate(sizeof(uv_tcp_t));
+  uv_tcp_init(vm->loop, tcp);
+  if(uv_tcp_bind(tcp, (struct sockaddr*)&addr, 0) != 0 || uv_listen((uv_stream_t*)tcp, SOMAXCONN, onConnection) != 0) {
+    uv_close((uv_handle_t*)tcp, freeHandle);
+    return NULL_VALUE;
+  }
+  pd_socket* socket = newSocket(vm, tcp);
+  socket->on_connection = args[2];
+  socket->listening = true;
+  // Listening keeps it alive until it's closed, like the event loop keeps running for it.
+  pvm_retain(vm, PD_FROM(socket));
+  return PD_FROM(socket);
+}
+
+typedef struct {
+  uv_connect_t req;
+  pd_socket* socket;
+  pd_task* task;
+} connect_req;
+
+static void onConnect(uv_connect_t* handle, int status) {
+  connect_req* req = (connect_req*)handle;
+  pd_socket* socket = req->socket;
+  pvm_t* vm = socket->vm;
+  if(status != 0) closeSocket(socket);
+  pd_task_complete(vm, req->task, status == 0 ? PD_FROM(socket) : NULL_VALUE);
+  pvm_release(vm, PD_FROM(req->task));
+  pvm_release(vm, PD_FROM(socket));
+  free(req);
+  pvm_run_tasks(vm);
+}
+
+// connect(host, port) gives a task for the connection, null if it couldn't connect.
+static pd_value netConnect(pvm_t* vm, int argc, pd_value* args) {
+  struct sockaddr_storage addr;
+  if(argc < 2 || !parseAddress(args[0], args[1], &addr)) return NULL_VALUE;
+  pd_task* task = pd_task_new(vm);
+  pvm_push(vm, PD_FROM(task)); // GC guard
+  uv_tcp_t* tcp = allocate(sizeof(uv_tcp_t));
+  uv_tcp_init(vm->loop, tcp);
+  pd_socket* socket = newSocket(vm, tcp);
+  connect_req* req = allocate(sizeof(connect_req));
+  req->socket = socket;
+  req->task = task;
+  if(uv_tcp_connect(&req->req, tcp, (struct sockaddr*)&addr, onConnect) != 0) {
+    free(req);
+    closeSocket(socket);
+    pd_task_complete(vm, task, NULL_VALUE);
+  } else {
+    // Only the retained set holds the socket, so it goes in first.
+    pvm_retain(vm, PD_FROM(socket));
+    pvm_retain(vm, PD_FROM(task));
+  }
+  return pvm_pop(vm);
+}
+
+static void onRead(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+  pd_socket* socket = stream->data;
+  // Nothing to do for EAGAIN, or if the socket was closed already.
+  if(socket == NULL || socket->reading == NULL || nread == 0) {
+    releaseSlab(buf);
+    return;
+  }
+  // One chunk per read, the next read() starts reading again.
+  uv_read_stop(stream);
+  // The task is still reachable through the socket while the string is allocated.
+  pd_value data = nread > 0 ? pd_str_new(socket->vm, buf->base, nread) : NULL_VALUE;
+  releaseSlab(buf);
+  finishRead(socket, data);
+  pvm_run_tasks(socket->vm);
+}
+
+// read(conn) gives a task for the next chunk of data as a string, null once the other side is done or on errors.
+static pd_value netRead(pvm_t* vm, int argc, pd_value* args) {
+  if(argc < 1 || !IS_OBJECT(args[0]) || !PD_IS_SOCKET(args[0])) return NULL_VALUE;
+  pd_socket* socket = PD_AS_SOCKET(args[0]);
+  // Reading twice before the first one is done gives the same chunk to both.
+  if(socket->reading != NULL) return PD_FROM(socket->reading);
+  pd_task* task = pd_task_new(vm);
+  if(socket->tcp == NULL || socket->listening) {
+    pd_task_complete(vm, task, NULL_VALUE);
+    return PD_FROM(task);
+  }
+  socket->reading = task;
+  pvm_retain(vm, PD_FROM(socket));
+  if(uv_read_start((uv_stream_t*)socket->tcp, allocSlab, onRead) != 0) finishRead(socket, NULL_VALUE);
+  return PD_FROM(task);
+}
+
+// The buffers point right into the strings, which ride along in the result of the task until it's done.
+// Short strings live in the value itself so their bytes are copied to [small].
+typedef struct {
+  uv_write_t req;
+  pvm_t* vm;
+  pd_task* task;
+  int count;
+  uv_buf_t bufs[];
+  // Followed by char small[count][PD_SSTR_MAX + 1]
+} write_req;
+
+static void onWrite(uv_write_t* handle, int status) {
+  write_req* req = (write_req*)handle;
+  pd_task_complete(req->vm, req->task, BOOL_VAL(status == 0));
+  pvm_release(req->vm, PD_FROM(req->task));
+  pvm_t* vm = req->vm;
+  free(req);
+  pvm_run_tasks(vm);
+}
+
+// write(conn, strings...) writes all the strings in one go without joining them.
+// Gives a task that is true once it's written or false if it failed.
+static pd_value netWrite(pvm_t* vm, int argc, pd_value* args) {
+  if(argc < 2) return NULL_VALUE;
+  pd_socket* socket = openSocket(args[0]);
+  if(socket == NULL || socket->listening) return NULL_VALUE;
+  int count = argc - 1;
+  for(int i = 0; i < count; i++) {
+    if(!PD_IS_ANY_STRING(args[i + 1])) return NULL_VALUE;
+  }
+
+  // Pushing can move the stack, args are only used before that.
+  pd_array* strings = pd_array_new(vm, args + 1, count);
+  pvm_push(vm, PD_FROM(strings)); // GC guard
+  pd_task* task = pd_task_new(vm);
+  task->result = PD_FROM(strings);
+
+  write_req* req = allocate(sizeof(write_req) + (sizeof(uv_buf_t) + PD_SSTR_MAX + 1) * count);
+  char (*small)[PD_SSTR_MAX + 1] = (void*)&req->bufs[count];
+  req->vm = vm;
+  req->task = task;
+  req->count = count;
+  for(int i = 0; i < count; i++) {
+    size_t len;
+    const char* bytes = stringBytes(strings->values.data[i], small[i], &len);
+    req->bufs[i] = uv_buf_init((char*)bytes, len);
+  }
+  // The task holds the strings now, it's the guard while retaining it.
+  vm->stack_top[-1] = PD_FROM(task);
+  if(uv_write(&req->req, (uv_stream_t*)socket->tcp, req->bufs, count, onWrite) != 0) {
+    free(req);
+    pd_task_complete(vm, task, FALSE_VALUE);
+  } else {
+    pvm_retain(vm, PD_FROM(task));
+  }
+  pvm_pop(vm);
+  return PD_FROM(task);
+}
+
+// queued(conn) is the number of bytes written but not sent yet.
+static pd_value netQueued(pvm_t* vm, int argc, pd_value* args) {
+  (void)vm;
+  pd_socket* socket = argc < 1 ? NULL : openSocket(args[0]);
+  if(socket == NULL) return NUMBER_VAL(0);
+  return NUMBER_VAL((double)uv_stream_get_write_queue_size((uv_stream_t*)socket->tcp));
+}
+
+// port(socket) is the local port, for servers listening on port 0.
+static pd_value netPort(pvm_t* vm, int argc, pd_value* args) {
+  (void)vm;
+  pd_socket* socket = argc < 1 ? NULL : openSocket(args[0]);
+  if(socket == NULL) return NULL_VALUE;
+  struct sockaddr_storage addr;
+  int len = sizeof(addr);
+  if(uv_tcp_getsockname(socket->tcp, (struct sockaddr*)&addr, &len) != 0) return NULL_VALUE;
+  if(addr.ss_family == AF_INET6) return NUMBER_VAL(ntohs(((struct sockaddr_in6*)&addr)->sin6_port));
+  return NUMBER_VAL(ntohs(((struct sockaddr_in*)&addr)->sin_port));
+}
+
+// close(socket) closes a connection or stops a server, a read in progress gives null.
+static pd_value netClose(pvm_t* vm, int argc, pd_value* args) {
+  (void)vm;
+  if(argc > 0 && IS_OBJECT(args[0]) && PD_IS_SOCKET(args[0])) closeSocket(PD_AS_SOCKET(args[0]));
+  return NULL_VALUE;
+}
+
+const pd_builtin pd_net_functions[] = {
+  { "net.listen", netListen },
+  { "net.connect", netConnect },
+  { "net.read", netRead },
+  { "net.write", netWrite },
+  { "net.queued", netQueued },
+  { "net.port", netPort },
+  { "net.close", netClose },
+  { NULL, NULL }
+};
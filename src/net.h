@@ -0,0 +1,54 @@
+#ifndef _PERIDOT_NET_H
+#define _PERIDOT_NET_H
+
+#include <stdbool.h>
+#include <uv.h>
+#include "object.h"
+#include "value.h"
+#include "runtime.h"
+
+// The net module, TCP servers and clients on libuv streams.
+//
+//   import net
+//
+//   async function echo(conn)
+//     data = await net.read(conn)
+//     while data != null
+//       await net.write(conn, "you said: ", data)
+//       data = await net.read(conn)
+//     end
+//     net.close(conn)
+//   end
+//
+//   server = net.listen("127.0.0.1", 8080, echo)
+//
+// Everything that waits gives a task, so the pace is set by whoever awaits them:
+// - A read only reads while someone asked for data, the socket stops reading once a chunk arrives
+//   so a slow consumer leaves the data in the kernel instead of piling it up in memory.
+// - A write is done once libuv handed it to the kernel, awaiting it is the backpressure.
+//   net.queued(conn) tells how many bytes are still waiting to be written for code that doesn't await every write.
+//
+// Sockets are objects of their own, one that nobody references anymore gets closed by the GC.
+// While something is pending on it (listening, connecting, a read) it's kept alive with pvm_retain()
+
+typedef struct pd_socket {
+  pd_object obj;
+  pvm_t* vm;
+  // NULL once closed. The handle is allocated separately since libuv needs it until the close callback
+  // and the object may be long gone by then, tcp->data points back to the socket until it's closed.
+  uv_tcp_t* tcp;
+  pd_value on_connection; // What a server calls with each connection.
+  struct pd_task* reading; // The task of the read in progress or NULL.
+  bool listening;
+} pd_socket;
+
+// The functions of the module, see builtin.c
+extern const pd_builtin pd_net_functions[];
+
+// Closes the socket if it's still open and frees it, used by the GC.
+void pd_socket_free(pvm_t* vm, pd_socket* socket);
+
+#define PD_IS_SOCKET(val) (OBJECT_TYPE(AS_OBJECT(val)) == PD_OBJ_SOCKET)
+#define PD_AS_SOCKET(val) ((pd_socket*)AS_OBJECT(val))
+
+#endif // _PERIDOT_NET_H
@@ -16,7 +16,13 @@ typedef enum {
   PD_OBJ_NATIVE, // Native C functions.
   PD_OBJ_CLASS,
   PD_OBJ_CLOSURE, // Closure
-  PD_OBJ_UPVALUE // Captured variable.
+  PD_OBJ_UPVALUE, // Captured variable.
+  PD_OBJ_ARRAY, // [1, 2, 3]
+  PD_OBJ_TYPED_ARRAY, // Float64Array(n) etc, arrays of unboxed numbers.
+  PD_OBJ_DICT, // { "key": value }
+  PD_OBJ_TASK, // What calling an async function gives.
+  PD_OBJ_SOCKET, // A TCP connection or server, see net.h
+  PD_OBJ_FILE_STREAM // Reads a file in chunks, see fs.h
 } pd_object_type;
 
 // The object struct
@@ -5,6 +5,7 @@
 // Being in a seperate file helps people to include the opcodes seperately if they for example want to write a custom frontend.
 // Currently not all opcodes are implemented in the VM.
 // The instruction set is little-endian
+// Compiled code is saved to disk (see bytecode.h) so bump PD_BYTECODE_MINOR when adding or changing an opcode.
 
 typedef enum {
   // Loads a constant
@@ -29,6 +30,13 @@ typedef enum {
   PVM_OP_POP,
   // Like pop but pops n times, useful to reduce multiple pops into a single instruction.
   PVM_OP_POPN,
+  // Pops n values under the top of the stack, the top stays. Used to drop the arguments of an inlined call.
+  // OP_POP_UNDER <n>
+  PVM_OP_POP_UNDER,
+
+  // Pushes a copy of the value n slots under the top of the stack, 0 is the top.
+  // OP_PEEK <n>
+  PVM_OP_PEEK,
 
   // Get/Set a local variable.
   PVM_OP_GET_LOCAL,
@@ -38,15 +46,43 @@ typedef enum {
   PVM_OP_GET_GLOBAL,
   PVM_OP_DEFINE_GLOBAL,
   PVM_OP_SET_GLOBAL,
+  // Same as above but for global indices past 255
+  // OP_GET_GLOBAL_LONG <byte 1> <byte 2>
+  PVM_OP_GET_GLOBAL_LONG,
+  PVM_OP_SET_GLOBAL_LONG,
 
   // Get/Set upvalues (closures)
   PVM_OP_GET_UPVALUE,
   PVM_OP_SET_UPVALUE,
+  // Gets an upvalue that was copied when the closure was created, they can't be set.
+  // OP_GET_UPVALUE_COPY <index>
+  PVM_OP_GET_UPVALUE_COPY,
 
   // Get/Set properties.
+  // Only dictionaries have properties for now, x.name is x["name"] but a missing one is an error.
+  // OP_GET_PROPERTY <name constant byte 1> <name constant byte 2>
   PVM_OP_GET_PROPERTY,
   PVM_OP_SET_PROPERTY,
 
+  // Creates an array from the top n values on the stack, the first element is the deepest one.
+  // OP_ARRAY <count byte 1> <count byte 2>
+  PVM_OP_ARRAY,
+
+  // Index an array, expects the array and the index on the stack.
+  // Indices must be integers within bounds otherwise it's a runtime error.
+  PVM_OP_GET_INDEX,
+  // Like GET_INDEX but also expects the value to assign on top, the value is left on the stack as the result.
+  // Assigning at the index right after the last element appends to the array.
+  PVM_OP_SET_INDEX,
+
+  // Creates a dictionary from the top n key/value pairs on the stack, pushed as key1 value1 key2 value2...
+  // OP_DICT <count byte 1> <count byte 2>
+  PVM_OP_DICT,
+
+  // Removes a key from a dictionary, expects the dictionary and the key on the stack.
+  // Pushes true if the key existed.
+  PVM_OP_DELETE_INDEX,
+
   // Get the Super class.
   PVM_OP_GET_SUPER,
 
@@ -94,13 +130,35 @@ typedef enum {
   PVM_OP_JUMP,
   PVM_OP_JUMP_IF_FALSE,
   PVM_OP_LOOP,
+  // Numeric for loops keep 4 stack slots starting at <slot>: the counter, the limit, the step and the loop variable.
+  // FOR_PREP checks the operands, pushes the loop variable and jumps forward over the loop if the range is empty.
+  // OP_FOR_PREP <slot> <offset byte 1> <offset byte 2>
+  PVM_OP_FOR_PREP,
+  // Steps the counter and jumps back to the body if it's still within the limit, all in a single dispatch.
+  // OP_FOR_LOOP <slot> <offset byte 1> <offset byte 2>
+  PVM_OP_FOR_LOOP,
 
   // Calls and methods.
   PVM_OP_CALL,
+  // Like CALL but reuses the current frame for return f(args) so tail recursion runs in constant frames.
+  // Always followed by a RETURN which is only reached when the callee is a native.
+  // OP_TAIL_CALL <argc>
+  PVM_OP_TAIL_CALL,
+  // Jumps forward if the global holds a closure of a function with the given inline hash (see pd_function.inline_hash)
+  // Inlined calls start with this, it jumps over a regular call of the global to the inlined code.
+  // OP_INLINE_GUARD <global byte 1> <global byte 2> <8 hash bytes> <offset byte 1> <offset byte 2>
+  PVM_OP_INLINE_GUARD,
+  // Replaces the task on top of the stack with its result, suspending the running task until it's done.
+  // Anything that isn't a task is left as is.
+  PVM_OP_AWAIT,
   PVM_OP_INVOKE,
   PVM_OP_SUPER,
   // Closures
+  // OP_CLOSURE <constant index> followed by a <kind> <index> pair for each upvalue.
+  // The kind is 0 for an upvalue of the enclosing closure, 1 to capture a local and 2 to copy the value of a local.
   PVM_OP_CLOSURE,
+  // Same as CLOSURE but with a 2 byte constant index.
+  PVM_OP_CLOSURE_LONG,
   PVM_OP_CLOSE_UPVALUE,
   // Returns a value from the current function frame.
   PVM_OP_RETURN,
@@ -120,7 +178,11 @@ typedef enum {
   PVM_OP_PUSH_TWO,
   PVM_OP_PUSH_THREE,
   PVM_OP_PUSH_FOUR,
-  PVM_OP_PUSH_FIVE
+  PVM_OP_PUSH_FIVE,
+
+  // Pushes the builtin module with the given name, a dictionary of its functions. (see pd_builtin_import())
+  // OP_IMPORT <name constant byte 1> <name constant byte 2>
+  PVM_OP_IMPORT
 } pvm_opcode;
 
 #endif // _PERIDOT_OPCODES_H
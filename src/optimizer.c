@@ -0,0 +1,928 @@
+/**
+ * AST optimization pass, runs over the whole tree before it gets compiled.
+ *
+ * Everything here is done in place, a folded node is simply overwritten with the literal it evaluates to.
+ * The rules must match what the VM would have done at runtime, anything that would error at runtime
+ * (like adding a string to a number) is left alone so the error still happens at the same place.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "optimizer.h"
+#include "value.h"
+#include "opcodes.h"
+#include "function.h"
+#include "str.h"
+
+// Is this node a literal that we know the value of at compile time?
+static bool isConstant(pd_ast_node* node) {
+  pd_ast_type t = node->type;
+  return t == PD_AST_NUMBER || t == PD_AST_STRING || t == PD_AST_BOOLEAN || t == PD_AST_NULL;
+}
+
+// Same rules as AS_BOOL() in the VM, only false, null and 0 are falsy.
+static bool isTruthy(pd_ast_node* node) {
+  switch(node->type) {
+    case PD_AST_BOOLEAN:
+      return node->boolean.value;
+    case PD_AST_NULL:
+      return false;
+    case PD_AST_NUMBER:
+      return node->number.value != 0.0;
+    default:
+      return true;
+  }
+}
+
+// Equality in the VM is a bitwise comparison of the values
+// strings are interned so two equal strings are always the same value.
+static bool constantsEqual(pd_ast_node* a, pd_ast_node* b) {
+  if(a->type != b->type) return false;
+  switch(a->type) {
+    case PD_AST_NUMBER:
+      return NUMBER_VAL(a->number.value) == NUMBER_VAL(b->number.value);
+    case PD_AST_STRING:
+      return strcmp(a->string.value, b->string.value) == 0;
+    case PD_AST_BOOLEAN:
+      return a->boolean.value == b->boolean.value;
+    default:
+      return true; // null
+  }
+}
+
+// Does this node always produce a number? (or an error)
+// All arithmetic only works on numbers in the VM so their results are always numbers.
+static bool isNumeric(pd_ast_node* node) {
+  if(node->type == PD_AST_NUMBER) return true;
+  if(node->type == PD_AST_UNARY) return node->unary.type == PD_UNARY_MINUS || node->unary.type == PD_UNARY_BNOT;
+  if(node->type != PD_AST_BIN_OP) return false;
+  switch(node->binop.op) {
+    case PD_BIN_PLUS:
+    case PD_BIN_MINUS:
+    case PD_BIN_MUL:
+    case PD_BIN_DIV:
+    case PD_BIN_SHL:
+    case PD_BIN_SHR:
+    case PD_BIN_BAND:
+    case PD_BIN_BOR:
+    case PD_BIN_XOR:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Bitwise results are converted from ints so they are never -0
+static bool isInteger(pd_ast_node* node) {
+  if(node->type == PD_AST_UNARY) return node->unary.type == PD_UNARY_BNOT;
+  if(node->type != PD_AST_BIN_OP) return false;
+  pd_binary_op_type op = node->binop.op;
+  return op == PD_BIN_SHL || op == PD_BIN_SHR || op == PD_BIN_BAND || op == PD_BIN_BOR || op == PD_BIN_XOR;
+}
+
+// Overwrites node with child, used to drop a node and keep one of it's operands in it's place.
+// Dropped nodes don't need freeing, they live in the arena of the parse.
+static void replaceWith(pd_ast_node* node, pd_ast_node* child) {
+  *node = *child;
+}
+
+static void makeNumber(pd_ast_node* node, double value) {
+  node->type = PD_AST_NUMBER;
+  node->number.value = value;
+}
+
+static void makeBoolean(pd_ast_node* node, bool value) {
+  node->type = PD_AST_BOOLEAN;
+  node->boolean.value = value;
+}
+
+// Folds a binary operation with two constant operands.
+// Returns false if it can't be folded.
+static bool foldBinary(pd_ast_node* node, pd_ast_node* lhs, pd_ast_node* rhs) {
+  pd_binary_op_type op = node->binop.op;
+  if(op == PD_BIN_EQ || op == PD_BIN_NEQ) {
+    bool equal = constantsEqual(lhs, rhs);
+    makeBoolean(node, op == PD_BIN_EQ ? equal : !equal);
+    return true;
+  }
+
+  if(op == PD_BIN_AND || op == PD_BIN_OR) {
+    // Same as the VM, && results in the lhs if it's falsy otherwise the rhs. || is the opposite.
+    bool truthy = isTruthy(lhs);
+    pd_ast_node* result = (op == PD_BIN_AND) == truthy ? rhs : lhs;
+    replaceWith(node, result);
+    return true;
+  }
+
+  // Everything else only works on numbers.
+  if(lhs->type != PD_AST_NUMBER || rhs->type != PD_AST_NUMBER) return false;
+  double a = lhs->number.value;
+  double b = rhs->number.value;
+
+  switch(op) {
+    case PD_BIN_PLUS: makeNumber(node, a + b); break;
+    case PD_BIN_MINUS: makeNumber(node, a - b); break;
+    case PD_BIN_MUL: makeNumber(node, a * b); break;
+    case PD_BIN_DIV: makeNumber(node, a / b); break;
+    case PD_BIN_GT: makeBoolean(node, a > b); break;
+    case PD_BIN_LT: makeBoolean(node, a < b); break;
+    case PD_BIN_GE: makeBoolean(node, a >= b); break;
+    case PD_BIN_LE: makeBoolean(node, a <= b); break;
+    default: {
+      // The same int32 wrapping as the VM. (see pd_to_int32())
+      int32_t x = pd_to_int32(a);
+      int32_t y = pd_to_int32(b);
+      switch(op) {
+        case PD_BIN_BAND: makeNumber(node, (double)(x & y)); break;
+        case PD_BIN_BOR: makeNumber(node, (double)(x | y)); break;
+        case PD_BIN_XOR: makeNumber(node, (double)(x ^ y)); break;
+        case PD_BIN_SHL: makeNumber(node, (double)pd_shl(x, y)); break;
+        case PD_BIN_SHR: makeNumber(node, (double)pd_shr(x, y)); break;
+        default:
+          return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Simplifies identities where only one operand is constant, e.g x * 1 => x
+// Only done when we know the other side is a number, otherwise we would hide the runtime error of something like "a" * 1
+static void simplifyBinary(pd_ast_node* node, pd_ast_node* lhs, pd_ast_node* rhs) {
+  pd_binary_op_type op = node->binop.op;
+
+  // A constant on the left side of && and || always decides the result.
+  if((op == PD_BIN_AND || op == PD_BIN_OR) && isConstant(lhs)) {
+    foldBinary(node, lhs, rhs);
+    return;
+  }
+
+  bool lnum = lhs->type == PD_AST_NUMBER;
+  bool rnum = rhs->type == PD_AST_NUMBER;
+  pd_ast_node* keep = NULL;
+  switch(op) {
+    case PD_BIN_MUL:
+      if(rnum && rhs->number.value == 1 && isNumeric(lhs)) keep = lhs;
+      else if(lnum && lhs->number.value == 1 && isNumeric(rhs)) keep = rhs;
+      break;
+    case PD_BIN_DIV:
+      if(rnum && rhs->number.value == 1 && isNumeric(lhs)) keep = lhs;
+      break;
+    case PD_BIN_MINUS:
+      // x - 0 is exact even for -0
+      if(rnum && NUMBER_VAL(rhs->number.value) == NUMBER_VAL(0.0) && isNumeric(lhs)) keep = lhs;
+      break;
+    case PD_BIN_PLUS:
+      // -0 + 0 is 0 so x + 0 is only an identity if x can't be -0
+      if(rnum && rhs->number.value == 0 && isInteger(lhs)) keep = lhs;
+      else if(lnum && lhs->number.value == 0 && isInteger(rhs)) keep = rhs;
+      break;
+    default:
+      break;
+  }
+  if(keep == NULL) return;
+  replaceWith(node, keep);
+}
+
+static void optimizeBinary(pd_ast_node* node) {
+  pd_optimize(node->binop.lhs);
+  pd_optimize(node->binop.rhs);
+  pd_ast_node* lhs = node->binop.lhs;
+  pd_ast_node* rhs = node->binop.rhs;
+  if(isConstant(lhs) && isConstant(rhs) && foldBinary(node, lhs, rhs)) return;
+  simplifyBinary(node, lhs, rhs);
+}
+
+static void optimizeUnary(pd_ast_node* node) {
+  pd_optimize(node->unary.rhs);
+  pd_ast_node* rhs = node->unary.rhs;
+  if(!isConstant(rhs)) return;
+  switch(node->unary.type) {
+    case PD_UNARY_NOT:
+      makeBoolean(node, !isTruthy(rhs));
+      break;
+    case PD_UNARY_MINUS:
+      if(rhs->type != PD_AST_NUMBER) return;
+      makeNumber(node, -rhs->number.value);
+      break;
+    case PD_UNARY_BNOT:
+      if(rhs->type != PD_AST_NUMBER) return;
+      makeNumber(node, (double)(~pd_to_int32(rhs->number.value)));
+      break;
+    case PD_UNARY_AWAIT:
+      // Never folded, the compiler still has to check that it's inside an async function.
+      break;
+  }
+}
+
+// Handles both ternaries and if statements, a constant condition means we know the branch to take.
+static void optimizeConditional(pd_ast_node* node) {
+  pd_optimize(node->conditional.condition);
+  pd_optimize(node->conditional.trueNode);
+  pd_optimize(node->conditional.falseNode);
+  pd_ast_node* condition = node->conditional.condition;
+  if(!isConstant(condition)) return;
+
+  pd_ast_node* taken = isTruthy(condition) ? node->conditional.trueNode : node->conditional.falseNode;
+  if(taken != NULL) {
+    replaceWith(node, taken);
+  } else {
+    // if false without an else, nothing is left.
+    node->type = PD_AST_EMPTY;
+  }
+}
+
+static void optimizeWhile(pd_ast_node* node) {
+  pd_optimize(node->while_loop.condition);
+  pd_optimize(node->while_loop.body);
+  // while false never runs.
+  if(isConstant(node->while_loop.condition) && !isTruthy(node->while_loop.condition)) {
+    node->type = PD_AST_EMPTY;
+  }
+}
+
+void pd_optimize(pd_ast_node* node) {
+  if(node == NULL) return;
+  switch(node->type) {
+    case PD_AST_BIN_OP:
+      optimizeBinary(node);
+      break;
+    case PD_AST_UNARY:
+      optimizeUnary(node);
+      break;
+    case PD_AST_CONDITIONAL:
+    case PD_AST_TERNARY:
+      optimizeConditional(node);
+      break;
+    case PD_AST_WHILE:
+      optimizeWhile(node);
+      break;
+    case PD_AST_FOR:
+      pd_optimize(node->for_loop.start);
+      pd_optimize(node->for_loop.limit);
+      pd_optimize(node->for_loop.step);
+      pd_optimize(node->for_loop.body);
+      break;
+    case PD_AST_BLOCK:
+      for(int x = 0; x < node->block.count; x++)
+        pd_optimize(node->block.statements[x]);
+      break;
+    case PD_AST_FUNCTION:
+      pd_optimize(node->function.body);
+      break;
+    case PD_AST_CALL:
+      pd_optimize(node->call.callee);
+      for(int x = 0; x < node->call.argc; x++)
+        pd_optimize(node->call.args[x]);
+      break;
+    case PD_AST_ASSIGN:
+      pd_optimize(node->assign.expr);
+      break;
+    case PD_AST_RETURN:
+      pd_optimize(node->ret.expr);
+      break;
+    case PD_AST_ARRAY:
+      for(int x = 0; x < node->array.count; x++)
+        pd_optimize(node->array.elements[x]);
+      break;
+    case PD_AST_DICT:
+      for(int x = 0; x < node->dict.count; x++) {
+        pd_optimize(node->dict.keys[x]);
+        pd_optimize(node->dict.values[x]);
+      }
+      break;
+    case PD_AST_INDEX:
+    case PD_AST_DELETE:
+      pd_optimize(node->index.expr);
+      pd_optimize(node->index.index);
+      pd_optimize(node->index.value);
+      break;
+    case PD_AST_PROPERTY:
+      pd_optimize(node->property.expr);
+      break;
+    default:
+      break; // Literals and variables, nothing to do.
+  }
+}
+
+/**
+ * Inlining, calls to small functions defined at the top-level are compiled as the body of the function right there.
+ *
+ * A function qualifies if its body is a single return of a small expression that doesn't call anything,
+ * so it can't be recursive either, and its global is never assigned or defined again at the top-level.
+ * (the only place globals are assigned) This pass finds them and binds the calls to them, the compiler does the rest.
+ * The global could still change at runtime from code compiled separately (e.g the REPL) so the inlined code checks that
+ * first, see compileInlined() in compiler.c
+ */
+
+// Biggest expression we inline, in nodes, about as many instructions as it ends up being.
+#define PD_INLINE_MAX_NODES 16
+
+typedef struct {
+  char* name; // NULL for empty entries.
+  int len;
+  uint32_t hash;
+  pd_ast_node* function; // NULL once something else assigns the name.
+} pd_inline_entry;
+
+typedef struct {
+  pd_inline_entry* entries;
+  int capacity; // Power of two.
+} pd_inline_table;
+
+// Returns the entry for [name] or the empty one it would go in.
+static pd_inline_entry* findEntry(pd_inline_table* table, char* name, int len) {
+  uint32_t hash = pd_str_hash_bytes(name, len);
+  for(uint32_t i = hash & (table->capacity - 1);; i = (i + 1) & (table->capacity - 1)) {
+    pd_inline_entry* entry = &table->entries[i];
+    if(entry->name == NULL || (entry->hash == hash && entry->len == len && memcmp(entry->name, name, len) == 0)) {
+      entry->hash = hash;
+      return entry;
+    }
+  }
+}
+
+// Counts the nodes of an expression that can be inlined, -1 if it has anything that can't.
+// Only pure expressions over the parameters and globals are allowed, anything that calls or assigns is not.
+static int inlineSize(pd_ast_node* node) {
+  if(node == NULL) return 0;
+  int size = 1;
+  int child;
+  switch(node->type) {
+    case PD_AST_NUMBER:
+    case PD_AST_STRING:
+    case PD_AST_BOOLEAN:
+    case PD_AST_NULL:
+    case PD_AST_VARIABLE:
+      return 1;
+    case PD_AST_BIN_OP:
+      if((child = inlineSize(node->binop.lhs)) == -1) return -1;
+      size += child;
+      if((child = inlineSize(node->binop.rhs)) == -1) return -1;
+      return size + child;
+    case PD_AST_UNARY:
+      if((child = inlineSize(node->unary.rhs)) == -1) return -1;
+      return size + child;
+    case PD_AST_TERNARY:
+      if((child = inlineSize(node->conditional.condition)) == -1) return -1;
+      size += child;
+      if((child = inlineSize(node->conditional.trueNode)) == -1) return -1;
+      size += child;
+      if((child = inlineSize(node->conditional.falseNode)) == -1) return -1;
+      return size + child;
+    case PD_AST_INDEX:
+      if(node->index.value != NULL) return -1;
+      if((child = inlineSize(node->index.expr)) == -1) return -1;
+      size += child;
+      if((child = inlineSize(node->index.index)) == -1) return -1;
+      return size + child;
+    default:
+      return -1;
+  }
+}
+
+// The body of a function that can be inlined is a single return, returns its expression or NULL if it's anything else.
+static pd_ast_node* inlineBody(pd_ast_node* function) {
+  pd_ast_node* body = function->function.body;
+  // Calling an async function starts a task, there's no expression to substitute.
+  if(function->function.async) return NULL;
+  if(function->function.prototype->prototype.argc > PD_INLINE_MAX_ARGS) return NULL;
+  if(body == NULL || body->type != PD_AST_BLOCK || body->block.count != 1) return NULL;
+  pd_ast_node* ret = body->block.statements[0];
+  if(ret->type != PD_AST_RETURN || ret->ret.expr == NULL) return NULL;
+  int size = inlineSize(ret->ret.expr);
+  return size == -1 || size > PD_INLINE_MAX_NODES ? NULL : ret->ret.expr;
+}
+
+static uint64_t hashBytes(uint64_t hash, const void* data, size_t size) {
+  const uint8_t* bytes = data;
+  for(size_t i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+// 64 bit FNV-1a over everything the expression does, two functions only hash the same if they compute the same thing.
+static uint64_t hashTree(uint64_t hash, pd_ast_node* node) {
+  if(node == NULL) return hashBytes(hash, "", 1);
+  hash = hashBytes(hash, &node->type, sizeof(node->type));
+  switch(node->type) {
+    case PD_AST_NUMBER:
+      return hashBytes(hash, &node->number.value, sizeof(double));
+    case PD_AST_STRING:
+      hash = hashBytes(hash, &node->string.len, sizeof(int));
+      return hashBytes(hash, node->string.value, node->string.len);
+    case PD_AST_BOOLEAN:
+      return hashBytes(hash, &node->boolean.value, sizeof(bool));
+    case PD_AST_VARIABLE:
+      hash = hashBytes(hash, &node->variable.len, sizeof(int));
+      return hashBytes(hash, node->variable.name, node->variable.len);
+    case PD_AST_BIN_OP:
+      hash = hashBytes(hash, &node->binop.op, sizeof(node->binop.op));
+      return hashTree(hashTree(hash, node->binop.lhs), node->binop.rhs);
+    case PD_AST_UNARY:
+      hash = hashBytes(hash, &node->unary.type, sizeof(node->unary.type));
+      return hashTree(hash, node->unary.rhs);
+    case PD_AST_TERNARY:
+      hash = hashTree(hash, node->conditional.condition);
+      return hashTree(hashTree(hash, node->conditional.trueNode), node->conditional.falseNode);
+    case PD_AST_INDEX:
+      return hashTree(hashTree(hash, node->index.expr), node->index.index);
+    default:
+      return hash;
+  }
+}
+
+static uint64_t hashFunction(pd_ast_node* function, pd_ast_node* expr) {
+  pd_ast_node* prototype = function->function.prototype;
+  uint64_t hash = hashBytes(14695981039346656037ull, &prototype->prototype.argc, sizeof(int));
+  for(int x = 0; x < prototype->prototype.argc; x++) {
+    hash = hashBytes(hash, &prototype->prototype.args[x].len, sizeof(int));
+    hash = hashBytes(hash, prototype->prototype.args[x].chars, prototype->prototype.args[x].len);
+  }
+  hash = hashTree(hash, expr);
+  return hash == 0 ? 1 : hash; // 0 means not inlined.
+}
+
+// Drops every function whose global is assigned or defined somewhere else in the top-level code.
+// Doesn't go into functions, assigning in there declares a local.
+static void findAssignments(pd_inline_table* table, pd_ast_node* node) {
+  if(node == NULL) return;
+  pd_inline_entry* entry;
+  switch(node->type) {
+    case PD_AST_ASSIGN:
+      entry = findEntry(table, node->assign.name, node->assign.len);
+      if(entry->name != NULL) entry->function = NULL;
+      findAssignments(table, node->assign.expr);
+      break;
+    case PD_AST_FUNCTION: {
+      pd_ast_node* prototype = node->function.prototype;
+      entry = findEntry(table, prototype->prototype.name, prototype->prototype.len);
+      if(entry->name != NULL && entry->function != node) entry->function = NULL;
+      break;
+    }
+    case PD_AST_BLOCK:
+      for(int x = 0; x < node->block.count; x++)
+        findAssignments(table, node->block.statements[x]);
+      break;
+    case PD_AST_CONDITIONAL:
+    case PD_AST_TERNARY:
+      findAssignments(table, node->conditional.condition);
+      findAssignments(table, node->conditional.trueNode);
+      findAssignments(table, node->conditional.falseNode);
+      break;
+    case PD_AST_WHILE:
+      findAssignments(table, node->while_loop.condition);
+      findAssignments(table, node->while_loop.body);
+      break;
+    case PD_AST_FOR:
+      findAssignments(table, node->for_loop.start);
+      findAssignments(table, node->for_loop.limit);
+      findAssignments(table, node->for_loop.step);
+      findAssignments(table, node->for_loop.body);
+      break;
+    case PD_AST_CALL:
+      findAssignments(table, node->call.callee);
+      for(int x = 0; x < node->call.argc; x++)
+        findAssignments(table, node->call.args[x]);
+      break;
+    case PD_AST_RETURN:
+      findAssignments(table, node->ret.expr);
+      break;
+    case PD_AST_BIN_OP:
+      findAssignments(table, node->binop.lhs);
+      findAssignments(table, node->binop.rhs);
+      break;
+    case PD_AST_UNARY:
+      findAssignments(table, node->unary.rhs);
+      break;
+    case PD_AST_ARRAY:
+      for(int x = 0; x < node->array.count; x++)
+        findAssignments(table, node->array.elements[x]);
+      break;
+    case PD_AST_DICT:
+      for(int x = 0; x < node->dict.count; x++) {
+        findAssignments(table, node->dict.keys[x]);
+        findAssignments(table, node->dict.values[x]);
+      }
+      break;
+    case PD_AST_INDEX:
+    case PD_AST_DELETE:
+      findAssignments(table, node->index.expr);
+      findAssignments(table, node->index.index);
+      findAssignments(table, node->index.value);
+      break;
+    case PD_AST_PROPERTY:
+      findAssignments(table, node->property.expr);
+      break;
+    default:
+      break;
+  }
+}
+
+// Binds every call to a function in [table] with the right number of arguments, functions included this time.
+static void bindCalls(pd_inline_table* table, pd_ast_node* node) {
+  if(node == NULL) return;
+  switch(node->type) {
+    case PD_AST_CALL: {
+      // x.name(args) calls whatever the property is, not the top-level function that happens to have the same name.
+      bindCalls(table, node->call.callee);
+      pd_inline_entry* entry = node->call.callee != NULL ? NULL : findEntry(table, node->call.name, node->call.len);
+      if(entry != NULL && entry->name != NULL && entry->function != NULL &&
+          entry->function->function.prototype->prototype.argc == node->call.argc) {
+        node->call.inlined = entry->function;
+      }
+      for(int x = 0; x < node->call.argc; x++)
+        bindCalls(table, node->call.args[x]);
+      break;
+    }
+    case PD_AST_FUNCTION:
+      bindCalls(table, node->function.body);
+      break;
+    case PD_AST_ASSIGN:
+      bindCalls(table, node->assign.expr);
+      break;
+    case PD_AST_BLOCK:
+      for(int x = 0; x < node->block.count; x++)
+        bindCalls(table, node->block.statements[x]);
+      break;
+    case PD_AST_CONDITIONAL:
+    case PD_AST_TERNARY:
+      bindCalls(table, node->conditional.condition);
+      bindCalls(table, node->conditional.trueNode);
+      bindCalls(table, node->conditional.falseNode);
+      break;
+    case PD_AST_WHILE:
+      bindCalls(table, node->while_loop.condition);
+      bindCalls(table, node->while_loop.body);
+      break;
+    case PD_AST_FOR:
+      bindCalls(table, node->for_loop.start);
+      bindCalls(table, node->for_loop.limit);
+      bindCalls(table, node->for_loop.step);
+      bindCalls(table, node->for_loop.body);
+      break;
+    case PD_AST_RETURN:
+      bindCalls(table, node->ret.expr);
+      break;
+    case PD_AST_BIN_OP:
+      bindCalls(table, node->binop.lhs);
+      bindCalls(table, node->binop.rhs);
+      break;
+    case PD_AST_UNARY:
+      bindCalls(table, node->unary.rhs);
+      break;
+    case PD_AST_ARRAY:
+      for(int x = 0; x < node->array.count; x++)
+        bindCalls(table, node->array.elements[x]);
+      break;
+    case PD_AST_DICT:
+      for(int x = 0; x < node->dict.count; x++) {
+        bindCalls(table, node->dict.keys[x]);
+        bindCalls(table, node->dict.values[x]);
+      }
+      break;
+    case PD_AST_INDEX:
+    case PD_AST_DELETE:
+      bindCalls(table, node->index.expr);
+      bindCalls(table, node->index.index);
+      bindCalls(table, node->index.value);
+      break;
+    case PD_AST_PROPERTY:
+      bindCalls(table, node->property.expr);
+      break;
+    default:
+      break;
+  }
+}
+
+void pd_optimize_inline(pd_arena* arena, pd_ast_node* root) {
+  if(root->type != PD_AST_BLOCK) return;
+  // Only functions right in the top-level block, the ones nested in an if or a loop may not be defined at all.
+  int count = 0;
+  for(int x = 0; x < root->block.count; x++) {
+    pd_ast_node* node = root->block.statements[x];
+    if(node->type == PD_AST_FUNCTION && inlineBody(node) != NULL) count++;
+  }
+  if(count == 0) return;
+
+  pd_inline_table table;
+  table.capacity = 8;
+  while(table.capacity < count * 2) table.capacity *= 2;
+  table.entries = pd_arena_alloc(arena, sizeof(pd_inline_entry) * table.capacity);
+  memset(table.entries, 0, sizeof(pd_inline_entry) * table.capacity);
+  for(int x = 0; x < root->block.count; x++) {
+    pd_ast_node* node = root->block.statements[x];
+    if(node->type != PD_AST_FUNCTION || inlineBody(node) == NULL) continue;
+    pd_ast_node* prototype = node->function.prototype;
+    pd_inline_entry* entry = findEntry(&table, prototype->prototype.name, prototype->prototype.len);
+    // Defined twice, the first one gets dropped with the second one by findAssignments()
+    if(entry->name != NULL) continue;
+    entry->name = prototype->prototype.name;
+    entry->len = prototype->prototype.len;
+    entry->function = node;
+  }
+  findAssignments(&table, root);
+
+  for(int x = 0; x < table.capacity; x++) {
+    pd_ast_node* function = table.entries[x].function;
+    if(function != NULL) function->function.inline_hash = hashFunction(function, inlineBody(function));
+  }
+  bindCalls(&table, root);
+}
+
+/**
+ * Peephole optimizer, runs over each function's chunk after it's fully compiled.
+ *
+ * The code is decoded into a list of instructions first so we can move things around without worrying about offsets,
+ * then it's written back in place, the result is never bigger than the input so the same buffers can be reused.
+ */
+
+typedef struct {
+  int offset; // Offset in the original code.
+  int length; // Length in bytes including operands.
+  int line;
+  int target; // Index of the instruction this one jumps to or -1 if it doesn't jump.
+  int pops; // For merged runs of pops, how many values are popped.
+  int newOffset;
+  bool reachable;
+  bool removed;
+  bool isTarget;
+} pd_peephole_instr;
+
+// Returns the length of the instruction at [offset] or -1 for instructions the compiler never emits.
+static int instructionLength(pvm_chunk* chunk, int offset) {
+  switch(chunk->code[offset]) {
+    case PVM_OP_CONSTANT:
+    case PVM_OP_POPN:
+    case PVM_OP_POP_UNDER:
+    case PVM_OP_PEEK:
+    case PVM_OP_GET_LOCAL:
+    case PVM_OP_SET_LOCAL:
+    case PVM_OP_GET_GLOBAL:
+    case PVM_OP_SET_GLOBAL:
+    case PVM_OP_GET_UPVALUE:
+    case PVM_OP_SET_UPVALUE:
+    case PVM_OP_GET_UPVALUE_COPY:
+    case PVM_OP_CALL:
+    case PVM_OP_TAIL_CALL:
+      return 2;
+    case PVM_OP_CONSTANT_LONG:
+    case PVM_OP_GET_GLOBAL_LONG:
+    case PVM_OP_SET_GLOBAL_LONG:
+    case PVM_OP_ARRAY:
+    case PVM_OP_DICT:
+    case PVM_OP_JUMP:
+    case PVM_OP_JUMP_IF_FALSE:
+    case PVM_OP_AND:
+    case PVM_OP_OR:
+    case PVM_OP_LOOP:
+    case PVM_OP_GET_PROPERTY:
+    case PVM_OP_IMPORT:
+      return 3;
+    case PVM_OP_FOR_PREP:
+    case PVM_OP_FOR_LOOP:
+      return 4;
+    case PVM_OP_INLINE_GUARD:
+      return 13;
+    case PVM_OP_CLOSURE: {
+      pd_function* function = PD_AS_FUNCTION(chunk->constants.data[chunk->code[offset + 1]]);
+      return 2 + function->upvalue_count * 2;
+    }
+    case PVM_OP_CLOSURE_LONG: {
+      pd_function* function = PD_AS_FUNCTION(chunk->constants.data[chunk->code[offset + 1] | (chunk->code[offset + 2] << 8)]);
+      return 3 + function->upvalue_count * 2;
+    }
+    case PVM_OP_NULL:
+    case PVM_OP_TRUE:
+    case PVM_OP_FALSE:
+    case PVM_OP_POP:
+    case PVM_OP_GET_INDEX:
+    case PVM_OP_SET_INDEX:
+    case PVM_OP_DELETE_INDEX:
+    case PVM_OP_EQ:
+    case PVM_OP_NEQ:
+    case PVM_OP_GT:
+    case PVM_OP_LT:
+    case PVM_OP_LE:
+    case PVM_OP_GE:
+    case PVM_OP_ADD:
+    case PVM_OP_SUBTRACT:
+    case PVM_OP_MULTIPLY:
+    case PVM_OP_DIVIDE:
+    case PVM_OP_NOT:
+    case PVM_OP_NEGATE:
+    case PVM_OP_SHL:
+    case PVM_OP_SHR:
+    case PVM_OP_BAND:
+    case PVM_OP_BOR:
+    case PVM_OP_XOR:
+    case PVM_OP_BNOT:
+    case PVM_OP_AWAIT:
+    case PVM_OP_CLOSE_UPVALUE:
+    case PVM_OP_RETURN:
+    case PVM_OP_RETURN_NULL:
+    case PVM_OP_PUSH_NEG_ONE:
+    case PVM_OP_PUSH_ZERO:
+    case PVM_OP_PUSH_ONE:
+    case PVM_OP_PUSH_TWO:
+    case PVM_OP_PUSH_THREE:
+    case PVM_OP_PUSH_FOUR:
+    case PVM_OP_PUSH_FIVE:
+      return 1;
+    default:
+      return -1;
+  }
+}
+
+// Returns the absolute offset a jump instruction goes to or -1 if it's not a jump.
+static int jumpTarget(pvm_chunk* chunk, int offset) {
+  uint8_t* code = chunk->code + offset;
+  switch(code[0]) {
+    case PVM_OP_JUMP:
+    case PVM_OP_JUMP_IF_FALSE:
+    case PVM_OP_AND:
+    case PVM_OP_OR:
+      return offset + 3 + (code[1] | (code[2] << 8));
+    case PVM_OP_LOOP:
+      return offset + 3 - (code[1] | (code[2] << 8));
+    case PVM_OP_FOR_PREP:
+      return offset + 4 + (code[2] | (code[3] << 8));
+    case PVM_OP_FOR_LOOP:
+      return offset + 4 - (code[2] | (code[3] << 8));
+    case PVM_OP_INLINE_GUARD:
+      return offset + 13 + (code[11] | (code[12] << 8));
+    default:
+      return -1;
+  }
+}
+
+static bool isUnconditionalJump(uint8_t op) {
+  return op == PVM_OP_JUMP || op == PVM_OP_LOOP;
+}
+
+// Does execution never continue to the next instruction?
+static bool endsFlow(uint8_t op) {
+  return isUnconditionalJump(op) || op == PVM_OP_RETURN || op == PVM_OP_RETURN_NULL;
+}
+
+// Jumps to an unconditional jump can go straight to the final destination.
+// JUMP and LOOP can go either way since we can swap between them but the rest only jump in one direction.
+static void threadJumps(pvm_chunk* chunk, pd_peephole_instr* instrs, int count) {
+  for(int i = 0; i < count; i++) {
+    if(instrs[i].target == -1) continue;
+    uint8_t op = chunk->code[instrs[i].offset];
+    int target = instrs[i].target;
+    // Bounded by count so a loop of jumps (e.g an empty infinite loop) can't hang us.
+    for(int hops = 0; hops < count && isUnconditionalJump(chunk->code[instrs[target].offset]); hops++) {
+      int next = instrs[target].target;
+      if(next == target) break;
+      if(!isUnconditionalJump(op) && (op == PVM_OP_FOR_LOOP ? next > i : next <= i)) break;
+      target = next;
+    }
+    instrs[i].target = target;
+  }
+}
+
+static void markReachable(pvm_chunk* chunk, pd_peephole_instr* instrs, int count) {
+  int* worklist = malloc(sizeof(int) * count);
+  int top = 0;
+  worklist[top++] = 0;
+  instrs[0].reachable = true;
+  while(top > 0) {
+    int i = worklist[--top];
+    int successors[2] = { -1, instrs[i].target };
+    if(!endsFlow(chunk->code[instrs[i].offset]) && i + 1 < count) successors[0] = i + 1;
+    for(int x = 0; x < 2; x++) {
+      int next = successors[x];
+      if(next == -1 || instrs[next].reachable) continue;
+      instrs[next].reachable = true;
+      worklist[top++] = next;
+    }
+  }
+  free(worklist);
+}
+
+// Skips over removed instructions, removing an instruction that is jumped to means the jump now lands on whatever follows it.
+static int nextSurviving(pd_peephole_instr* instrs, int count, int index) {
+  while(index < count - 1 && instrs[index].removed) index++;
+  return index;
+}
+
+void pd_optimize_chunk(pvm_chunk* chunk) {
+  if(chunk->count == 0) return;
+
+  // Decode.
+  pd_peephole_instr* instrs = malloc(sizeof(pd_peephole_instr) * chunk->count);
+  int* indexOf = malloc(sizeof(int) * (chunk->count + 1)); // offset -> instruction index
+  int count = 0;
+  for(int offset = 0; offset < chunk->count;) {
+    int length = instructionLength(chunk, offset);
+    if(length == -1) goto done; // Something we don't understand, leave the chunk alone.
+    indexOf[offset] = count;
+    for(int x = 1; x < length; x++) indexOf[offset + x] = -1;
+    pd_peephole_instr* instr = &instrs[count++];
+    instr->offset = offset;
+    instr->length = length;
+    instr->line = chunk->lines[offset];
+    instr->pops = 0;
+    instr->reachable = false;
+    instr->removed = false;
+    instr->isTarget = false;
+    offset += length;
+  }
+  for(int i = 0; i < count; i++) {
+    int target = jumpTarget(chunk, instrs[i].offset);
+    // Jumps must land on an instruction, bail out otherwise.
+    if(target != -1 && (target < 0 || target >= chunk->count || indexOf[target] == -1)) goto done;
+    instrs[i].target = target == -1 ? -1 : indexOf[target];
+  }
+
+  threadJumps(chunk, instrs, count);
+  markReachable(chunk, instrs, count);
+
+  // Remove dead code and jumps that land on the very next instruction, going backwards so chains of those all go away.
+  int next = -1; // The next instruction that survives.
+  for(int i = count - 1; i >= 0; i--) {
+    if(instrs[i].target != -1) instrs[i].target = nextSurviving(instrs, count, instrs[i].target);
+    if(!instrs[i].reachable ||
+        (chunk->code[instrs[i].offset] == PVM_OP_JUMP && instrs[i].target == next)) {
+      instrs[i].removed = true;
+      continue;
+    }
+    next = i;
+  }
+  for(int i = 0; i < count; i++) {
+    if(instrs[i].removed || instrs[i].target == -1) continue;
+    instrs[i].target = nextSurviving(instrs, count, instrs[i].target);
+    instrs[instrs[i].target].isTarget = true;
+  }
+
+  // Merge runs of pops into a single POPN, a jump into the middle of a run would skip part of it so targets end a run.
+  for(int i = 0; i < count; i++) {
+    uint8_t op = chunk->code[instrs[i].offset];
+    if(instrs[i].removed || (op != PVM_OP_POP && op != PVM_OP_POPN)) continue;
+    int pops = op == PVM_OP_POP ? 1 : chunk->code[instrs[i].offset + 1];
+    int j = i + 1;
+    for(; j < count; j++) {
+      if(instrs[j].removed) continue;
+      uint8_t next = chunk->code[instrs[j].offset];
+      if(instrs[j].isTarget || (next != PVM_OP_POP && next != PVM_OP_POPN)) break;
+      int more = next == PVM_OP_POP ? 1 : chunk->code[instrs[j].offset + 1];
+      if(pops + more > UINT8_MAX) break;
+      pops += more;
+      instrs[j].removed = true;
+    }
+    instrs[i].pops = pops;
+    instrs[i].length = pops == 1 ? 1 : 2;
+    i = j - 1;
+  }
+
+  // Lay out the surviving code, removed instructions take the offset of whatever comes after them
+  // so anything that jumped to them now lands on the right place.
+  int newCount = 0;
+  for(int i = 0; i < count; i++) {
+    instrs[i].newOffset = newCount;
+    if(!instrs[i].removed) newCount += instrs[i].length;
+  }
+
+  // Write everything back, new offsets are never after the old ones so copying forward is safe.
+  for(int i = 0; i < count; i++) {
+    pd_peephole_instr* instr = &instrs[i];
+    if(instr->removed) continue;
+    uint8_t* code = chunk->code + instr->newOffset;
+    if(instr->pops > 0) {
+      if(instr->pops == 1) {
+        code[0] = PVM_OP_POP;
+      } else {
+        code[0] = PVM_OP_POPN;
+        code[1] = (uint8_t)instr->pops;
+      }
+    } else {
+      memmove(code, chunk->code + instr->offset, instr->length);
+    }
+    for(int x = 0; x < instr->length; x++) chunk->lines[instr->newOffset + x] = instr->line;
+
+    if(instr->target == -1) continue;
+    int end = instr->newOffset + instr->length;
+    int target = instrs[instr->target].newOffset;
+    // The offset operand sits at the end of every jump.
+    uint8_t* operand = code + instr->length - 2;
+    int jump;
+    if(isUnconditionalJump(code[0])) {
+      code[0] = target >= end ? PVM_OP_JUMP : PVM_OP_LOOP;
+      jump = target >= end ? target - end : end - target;
+    } else if(code[0] == PVM_OP_FOR_LOOP) {
+      jump = end - target;
+    } else {
+      jump = target - end;
+    }
+    operand[0] = jump & 0xff;
+    operand[1] = (jump >> 8) & 0xff;
+  }
+  chunk->count = newCount;
+
+done:
+  free(instrs);
+  free(indexOf);
+}
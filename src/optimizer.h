@@ -0,0 +1,29 @@
+#ifndef _PERIDOT_OPTIMIZER_H
+#define _PERIDOT_OPTIMIZER_H
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include "ast.h"
+#include "chunk.h"
+
+// Optimizes the tree in place before compilation.
+// Folds constant expressions and dead branches and simplifies a few identities like x * 1
+void pd_optimize(pd_ast_node* node);
+
+// Most parameters a function can have to be inlined.
+#define PD_INLINE_MAX_ARGS 16
+
+// Finds the small functions defined at the top-level of [root] that calls can be inlined to and binds the calls to them.
+// (see pd_ast_call.inlined) The tree must not be compiled before this, [arena] is the one it was parsed in.
+void pd_optimize_inline(pd_arena* arena, pd_ast_node* root);
+
+// Peephole pass over a finished chunk of bytecode.
+// Threads jumps, removes unreachable code and merges pops, the jump offsets and lines are rewritten to match.
+void pd_optimize_chunk(pvm_chunk* chunk);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // _PERIDOT_OPTIMIZER_H
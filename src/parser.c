@@ -1,8 +1,8 @@
-/* A Bison parser, made by GNU Bison 3.4.2.  */
+/* A Bison parser, made by GNU Bison 3.8.2.  */
 
 /* Bison implementation for Yacc-like parsers in C
 
-   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2019 Free Software Foundation,
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
    Inc.
 
    This program is free software: you can redistribute it and/or modify
@@ -16,7 +16,7 @@
    GNU General Public License for more details.
 
    You should have received a copy of the GNU General Public License
-   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
 
 /* As a special exception, you may create a larger work that contains
    part or all of the Bison parser skeleton and distribute that work
@@ -34,6 +34,10 @@
 /* C LALR(1) parser skeleton written by Richard Stallman, by
    simplifying the original so-called "semantic" parser.  */
 
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
+
 /* All symbols defined below should begin with yy or YY, to avoid
    infringing on user name space.  This should be done even for local
    variables, as they might otherwise be expanded by user macros.
@@ -41,14 +45,11 @@
    define necessary library symbols; they are noted "INFRINGES ON
    USER NAME SPACE" below.  */
 
-/* Undocumented macros, especially those whose name start with YY_,
-   are private implementation details.  Do not rely on them.  */
-
-/* Identify Bison output.  */
-#define YYBISON 1
+/* Identify Bison output, and Bison version.  */
+#define YYBISON 30802
 
-/* Bison version.  */
-#define YYBISON_VERSION "3.4.2"
+/* Bison version string.  */
+#define YYBISON_VERSION "3.8.2"
 
 /* Skeleton name.  */
 #define YYSKELETON_NAME "yacc.c"
@@ -80,8 +81,20 @@
 #include "lexer.h"
 #include "ast.h"
 
-#line 84 "parser.c"
+// Nodes and token text all go in the arena of the parse, the lexer carries it.
+#define ARENA (lexer->arena)
+
+#line 88 "parser.c"
 
+# ifndef YY_CAST
+#  ifdef __cplusplus
+#   define YY_CAST(Type, Val) static_cast<Type> (Val)
+#   define YY_REINTERPRET_CAST(Type, Val) reinterpret_cast<Type> (Val)
+#  else
+#   define YY_CAST(Type, Val) ((Type) (Val))
+#   define YY_REINTERPRET_CAST(Type, Val) ((Type) (Val))
+#  endif
+# endif
 # ifndef YY_NULLPTR
 #  if defined __cplusplus
 #   if 201103L <= __cplusplus
@@ -94,167 +107,192 @@
 #  endif
 # endif
 
-/* Enabling verbose error messages.  */
-#ifdef YYERROR_VERBOSE
-# undef YYERROR_VERBOSE
-# define YYERROR_VERBOSE 1
-#else
-# define YYERROR_VERBOSE 0
-#endif
+#include "parser.h"
+/* Symbol kind.  */
+enum yysymbol_kind_t
+{
+  YYSYMBOL_YYEMPTY = -2,
+  YYSYMBOL_YYEOF = 0,                      /* "end of file"  */
+  YYSYMBOL_YYerror = 1,                    /* error  */
+  YYSYMBOL_YYUNDEF = 2,                    /* "invalid token"  */
+  YYSYMBOL_tIDENT = 3,                     /* tIDENT  */
+  YYSYMBOL_tSTRING = 4,                    /* tSTRING  */
+  YYSYMBOL_tNUMBER = 5,                    /* tNUMBER  */
+  YYSYMBOL_tTRUE = 6,                      /* tTRUE  */
+  YYSYMBOL_tFALSE = 7,                     /* tFALSE  */
+  YYSYMBOL_tNULL = 8,                      /* tNULL  */
+  YYSYMBOL_tGT = 9,                        /* tGT  */
+  YYSYMBOL_tGE = 10,                       /* tGE  */
+  YYSYMBOL_tLT = 11,                       /* tLT  */
+  YYSYMBOL_tLE = 12,                       /* tLE  */
+  YYSYMBOL_tPLUS = 13,                     /* tPLUS  */
+  YYSYMBOL_tMINUS = 14,                    /* tMINUS  */
+  YYSYMBOL_tSLASH = 15,                    /* tSLASH  */
+  YYSYMBOL_tSTAR = 16,                     /* tSTAR  */
+  YYSYMBOL_tEQ = 17,                       /* tEQ  */
+  YYSYMBOL_tEQEQ = 18,                     /* tEQEQ  */
+  YYSYMBOL_tNOT = 19,                      /* tNOT  */
+  YYSYMBOL_tNEQ = 20,                      /* tNEQ  */
+  YYSYMBOL_tAND = 21,                      /* tAND  */
+  YYSYMBOL_tOR = 22,                       /* tOR  */
+  YYSYMBOL_tQU = 23,                       /* tQU  */
+  YYSYMBOL_tSHR = 24,                      /* tSHR  */
+  YYSYMBOL_tSHL = 25,                      /* tSHL  */
+  YYSYMBOL_tBOR = 26,                      /* tBOR  */
+  YYSYMBOL_tBAND = 27,                     /* tBAND  */
+  YYSYMBOL_tBNOT = 28,                     /* tBNOT  */
+  YYSYMBOL_tXOR = 29,                      /* tXOR  */
+  YYSYMBOL_tCOLON = 30,                    /* tCOLON  */
+  YYSYMBOL_tDOT = 31,                      /* tDOT  */
+  YYSYMBOL_tDOTDOT = 32,                   /* tDOTDOT  */
+  YYSYMBOL_tFUNCTION = 33,                 /* tFUNCTION  */
+  YYSYMBOL_tWHILE = 34,                    /* tWHILE  */
+  YYSYMBOL_tEND = 35,                      /* tEND  */
+  YYSYMBOL_tFILE = 36,                     /* tFILE  */
+  YYSYMBOL_tMACRO = 37,                    /* tMACRO  */
+  YYSYMBOL_tRETURN = 38,                   /* tRETURN  */
+  YYSYMBOL_tIF = 39,                       /* tIF  */
+  YYSYMBOL_tELSE = 40,                     /* tELSE  */
+  YYSYMBOL_tDO = 41,                       /* tDO  */
+  YYSYMBOL_tCLASS = 42,                    /* tCLASS  */
+  YYSYMBOL_tSTATIC = 43,                   /* tSTATIC  */
+  YYSYMBOL_tIMPORT = 44,                   /* tIMPORT  */
+  YYSYMBOL_tDELETE = 45,                   /* tDELETE  */
+  YYSYMBOL_tFOR = 46,                      /* tFOR  */
+  YYSYMBOL_tIN = 47,                       /* tIN  */
+  YYSYMBOL_tASYNC = 48,                    /* tASYNC  */
+  YYSYMBOL_tAWAIT = 49,                    /* tAWAIT  */
+  YYSYMBOL_tLPAREN = 50,                   /* tLPAREN  */
+  YYSYMBOL_tRPAREN = 51,                   /* tRPAREN  */
+  YYSYMBOL_tLBRACE = 52,                   /* tLBRACE  */
+  YYSYMBOL_tRBRACE = 53,                   /* tRBRACE  */
+  YYSYMBOL_tLBRACKET = 54,                 /* tLBRACKET  */
+  YYSYMBOL_tRBRACKET = 55,                 /* tRBRACKET  */
+  YYSYMBOL_tCOMMA = 56,                    /* tCOMMA  */
+  YYSYMBOL_tSEMI = 57,                     /* tSEMI  */
+  YYSYMBOL_UNARY = 58,                     /* UNARY  */
+  YYSYMBOL_YYACCEPT = 59,                  /* $accept  */
+  YYSYMBOL_program = 60,                   /* program  */
+  YYSYMBOL_stmts = 61,                     /* stmts  */
+  YYSYMBOL_stmt = 62,                      /* stmt  */
+  YYSYMBOL_import_stmt = 63,               /* import_stmt  */
+  YYSYMBOL_class_method = 64,              /* class_method  */
+  YYSYMBOL_class_body = 65,                /* class_body  */
+  YYSYMBOL_class_stmt = 66,                /* class_stmt  */
+  YYSYMBOL_do_block = 67,                  /* do_block  */
+  YYSYMBOL_while_loop = 68,                /* while_loop  */
+  YYSYMBOL_for_loop = 69,                  /* for_loop  */
+  YYSYMBOL_for_step = 70,                  /* for_step  */
+  YYSYMBOL_func = 71,                      /* func  */
+  YYSYMBOL_proto = 72,                     /* proto  */
+  YYSYMBOL_fnargs = 73,                    /* fnargs  */
+  YYSYMBOL_args = 74,                      /* args  */
+  YYSYMBOL_number = 75,                    /* number  */
+  YYSYMBOL_bool = 76,                      /* bool  */
+  YYSYMBOL_return_expr = 77,               /* return_expr  */
+  YYSYMBOL_string = 78,                    /* string  */
+  YYSYMBOL_ternary = 79,                   /* ternary  */
+  YYSYMBOL_ident = 80,                     /* ident  */
+  YYSYMBOL_file = 81,                      /* file  */
+  YYSYMBOL_call = 82,                      /* call  */
+  YYSYMBOL_cond = 83,                      /* cond  */
+  YYSYMBOL_assign = 84,                    /* assign  */
+  YYSYMBOL_array = 85,                     /* array  */
+  YYSYMBOL_dict = 86,                      /* dict  */
+  YYSYMBOL_pairs = 87,                     /* pairs  */
+  YYSYMBOL_index = 88,                     /* index  */
+  YYSYMBOL_expr = 89                       /* expr  */
+};
+typedef enum yysymbol_kind_t yysymbol_kind_t;
 
-/* Use api.header.include to #include this header
-   instead of duplicating it here.  */
-#ifndef YY_YY_PARSER_H_INCLUDED
-# define YY_YY_PARSER_H_INCLUDED
-/* Debug traces.  */
-#ifndef YYDEBUG
-# define YYDEBUG 1
-#endif
-#if YYDEBUG
-extern int yydebug;
-#endif
-/* "%code requires" blocks.  */
-#line 16 "parser.y"
 
-#include "ast.h"
 
-#line 122 "parser.c"
 
-/* Token type.  */
-#ifndef YYTOKENTYPE
-# define YYTOKENTYPE
-  enum yytokentype
-  {
-    tIDENT = 258,
-    tSTRING = 259,
-    tNUMBER = 260,
-    tTRUE = 261,
-    tFALSE = 262,
-    tNULL = 263,
-    tGT = 264,
-    tGE = 265,
-    tLT = 266,
-    tLE = 267,
-    tPLUS = 268,
-    tMINUS = 269,
-    tSLASH = 270,
-    tSTAR = 271,
-    tEQ = 272,
-    tEQEQ = 273,
-    tNOT = 274,
-    tNEQ = 275,
-    tAND = 276,
-    tOR = 277,
-    tQU = 278,
-    tSHR = 279,
-    tSHL = 280,
-    tBOR = 281,
-    tBAND = 282,
-    tBNOT = 283,
-    tXOR = 284,
-    tCOLON = 285,
-    tDOT = 286,
-    tFUNCTION = 287,
-    tWHILE = 288,
-    tEND = 289,
-    tFILE = 290,
-    tMACRO = 291,
-    tRETURN = 292,
-    tIF = 293,
-    tELSE = 294,
-    tDO = 295,
-    tCLASS = 296,
-    tSTATIC = 297,
-    tIMPORT = 298,
-    tLPAREN = 299,
-    tRPAREN = 300,
-    tLBRACE = 301,
-    tRBRACE = 302,
-    tCOMMA = 303,
-    tSEMI = 304,
-    UNARY = 305
-  };
+#ifdef short
+# undef short
 #endif
 
-/* Value type.  */
-#if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
-union YYSTYPE
-{
-#line 40 "parser.y"
+/* On compilers that do not define __PTRDIFF_MAX__ etc., make sure
+   <limits.h> and (if available) <stdint.h> are included
+   so that the code can choose integer types of a good width.  */
 
-  char* str;
-  double num;
-  pd_ast_node* node;
-  struct {
-    int count;
-    union {
-      char** args;
-      pd_ast_node** call;
-    };
-  } fnargs;
+#ifndef __PTRDIFF_MAX__
+# include <limits.h> /* INFRINGES ON USER NAME SPACE */
+# if defined __STDC_VERSION__ && 199901 <= __STDC_VERSION__
+#  include <stdint.h> /* INFRINGES ON USER NAME SPACE */
+#  define YY_STDINT_H
+# endif
+#endif
 
-#line 197 "parser.c"
+/* Narrow types that promote to a signed type and that can represent a
+   signed or unsigned integer of at least N bits.  In tables they can
+   save space and decrease cache pressure.  Promoting to a signed type
+   helps avoid bugs in integer arithmetic.  */
 
-};
-typedef union YYSTYPE YYSTYPE;
-# define YYSTYPE_IS_TRIVIAL 1
-# define YYSTYPE_IS_DECLARED 1
+#ifdef __INT_LEAST8_MAX__
+typedef __INT_LEAST8_TYPE__ yytype_int8;
+#elif defined YY_STDINT_H
+typedef int_least8_t yytype_int8;
+#else
+typedef signed char yytype_int8;
 #endif
 
-/* Location type.  */
-#if ! defined YYLTYPE && ! defined YYLTYPE_IS_DECLARED
-typedef struct YYLTYPE YYLTYPE;
-struct YYLTYPE
-{
-  int first_line;
-  int first_column;
-  int last_line;
-  int last_column;
-};
-# define YYLTYPE_IS_DECLARED 1
-# define YYLTYPE_IS_TRIVIAL 1
+#ifdef __INT_LEAST16_MAX__
+typedef __INT_LEAST16_TYPE__ yytype_int16;
+#elif defined YY_STDINT_H
+typedef int_least16_t yytype_int16;
+#else
+typedef short yytype_int16;
 #endif
 
-
-
-int yyparse (void* scanner, pd_ast_node* ast);
-/* "%code provides" blocks.  */
-#line 19 "parser.y"
-
-int yyerror(YYLTYPE* yylloc, void* scanner, pd_ast_node* ast, const char* msg);
-
-#line 227 "parser.c"
-
-#endif /* !YY_YY_PARSER_H_INCLUDED  */
-
-
-
-#ifdef short
-# undef short
+/* Work around bug in HP-UX 11.23, which defines these macros
+   incorrectly for preprocessor constants.  This workaround can likely
+   be removed in 2023, as HPE has promised support for HP-UX 11.23
+   (aka HP-UX 11i v2) only through the end of 2022; see Table 2 of
+   <https://h20195.www2.hpe.com/V2/getpdf.aspx/4AA4-7673ENW.pdf>.  */
+#ifdef __hpux
+# undef UINT_LEAST8_MAX
+# undef UINT_LEAST16_MAX
+# define UINT_LEAST8_MAX 255
+# define UINT_LEAST16_MAX 65535
 #endif
 
-#ifdef YYTYPE_UINT8
-typedef YYTYPE_UINT8 yytype_uint8;
-#else
+#if defined __UINT_LEAST8_MAX__ && __UINT_LEAST8_MAX__ <= __INT_MAX__
+typedef __UINT_LEAST8_TYPE__ yytype_uint8;
+#elif (!defined __UINT_LEAST8_MAX__ && defined YY_STDINT_H \
+       && UINT_LEAST8_MAX <= INT_MAX)
+typedef uint_least8_t yytype_uint8;
+#elif !defined __UINT_LEAST8_MAX__ && UCHAR_MAX <= INT_MAX
 typedef unsigned char yytype_uint8;
-#endif
-
-#ifdef YYTYPE_INT8
-typedef YYTYPE_INT8 yytype_int8;
 #else
-typedef signed char yytype_int8;
+typedef short yytype_uint8;
 #endif
 
-#ifdef YYTYPE_UINT16
-typedef YYTYPE_UINT16 yytype_uint16;
-#else
+#if defined __UINT_LEAST16_MAX__ && __UINT_LEAST16_MAX__ <= __INT_MAX__
+typedef __UINT_LEAST16_TYPE__ yytype_uint16;
+#elif (!defined __UINT_LEAST16_MAX__ && defined YY_STDINT_H \
+       && UINT_LEAST16_MAX <= INT_MAX)
+typedef uint_least16_t yytype_uint16;
+#elif !defined __UINT_LEAST16_MAX__ && USHRT_MAX <= INT_MAX
 typedef unsigned short yytype_uint16;
+#else
+typedef int yytype_uint16;
 #endif
 
-#ifdef YYTYPE_INT16
-typedef YYTYPE_INT16 yytype_int16;
-#else
-typedef short yytype_int16;
+#ifndef YYPTRDIFF_T
+# if defined __PTRDIFF_TYPE__ && defined __PTRDIFF_MAX__
+#  define YYPTRDIFF_T __PTRDIFF_TYPE__
+#  define YYPTRDIFF_MAXIMUM __PTRDIFF_MAX__
+# elif defined PTRDIFF_MAX
+#  ifndef ptrdiff_t
+#   include <stddef.h> /* INFRINGES ON USER NAME SPACE */
+#  endif
+#  define YYPTRDIFF_T ptrdiff_t
+#  define YYPTRDIFF_MAXIMUM PTRDIFF_MAX
+# else
+#  define YYPTRDIFF_T long
+#  define YYPTRDIFF_MAXIMUM LONG_MAX
+# endif
 #endif
 
 #ifndef YYSIZE_T
@@ -262,7 +300,7 @@ typedef short yytype_int16;
 #  define YYSIZE_T __SIZE_TYPE__
 # elif defined size_t
 #  define YYSIZE_T size_t
-# elif ! defined YYSIZE_T
+# elif defined __STDC_VERSION__ && 199901 <= __STDC_VERSION__
 #  include <stddef.h> /* INFRINGES ON USER NAME SPACE */
 #  define YYSIZE_T size_t
 # else
@@ -270,7 +308,20 @@ typedef short yytype_int16;
 # endif
 #endif
 
-#define YYSIZE_MAXIMUM ((YYSIZE_T) -1)
+#define YYSIZE_MAXIMUM                                  \
+  YY_CAST (YYPTRDIFF_T,                                 \
+           (YYPTRDIFF_MAXIMUM < YY_CAST (YYSIZE_T, -1)  \
+            ? YYPTRDIFF_MAXIMUM                         \
+            : YY_CAST (YYSIZE_T, -1)))
+
+#define YYSIZEOF(X) YY_CAST (YYPTRDIFF_T, sizeof (X))
+
+
+/* Stored state numbers (used for stacks). */
+typedef yytype_uint8 yy_state_t;
+
+/* State numbers in computations.  */
+typedef int yy_state_fast_t;
 
 #ifndef YY_
 # if defined YYENABLE_NLS && YYENABLE_NLS
@@ -284,38 +335,43 @@ typedef short yytype_int16;
 # endif
 #endif
 
-#ifndef YY_ATTRIBUTE
-# if (defined __GNUC__                                               \
-      && (2 < __GNUC__ || (__GNUC__ == 2 && 96 <= __GNUC_MINOR__)))  \
-     || defined __SUNPRO_C && 0x5110 <= __SUNPRO_C
-#  define YY_ATTRIBUTE(Spec) __attribute__(Spec)
-# else
-#  define YY_ATTRIBUTE(Spec) /* empty */
-# endif
-#endif
 
 #ifndef YY_ATTRIBUTE_PURE
-# define YY_ATTRIBUTE_PURE   YY_ATTRIBUTE ((__pure__))
+# if defined __GNUC__ && 2 < __GNUC__ + (96 <= __GNUC_MINOR__)
+#  define YY_ATTRIBUTE_PURE __attribute__ ((__pure__))
+# else
+#  define YY_ATTRIBUTE_PURE
+# endif
 #endif
 
 #ifndef YY_ATTRIBUTE_UNUSED
-# define YY_ATTRIBUTE_UNUSED YY_ATTRIBUTE ((__unused__))
+# if defined __GNUC__ && 2 < __GNUC__ + (7 <= __GNUC_MINOR__)
+#  define YY_ATTRIBUTE_UNUSED __attribute__ ((__unused__))
+# else
+#  define YY_ATTRIBUTE_UNUSED
+# endif
 #endif
 
 /* Suppress unused-variable warnings by "using" E.  */
 #if ! defined lint || defined __GNUC__
-# define YYUSE(E) ((void) (E))
+# define YY_USE(E) ((void) (E))
 #else
-# define YYUSE(E) /* empty */
+# define YY_USE(E) /* empty */
 #endif
 
-#if defined __GNUC__ && ! defined __ICC && 407 <= __GNUC__ * 100 + __GNUC_MINOR__
 /* Suppress an incorrect diagnostic about yylval being uninitialized.  */
-# define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN \
-    _Pragma ("GCC diagnostic push") \
-    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")\
+#if defined __GNUC__ && ! defined __ICC && 406 <= __GNUC__ * 100 + __GNUC_MINOR__
+# if __GNUC__ * 100 + __GNUC_MINOR__ < 407
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")
+# else
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")              \
     _Pragma ("GCC diagnostic ignored \"-Wmaybe-uninitialized\"")
-# define YY_IGNORE_MAYBE_UNINITIALIZED_END \
+# endif
+# define YY_IGNORE_MAYBE_UNINITIALIZED_END      \
     _Pragma ("GCC diagnostic pop")
 #else
 # define YY_INITIAL_VALUE(Value) Value
@@ -328,10 +384,22 @@ typedef short yytype_int16;
 # define YY_INITIAL_VALUE(Value) /* Nothing. */
 #endif
 
+#if defined __cplusplus && defined __GNUC__ && ! defined __ICC && 6 <= __GNUC__
+# define YY_IGNORE_USELESS_CAST_BEGIN                          \
+    _Pragma ("GCC diagnostic push")                            \
+    _Pragma ("GCC diagnostic ignored \"-Wuseless-cast\"")
+# define YY_IGNORE_USELESS_CAST_END            \
+    _Pragma ("GCC diagnostic pop")
+#endif
+#ifndef YY_IGNORE_USELESS_CAST_BEGIN
+# define YY_IGNORE_USELESS_CAST_BEGIN
+# define YY_IGNORE_USELESS_CAST_END
+#endif
+
 
 #define YY_ASSERT(E) ((void) (0 && (E)))
 
-#if ! defined yyoverflow || YYERROR_VERBOSE
+#if 1
 
 /* The parser invokes alloca or malloc; define the necessary symbols.  */
 
@@ -396,8 +464,7 @@ void free (void *); /* INFRINGES ON USER NAME SPACE */
 #   endif
 #  endif
 # endif
-#endif /* ! defined yyoverflow || YYERROR_VERBOSE */
-
+#endif /* 1 */
 
 #if (! defined yyoverflow \
      && (! defined __cplusplus \
@@ -407,18 +474,19 @@ void free (void *); /* INFRINGES ON USER NAME SPACE */
 /* A type that is properly aligned for any stack member.  */
 union yyalloc
 {
-  yytype_int16 yyss_alloc;
+  yy_state_t yyss_alloc;
   YYSTYPE yyvs_alloc;
   YYLTYPE yyls_alloc;
 };
 
 /* The size of the maximum gap between one aligned stack and the next.  */
-# define YYSTACK_GAP_MAXIMUM (sizeof (union yyalloc) - 1)
+# define YYSTACK_GAP_MAXIMUM (YYSIZEOF (union yyalloc) - 1)
 
 /* The size of an array large to enough to hold all stacks, each with
    N elements.  */
 # define YYSTACK_BYTES(N) \
-     ((N) * (sizeof (yytype_int16) + sizeof (YYSTYPE) + sizeof (YYLTYPE)) \
+     ((N) * (YYSIZEOF (yy_state_t) + YYSIZEOF (YYSTYPE) \
+             + YYSIZEOF (YYLTYPE)) \
       + 2 * YYSTACK_GAP_MAXIMUM)
 
 # define YYCOPY_NEEDED 1
@@ -431,11 +499,11 @@ union yyalloc
 # define YYSTACK_RELOCATE(Stack_alloc, Stack)                           \
     do                                                                  \
       {                                                                 \
-        YYSIZE_T yynewbytes;                                            \
+        YYPTRDIFF_T yynewbytes;                                         \
         YYCOPY (&yyptr->Stack_alloc, Stack, yysize);                    \
         Stack = &yyptr->Stack_alloc;                                    \
-        yynewbytes = yystacksize * sizeof (*Stack) + YYSTACK_GAP_MAXIMUM; \
-        yyptr += yynewbytes / sizeof (*yyptr);                          \
+        yynewbytes = yystacksize * YYSIZEOF (*Stack) + YYSTACK_GAP_MAXIMUM; \
+        yyptr += yynewbytes / YYSIZEOF (*yyptr);                        \
       }                                                                 \
     while (0)
 
@@ -447,12 +515,12 @@ union yyalloc
 # ifndef YYCOPY
 #  if defined __GNUC__ && 1 < __GNUC__
 #   define YYCOPY(Dst, Src, Count) \
-      __builtin_memcpy (Dst, Src, (Count) * sizeof (*(Src)))
+      __builtin_memcpy (Dst, Src, YY_CAST (YYSIZE_T, (Count)) * sizeof (*(Src)))
 #  else
 #   define YYCOPY(Dst, Src, Count)              \
       do                                        \
         {                                       \
-          YYSIZE_T yyi;                         \
+          YYPTRDIFF_T yyi;                      \
           for (yyi = 0; yyi < (Count); yyi++)   \
             (Dst)[yyi] = (Src)[yyi];            \
         }                                       \
@@ -462,30 +530,33 @@ union yyalloc
 #endif /* !YYCOPY_NEEDED */
 
 /* YYFINAL -- State number of the termination state.  */
-#define YYFINAL  52
+#define YYFINAL  70
 /* YYLAST -- Last index in YYTABLE.  */
-#define YYLAST   534
+#define YYLAST   1255
 
 /* YYNTOKENS -- Number of terminals.  */
-#define YYNTOKENS  51
+#define YYNTOKENS  59
 /* YYNNTS -- Number of nonterminals.  */
-#define YYNNTS  25
+#define YYNNTS  31
 /* YYNRULES -- Number of rules.  */
-#define YYNRULES  75
+#define YYNRULES  96
 /* YYNSTATES -- Number of states.  */
-#define YYNSTATES  135
+#define YYNSTATES  186
+
+/* YYMAXUTOK -- Last valid token kind.  */
+#define YYMAXUTOK   313
 
-#define YYUNDEFTOK  2
-#define YYMAXUTOK   305
 
 /* YYTRANSLATE(TOKEN-NUM) -- Symbol number corresponding to TOKEN-NUM
    as returned by yylex, with out-of-bounds checking.  */
-#define YYTRANSLATE(YYX)                                                \
-  ((unsigned) (YYX) <= YYMAXUTOK ? yytranslate[YYX] : YYUNDEFTOK)
+#define YYTRANSLATE(YYX)                                \
+  (0 <= (YYX) && (YYX) <= YYMAXUTOK                     \
+   ? YY_CAST (yysymbol_kind_t, yytranslate[YYX])        \
+   : YYSYMBOL_YYUNDEF)
 
 /* YYTRANSLATE[TOKEN-NUM] -- Symbol number corresponding to TOKEN-NUM
    as returned by yylex.  */
-static const yytype_uint8 yytranslate[] =
+static const yytype_int8 yytranslate[] =
 {
        0,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
@@ -517,298 +588,468 @@ static const yytype_uint8 yytranslate[] =
       15,    16,    17,    18,    19,    20,    21,    22,    23,    24,
       25,    26,    27,    28,    29,    30,    31,    32,    33,    34,
       35,    36,    37,    38,    39,    40,    41,    42,    43,    44,
-      45,    46,    47,    48,    49,    50
+      45,    46,    47,    48,    49,    50,    51,    52,    53,    54,
+      55,    56,    57,    58
 };
 
 #if YYDEBUG
-  /* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
-static const yytype_uint16 yyrline[] =
+/* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
+static const yytype_int16 yyrline[] =
 {
-       0,    85,    85,    87,    91,    93,    97,    99,   101,   103,
-     105,   107,   109,   111,   114,   117,   119,   122,   124,   127,
-     129,   132,   136,   138,   142,   144,   148,   155,   157,   158,
-     161,   163,   165,   168,   171,   172,   176,   178,   181,   185,
-     188,   190,   193,   196,   200,   202,   205,   209,   211,   213,
-     215,   217,   219,   221,   223,   225,   227,   229,   231,   233,
-     235,   237,   239,   241,   243,   245,   247,   249,   251,   253,
-     255,   257,   259,   261,   263,   265
+       0,    98,    98,   100,   104,   106,   110,   112,   114,   116,
+     118,   120,   122,   124,   126,   130,   133,   135,   138,   140,
+     143,   145,   148,   152,   154,   159,   161,   164,   166,   170,
+     172,   174,   176,   180,   183,   185,   186,   189,   191,   193,
+     196,   199,   200,   204,   206,   209,   213,   216,   218,   221,
+     224,   226,   233,   235,   238,   241,   244,   247,   249,   257,
+     269,   271,   275,   277,   279,   281,   283,   285,   287,   289,
+     291,   293,   295,   297,   299,   301,   303,   305,   307,   309,
+     311,   313,   315,   317,   319,   321,   323,   325,   327,   329,
+     331,   333,   335,   337,   339,   341,   343
 };
 #endif
 
-#if YYDEBUG || YYERROR_VERBOSE || 0
+/** Accessing symbol of state STATE.  */
+#define YY_ACCESSING_SYMBOL(State) YY_CAST (yysymbol_kind_t, yystos[State])
+
+#if 1
+/* The user-facing name of the symbol whose (internal) number is
+   YYSYMBOL.  No bounds checking.  */
+static const char *yysymbol_name (yysymbol_kind_t yysymbol) YY_ATTRIBUTE_UNUSED;
+
 /* YYTNAME[SYMBOL-NUM] -- String name of the symbol SYMBOL-NUM.
    First, the terminals, then, starting at YYNTOKENS, nonterminals.  */
 static const char *const yytname[] =
 {
-  "$end", "error", "$undefined", "tIDENT", "tSTRING", "tNUMBER", "tTRUE",
-  "tFALSE", "tNULL", "tGT", "tGE", "tLT", "tLE", "tPLUS", "tMINUS",
-  "tSLASH", "tSTAR", "tEQ", "tEQEQ", "tNOT", "tNEQ", "tAND", "tOR", "tQU",
-  "tSHR", "tSHL", "tBOR", "tBAND", "tBNOT", "tXOR", "tCOLON", "tDOT",
-  "tFUNCTION", "tWHILE", "tEND", "tFILE", "tMACRO", "tRETURN", "tIF",
-  "tELSE", "tDO", "tCLASS", "tSTATIC", "tIMPORT", "tLPAREN", "tRPAREN",
-  "tLBRACE", "tRBRACE", "tCOMMA", "tSEMI", "UNARY", "$accept", "program",
-  "stmts", "stmt", "import_stmt", "class_method", "class_body",
-  "class_stmt", "do_block", "while_loop", "func", "proto", "fnargs",
-  "args", "number", "bool", "return_expr", "string", "ternary", "ident",
-  "file", "call", "cond", "assign", "expr", YY_NULLPTR
+  "\"end of file\"", "error", "\"invalid token\"", "tIDENT", "tSTRING",
+  "tNUMBER", "tTRUE", "tFALSE", "tNULL", "tGT", "tGE", "tLT", "tLE",
+  "tPLUS", "tMINUS", "tSLASH", "tSTAR", "tEQ", "tEQEQ", "tNOT", "tNEQ",
+  "tAND", "tOR", "tQU", "tSHR", "tSHL", "tBOR", "tBAND", "tBNOT", "tXOR",
+  "tCOLON", "tDOT", "tDOTDOT", "tFUNCTION", "tWHILE", "tEND", "tFILE",
+  "tMACRO", "tRETURN", "tIF", "tELSE", "tDO", "tCLASS", "tSTATIC",
+  "tIMPORT", "tDELETE", "tFOR", "tIN", "tASYNC", "tAWAIT", "tLPAREN",
+  "tRPAREN", "tLBRACE", "tRBRACE", "tLBRACKET", "tRBRACKET", "tCOMMA",
+  "tSEMI", "UNARY", "$accept", "program", "stmts", "stmt", "import_stmt",
+  "class_method", "class_body", "class_stmt", "do_block", "while_loop",
+  "for_loop", "for_step", "func", "proto", "fnargs", "args", "number",
+  "bool", "return_expr", "string", "ternary", "ident", "file", "call",
+  "cond", "assign", "array", "dict", "pairs", "index", "expr", YY_NULLPTR
 };
-#endif
 
-# ifdef YYPRINT
-/* YYTOKNUM[NUM] -- (External) token number corresponding to the
-   (internal) symbol number NUM (which must be that of a token).  */
-static const yytype_uint16 yytoknum[] =
+static const char *
+yysymbol_name (yysymbol_kind_t yysymbol)
 {
-       0,   256,   257,   258,   259,   260,   261,   262,   263,   264,
-     265,   266,   267,   268,   269,   270,   271,   272,   273,   274,
-     275,   276,   277,   278,   279,   280,   281,   282,   283,   284,
-     285,   286,   287,   288,   289,   290,   291,   292,   293,   294,
-     295,   296,   297,   298,   299,   300,   301,   302,   303,   304,
-     305
-};
-# endif
+  return yytname[yysymbol];
+}
+#endif
 
-#define YYPACT_NINF -53
+#define YYPACT_NINF (-53)
 
-#define yypact_value_is_default(Yystate) \
-  (!!((Yystate) == (-53)))
+#define yypact_value_is_default(Yyn) \
+  ((Yyn) == YYPACT_NINF)
 
-#define YYTABLE_NINF -1
+#define YYTABLE_NINF (-1)
 
-#define yytable_value_is_error(Yytable_value) \
+#define yytable_value_is_error(Yyn) \
   0
 
-  /* YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
-     STATE-NUM.  */
+/* YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
+   STATE-NUM.  */
 static const yytype_int16 yypact[] =
 {
-     325,    -4,   -53,   -53,   -53,   -53,   -53,   367,   367,   367,
-      -2,   367,   -53,   367,   367,   325,    12,    22,   367,    29,
-     325,   -19,   -53,   -53,   -53,   -53,   -53,   -53,   -53,   -53,
-     -53,   -53,   -53,   -53,   -53,   -53,   -53,   484,   367,   367,
-     -53,   -53,   -53,     2,   -15,   394,   484,   415,    89,     0,
-     -53,   436,   -53,     8,   -53,   367,   367,   367,   367,   367,
-     367,   367,   367,   367,   367,   367,   367,   367,   367,   367,
-     367,   367,   367,   484,   -31,   484,    47,   131,   148,   325,
-     -53,    -1,   -53,   -53,    40,    40,    40,    40,   -10,   -10,
-     -53,   -53,    40,    40,    40,    40,   462,    40,    40,    40,
-      40,    40,   -53,   367,   -53,   -29,   -53,   190,   -53,   207,
-       4,   -53,     9,     1,    10,   367,   484,   -53,    57,   -53,
-     -53,   -53,   325,   -53,   -53,    14,   249,   505,   -53,   266,
-     -53,   -53,   308,   -53,   -53
+     835,     6,   -53,   -53,   -53,   -53,   -53,   887,   887,   887,
+      31,   887,   -53,   887,   887,   835,    34,    40,   887,    41,
+      12,   887,   887,   887,   887,    46,   835,   -10,   -53,   -53,
+     -53,   -53,   -53,   -53,   -53,   -53,   -53,   -53,   -53,   -53,
+     -53,   -53,   -53,   -53,   -53,   -53,   -53,  1177,   887,   887,
+     -22,   -22,   -22,    -1,    -9,   933,  1177,   957,   211,    -4,
+     -53,   -22,     3,    31,   -22,   106,   -26,  1077,   -16,  1177,
+     -53,     1,   -53,   887,   887,   887,   887,   887,   887,   887,
+     887,   887,   887,   887,   887,   887,   887,   887,   887,   887,
+     887,    49,   887,  1177,   -27,    52,   263,   315,   835,   -53,
+      19,   887,     7,   -53,   -53,   887,   887,   -53,   887,   -53,
+       5,     5,     5,     5,    -3,    -3,   -22,   -22,     5,     5,
+       5,     5,  1103,     5,     5,     5,     5,     5,    10,  1030,
+     -53,   -53,   -25,   -53,   367,   -53,   419,   159,   -53,     8,
+      22,    27,  1127,   471,  1153,  1177,  1177,   887,   887,    45,
+     -53,    60,   -53,   -53,   -53,   835,   -53,   -53,    29,   523,
+     887,   -53,   575,   887,  1201,   -18,   887,   -53,   627,   -53,
+     -53,   679,  1006,   -53,  1177,   -53,  1177,   -53,   -53,   887,
+      30,  1177,   731,   -53,   783,   -53
 };
 
-  /* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
-     Performed when YYTABLE does not specify something else to do.  Zero
-     means the default is an error.  */
-static const yytype_uint8 yydefact[] =
+/* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
+   Performed when YYTABLE does not specify something else to do.  Zero
+   means the default is an error.  */
+static const yytype_int8 yydefact[] =
 {
-       2,    40,    38,    33,    34,    35,    50,     0,     0,     0,
-       0,     0,    42,    36,     0,     0,     0,     0,     0,     0,
-       3,     0,    12,    13,    10,    11,     7,    47,    49,     8,
-      52,    48,    53,    41,    54,     9,    51,     6,     0,    30,
-      74,    75,    73,     0,     0,     0,    37,     0,     0,     0,
-      14,     0,     1,     0,     4,     0,     0,     0,     0,     0,
+       2,    47,    45,    40,    41,    42,    65,     0,     0,     0,
+       0,     0,    49,    43,     0,     0,     0,     0,     0,     0,
+       0,     0,     0,    57,    37,     0,     3,     0,    13,    14,
+      10,    11,    12,     7,    62,    64,     8,    67,    63,    68,
+      48,    69,     9,    66,    70,    71,    72,     6,     0,    37,
+      93,    94,    92,     0,     0,     0,    44,     0,     0,     0,
+      15,    96,     0,     0,    95,     0,     0,     0,     0,    38,
+       1,     0,     4,     0,     0,     0,     0,     0,     0,     0,
        0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
-       0,     0,     0,    46,     0,    31,    27,     0,     0,     0,
-      21,     0,    55,     5,    60,    61,    62,    63,    56,    57,
-      58,    59,    68,    70,    71,    72,     0,    64,    65,    66,
-      67,    69,    43,     0,    28,     0,    25,     0,    23,     0,
-       0,    19,     0,     0,     0,     0,    32,    26,     0,    24,
-      22,    44,     0,    17,    20,     0,     0,    39,    29,     0,
-      18,    16,     0,    45,    15
+       0,     0,     0,    54,     0,    34,     0,     0,     0,    22,
+       0,     0,     0,    74,    56,     0,     0,    55,     0,     5,
+      79,    80,    81,    82,    75,    76,    77,    78,    87,    89,
+      90,    91,     0,    83,    84,    85,    86,    88,    73,     0,
+      50,    35,     0,    30,     0,    24,     0,     0,    20,     0,
+       0,     0,     0,     0,     0,    58,    39,     0,    37,    60,
+      33,     0,    29,    23,    52,     0,    18,    21,     0,     0,
+       0,    32,     0,     0,    46,     0,     0,    36,     0,    19,
+      17,     0,    27,    31,    59,    51,    61,    53,    16,     0,
+       0,    28,     0,    26,     0,    25
 };
 
-  /* YYPGOTO[NTERM-NUM].  */
+/* YYPGOTO[NTERM-NUM].  */
 static const yytype_int8 yypgoto[] =
 {
-     -53,   -53,   -12,   -20,   -53,   -52,   -53,   -53,   -53,   -53,
-     -53,    52,   -53,   -53,   -53,   -53,   -53,   -53,   -53,   -53,
-     -53,   -53,   -53,   -53,    13
+     -53,   -53,    -5,   -23,   -53,   -52,   -53,   -53,   -53,   -53,
+     -53,   -53,   -53,    -2,   -53,   -44,   -53,   -53,   -53,   -53,
+     -53,   -53,   -53,   -53,   -53,   -53,   -53,   -53,   -53,   -53,
+      -7
 };
 
-  /* YYDEFGOTO[NTERM-NUM].  */
-static const yytype_int8 yydefgoto[] =
+/* YYDEFGOTO[NTERM-NUM].  */
+static const yytype_uint8 yydefgoto[] =
 {
-      -1,    19,    20,    21,    22,   112,   113,    23,    24,    25,
-      26,   114,   105,    74,    27,    28,    29,    30,    31,    32,
-      33,    34,    35,    36,    37
+       0,    25,    26,    27,    28,   139,   140,    29,    30,    31,
+      32,   180,    33,   141,   132,    68,    34,    35,    36,    37,
+      38,    39,    40,    41,    42,    43,    44,    45,    66,    46,
+      47
 };
 
-  /* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
-     positive, shift that token.  If negative, reduce the rule whose
-     number is the opposite.  If YYTABLE_NINF, syntax error.  */
+/* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
+   positive, shift that token.  If negative, reduce the rule whose
+   number is the opposite.  If YYTABLE_NINF, syntax error.  */
 static const yytype_uint8 yytable[] =
 {
-      53,    43,    43,    48,    43,    61,    62,     1,     2,     3,
-       4,     5,     6,    38,   102,    49,   117,   103,     7,   118,
-      40,    41,    42,     8,    45,    50,    46,    47,    53,    52,
-      54,    51,     9,   111,    77,   124,    10,    11,   121,    12,
-      39,    13,    14,   122,    15,    16,    76,    17,    18,    81,
-     104,    73,    75,    59,    60,    61,    62,    83,   123,   126,
-     128,   125,    44,   130,     0,   107,   109,   110,    84,    85,
-      86,    87,    88,    89,    90,    91,    92,    93,    94,    95,
-      96,    97,    98,    99,   100,   101,     0,    53,     0,    53,
-      53,     0,     1,     2,     3,     4,     5,     6,     0,     0,
-       0,     0,     0,     7,     0,     0,     0,     0,     8,    53,
-     129,     0,    53,     0,   132,     0,   116,     9,     0,     0,
-       0,    10,    11,    80,    12,     0,    13,    14,   127,    15,
-      16,     0,    17,    18,     1,     2,     3,     4,     5,     6,
+      50,    51,    52,    71,    55,    94,    56,    57,    54,    91,
+      58,    61,    79,    80,    64,    65,    67,    69,    77,    78,
+      79,    80,    53,    48,   130,    53,   150,   104,    91,   108,
+     105,   151,    92,   175,    53,    71,    91,    59,   108,   107,
+     108,    93,    69,    60,    62,    63,    70,    72,    96,    95,
+     101,    92,   128,   100,   138,   131,    49,   157,   109,    92,
+     148,   102,   166,   167,   143,   156,   110,   111,   112,   113,
+     114,   115,   116,   117,   118,   119,   120,   121,   122,   123,
+     124,   125,   126,   127,   159,   129,   169,   182,   158,     0,
+       0,   134,   136,   137,   142,     0,     0,     0,   144,   145,
+       0,   146,     0,     0,   165,     0,     0,     0,     0,     0,
+       0,    71,     0,    71,    71,    73,    74,    75,    76,    77,
+      78,    79,    80,     0,    81,     0,    82,    83,    84,    85,
+      86,    87,    88,    89,     0,    90,     0,    91,   162,    71,
+     164,    69,     0,     0,     0,    71,     0,     0,    71,     0,
+     168,     0,     0,   172,   171,     0,   174,   103,     0,   176,
+      92,    71,     1,     2,     3,     4,     5,     6,     0,     0,
+       0,     0,   181,     7,     0,     0,     0,   184,     8,     0,
+       0,     0,     0,     0,     0,     0,     0,     9,     0,     0,
+       0,     0,    10,    11,   154,    12,     0,    13,    14,   155,
+      15,    16,     0,    17,    18,    19,     0,    20,    21,    22,
+       0,    23,     0,    24,     1,     2,     3,     4,     5,     6,
+       0,     0,     0,     0,     0,     7,     0,     0,     0,     0,
+       8,     0,     0,     0,     0,     0,     0,     0,     0,     9,
+       0,     0,     0,     0,    10,    11,    99,    12,     0,    13,
+      14,     0,    15,    16,     0,    17,    18,    19,     0,    20,
+      21,    22,     0,    23,     0,    24,     1,     2,     3,     4,
+       5,     6,     0,     0,     0,     0,     0,     7,     0,     0,
+       0,     0,     8,     0,     0,     0,     0,     0,     0,     0,
+       0,     9,     0,     0,     0,     0,    10,    11,   133,    12,
+       0,    13,    14,     0,    15,    16,     0,    17,    18,    19,
+       0,    20,    21,    22,     0,    23,     0,    24,     1,     2,
+       3,     4,     5,     6,     0,     0,     0,     0,     0,     7,
+       0,     0,     0,     0,     8,     0,     0,     0,     0,     0,
+       0,     0,     0,     9,     0,     0,     0,     0,    10,    11,
+     135,    12,     0,    13,    14,     0,    15,    16,     0,    17,
+      18,    19,     0,    20,    21,    22,     0,    23,     0,    24,
+       1,     2,     3,     4,     5,     6,     0,     0,     0,     0,
+       0,     7,     0,     0,     0,     0,     8,     0,     0,     0,
+       0,     0,     0,     0,     0,     9,     0,     0,     0,     0,
+      10,    11,   152,    12,     0,    13,    14,     0,    15,    16,
+       0,    17,    18,    19,     0,    20,    21,    22,     0,    23,
+       0,    24,     1,     2,     3,     4,     5,     6,     0,     0,
+       0,     0,     0,     7,     0,     0,     0,     0,     8,     0,
+       0,     0,     0,     0,     0,     0,     0,     9,     0,     0,
+       0,     0,    10,    11,   153,    12,     0,    13,    14,     0,
+      15,    16,     0,    17,    18,    19,     0,    20,    21,    22,
+       0,    23,     0,    24,     1,     2,     3,     4,     5,     6,
+       0,     0,     0,     0,     0,     7,     0,     0,     0,     0,
+       8,     0,     0,     0,     0,     0,     0,     0,     0,     9,
+       0,     0,     0,     0,    10,    11,   161,    12,     0,    13,
+      14,     0,    15,    16,     0,    17,    18,    19,     0,    20,
+      21,    22,     0,    23,     0,    24,     1,     2,     3,     4,
+       5,     6,     0,     0,     0,     0,     0,     7,     0,     0,
+       0,     0,     8,     0,     0,     0,     0,     0,     0,     0,
+       0,     9,     0,     0,     0,     0,    10,    11,   170,    12,
+       0,    13,    14,     0,    15,    16,     0,    17,    18,    19,
+       0,    20,    21,    22,     0,    23,     0,    24,     1,     2,
+       3,     4,     5,     6,     0,     0,     0,     0,     0,     7,
+       0,     0,     0,     0,     8,     0,     0,     0,     0,     0,
+       0,     0,     0,     9,     0,     0,     0,     0,    10,    11,
+     173,    12,     0,    13,    14,     0,    15,    16,     0,    17,
+      18,    19,     0,    20,    21,    22,     0,    23,     0,    24,
+       1,     2,     3,     4,     5,     6,     0,     0,     0,     0,
+       0,     7,     0,     0,     0,     0,     8,     0,     0,     0,
+       0,     0,     0,     0,     0,     9,     0,     0,     0,     0,
+      10,    11,   177,    12,     0,    13,    14,     0,    15,    16,
+       0,    17,    18,    19,     0,    20,    21,    22,     0,    23,
+       0,    24,     1,     2,     3,     4,     5,     6,     0,     0,
+       0,     0,     0,     7,     0,     0,     0,     0,     8,     0,
+       0,     0,     0,     0,     0,     0,     0,     9,     0,     0,
+       0,     0,    10,    11,   178,    12,     0,    13,    14,     0,
+      15,    16,     0,    17,    18,    19,     0,    20,    21,    22,
+       0,    23,     0,    24,     1,     2,     3,     4,     5,     6,
        0,     0,     0,     0,     0,     7,     0,     0,     0,     0,
-       8,     1,     2,     3,     4,     5,     6,     0,     0,     9,
-       0,     0,     7,    10,    11,   106,    12,     8,    13,    14,
-       0,    15,    16,     0,    17,    18,     9,     0,     0,     0,
-      10,    11,   108,    12,     0,    13,    14,     0,    15,    16,
-       0,    17,    18,     1,     2,     3,     4,     5,     6,     0,
-       0,     0,     0,     0,     7,     0,     0,     0,     0,     8,
-       1,     2,     3,     4,     5,     6,     0,     0,     9,     0,
-       0,     7,    10,    11,   119,    12,     8,    13,    14,     0,
-      15,    16,     0,    17,    18,     9,     0,     0,     0,    10,
-      11,   120,    12,     0,    13,    14,     0,    15,    16,     0,
-      17,    18,     1,     2,     3,     4,     5,     6,     0,     0,
-       0,     0,     0,     7,     0,     0,     0,     0,     8,     1,
-       2,     3,     4,     5,     6,     0,     0,     9,     0,     0,
-       7,    10,    11,   131,    12,     8,    13,    14,     0,    15,
-      16,     0,    17,    18,     9,     0,     0,     0,    10,    11,
-     133,    12,     0,    13,    14,     0,    15,    16,     0,    17,
-      18,     1,     2,     3,     4,     5,     6,     0,     0,     0,
-       0,     0,     7,     0,     0,     0,     0,     8,     1,     2,
-       3,     4,     5,     6,     0,     0,     9,     0,     0,     7,
-      10,    11,   134,    12,     8,    13,    14,     0,    15,    16,
-       0,    17,    18,     9,     0,     0,     0,    10,    11,     0,
-      12,     0,    13,    14,     0,    15,    16,     0,    17,    18,
+       8,     0,     0,     0,     0,     0,     0,     0,     0,     9,
+       0,     0,     0,     0,    10,    11,   183,    12,     0,    13,
+      14,     0,    15,    16,     0,    17,    18,    19,     0,    20,
+      21,    22,     0,    23,     0,    24,     1,     2,     3,     4,
+       5,     6,     0,     0,     0,     0,     0,     7,     0,     0,
+       0,     0,     8,     0,     0,     0,     0,     0,     0,     0,
+       0,     9,     0,     0,     0,     0,    10,    11,   185,    12,
+       0,    13,    14,     0,    15,    16,     0,    17,    18,    19,
+       0,    20,    21,    22,     0,    23,     0,    24,     1,     2,
+       3,     4,     5,     6,     0,     0,     0,     0,     0,     7,
+       0,     0,     0,     0,     8,     0,     0,     0,     0,     0,
+       0,     0,     0,     9,     0,     0,     0,     0,    10,    11,
+       0,    12,     0,    13,    14,     0,    15,    16,     0,    17,
+      18,    19,     0,    20,    21,    22,     0,    23,     0,    24,
        1,     2,     3,     4,     5,     6,     0,     0,     0,     0,
        0,     7,     0,     0,     0,     0,     8,     0,     0,     0,
        0,     0,     0,     0,     0,     9,     0,     0,     0,     0,
-       0,     0,    12,    55,    56,    57,    58,    59,    60,    61,
-      62,    18,    63,     0,    64,    65,    66,    67,    68,    69,
-      70,    71,     0,    72,    55,    56,    57,    58,    59,    60,
-      61,    62,     0,    63,     0,    64,    65,    66,    67,    68,
-      69,    70,    71,    78,    72,    55,    56,    57,    58,    59,
-      60,    61,    62,     0,    63,     0,    64,    65,    66,    67,
-      68,    69,    70,    71,    79,    72,     0,     0,     0,     0,
-       0,    55,    56,    57,    58,    59,    60,    61,    62,     0,
-      63,    82,    64,    65,    66,    67,    68,    69,    70,    71,
-       0,    72,   115,    55,    56,    57,    58,    59,    60,    61,
-      62,     0,    63,     0,    64,    65,    66,    67,    68,    69,
-      70,    71,     0,    72,    55,    56,    57,    58,    59,    60,
-      61,    62,     0,    63,     0,    64,    65,    66,     0,    68,
-      69,    70,    71,     0,    72
+       0,     0,     0,    12,     0,     0,     0,     0,     0,     0,
+       0,     0,    18,     0,     0,     0,    21,    22,     0,    23,
+       0,    24,    73,    74,    75,    76,    77,    78,    79,    80,
+       0,    81,     0,    82,    83,    84,    85,    86,    87,    88,
+      89,     0,    90,     0,    91,     0,    73,    74,    75,    76,
+      77,    78,    79,    80,     0,    81,     0,    82,    83,    84,
+      85,    86,    87,    88,    89,     0,    90,    92,    91,     0,
+      97,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+       0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+       0,    92,     0,     0,    98,    73,    74,    75,    76,    77,
+      78,    79,    80,     0,    81,     0,    82,    83,    84,    85,
+      86,    87,    88,    89,     0,    90,     0,    91,     0,    73,
+      74,    75,    76,    77,    78,    79,    80,     0,    81,     0,
+      82,    83,    84,    85,    86,    87,    88,    89,     0,    90,
+      92,    91,   179,     0,     0,     0,     0,     0,     0,     0,
+       0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+       0,     0,     0,     0,    92,   149,    73,    74,    75,    76,
+      77,    78,    79,    80,     0,    81,     0,    82,    83,    84,
+      85,    86,    87,    88,    89,     0,    90,   106,    91,     0,
+       0,     0,    73,    74,    75,    76,    77,    78,    79,    80,
+       0,    81,     0,    82,    83,    84,    85,    86,    87,    88,
+      89,    92,    90,   147,    91,     0,    73,    74,    75,    76,
+      77,    78,    79,    80,     0,    81,     0,    82,    83,    84,
+      85,    86,    87,    88,    89,     0,    90,    92,    91,   160,
+       0,     0,    73,    74,    75,    76,    77,    78,    79,    80,
+       0,    81,     0,    82,    83,    84,    85,    86,    87,    88,
+      89,    92,    90,   163,    91,     0,    73,    74,    75,    76,
+      77,    78,    79,    80,     0,    81,     0,    82,    83,    84,
+      85,    86,    87,    88,    89,     0,    90,    92,    91,     0,
+      73,    74,    75,    76,    77,    78,    79,    80,     0,    81,
+       0,    82,    83,    84,     0,    86,    87,    88,    89,     0,
+      90,    92,    91,     0,     0,     0,     0,     0,     0,     0,
+       0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+       0,     0,     0,     0,     0,    92
 };
 
 static const yytype_int16 yycheck[] =
 {
-      20,     3,     3,    15,     3,    15,    16,     3,     4,     5,
-       6,     7,     8,    17,    45,     3,    45,    48,    14,    48,
-       7,     8,     9,    19,    11,     3,    13,    14,    48,     0,
-      49,    18,    28,    34,    49,    34,    32,    33,    34,    35,
-      44,    37,    38,    39,    40,    41,    44,    43,    44,    49,
-       3,    38,    39,    13,    14,    15,    16,    49,    49,    49,
-       3,   113,    10,    49,    -1,    77,    78,    79,    55,    56,
-      57,    58,    59,    60,    61,    62,    63,    64,    65,    66,
-      67,    68,    69,    70,    71,    72,    -1,   107,    -1,   109,
-     110,    -1,     3,     4,     5,     6,     7,     8,    -1,    -1,
-      -1,    -1,    -1,    14,    -1,    -1,    -1,    -1,    19,   129,
-     122,    -1,   132,    -1,   126,    -1,   103,    28,    -1,    -1,
-      -1,    32,    33,    34,    35,    -1,    37,    38,   115,    40,
-      41,    -1,    43,    44,     3,     4,     5,     6,     7,     8,
+       7,     8,     9,    26,    11,    49,    13,    14,    10,    31,
+      15,    18,    15,    16,    21,    22,    23,    24,    13,    14,
+      15,    16,     3,    17,    51,     3,    51,    53,    31,    56,
+      56,    56,    54,    51,     3,    58,    31,     3,    56,    55,
+      56,    48,    49,     3,     3,    33,     0,    57,    57,    50,
+      47,    54,     3,    57,    35,     3,    50,    35,    57,    54,
+      50,    63,    17,     3,    57,    57,    73,    74,    75,    76,
+      77,    78,    79,    80,    81,    82,    83,    84,    85,    86,
+      87,    88,    89,    90,    57,    92,    57,    57,   140,    -1,
+      -1,    96,    97,    98,   101,    -1,    -1,    -1,   105,   106,
+      -1,   108,    -1,    -1,   148,    -1,    -1,    -1,    -1,    -1,
+      -1,   134,    -1,   136,   137,     9,    10,    11,    12,    13,
+      14,    15,    16,    -1,    18,    -1,    20,    21,    22,    23,
+      24,    25,    26,    27,    -1,    29,    -1,    31,   143,   162,
+     147,   148,    -1,    -1,    -1,   168,    -1,    -1,   171,    -1,
+     155,    -1,    -1,   160,   159,    -1,   163,    51,    -1,   166,
+      54,   184,     3,     4,     5,     6,     7,     8,    -1,    -1,
+      -1,    -1,   179,    14,    -1,    -1,    -1,   182,    19,    -1,
+      -1,    -1,    -1,    -1,    -1,    -1,    -1,    28,    -1,    -1,
+      -1,    -1,    33,    34,    35,    36,    -1,    38,    39,    40,
+      41,    42,    -1,    44,    45,    46,    -1,    48,    49,    50,
+      -1,    52,    -1,    54,     3,     4,     5,     6,     7,     8,
       -1,    -1,    -1,    -1,    -1,    14,    -1,    -1,    -1,    -1,
-      19,     3,     4,     5,     6,     7,     8,    -1,    -1,    28,
-      -1,    -1,    14,    32,    33,    34,    35,    19,    37,    38,
-      -1,    40,    41,    -1,    43,    44,    28,    -1,    -1,    -1,
-      32,    33,    34,    35,    -1,    37,    38,    -1,    40,    41,
-      -1,    43,    44,     3,     4,     5,     6,     7,     8,    -1,
-      -1,    -1,    -1,    -1,    14,    -1,    -1,    -1,    -1,    19,
-       3,     4,     5,     6,     7,     8,    -1,    -1,    28,    -1,
-      -1,    14,    32,    33,    34,    35,    19,    37,    38,    -1,
-      40,    41,    -1,    43,    44,    28,    -1,    -1,    -1,    32,
-      33,    34,    35,    -1,    37,    38,    -1,    40,    41,    -1,
-      43,    44,     3,     4,     5,     6,     7,     8,    -1,    -1,
-      -1,    -1,    -1,    14,    -1,    -1,    -1,    -1,    19,     3,
-       4,     5,     6,     7,     8,    -1,    -1,    28,    -1,    -1,
-      14,    32,    33,    34,    35,    19,    37,    38,    -1,    40,
-      41,    -1,    43,    44,    28,    -1,    -1,    -1,    32,    33,
-      34,    35,    -1,    37,    38,    -1,    40,    41,    -1,    43,
-      44,     3,     4,     5,     6,     7,     8,    -1,    -1,    -1,
-      -1,    -1,    14,    -1,    -1,    -1,    -1,    19,     3,     4,
-       5,     6,     7,     8,    -1,    -1,    28,    -1,    -1,    14,
-      32,    33,    34,    35,    19,    37,    38,    -1,    40,    41,
-      -1,    43,    44,    28,    -1,    -1,    -1,    32,    33,    -1,
-      35,    -1,    37,    38,    -1,    40,    41,    -1,    43,    44,
+      19,    -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,    28,
+      -1,    -1,    -1,    -1,    33,    34,    35,    36,    -1,    38,
+      39,    -1,    41,    42,    -1,    44,    45,    46,    -1,    48,
+      49,    50,    -1,    52,    -1,    54,     3,     4,     5,     6,
+       7,     8,    -1,    -1,    -1,    -1,    -1,    14,    -1,    -1,
+      -1,    -1,    19,    -1,    -1,    -1,    -1,    -1,    -1,    -1,
+      -1,    28,    -1,    -1,    -1,    -1,    33,    34,    35,    36,
+      -1,    38,    39,    -1,    41,    42,    -1,    44,    45,    46,
+      -1,    48,    49,    50,    -1,    52,    -1,    54,     3,     4,
+       5,     6,     7,     8,    -1,    -1,    -1,    -1,    -1,    14,
+      -1,    -1,    -1,    -1,    19,    -1,    -1,    -1,    -1,    -1,
+      -1,    -1,    -1,    28,    -1,    -1,    -1,    -1,    33,    34,
+      35,    36,    -1,    38,    39,    -1,    41,    42,    -1,    44,
+      45,    46,    -1,    48,    49,    50,    -1,    52,    -1,    54,
        3,     4,     5,     6,     7,     8,    -1,    -1,    -1,    -1,
       -1,    14,    -1,    -1,    -1,    -1,    19,    -1,    -1,    -1,
       -1,    -1,    -1,    -1,    -1,    28,    -1,    -1,    -1,    -1,
-      -1,    -1,    35,     9,    10,    11,    12,    13,    14,    15,
-      16,    44,    18,    -1,    20,    21,    22,    23,    24,    25,
-      26,    27,    -1,    29,     9,    10,    11,    12,    13,    14,
-      15,    16,    -1,    18,    -1,    20,    21,    22,    23,    24,
-      25,    26,    27,    49,    29,     9,    10,    11,    12,    13,
+      33,    34,    35,    36,    -1,    38,    39,    -1,    41,    42,
+      -1,    44,    45,    46,    -1,    48,    49,    50,    -1,    52,
+      -1,    54,     3,     4,     5,     6,     7,     8,    -1,    -1,
+      -1,    -1,    -1,    14,    -1,    -1,    -1,    -1,    19,    -1,
+      -1,    -1,    -1,    -1,    -1,    -1,    -1,    28,    -1,    -1,
+      -1,    -1,    33,    34,    35,    36,    -1,    38,    39,    -1,
+      41,    42,    -1,    44,    45,    46,    -1,    48,    49,    50,
+      -1,    52,    -1,    54,     3,     4,     5,     6,     7,     8,
+      -1,    -1,    -1,    -1,    -1,    14,    -1,    -1,    -1,    -1,
+      19,    -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,    28,
+      -1,    -1,    -1,    -1,    33,    34,    35,    36,    -1,    38,
+      39,    -1,    41,    42,    -1,    44,    45,    46,    -1,    48,
+      49,    50,    -1,    52,    -1,    54,     3,     4,     5,     6,
+       7,     8,    -1,    -1,    -1,    -1,    -1,    14,    -1,    -1,
+      -1,    -1,    19,    -1,    -1,    -1,    -1,    -1,    -1,    -1,
+      -1,    28,    -1,    -1,    -1,    -1,    33,    34,    35,    36,
+      -1,    38,    39,    -1,    41,    42,    -1,    44,    45,    46,
+      -1,    48,    49,    50,    -1,    52,    -1,    54,     3,     4,
+       5,     6,     7,     8,    -1,    -1,    -1,    -1,    -1,    14,
+      -1,    -1,    -1,    -1,    19,    -1,    -1,    -1,    -1,    -1,
+      -1,    -1,    -1,    28,    -1,    -1,    -1,    -1,    33,    34,
+      35,    36,    -1,    38,    39,    -1,    41,    42,    -1,    44,
+      45,    46,    -1,    48,    49,    50,    -1,    52,    -1,    54,
+       3,     4,     5,     6,     7,     8,    -1,    -1,    -1,    -1,
+      -1,    14,    -1,    -1,    -1,    -1,    19,    -1,    -1,    -1,
+      -1,    -1,    -1,    -1,    -1,    28,    -1,    -1,    -1,    -1,
+      33,    34,    35,    36,    -1,    38,    39,    -1,    41,    42,
+      -1,    44,    45,    46,    -1,    48,    49,    50,    -1,    52,
+      -1,    54,     3,     4,     5,     6,     7,     8,    -1,    -1,
+      -1,    -1,    -1,    14,    -1,    -1,    -1,    -1,    19,    -1,
+      -1,    -1,    -1,    -1,    -1,    -1,    -1,    28,    -1,    -1,
+      -1,    -1,    33,    34,    35,    36,    -1,    38,    39,    -1,
+      41,    42,    -1,    44,    45,    46,    -1,    48,    49,    50,
+      -1,    52,    -1,    54,     3,     4,     5,     6,     7,     8,
+      -1,    -1,    -1,    -1,    -1,    14,    -1,    -1,    -1,    -1,
+      19,    -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,    28,
+      -1,    -1,    -1,    -1,    33,    34,    35,    36,    -1,    38,
+      39,    -1,    41,    42,    -1,    44,    45,    46,    -1,    48,
+      49,    50,    -1,    52,    -1,    54,     3,     4,     5,     6,
+       7,     8,    -1,    -1,    -1,    -1,    -1,    14,    -1,    -1,
+      -1,    -1,    19,    -1,    -1,    -1,    -1,    -1,    -1,    -1,
+      -1,    28,    -1,    -1,    -1,    -1,    33,    34,    35,    36,
+      -1,    38,    39,    -1,    41,    42,    -1,    44,    45,    46,
+      -1,    48,    49,    50,    -1,    52,    -1,    54,     3,     4,
+       5,     6,     7,     8,    -1,    -1,    -1,    -1,    -1,    14,
+      -1,    -1,    -1,    -1,    19,    -1,    -1,    -1,    -1,    -1,
+      -1,    -1,    -1,    28,    -1,    -1,    -1,    -1,    33,    34,
+      -1,    36,    -1,    38,    39,    -1,    41,    42,    -1,    44,
+      45,    46,    -1,    48,    49,    50,    -1,    52,    -1,    54,
+       3,     4,     5,     6,     7,     8,    -1,    -1,    -1,    -1,
+      -1,    14,    -1,    -1,    -1,    -1,    19,    -1,    -1,    -1,
+      -1,    -1,    -1,    -1,    -1,    28,    -1,    -1,    -1,    -1,
+      -1,    -1,    -1,    36,    -1,    -1,    -1,    -1,    -1,    -1,
+      -1,    -1,    45,    -1,    -1,    -1,    49,    50,    -1,    52,
+      -1,    54,     9,    10,    11,    12,    13,    14,    15,    16,
+      -1,    18,    -1,    20,    21,    22,    23,    24,    25,    26,
+      27,    -1,    29,    -1,    31,    -1,     9,    10,    11,    12,
+      13,    14,    15,    16,    -1,    18,    -1,    20,    21,    22,
+      23,    24,    25,    26,    27,    -1,    29,    54,    31,    -1,
+      57,    -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,
+      -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,
+      -1,    54,    -1,    -1,    57,     9,    10,    11,    12,    13,
       14,    15,    16,    -1,    18,    -1,    20,    21,    22,    23,
-      24,    25,    26,    27,    49,    29,    -1,    -1,    -1,    -1,
-      -1,     9,    10,    11,    12,    13,    14,    15,    16,    -1,
-      18,    45,    20,    21,    22,    23,    24,    25,    26,    27,
-      -1,    29,    30,     9,    10,    11,    12,    13,    14,    15,
-      16,    -1,    18,    -1,    20,    21,    22,    23,    24,    25,
-      26,    27,    -1,    29,     9,    10,    11,    12,    13,    14,
-      15,    16,    -1,    18,    -1,    20,    21,    22,    -1,    24,
-      25,    26,    27,    -1,    29
+      24,    25,    26,    27,    -1,    29,    -1,    31,    -1,     9,
+      10,    11,    12,    13,    14,    15,    16,    -1,    18,    -1,
+      20,    21,    22,    23,    24,    25,    26,    27,    -1,    29,
+      54,    31,    56,    -1,    -1,    -1,    -1,    -1,    -1,    -1,
+      -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,
+      -1,    -1,    -1,    -1,    54,    55,     9,    10,    11,    12,
+      13,    14,    15,    16,    -1,    18,    -1,    20,    21,    22,
+      23,    24,    25,    26,    27,    -1,    29,    30,    31,    -1,
+      -1,    -1,     9,    10,    11,    12,    13,    14,    15,    16,
+      -1,    18,    -1,    20,    21,    22,    23,    24,    25,    26,
+      27,    54,    29,    30,    31,    -1,     9,    10,    11,    12,
+      13,    14,    15,    16,    -1,    18,    -1,    20,    21,    22,
+      23,    24,    25,    26,    27,    -1,    29,    54,    31,    32,
+      -1,    -1,     9,    10,    11,    12,    13,    14,    15,    16,
+      -1,    18,    -1,    20,    21,    22,    23,    24,    25,    26,
+      27,    54,    29,    30,    31,    -1,     9,    10,    11,    12,
+      13,    14,    15,    16,    -1,    18,    -1,    20,    21,    22,
+      23,    24,    25,    26,    27,    -1,    29,    54,    31,    -1,
+       9,    10,    11,    12,    13,    14,    15,    16,    -1,    18,
+      -1,    20,    21,    22,    -1,    24,    25,    26,    27,    -1,
+      29,    54,    31,    -1,    -1,    -1,    -1,    -1,    -1,    -1,
+      -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,
+      -1,    -1,    -1,    -1,    -1,    54
 };
 
-  /* YYSTOS[STATE-NUM] -- The (internal number of the) accessing
-     symbol of state STATE-NUM.  */
-static const yytype_uint8 yystos[] =
+/* YYSTOS[STATE-NUM] -- The symbol kind of the accessing symbol of
+   state STATE-NUM.  */
+static const yytype_int8 yystos[] =
 {
        0,     3,     4,     5,     6,     7,     8,    14,    19,    28,
-      32,    33,    35,    37,    38,    40,    41,    43,    44,    52,
-      53,    54,    55,    58,    59,    60,    61,    65,    66,    67,
-      68,    69,    70,    71,    72,    73,    74,    75,    17,    44,
-      75,    75,    75,     3,    62,    75,    75,    75,    53,     3,
-       3,    75,     0,    54,    49,     9,    10,    11,    12,    13,
-      14,    15,    16,    18,    20,    21,    22,    23,    24,    25,
-      26,    27,    29,    75,    64,    75,    44,    49,    49,    49,
-      34,    49,    45,    49,    75,    75,    75,    75,    75,    75,
-      75,    75,    75,    75,    75,    75,    75,    75,    75,    75,
-      75,    75,    45,    48,     3,    63,    34,    53,    34,    53,
-      53,    34,    56,    57,    62,    30,    75,    45,    48,    34,
-      34,    34,    39,    49,    34,    56,    49,    75,     3,    53,
-      49,    34,    53,    34,    34
+      33,    34,    36,    38,    39,    41,    42,    44,    45,    46,
+      48,    49,    50,    52,    54,    60,    61,    62,    63,    66,
+      67,    68,    69,    71,    75,    76,    77,    78,    79,    80,
+      81,    82,    83,    84,    85,    86,    88,    89,    17,    50,
+      89,    89,    89,     3,    72,    89,    89,    89,    61,     3,
+       3,    89,     3,    33,    89,    89,    87,    89,    74,    89,
+       0,    62,    57,     9,    10,    11,    12,    13,    14,    15,
+      16,    18,    20,    21,    22,    23,    24,    25,    26,    27,
+      29,    31,    54,    89,    74,    50,    57,    57,    57,    35,
+      57,    47,    72,    51,    53,    56,    30,    55,    56,    57,
+      89,    89,    89,    89,    89,    89,    89,    89,    89,    89,
+      89,    89,    89,    89,    89,    89,    89,    89,     3,    89,
+      51,     3,    73,    35,    61,    35,    61,    61,    35,    64,
+      65,    72,    89,    57,    89,    89,    89,    30,    50,    55,
+      51,    56,    35,    35,    35,    40,    57,    35,    64,    57,
+      32,    35,    61,    30,    89,    74,    17,     3,    61,    57,
+      35,    61,    89,    35,    89,    51,    89,    35,    35,    56,
+      70,    89,    57,    35,    61,    35
 };
 
-  /* YYR1[YYN] -- Symbol number of symbol that rule YYN derives.  */
-static const yytype_uint8 yyr1[] =
+/* YYR1[RULE-NUM] -- Symbol kind of the left-hand side of rule RULE-NUM.  */
+static const yytype_int8 yyr1[] =
 {
-       0,    51,    52,    52,    53,    53,    54,    54,    54,    54,
-      54,    54,    54,    54,    55,    56,    56,    57,    57,    58,
-      58,    59,    60,    60,    61,    61,    62,    63,    63,    63,
-      64,    64,    64,    65,    66,    66,    67,    67,    68,    69,
-      70,    70,    71,    72,    73,    73,    74,    75,    75,    75,
-      75,    75,    75,    75,    75,    75,    75,    75,    75,    75,
-      75,    75,    75,    75,    75,    75,    75,    75,    75,    75,
-      75,    75,    75,    75,    75,    75
+       0,    59,    60,    60,    61,    61,    62,    62,    62,    62,
+      62,    62,    62,    62,    62,    63,    64,    64,    65,    65,
+      66,    66,    67,    68,    68,    69,    69,    70,    70,    71,
+      71,    71,    71,    72,    73,    73,    73,    74,    74,    74,
+      75,    76,    76,    77,    77,    78,    79,    80,    80,    81,
+      82,    82,    83,    83,    84,    85,    86,    87,    87,    87,
+      88,    88,    89,    89,    89,    89,    89,    89,    89,    89,
+      89,    89,    89,    89,    89,    89,    89,    89,    89,    89,
+      89,    89,    89,    89,    89,    89,    89,    89,    89,    89,
+      89,    89,    89,    89,    89,    89,    89
 };
 
-  /* YYR2[YYN] -- Number of symbols on the right hand side of rule YYN.  */
-static const yytype_uint8 yyr2[] =
+/* YYR2[RULE-NUM] -- Number of symbols on the right-hand side of rule RULE-NUM.  */
+static const yytype_int8 yyr2[] =
 {
        0,     2,     0,     1,     2,     3,     1,     1,     1,     1,
-       1,     1,     1,     1,     2,     4,     3,     2,     3,     4,
-       5,     3,     5,     4,     5,     4,     4,     0,     1,     3,
-       0,     1,     3,     1,     1,     1,     1,     2,     1,     5,
-       1,     1,     1,     4,     5,     7,     3,     1,     1,     1,
-       1,     1,     1,     1,     1,     3,     3,     3,     3,     3,
+       1,     1,     1,     1,     1,     2,     4,     3,     2,     3,
+       4,     5,     3,     5,     4,    10,     9,     0,     2,     5,
+       4,     6,     5,     4,     0,     1,     3,     0,     1,     3,
+       1,     1,     1,     1,     2,     1,     5,     1,     1,     1,
+       4,     6,     5,     7,     3,     3,     3,     0,     3,     5,
+       4,     6,     1,     1,     1,     1,     1,     1,     1,     1,
+       1,     1,     1,     3,     3,     3,     3,     3,     3,     3,
        3,     3,     3,     3,     3,     3,     3,     3,     3,     3,
-       3,     3,     3,     2,     2,     2
+       3,     3,     2,     2,     2,     2,     2
 };
 
 
+enum { YYENOMEM = -2 };
+
 #define yyerrok         (yyerrstatus = 0)
 #define yyclearin       (yychar = YYEMPTY)
-#define YYEMPTY         (-2)
-#define YYEOF           0
 
 #define YYACCEPT        goto yyacceptlab
 #define YYABORT         goto yyabortlab
 #define YYERROR         goto yyerrorlab
+#define YYNOMEM         goto yyexhaustedlab
 
 
 #define YYRECOVERING()  (!!yyerrstatus)
@@ -825,15 +1066,14 @@ static const yytype_uint8 yyr2[] =
       }                                                           \
     else                                                          \
       {                                                           \
-        yyerror (&yylloc, scanner, ast, YY_("syntax error: cannot back up")); \
+        yyerror (&yylloc, lexer, ast, YY_("syntax error: cannot back up")); \
         YYERROR;                                                  \
       }                                                           \
   while (0)
 
-/* Error token number */
-#define YYTERROR        1
-#define YYERRCODE       256
-
+/* Backward compatibility with an undocumented macro.
+   Use YYerror or YYUNDEF. */
+#define YYERRCODE YYUNDEF
 
 /* YYLLOC_DEFAULT -- Set CURRENT to span from RHS[1] to RHS[N].
    If N is 0, then set CURRENT to the empty location which ends
@@ -877,12 +1117,19 @@ do {                                            \
 } while (0)
 
 
-/* YY_LOCATION_PRINT -- Print the location on the stream.
+/* YYLOCATION_PRINT -- Print the location on the stream.
    This macro was not mandated originally: define only if we know
    we won't break user code: when these are the locations we know.  */
 
-#ifndef YY_LOCATION_PRINT
-# if defined YYLTYPE_IS_TRIVIAL && YYLTYPE_IS_TRIVIAL
+# ifndef YYLOCATION_PRINT
+
+#  if defined YY_LOCATION_PRINT
+
+   /* Temporary convenience wrapper in case some people defined the
+      undocumented and private YY_LOCATION_PRINT macros.  */
+#   define YYLOCATION_PRINT(File, Loc)  YY_LOCATION_PRINT(File, *(Loc))
+
+#  elif defined YYLTYPE_IS_TRIVIAL && YYLTYPE_IS_TRIVIAL
 
 /* Print *YYLOCP on YYO.  Private, do not rely on its existence. */
 
@@ -910,24 +1157,32 @@ yy_location_print_ (FILE *yyo, YYLTYPE const * const yylocp)
         res += YYFPRINTF (yyo, "-%d", end_col);
     }
   return res;
- }
+}
 
-#  define YY_LOCATION_PRINT(File, Loc)          \
-  yy_location_print_ (File, &(Loc))
+#   define YYLOCATION_PRINT  yy_location_print_
 
-# else
-#  define YY_LOCATION_PRINT(File, Loc) ((void) 0)
-# endif
-#endif
+    /* Temporary convenience wrapper in case some people defined the
+       undocumented and private YY_LOCATION_PRINT macros.  */
+#   define YY_LOCATION_PRINT(File, Loc)  YYLOCATION_PRINT(File, &(Loc))
+
+#  else
 
+#   define YYLOCATION_PRINT(File, Loc) ((void) 0)
+    /* Temporary convenience wrapper in case some people defined the
+       undocumented and private YY_LOCATION_PRINT macros.  */
+#   define YY_LOCATION_PRINT  YYLOCATION_PRINT
+
+#  endif
+# endif /* !defined YYLOCATION_PRINT */
 
-# define YY_SYMBOL_PRINT(Title, Type, Value, Location)                    \
+
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)                    \
 do {                                                                      \
   if (yydebug)                                                            \
     {                                                                     \
       YYFPRINTF (stderr, "%s ", Title);                                   \
       yy_symbol_print (stderr,                                            \
-                  Type, Value, Location, scanner, ast); \
+                  Kind, Value, Location, lexer, ast); \
       YYFPRINTF (stderr, "\n");                                           \
     }                                                                     \
 } while (0)
@@ -938,21 +1193,18 @@ do {                                                                      \
 `-----------------------------------*/
 
 static void
-yy_symbol_value_print (FILE *yyo, int yytype, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp, void* scanner, pd_ast_node* ast)
+yy_symbol_value_print (FILE *yyo,
+                       yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp, struct pd_lexer* lexer, pd_ast_node* ast)
 {
   FILE *yyoutput = yyo;
-  YYUSE (yyoutput);
-  YYUSE (yylocationp);
-  YYUSE (scanner);
-  YYUSE (ast);
+  YY_USE (yyoutput);
+  YY_USE (yylocationp);
+  YY_USE (lexer);
+  YY_USE (ast);
   if (!yyvaluep)
     return;
-# ifdef YYPRINT
-  if (yytype < YYNTOKENS)
-    YYPRINT (yyo, yytoknum[yytype], *yyvaluep);
-# endif
   YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
-  YYUSE (yytype);
+  YY_USE (yykind);
   YY_IGNORE_MAYBE_UNINITIALIZED_END
 }
 
@@ -962,14 +1214,15 @@ yy_symbol_value_print (FILE *yyo, int yytype, YYSTYPE const * const yyvaluep, YY
 `---------------------------*/
 
 static void
-yy_symbol_print (FILE *yyo, int yytype, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp, void* scanner, pd_ast_node* ast)
+yy_symbol_print (FILE *yyo,
+                 yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp, struct pd_lexer* lexer, pd_ast_node* ast)
 {
   YYFPRINTF (yyo, "%s %s (",
-             yytype < YYNTOKENS ? "token" : "nterm", yytname[yytype]);
+             yykind < YYNTOKENS ? "token" : "nterm", yysymbol_name (yykind));
 
-  YY_LOCATION_PRINT (yyo, *yylocationp);
+  YYLOCATION_PRINT (yyo, yylocationp);
   YYFPRINTF (yyo, ": ");
-  yy_symbol_value_print (yyo, yytype, yyvaluep, yylocationp, scanner, ast);
+  yy_symbol_value_print (yyo, yykind, yyvaluep, yylocationp, lexer, ast);
   YYFPRINTF (yyo, ")");
 }
 
@@ -979,7 +1232,7 @@ yy_symbol_print (FILE *yyo, int yytype, YYSTYPE const * const yyvaluep, YYLTYPE
 `------------------------------------------------------------------*/
 
 static void
-yy_stack_print (yytype_int16 *yybottom, yytype_int16 *yytop)
+yy_stack_print (yy_state_t *yybottom, yy_state_t *yytop)
 {
   YYFPRINTF (stderr, "Stack now");
   for (; yybottom <= yytop; yybottom++)
@@ -1002,21 +1255,22 @@ do {                                                            \
 `------------------------------------------------*/
 
 static void
-yy_reduce_print (yytype_int16 *yyssp, YYSTYPE *yyvsp, YYLTYPE *yylsp, int yyrule, void* scanner, pd_ast_node* ast)
+yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp, YYLTYPE *yylsp,
+                 int yyrule, struct pd_lexer* lexer, pd_ast_node* ast)
 {
-  unsigned long yylno = yyrline[yyrule];
+  int yylno = yyrline[yyrule];
   int yynrhs = yyr2[yyrule];
   int yyi;
-  YYFPRINTF (stderr, "Reducing stack by rule %d (line %lu):\n",
+  YYFPRINTF (stderr, "Reducing stack by rule %d (line %d):\n",
              yyrule - 1, yylno);
   /* The symbols being reduced.  */
   for (yyi = 0; yyi < yynrhs; yyi++)
     {
       YYFPRINTF (stderr, "   $%d = ", yyi + 1);
       yy_symbol_print (stderr,
-                       yystos[yyssp[yyi + 1 - yynrhs]],
-                       &yyvsp[(yyi + 1) - (yynrhs)]
-                       , &(yylsp[(yyi + 1) - (yynrhs)])                       , scanner, ast);
+                       YY_ACCESSING_SYMBOL (+yyssp[yyi + 1 - yynrhs]),
+                       &yyvsp[(yyi + 1) - (yynrhs)],
+                       &(yylsp[(yyi + 1) - (yynrhs)]), lexer, ast);
       YYFPRINTF (stderr, "\n");
     }
 }
@@ -1024,15 +1278,15 @@ yy_reduce_print (yytype_int16 *yyssp, YYSTYPE *yyvsp, YYLTYPE *yylsp, int yyrule
 # define YY_REDUCE_PRINT(Rule)          \
 do {                                    \
   if (yydebug)                          \
-    yy_reduce_print (yyssp, yyvsp, yylsp, Rule, scanner, ast); \
+    yy_reduce_print (yyssp, yyvsp, yylsp, Rule, lexer, ast); \
 } while (0)
 
 /* Nonzero means print parse trace.  It is left uninitialized so that
    multiple parsers can coexist.  */
 int yydebug;
 #else /* !YYDEBUG */
-# define YYDPRINTF(Args)
-# define YY_SYMBOL_PRINT(Title, Type, Value, Location)
+# define YYDPRINTF(Args) ((void) 0)
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)
 # define YY_STACK_PRINT(Bottom, Top)
 # define YY_REDUCE_PRINT(Rule)
 #endif /* !YYDEBUG */
@@ -1055,28 +1309,77 @@ int yydebug;
 #endif
 
 
-#if YYERROR_VERBOSE
+/* Context of a parse error.  */
+typedef struct
+{
+  yy_state_t *yyssp;
+  yysymbol_kind_t yytoken;
+  YYLTYPE *yylloc;
+} yypcontext_t;
+
+/* Put in YYARG at most YYARGN of the expected tokens given the
+   current YYCTX, and return the number of tokens stored in YYARG.  If
+   YYARG is null, return the number of expected tokens (guaranteed to
+   be less than YYNTOKENS).  Return YYENOMEM on memory exhaustion.
+   Return 0 if there are more than YYARGN expected tokens, yet fill
+   YYARG up to YYARGN. */
+static int
+yypcontext_expected_tokens (const yypcontext_t *yyctx,
+                            yysymbol_kind_t yyarg[], int yyargn)
+{
+  /* Actual size of YYARG. */
+  int yycount = 0;
+  int yyn = yypact[+*yyctx->yyssp];
+  if (!yypact_value_is_default (yyn))
+    {
+      /* Start YYX at -YYN if negative to avoid negative indexes in
+         YYCHECK.  In other words, skip the first -YYN actions for
+         this state because they are default actions.  */
+      int yyxbegin = yyn < 0 ? -yyn : 0;
+      /* Stay within bounds of both yycheck and yytname.  */
+      int yychecklim = YYLAST - yyn + 1;
+      int yyxend = yychecklim < YYNTOKENS ? yychecklim : YYNTOKENS;
+      int yyx;
+      for (yyx = yyxbegin; yyx < yyxend; ++yyx)
+        if (yycheck[yyx + yyn] == yyx && yyx != YYSYMBOL_YYerror
+            && !yytable_value_is_error (yytable[yyx + yyn]))
+          {
+            if (!yyarg)
+              ++yycount;
+            else if (yycount == yyargn)
+              return 0;
+            else
+              yyarg[yycount++] = YY_CAST (yysymbol_kind_t, yyx);
+          }
+    }
+  if (yyarg && yycount == 0 && 0 < yyargn)
+    yyarg[0] = YYSYMBOL_YYEMPTY;
+  return yycount;
+}
+
+
 
-# ifndef yystrlen
-#  if defined __GLIBC__ && defined _STRING_H
-#   define yystrlen strlen
-#  else
+
+#ifndef yystrlen
+# if defined __GLIBC__ && defined _STRING_H
+#  define yystrlen(S) (YY_CAST (YYPTRDIFF_T, strlen (S)))
+# else
 /* Return the length of YYSTR.  */
-static YYSIZE_T
+static YYPTRDIFF_T
 yystrlen (const char *yystr)
 {
-  YYSIZE_T yylen;
+  YYPTRDIFF_T yylen;
   for (yylen = 0; yystr[yylen]; yylen++)
     continue;
   return yylen;
 }
-#  endif
 # endif
+#endif
 
-# ifndef yystpcpy
-#  if defined __GLIBC__ && defined _STRING_H && defined _GNU_SOURCE
-#   define yystpcpy stpcpy
-#  else
+#ifndef yystpcpy
+# if defined __GLIBC__ && defined _STRING_H && defined _GNU_SOURCE
+#  define yystpcpy stpcpy
+# else
 /* Copy YYSRC to YYDEST, returning the address of the terminating '\0' in
    YYDEST.  */
 static char *
@@ -1090,10 +1393,10 @@ yystpcpy (char *yydest, const char *yysrc)
 
   return yyd - 1;
 }
-#  endif
 # endif
+#endif
 
-# ifndef yytnamerr
+#ifndef yytnamerr
 /* Copy to YYRES the contents of YYSTR after stripping away unnecessary
    quotes and backslashes, so that it's suitable for yyerror.  The
    heuristic is that double-quoting is unnecessary unless the string
@@ -1101,14 +1404,13 @@ yystpcpy (char *yydest, const char *yysrc)
    backslash-backslash).  YYSTR is taken from yytname.  If YYRES is
    null, do not copy; instead, return the length of what the result
    would have been.  */
-static YYSIZE_T
+static YYPTRDIFF_T
 yytnamerr (char *yyres, const char *yystr)
 {
   if (*yystr == '"')
     {
-      YYSIZE_T yyn = 0;
+      YYPTRDIFF_T yyn = 0;
       char const *yyp = yystr;
-
       for (;;)
         switch (*++yyp)
           {
@@ -1137,36 +1439,20 @@ yytnamerr (char *yyres, const char *yystr)
     do_not_strip_quotes: ;
     }
 
-  if (! yyres)
+  if (yyres)
+    return yystpcpy (yyres, yystr) - yyres;
+  else
     return yystrlen (yystr);
-
-  return (YYSIZE_T) (yystpcpy (yyres, yystr) - yyres);
 }
-# endif
+#endif
 
-/* Copy into *YYMSG, which is of size *YYMSG_ALLOC, an error message
-   about the unexpected token YYTOKEN for the state stack whose top is
-   YYSSP.
 
-   Return 0 if *YYMSG was successfully written.  Return 1 if *YYMSG is
-   not large enough to hold the message.  In that case, also set
-   *YYMSG_ALLOC to the required number of bytes.  Return 2 if the
-   required number of bytes is too large to store.  */
 static int
-yysyntax_error (YYSIZE_T *yymsg_alloc, char **yymsg,
-                yytype_int16 *yyssp, int yytoken)
+yy_syntax_error_arguments (const yypcontext_t *yyctx,
+                           yysymbol_kind_t yyarg[], int yyargn)
 {
-  YYSIZE_T yysize0 = yytnamerr (YY_NULLPTR, yytname[yytoken]);
-  YYSIZE_T yysize = yysize0;
-  enum { YYERROR_VERBOSE_ARGS_MAXIMUM = 5 };
-  /* Internationalized format string. */
-  const char *yyformat = YY_NULLPTR;
-  /* Arguments of yyformat. */
-  char const *yyarg[YYERROR_VERBOSE_ARGS_MAXIMUM];
-  /* Number of reported tokens (one for the "unexpected", one per
-     "expected"). */
+  /* Actual size of YYARG. */
   int yycount = 0;
-
   /* There are many possibilities here to consider:
      - If this state is a consistent state with a default action, then
        the only way this function was invoked is if the default action
@@ -1190,49 +1476,54 @@ yysyntax_error (YYSIZE_T *yymsg_alloc, char **yymsg,
        one exception: it will still contain any token that will not be
        accepted due to an error action in a later state.
   */
-  if (yytoken != YYEMPTY)
+  if (yyctx->yytoken != YYSYMBOL_YYEMPTY)
     {
-      int yyn = yypact[*yyssp];
-      yyarg[yycount++] = yytname[yytoken];
-      if (!yypact_value_is_default (yyn))
-        {
-          /* Start YYX at -YYN if negative to avoid negative indexes in
-             YYCHECK.  In other words, skip the first -YYN actions for
-             this state because they are default actions.  */
-          int yyxbegin = yyn < 0 ? -yyn : 0;
-          /* Stay within bounds of both yycheck and yytname.  */
-          int yychecklim = YYLAST - yyn + 1;
-          int yyxend = yychecklim < YYNTOKENS ? yychecklim : YYNTOKENS;
-          int yyx;
-
-          for (yyx = yyxbegin; yyx < yyxend; ++yyx)
-            if (yycheck[yyx + yyn] == yyx && yyx != YYTERROR
-                && !yytable_value_is_error (yytable[yyx + yyn]))
-              {
-                if (yycount == YYERROR_VERBOSE_ARGS_MAXIMUM)
-                  {
-                    yycount = 1;
-                    yysize = yysize0;
-                    break;
-                  }
-                yyarg[yycount++] = yytname[yyx];
-                {
-                  YYSIZE_T yysize1 = yysize + yytnamerr (YY_NULLPTR, yytname[yyx]);
-                  if (yysize <= yysize1 && yysize1 <= YYSTACK_ALLOC_MAXIMUM)
-                    yysize = yysize1;
-                  else
-                    return 2;
-                }
-              }
-        }
+      int yyn;
+      if (yyarg)
+        yyarg[yycount] = yyctx->yytoken;
+      ++yycount;
+      yyn = yypcontext_expected_tokens (yyctx,
+                                        yyarg ? yyarg + 1 : yyarg, yyargn - 1);
+      if (yyn == YYENOMEM)
+        return YYENOMEM;
+      else
+        yycount += yyn;
     }
+  return yycount;
+}
+
+/* Copy into *YYMSG, which is of size *YYMSG_ALLOC, an error message
+   about the unexpected token YYTOKEN for the state stack whose top is
+   YYSSP.
+
+   Return 0 if *YYMSG was successfully written.  Return -1 if *YYMSG is
+   not large enough to hold the message.  In that case, also set
+   *YYMSG_ALLOC to the required number of bytes.  Return YYENOMEM if the
+   required number of bytes is too large to store.  */
+static int
+yysyntax_error (YYPTRDIFF_T *yymsg_alloc, char **yymsg,
+                const yypcontext_t *yyctx)
+{
+  enum { YYARGS_MAX = 5 };
+  /* Internationalized format string. */
+  const char *yyformat = YY_NULLPTR;
+  /* Arguments of yyformat: reported tokens (one for the "unexpected",
+     one per "expected"). */
+  yysymbol_kind_t yyarg[YYARGS_MAX];
+  /* Cumulated lengths of YYARG.  */
+  YYPTRDIFF_T yysize = 0;
+
+  /* Actual size of YYARG. */
+  int yycount = yy_syntax_error_arguments (yyctx, yyarg, YYARGS_MAX);
+  if (yycount == YYENOMEM)
+    return YYENOMEM;
 
   switch (yycount)
     {
-# define YYCASE_(N, S)                      \
+#define YYCASE_(N, S)                       \
       case N:                               \
         yyformat = S;                       \
-      break
+        break
     default: /* Avoid compiler warnings. */
       YYCASE_(0, YY_("syntax error"));
       YYCASE_(1, YY_("syntax error, unexpected %s"));
@@ -1240,15 +1531,23 @@ yysyntax_error (YYSIZE_T *yymsg_alloc, char **yymsg,
       YYCASE_(3, YY_("syntax error, unexpected %s, expecting %s or %s"));
       YYCASE_(4, YY_("syntax error, unexpected %s, expecting %s or %s or %s"));
       YYCASE_(5, YY_("syntax error, unexpected %s, expecting %s or %s or %s or %s"));
-# undef YYCASE_
+#undef YYCASE_
     }
 
+  /* Compute error message size.  Don't count the "%s"s, but reserve
+     room for the terminator.  */
+  yysize = yystrlen (yyformat) - 2 * yycount + 1;
   {
-    YYSIZE_T yysize1 = yysize + yystrlen (yyformat);
-    if (yysize <= yysize1 && yysize1 <= YYSTACK_ALLOC_MAXIMUM)
-      yysize = yysize1;
-    else
-      return 2;
+    int yyi;
+    for (yyi = 0; yyi < yycount; ++yyi)
+      {
+        YYPTRDIFF_T yysize1
+          = yysize + yytnamerr (YY_NULLPTR, yytname[yyarg[yyi]]);
+        if (yysize <= yysize1 && yysize1 <= YYSTACK_ALLOC_MAXIMUM)
+          yysize = yysize1;
+        else
+          return YYENOMEM;
+      }
   }
 
   if (*yymsg_alloc < yysize)
@@ -1257,7 +1556,7 @@ yysyntax_error (YYSIZE_T *yymsg_alloc, char **yymsg,
       if (! (yysize <= *yymsg_alloc
              && *yymsg_alloc <= YYSTACK_ALLOC_MAXIMUM))
         *yymsg_alloc = YYSTACK_ALLOC_MAXIMUM;
-      return 1;
+      return -1;
     }
 
   /* Avoid sprintf, as that infringes on the user's name space.
@@ -1269,50 +1568,53 @@ yysyntax_error (YYSIZE_T *yymsg_alloc, char **yymsg,
     while ((*yyp = *yyformat) != '\0')
       if (*yyp == '%' && yyformat[1] == 's' && yyi < yycount)
         {
-          yyp += yytnamerr (yyp, yyarg[yyi++]);
+          yyp += yytnamerr (yyp, yytname[yyarg[yyi++]]);
           yyformat += 2;
         }
       else
         {
-          yyp++;
-          yyformat++;
+          ++yyp;
+          ++yyformat;
         }
   }
   return 0;
 }
-#endif /* YYERROR_VERBOSE */
+
 
 /*-----------------------------------------------.
 | Release the memory associated to this symbol.  |
 `-----------------------------------------------*/
 
 static void
-yydestruct (const char *yymsg, int yytype, YYSTYPE *yyvaluep, YYLTYPE *yylocationp, void* scanner, pd_ast_node* ast)
+yydestruct (const char *yymsg,
+            yysymbol_kind_t yykind, YYSTYPE *yyvaluep, YYLTYPE *yylocationp, struct pd_lexer* lexer, pd_ast_node* ast)
 {
-  YYUSE (yyvaluep);
-  YYUSE (yylocationp);
-  YYUSE (scanner);
-  YYUSE (ast);
+  YY_USE (yyvaluep);
+  YY_USE (yylocationp);
+  YY_USE (lexer);
+  YY_USE (ast);
   if (!yymsg)
     yymsg = "Deleting";
-  YY_SYMBOL_PRINT (yymsg, yytype, yyvaluep, yylocationp);
+  YY_SYMBOL_PRINT (yymsg, yykind, yyvaluep, yylocationp);
 
   YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
-  YYUSE (yytype);
+  YY_USE (yykind);
   YY_IGNORE_MAYBE_UNINITIALIZED_END
 }
 
 
 
 
+
+
 /*----------.
 | yyparse.  |
 `----------*/
 
 int
-yyparse (void* scanner, pd_ast_node* ast)
+yyparse (struct pd_lexer* lexer, pd_ast_node* ast)
 {
-/* The lookahead symbol.  */
+/* Lookahead token kind.  */
 int yychar;
 
 
@@ -1331,55 +1633,50 @@ static YYLTYPE yyloc_default
 YYLTYPE yylloc = yyloc_default;
 
     /* Number of syntax errors so far.  */
-    int yynerrs;
+    int yynerrs = 0;
 
-    int yystate;
+    yy_state_fast_t yystate = 0;
     /* Number of tokens to shift before error messages enabled.  */
-    int yyerrstatus;
+    int yyerrstatus = 0;
 
-    /* The stacks and their tools:
-       'yyss': related to states.
-       'yyvs': related to semantic values.
-       'yyls': related to locations.
-
-       Refer to the stacks through separate pointers, to allow yyoverflow
+    /* Refer to the stacks through separate pointers, to allow yyoverflow
        to reallocate them elsewhere.  */
 
-    /* The state stack.  */
-    yytype_int16 yyssa[YYINITDEPTH];
-    yytype_int16 *yyss;
-    yytype_int16 *yyssp;
+    /* Their size.  */
+    YYPTRDIFF_T yystacksize = YYINITDEPTH;
+
+    /* The state stack: array, bottom, top.  */
+    yy_state_t yyssa[YYINITDEPTH];
+    yy_state_t *yyss = yyssa;
+    yy_state_t *yyssp = yyss;
 
-    /* The semantic value stack.  */
+    /* The semantic value stack: array, bottom, top.  */
     YYSTYPE yyvsa[YYINITDEPTH];
-    YYSTYPE *yyvs;
-    YYSTYPE *yyvsp;
+    YYSTYPE *yyvs = yyvsa;
+    YYSTYPE *yyvsp = yyvs;
 
-    /* The location stack.  */
+    /* The location stack: array, bottom, top.  */
     YYLTYPE yylsa[YYINITDEPTH];
-    YYLTYPE *yyls;
-    YYLTYPE *yylsp;
-
-    /* The locations where the error started and ended.  */
-    YYLTYPE yyerror_range[3];
-
-    YYSIZE_T yystacksize;
+    YYLTYPE *yyls = yylsa;
+    YYLTYPE *yylsp = yyls;
 
   int yyn;
+  /* The return value of yyparse.  */
   int yyresult;
-  /* Lookahead token as an internal (translated) token number.  */
-  int yytoken = 0;
+  /* Lookahead symbol kind.  */
+  yysymbol_kind_t yytoken = YYSYMBOL_YYEMPTY;
   /* The variables used to return semantic value and location from the
      action routines.  */
   YYSTYPE yyval;
   YYLTYPE yyloc;
 
-#if YYERROR_VERBOSE
+  /* The locations where the error started and ended.  */
+  YYLTYPE yyerror_range[3];
+
   /* Buffer for error messages, and its allocated size.  */
   char yymsgbuf[128];
   char *yymsg = yymsgbuf;
-  YYSIZE_T yymsg_alloc = sizeof yymsgbuf;
-#endif
+  YYPTRDIFF_T yymsg_alloc = sizeof yymsgbuf;
 
 #define YYPOPSTACK(N)   (yyvsp -= (N), yyssp -= (N), yylsp -= (N))
 
@@ -1387,17 +1684,10 @@ YYLTYPE yylloc = yyloc_default;
      Keep to zero when no symbol should be popped.  */
   int yylen = 0;
 
-  yyssp = yyss = yyssa;
-  yyvsp = yyvs = yyvsa;
-  yylsp = yyls = yylsa;
-  yystacksize = YYINITDEPTH;
-
   YYDPRINTF ((stderr, "Starting parse\n"));
 
-  yystate = 0;
-  yyerrstatus = 0;
-  yynerrs = 0;
   yychar = YYEMPTY; /* Cause a token to be read.  */
+
   yylsp[0] = yylloc;
   goto yysetstate;
 
@@ -1412,28 +1702,31 @@ yynewstate:
 
 
 /*--------------------------------------------------------------------.
-| yynewstate -- set current state (the top of the stack) to yystate.  |
+| yysetstate -- set current state (the top of the stack) to yystate.  |
 `--------------------------------------------------------------------*/
 yysetstate:
   YYDPRINTF ((stderr, "Entering state %d\n", yystate));
   YY_ASSERT (0 <= yystate && yystate < YYNSTATES);
-  *yyssp = (yytype_int16) yystate;
+  YY_IGNORE_USELESS_CAST_BEGIN
+  *yyssp = YY_CAST (yy_state_t, yystate);
+  YY_IGNORE_USELESS_CAST_END
+  YY_STACK_PRINT (yyss, yyssp);
 
   if (yyss + yystacksize - 1 <= yyssp)
 #if !defined yyoverflow && !defined YYSTACK_RELOCATE
-    goto yyexhaustedlab;
+    YYNOMEM;
 #else
     {
       /* Get the current used size of the three stacks, in elements.  */
-      YYSIZE_T yysize = (YYSIZE_T) (yyssp - yyss + 1);
+      YYPTRDIFF_T yysize = yyssp - yyss + 1;
 
 # if defined yyoverflow
       {
         /* Give user a chance to reallocate the stack.  Use copies of
            these so that the &'s don't force the real ones into
            memory.  */
+        yy_state_t *yyss1 = yyss;
         YYSTYPE *yyvs1 = yyvs;
-        yytype_int16 *yyss1 = yyss;
         YYLTYPE *yyls1 = yyls;
 
         /* Each stack pointer address is followed by the size of the
@@ -1441,9 +1734,9 @@ yysetstate:
            conditional around just the two extra args, but that might
            be undefined if yyoverflow is a macro.  */
         yyoverflow (YY_("memory exhausted"),
-                    &yyss1, yysize * sizeof (*yyssp),
-                    &yyvs1, yysize * sizeof (*yyvsp),
-                    &yyls1, yysize * sizeof (*yylsp),
+                    &yyss1, yysize * YYSIZEOF (*yyssp),
+                    &yyvs1, yysize * YYSIZEOF (*yyvsp),
+                    &yyls1, yysize * YYSIZEOF (*yylsp),
                     &yystacksize);
         yyss = yyss1;
         yyvs = yyvs1;
@@ -1452,21 +1745,22 @@ yysetstate:
 # else /* defined YYSTACK_RELOCATE */
       /* Extend the stack our own way.  */
       if (YYMAXDEPTH <= yystacksize)
-        goto yyexhaustedlab;
+        YYNOMEM;
       yystacksize *= 2;
       if (YYMAXDEPTH < yystacksize)
         yystacksize = YYMAXDEPTH;
 
       {
-        yytype_int16 *yyss1 = yyss;
+        yy_state_t *yyss1 = yyss;
         union yyalloc *yyptr =
-          (union yyalloc *) YYSTACK_ALLOC (YYSTACK_BYTES (yystacksize));
+          YY_CAST (union yyalloc *,
+                   YYSTACK_ALLOC (YY_CAST (YYSIZE_T, YYSTACK_BYTES (yystacksize))));
         if (! yyptr)
-          goto yyexhaustedlab;
+          YYNOMEM;
         YYSTACK_RELOCATE (yyss_alloc, yyss);
         YYSTACK_RELOCATE (yyvs_alloc, yyvs);
         YYSTACK_RELOCATE (yyls_alloc, yyls);
-# undef YYSTACK_RELOCATE
+#  undef YYSTACK_RELOCATE
         if (yyss1 != yyssa)
           YYSTACK_FREE (yyss1);
       }
@@ -1476,14 +1770,17 @@ yysetstate:
       yyvsp = yyvs + yysize - 1;
       yylsp = yyls + yysize - 1;
 
-      YYDPRINTF ((stderr, "Stack size increased to %lu\n",
-                  (unsigned long) yystacksize));
+      YY_IGNORE_USELESS_CAST_BEGIN
+      YYDPRINTF ((stderr, "Stack size increased to %ld\n",
+                  YY_CAST (long, yystacksize)));
+      YY_IGNORE_USELESS_CAST_END
 
       if (yyss + yystacksize - 1 <= yyssp)
         YYABORT;
     }
 #endif /* !defined yyoverflow && !defined YYSTACK_RELOCATE */
 
+
   if (yystate == YYFINAL)
     YYACCEPT;
 
@@ -1504,18 +1801,30 @@ yybackup:
 
   /* Not known => get a lookahead token if don't already have one.  */
 
-  /* YYCHAR is either YYEMPTY or YYEOF or a valid lookahead symbol.  */
+  /* YYCHAR is either empty, or end-of-input, or a valid lookahead.  */
   if (yychar == YYEMPTY)
     {
-      YYDPRINTF ((stderr, "Reading a token: "));
-      yychar = yylex (&yylval, &yylloc, scanner);
+      YYDPRINTF ((stderr, "Reading a token\n"));
+      yychar = yylex (&yylval, &yylloc, lexer);
     }
 
   if (yychar <= YYEOF)
     {
-      yychar = yytoken = YYEOF;
+      yychar = YYEOF;
+      yytoken = YYSYMBOL_YYEOF;
       YYDPRINTF ((stderr, "Now at end of input.\n"));
     }
+  else if (yychar == YYerror)
+    {
+      /* The scanner already issued an error message, process directly
+         to error recovery.  But do not keep the error token as
+         lookahead, it is too special and may lead us to an endless
+         loop in error recovery. */
+      yychar = YYUNDEF;
+      yytoken = YYSYMBOL_YYerror;
+      yyerror_range[1] = yylloc;
+      goto yyerrlab1;
+    }
   else
     {
       yytoken = YYTRANSLATE (yychar);
@@ -1543,15 +1852,14 @@ yybackup:
 
   /* Shift the lookahead token.  */
   YY_SYMBOL_PRINT ("Shifting", yytoken, &yylval, &yylloc);
-
-  /* Discard the shifted token.  */
-  yychar = YYEMPTY;
-
   yystate = yyn;
   YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
   *++yyvsp = yylval;
   YY_IGNORE_MAYBE_UNINITIALIZED_END
   *++yylsp = yylloc;
+
+  /* Discard the shifted token.  */
+  yychar = YYEMPTY;
   goto yynewstate;
 
 
@@ -1588,336 +1896,458 @@ yyreduce:
   YY_REDUCE_PRINT (yyn);
   switch (yyn)
     {
-  case 2:
-#line 85 "parser.y"
-    { *ast = *pd_ast_empty_create(); }
-#line 1595 "parser.c"
-    break;
-
-  case 3:
-#line 87 "parser.y"
-    { *ast = *(yyvsp[0].node); }
-#line 1601 "parser.c"
+  case 2: /* program: %empty  */
+#line 98 "parser.y"
+                     { *ast = *pd_ast_empty_create(ARENA); }
+#line 1903 "parser.c"
     break;
 
-  case 4:
-#line 91 "parser.y"
-    { (yyval.node) = pd_ast_block_create((yyvsp[-1].node)); }
-#line 1607 "parser.c"
+  case 3: /* program: stmts  */
+#line 100 "parser.y"
+             { *ast = *(yyvsp[0].node); }
+#line 1909 "parser.c"
     break;
 
-  case 5:
-#line 93 "parser.y"
-    { (yyval.node) = pd_ast_block_append((yyvsp[-2].node), (yyvsp[-1].node)); }
-#line 1613 "parser.c"
+  case 4: /* stmts: stmt tSEMI  */
+#line 104 "parser.y"
+                { (yyval.node) = pd_ast_block_create(ARENA, (yyvsp[-1].node)); }
+#line 1915 "parser.c"
     break;
 
-  case 14:
-#line 114 "parser.y"
-    { (yyval.node) = pd_ast_empty_create(); }
-#line 1619 "parser.c"
+  case 5: /* stmts: stmts stmt tSEMI  */
+#line 106 "parser.y"
+                      { (yyval.node) = pd_ast_block_append(ARENA, (yyvsp[-2].node), (yyvsp[-1].node)); }
+#line 1921 "parser.c"
     break;
 
-  case 19:
-#line 127 "parser.y"
-    { (yyval.node) = pd_ast_class_create((yylsp[-3]).first_line, (yyvsp[-2].str)); free((yyvsp[-2].str)); }
-#line 1625 "parser.c"
+  case 15: /* import_stmt: tIMPORT tIDENT  */
+#line 130 "parser.y"
+                            { (yyval.node) = pd_ast_assign_create(ARENA, (yylsp[-1]).first_line, (yyvsp[0].str), pd_ast_import_create(ARENA, (yylsp[-1]).first_line, (yyvsp[0].str))); }
+#line 1927 "parser.c"
     break;
 
-  case 20:
-#line 129 "parser.y"
-    { (yyval.node) = pd_ast_empty_create(); }
-#line 1631 "parser.c"
+  case 20: /* class_stmt: tCLASS tIDENT tSEMI tEND  */
+#line 143 "parser.y"
+                                                 { (yyval.node) = pd_ast_class_create(ARENA, (yylsp[-3]).first_line, (yyvsp[-2].str)); }
+#line 1933 "parser.c"
     break;
 
-  case 21:
-#line 132 "parser.y"
-    { (yyval.node) = (yyvsp[-1].node); }
-#line 1637 "parser.c"
+  case 21: /* class_stmt: tCLASS tIDENT tSEMI class_body tEND  */
+#line 145 "parser.y"
+                                              { (yyval.node) = pd_ast_empty_create(ARENA); }
+#line 1939 "parser.c"
     break;
 
-  case 22:
-#line 136 "parser.y"
-    { (yyval.node) = pd_ast_while_create((yylsp[-4]).first_line, (yyvsp[-3].node), (yyvsp[-1].node)); }
-#line 1643 "parser.c"
+  case 22: /* do_block: tDO stmts tEND  */
+#line 148 "parser.y"
+                         { (yyval.node) = (yyvsp[-1].node); }
+#line 1945 "parser.c"
     break;
 
-  case 23:
-#line 138 "parser.y"
-    { (yyval.node) = pd_ast_while_create((yylsp[-3]).first_line, (yyvsp[-2].node), NULL); }
-#line 1649 "parser.c"
+  case 23: /* while_loop: tWHILE expr tSEMI stmts tEND  */
+#line 152 "parser.y"
+                                       { (yyval.node) = pd_ast_while_create(ARENA, (yylsp[-4]).first_line, (yyvsp[-3].node), (yyvsp[-1].node)); }
+#line 1951 "parser.c"
     break;
 
-  case 24:
-#line 142 "parser.y"
-    { (yyval.node) = pd_ast_function_create((yylsp[-4]).first_line, (yyvsp[-3].node), (yyvsp[-1].node)); }
-#line 1655 "parser.c"
+  case 24: /* while_loop: tWHILE expr tSEMI tEND  */
+#line 154 "parser.y"
+                                 { (yyval.node) = pd_ast_while_create(ARENA, (yylsp[-3]).first_line, (yyvsp[-2].node), NULL); }
+#line 1957 "parser.c"
     break;
 
-  case 25:
-#line 144 "parser.y"
-    { (yyval.node) = pd_ast_function_create((yylsp[-3]).first_line, (yyvsp[-2].node), NULL); }
-#line 1661 "parser.c"
+  case 25: /* for_loop: tFOR tIDENT tIN expr tDOTDOT expr for_step tSEMI stmts tEND  */
+#line 159 "parser.y"
+                                                                    { (yyval.node) = pd_ast_for_create(ARENA, (yylsp[-9]).first_line, (yyvsp[-8].str), (yyvsp[-6].node), (yyvsp[-4].node), (yyvsp[-3].node), (yyvsp[-1].node)); }
+#line 1963 "parser.c"
     break;
 
-  case 26:
-#line 148 "parser.y"
-    {
-       (yyval.node) = pd_ast_prototype_create((yylsp[-3]).first_line, (yyvsp[-3].str), (yyvsp[-1].fnargs).args, (yyvsp[-1].fnargs).count);
-       free((yyvsp[-3].str));
-       for(int x = 0; x < (yyvsp[-1].fnargs).count; x++) free((yyvsp[-1].fnargs).args[x]);
-     }
-#line 1671 "parser.c"
+  case 26: /* for_loop: tFOR tIDENT tIN expr tDOTDOT expr for_step tSEMI tEND  */
+#line 161 "parser.y"
+                                                              { (yyval.node) = pd_ast_for_create(ARENA, (yylsp[-8]).first_line, (yyvsp[-7].str), (yyvsp[-5].node), (yyvsp[-3].node), (yyvsp[-2].node), NULL); }
+#line 1969 "parser.c"
     break;
 
-  case 27:
-#line 155 "parser.y"
-    { (yyval.fnargs).count = 0; (yyval.fnargs).args = NULL; }
-#line 1677 "parser.c"
+  case 27: /* for_step: %empty  */
+#line 164 "parser.y"
+                      { (yyval.node) = NULL; }
+#line 1975 "parser.c"
     break;
 
-  case 28:
-#line 157 "parser.y"
-    { (yyval.fnargs).count = 1; (yyval.fnargs).args = malloc(sizeof(char*)); (yyval.fnargs).args[0] = strdup((yyvsp[0].str)); }
-#line 1683 "parser.c"
+  case 28: /* for_step: tCOMMA expr  */
+#line 166 "parser.y"
+                    { (yyval.node) = (yyvsp[0].node); }
+#line 1981 "parser.c"
     break;
 
-  case 29:
-#line 158 "parser.y"
-    { (yyvsp[-2].fnargs).count++; (yyvsp[-2].fnargs).args = realloc((yyvsp[-2].fnargs).args, sizeof(char*) * (yyvsp[-2].fnargs).count); (yyvsp[-2].fnargs).args[(yyvsp[-2].fnargs).count-1] = strdup((yyvsp[0].str)); (yyval.fnargs) = (yyvsp[-2].fnargs); }
-#line 1689 "parser.c"
+  case 29: /* func: tFUNCTION proto tSEMI stmts tEND  */
+#line 170 "parser.y"
+                                     { (yyval.node) = pd_ast_function_create(ARENA, (yylsp[-4]).first_line, (yyvsp[-3].node), (yyvsp[-1].node)); }
+#line 1987 "parser.c"
     break;
 
-  case 30:
-#line 161 "parser.y"
-    { (yyval.fnargs).count = 0; (yyval.fnargs).call = NULL; }
-#line 1695 "parser.c"
+  case 30: /* func: tFUNCTION proto tSEMI tEND  */
+#line 172 "parser.y"
+                               { (yyval.node) = pd_ast_function_create(ARENA, (yylsp[-3]).first_line, (yyvsp[-2].node), NULL); }
+#line 1993 "parser.c"
     break;
 
-  case 31:
-#line 163 "parser.y"
-    { (yyval.fnargs).count = 1; (yyval.fnargs).call = malloc(sizeof(pd_ast_node*)); (yyval.fnargs).call[0] = (yyvsp[0].node); }
-#line 1701 "parser.c"
+  case 31: /* func: tASYNC tFUNCTION proto tSEMI stmts tEND  */
+#line 174 "parser.y"
+                                            { (yyval.node) = pd_ast_function_create(ARENA, (yylsp[-5]).first_line, (yyvsp[-3].node), (yyvsp[-1].node)); (yyval.node)->function.async = true; }
+#line 1999 "parser.c"
     break;
 
-  case 32:
-#line 165 "parser.y"
-    { (yyvsp[-2].fnargs).count++; (yyvsp[-2].fnargs).call = realloc((yyvsp[-2].fnargs).call, sizeof(pd_ast_node*) * (yyvsp[-2].fnargs).count); (yyvsp[-2].fnargs).call[(yyvsp[-2].fnargs).count - 1] = (yyvsp[0].node); (yyval.fnargs) = (yyvsp[-2].fnargs); }
-#line 1707 "parser.c"
+  case 32: /* func: tASYNC tFUNCTION proto tSEMI tEND  */
+#line 176 "parser.y"
+                                      { (yyval.node) = pd_ast_function_create(ARENA, (yylsp[-4]).first_line, (yyvsp[-2].node), NULL); (yyval.node)->function.async = true; }
+#line 2005 "parser.c"
     break;
 
-  case 33:
-#line 168 "parser.y"
-    { (yyval.node) = pd_ast_number_create((yylsp[0]).first_line, (yyvsp[0].num)); }
-#line 1713 "parser.c"
+  case 33: /* proto: tIDENT tLPAREN fnargs tRPAREN  */
+#line 180 "parser.y"
+                                   { (yyval.node) = pd_ast_prototype_create(ARENA, (yylsp[-3]).first_line, (yyvsp[-3].str), (yyvsp[-1].fnargs).args, (yyvsp[-1].fnargs).count); }
+#line 2011 "parser.c"
     break;
 
-  case 34:
-#line 171 "parser.y"
-    { (yyval.node) = pd_ast_boolean_create((yylsp[0]).first_line, true); }
-#line 1719 "parser.c"
+  case 34: /* fnargs: %empty  */
+#line 183 "parser.y"
+                    { (yyval.fnargs).count = 0; (yyval.fnargs).args = NULL; }
+#line 2017 "parser.c"
     break;
 
-  case 35:
-#line 172 "parser.y"
-    { (yyval.node) = pd_ast_boolean_create((yylsp[0]).first_line, false); }
-#line 1725 "parser.c"
+  case 35: /* fnargs: tIDENT  */
+#line 185 "parser.y"
+             { (yyval.fnargs).count = 1; (yyval.fnargs).args = pd_arena_append(ARENA, NULL, 0, sizeof(pd_ast_text)); (yyval.fnargs).args[0] = (yyvsp[0].str); }
+#line 2023 "parser.c"
     break;
 
-  case 36:
-#line 176 "parser.y"
-    { (yyval.node) = pd_ast_return_create((yylsp[0]).first_line, NULL); }
-#line 1731 "parser.c"
+  case 36: /* fnargs: fnargs tCOMMA tIDENT  */
+#line 186 "parser.y"
+                             { (yyvsp[-2].fnargs).args = pd_arena_append(ARENA, (yyvsp[-2].fnargs).args, (yyvsp[-2].fnargs).count, sizeof(pd_ast_text)); (yyvsp[-2].fnargs).args[(yyvsp[-2].fnargs).count++] = (yyvsp[0].str); (yyval.fnargs) = (yyvsp[-2].fnargs); }
+#line 2029 "parser.c"
     break;
 
-  case 37:
-#line 178 "parser.y"
-    { (yyval.node) = pd_ast_return_create((yylsp[-1]).first_line, (yyvsp[0].node)); }
-#line 1737 "parser.c"
+  case 37: /* args: %empty  */
+#line 189 "parser.y"
+                  { (yyval.fnargs).count = 0; (yyval.fnargs).call = NULL; }
+#line 2035 "parser.c"
     break;
 
-  case 38:
-#line 181 "parser.y"
-    { (yyval.node) = pd_ast_string_create((yylsp[0]).first_line, (yyvsp[0].str)); }
-#line 1743 "parser.c"
+  case 38: /* args: expr  */
+#line 191 "parser.y"
+         { (yyval.fnargs).count = 1; (yyval.fnargs).call = pd_arena_append(ARENA, NULL, 0, sizeof(pd_ast_node*)); (yyval.fnargs).call[0] = (yyvsp[0].node); }
+#line 2041 "parser.c"
     break;
 
-  case 39:
-#line 185 "parser.y"
-    { (yyval.node) = pd_ast_ternary_create((yylsp[-4]).first_line, (yyvsp[-4].node), (yyvsp[-2].node), (yyvsp[0].node)); }
-#line 1749 "parser.c"
+  case 39: /* args: args tCOMMA expr  */
+#line 193 "parser.y"
+                     { (yyvsp[-2].fnargs).call = pd_arena_append(ARENA, (yyvsp[-2].fnargs).call, (yyvsp[-2].fnargs).count, sizeof(pd_ast_node*)); (yyvsp[-2].fnargs).call[(yyvsp[-2].fnargs).count++] = (yyvsp[0].node); (yyval.fnargs) = (yyvsp[-2].fnargs); }
+#line 2047 "parser.c"
     break;
 
-  case 40:
-#line 188 "parser.y"
-    { (yyval.node) = pd_ast_variable_create((yylsp[0]).first_line, (yyvsp[0].str)); }
-#line 1755 "parser.c"
+  case 40: /* number: tNUMBER  */
+#line 196 "parser.y"
+                { (yyval.node) = pd_ast_number_create(ARENA, (yylsp[0]).first_line, (yyvsp[0].num)); }
+#line 2053 "parser.c"
     break;
 
-  case 42:
-#line 193 "parser.y"
-    { (yyval.node) = pd_ast_file_create((yylsp[0]).first_line); }
-#line 1761 "parser.c"
+  case 41: /* bool: tTRUE  */
+#line 199 "parser.y"
+            { (yyval.node) = pd_ast_boolean_create(ARENA, (yylsp[0]).first_line, true); }
+#line 2059 "parser.c"
     break;
 
-  case 43:
-#line 196 "parser.y"
-    { (yyval.node) = pd_ast_call_create((yylsp[-3]).first_line, (yyvsp[-3].str), (yyvsp[-1].fnargs).call, (yyvsp[-1].fnargs).count); free((yyvsp[-3].str)); free((yyvsp[-1].fnargs).call); }
-#line 1767 "parser.c"
+  case 42: /* bool: tFALSE  */
+#line 200 "parser.y"
+             { (yyval.node) = pd_ast_boolean_create(ARENA, (yylsp[0]).first_line, false); }
+#line 2065 "parser.c"
     break;
 
-  case 44:
-#line 200 "parser.y"
-    { (yyval.node) = pd_ast_conditional_create((yylsp[-4]).first_line, (yyvsp[-3].node), (yyvsp[-1].node), NULL); }
-#line 1773 "parser.c"
+  case 43: /* return_expr: tRETURN  */
+#line 204 "parser.y"
+                   { (yyval.node) = pd_ast_return_create(ARENA, (yylsp[0]).first_line, NULL); }
+#line 2071 "parser.c"
     break;
 
-  case 45:
-#line 202 "parser.y"
-    { (yyval.node) = pd_ast_conditional_create((yylsp[-6]).first_line, (yyvsp[-5].node), (yyvsp[-3].node), (yyvsp[-1].node)); }
-#line 1779 "parser.c"
+  case 44: /* return_expr: tRETURN expr  */
+#line 206 "parser.y"
+                        { (yyval.node) = pd_ast_return_create(ARENA, (yylsp[-1]).first_line, (yyvsp[0].node)); }
+#line 2077 "parser.c"
     break;
 
-  case 46:
-#line 205 "parser.y"
-    { (yyval.node) = pd_ast_assign_create((yylsp[-2]).first_line, (yyvsp[-2].str), (yyvsp[0].node)); }
-#line 1785 "parser.c"
+  case 45: /* string: tSTRING  */
+#line 209 "parser.y"
+                { (yyval.node) = pd_ast_string_create(ARENA, (yylsp[0]).first_line, (yyvsp[0].str)); }
+#line 2083 "parser.c"
     break;
 
-  case 50:
-#line 215 "parser.y"
-    { (yyval.node) = pd_ast_null_create((yylsp[0]).first_line); }
-#line 1791 "parser.c"
+  case 46: /* ternary: expr tQU expr tCOLON expr  */
+#line 213 "parser.y"
+                                 { (yyval.node) = pd_ast_ternary_create(ARENA, (yylsp[-4]).first_line, (yyvsp[-4].node), (yyvsp[-2].node), (yyvsp[0].node)); }
+#line 2089 "parser.c"
     break;
 
-  case 55:
-#line 225 "parser.y"
-    { (yyval.node) = (yyvsp[-1].node); }
-#line 1797 "parser.c"
+  case 47: /* ident: tIDENT  */
+#line 216 "parser.y"
+              { (yyval.node) = pd_ast_variable_create(ARENA, (yylsp[0]).first_line, (yyvsp[0].str)); }
+#line 2095 "parser.c"
     break;
 
-  case 56:
-#line 227 "parser.y"
-    { (yyval.node) = pd_ast_binary_op_create((yylsp[-2]).first_line, PD_BIN_PLUS, (yyvsp[-2].node), (yyvsp[0].node)); }
-#line 1803 "parser.c"
+  case 49: /* file: tFILE  */
+#line 221 "parser.y"
+            { (yyval.node) = pd_ast_file_create(ARENA, (yylsp[0]).first_line); }
+#line 2101 "parser.c"
     break;
 
-  case 57:
-#line 229 "parser.y"
-    { (yyval.node) = pd_ast_binary_op_create((yylsp[-2]).first_line, PD_BIN_MINUS, (yyvsp[-2].node), (yyvsp[0].node)); }
-#line 1809 "parser.c"
+  case 50: /* call: tIDENT tLPAREN args tRPAREN  */
+#line 224 "parser.y"
+                                { (yyval.node) = pd_ast_call_create(ARENA, (yylsp[-3]).first_line, (yyvsp[-3].str), (yyvsp[-1].fnargs).call, (yyvsp[-1].fnargs).count); }
+#line 2107 "parser.c"
     break;
 
-  case 58:
-#line 231 "parser.y"
-    { (yyval.node) = pd_ast_binary_op_create((yylsp[-2]).first_line, PD_BIN_DIV, (yyvsp[-2].node), (yyvsp[0].node)); }
-#line 1815 "parser.c"
+  case 51: /* call: expr tDOT tIDENT tLPAREN args tRPAREN  */
+#line 226 "parser.y"
+                                          {
+      (yyval.node) = pd_ast_call_create(ARENA, (yylsp[-5]).first_line, (yyvsp[-3].str), (yyvsp[-1].fnargs).call, (yyvsp[-1].fnargs).count);
+      (yyval.node)->call.callee = pd_ast_property_create(ARENA, (yylsp[-5]).first_line, (yyvsp[-5].node), (yyvsp[-3].str));
+    }
+#line 2116 "parser.c"
     break;
 
-  case 59:
+  case 52: /* cond: tIF expr tSEMI stmts tEND  */
 #line 233 "parser.y"
-    { (yyval.node) = pd_ast_binary_op_create((yylsp[-2]).first_line, PD_BIN_MUL, (yyvsp[-2].node), (yyvsp[0].node)); }
-#line 1821 "parser.c"
+                              { (yyval.node) = pd_ast_conditional_create(ARENA, (yylsp[-4]).first_line, (yyvsp[-3].node), (yyvsp[-1].node), NULL); }
+#line 2122 "parser.c"
     break;
 
-  case 60:
+  case 53: /* cond: tIF expr tSEMI stmts tELSE stmts tEND  */
 #line 235 "parser.y"
-    { (yyval.node) = pd_ast_binary_op_create((yylsp[-2]).first_line, PD_BIN_GT, (yyvsp[-2].node), (yyvsp[0].node)); }
-#line 1827 "parser.c"
+                                          { (yyval.node) = pd_ast_conditional_create(ARENA, (yylsp[-6]).first_line, (yyvsp[-5].node), (yyvsp[-3].node), (yyvsp[-1].node)); }
+#line 2128 "parser.c"
     break;
 
-  case 61:
-#line 237 "parser.y"
-    { (yyval.node) = pd_ast_binary_op_create((yylsp[-2]).first_line, PD_BIN_GE, (yyvsp[-2].node), (yyvsp[0].node)); }
-#line 1833 "parser.c"
+  case 54: /* assign: tIDENT tEQ expr  */
+#line 238 "parser.y"
+                        { (yyval.node) = pd_ast_assign_create(ARENA, (yylsp[-2]).first_line, (yyvsp[-2].str), (yyvsp[0].node)); }
+#line 2134 "parser.c"
     break;
 
-  case 62:
-#line 239 "parser.y"
-    { (yyval.node) = pd_ast_binary_op_create((yylsp[-2]).first_line, PD_BIN_LT, (yyvsp[-2].node), (yyvsp[0].node)); }
-#line 1839 "parser.c"
+  case 55: /* array: tLBRACKET args tRBRACKET  */
+#line 241 "parser.y"
+                                { (yyval.node) = pd_ast_array_create(ARENA, (yylsp[-2]).first_line, (yyvsp[-1].fnargs).call, (yyvsp[-1].fnargs).count); }
+#line 2140 "parser.c"
     break;
 
-  case 63:
-#line 241 "parser.y"
-    { (yyval.node) = pd_ast_binary_op_create((yylsp[-2]).first_line, PD_BIN_LE, (yyvsp[-2].node), (yyvsp[0].node)); }
-#line 1845 "parser.c"
+  case 56: /* dict: tLBRACE pairs tRBRACE  */
+#line 244 "parser.y"
+                            { (yyval.node) = pd_ast_dict_create(ARENA, (yylsp[-2]).first_line, (yyvsp[-1].pairs).keys, (yyvsp[-1].pairs).values, (yyvsp[-1].pairs).count); }
+#line 2146 "parser.c"
     break;
 
-  case 64:
-#line 243 "parser.y"
-    { (yyval.node) = pd_ast_binary_op_create((yylsp[-2]).first_line, PD_BIN_SHR, (yyvsp[-2].node), (yyvsp[0].node)); }
-#line 1851 "parser.c"
+  case 57: /* pairs: %empty  */
+#line 247 "parser.y"
+                   { (yyval.pairs).count = 0; (yyval.pairs).keys = NULL; (yyval.pairs).values = NULL; }
+#line 2152 "parser.c"
     break;
 
-  case 65:
-#line 245 "parser.y"
-    { (yyval.node) = pd_ast_binary_op_create((yylsp[-2]).first_line, PD_BIN_SHL, (yyvsp[-2].node), (yyvsp[0].node)); }
-#line 1857 "parser.c"
+  case 58: /* pairs: expr tCOLON expr  */
+#line 249 "parser.y"
+                      {
+       (yyval.pairs).count = 1;
+       (yyval.pairs).keys = pd_arena_append(ARENA, NULL, 0, sizeof(pd_ast_node*));
+       (yyval.pairs).values = pd_arena_append(ARENA, NULL, 0, sizeof(pd_ast_node*));
+       (yyval.pairs).keys[0] = (yyvsp[-2].node);
+       (yyval.pairs).values[0] = (yyvsp[0].node);
+     }
+#line 2164 "parser.c"
     break;
 
-  case 66:
-#line 247 "parser.y"
-    { (yyval.node) = pd_ast_binary_op_create((yylsp[-2]).first_line, PD_BIN_BOR, (yyvsp[-2].node), (yyvsp[0].node)); }
-#line 1863 "parser.c"
+  case 59: /* pairs: pairs tCOMMA expr tCOLON expr  */
+#line 257 "parser.y"
+                                   {
+       (yyvsp[-4].pairs).keys = pd_arena_append(ARENA, (yyvsp[-4].pairs).keys, (yyvsp[-4].pairs).count, sizeof(pd_ast_node*));
+       (yyvsp[-4].pairs).values = pd_arena_append(ARENA, (yyvsp[-4].pairs).values, (yyvsp[-4].pairs).count, sizeof(pd_ast_node*));
+       (yyvsp[-4].pairs).keys[(yyvsp[-4].pairs).count] = (yyvsp[-2].node);
+       (yyvsp[-4].pairs).values[(yyvsp[-4].pairs).count] = (yyvsp[0].node);
+       (yyvsp[-4].pairs).count++;
+       (yyval.pairs) = (yyvsp[-4].pairs);
+     }
+#line 2177 "parser.c"
     break;
 
-  case 67:
-#line 249 "parser.y"
-    { (yyval.node) = pd_ast_binary_op_create((yylsp[-2]).first_line, PD_BIN_BAND, (yyvsp[-2].node), (yyvsp[0].node)); }
-#line 1869 "parser.c"
+  case 60: /* index: expr tLBRACKET expr tRBRACKET  */
+#line 269 "parser.y"
+                                   { (yyval.node) = pd_ast_index_create(ARENA, (yylsp[-3]).first_line, (yyvsp[-3].node), (yyvsp[-1].node), NULL); }
+#line 2183 "parser.c"
     break;
 
-  case 68:
-#line 251 "parser.y"
-    { (yyval.node) = pd_ast_binary_op_create((yylsp[-2]).first_line, PD_BIN_EQ, (yyvsp[-2].node), (yyvsp[0].node)); }
-#line 1875 "parser.c"
+  case 61: /* index: expr tLBRACKET expr tRBRACKET tEQ expr  */
+#line 271 "parser.y"
+                                            { (yyval.node) = pd_ast_index_create(ARENA, (yylsp[-5]).first_line, (yyvsp[-5].node), (yyvsp[-3].node), (yyvsp[0].node)); }
+#line 2189 "parser.c"
     break;
 
-  case 69:
-#line 253 "parser.y"
-    { (yyval.node) = pd_ast_binary_op_create((yylsp[-2]).first_line, PD_BIN_XOR, (yyvsp[-2].node), (yyvsp[0].node)); }
-#line 1881 "parser.c"
+  case 65: /* expr: tNULL  */
+#line 281 "parser.y"
+          { (yyval.node) = pd_ast_null_create(ARENA, (yylsp[0]).first_line); }
+#line 2195 "parser.c"
     break;
 
-  case 70:
-#line 255 "parser.y"
-    { (yyval.node) = pd_ast_binary_op_create((yylsp[-2]).first_line, PD_BIN_NEQ, (yyvsp[-2].node), (yyvsp[0].node)); }
-#line 1887 "parser.c"
+  case 73: /* expr: expr tDOT tIDENT  */
+#line 297 "parser.y"
+                                  { (yyval.node) = pd_ast_property_create(ARENA, (yylsp[-2]).first_line, (yyvsp[-2].node), (yyvsp[0].str)); }
+#line 2201 "parser.c"
     break;
 
-  case 71:
-#line 257 "parser.y"
-    { (yyval.node) = pd_ast_binary_op_create((yylsp[-2]).first_line, PD_BIN_AND, (yyvsp[-2].node), (yyvsp[0].node)); }
-#line 1893 "parser.c"
+  case 74: /* expr: tLPAREN expr tRPAREN  */
+#line 299 "parser.y"
+                         { (yyval.node) = (yyvsp[-1].node); }
+#line 2207 "parser.c"
     break;
 
-  case 72:
-#line 259 "parser.y"
-    { (yyval.node) = pd_ast_binary_op_create((yylsp[-2]).first_line, PD_BIN_OR, (yyvsp[-2].node), (yyvsp[0].node)); }
-#line 1899 "parser.c"
+  case 75: /* expr: expr tPLUS expr  */
+#line 301 "parser.y"
+                    { (yyval.node) = pd_ast_binary_op_create(ARENA, (yylsp[-2]).first_line, PD_BIN_PLUS, (yyvsp[-2].node), (yyvsp[0].node)); }
+#line 2213 "parser.c"
     break;
 
-  case 73:
-#line 261 "parser.y"
-    { (yyval.node) = pd_ast_unary_op_create((yylsp[-1]).first_line, PD_UNARY_BNOT, (yyvsp[0].node)); }
-#line 1905 "parser.c"
+  case 76: /* expr: expr tMINUS expr  */
+#line 303 "parser.y"
+                     { (yyval.node) = pd_ast_binary_op_create(ARENA, (yylsp[-2]).first_line, PD_BIN_MINUS, (yyvsp[-2].node), (yyvsp[0].node)); }
+#line 2219 "parser.c"
     break;
 
-  case 74:
-#line 263 "parser.y"
-    { (yyval.node) = pd_ast_unary_op_create((yylsp[-1]).first_line, PD_UNARY_MINUS, (yyvsp[0].node)); /* pd_ast_binary_op_create(@1.first_line, PD_BIN_MINUS, pd_ast_number_create(@1.first_line, 0), $2); */ }
-#line 1911 "parser.c"
+  case 77: /* expr: expr tSLASH expr  */
+#line 305 "parser.y"
+                     { (yyval.node) = pd_ast_binary_op_create(ARENA, (yylsp[-2]).first_line, PD_BIN_DIV, (yyvsp[-2].node), (yyvsp[0].node)); }
+#line 2225 "parser.c"
     break;
 
-  case 75:
-#line 265 "parser.y"
-    { (yyval.node) = pd_ast_unary_op_create((yylsp[-1]).first_line, PD_UNARY_NOT, (yyvsp[0].node)); }
-#line 1917 "parser.c"
+  case 78: /* expr: expr tSTAR expr  */
+#line 307 "parser.y"
+                    { (yyval.node) = pd_ast_binary_op_create(ARENA, (yylsp[-2]).first_line, PD_BIN_MUL, (yyvsp[-2].node), (yyvsp[0].node)); }
+#line 2231 "parser.c"
     break;
 
+  case 79: /* expr: expr tGT expr  */
+#line 309 "parser.y"
+                  { (yyval.node) = pd_ast_binary_op_create(ARENA, (yylsp[-2]).first_line, PD_BIN_GT, (yyvsp[-2].node), (yyvsp[0].node)); }
+#line 2237 "parser.c"
+    break;
 
-#line 1921 "parser.c"
+  case 80: /* expr: expr tGE expr  */
+#line 311 "parser.y"
+                  { (yyval.node) = pd_ast_binary_op_create(ARENA, (yylsp[-2]).first_line, PD_BIN_GE, (yyvsp[-2].node), (yyvsp[0].node)); }
+#line 2243 "parser.c"
+    break;
+
+  case 81: /* expr: expr tLT expr  */
+#line 313 "parser.y"
+                  { (yyval.node) = pd_ast_binary_op_create(ARENA, (yylsp[-2]).first_line, PD_BIN_LT, (yyvsp[-2].node), (yyvsp[0].node)); }
+#line 2249 "parser.c"
+    break;
+
+  case 82: /* expr: expr tLE expr  */
+#line 315 "parser.y"
+                  { (yyval.node) = pd_ast_binary_op_create(ARENA, (yylsp[-2]).first_line, PD_BIN_LE, (yyvsp[-2].node), (yyvsp[0].node)); }
+#line 2255 "parser.c"
+    break;
+
+  case 83: /* expr: expr tSHR expr  */
+#line 317 "parser.y"
+                   { (yyval.node) = pd_ast_binary_op_create(ARENA, (yylsp[-2]).first_line, PD_BIN_SHR, (yyvsp[-2].node), (yyvsp[0].node)); }
+#line 2261 "parser.c"
+    break;
+
+  case 84: /* expr: expr tSHL expr  */
+#line 319 "parser.y"
+                   { (yyval.node) = pd_ast_binary_op_create(ARENA, (yylsp[-2]).first_line, PD_BIN_SHL, (yyvsp[-2].node), (yyvsp[0].node)); }
+#line 2267 "parser.c"
+    break;
+
+  case 85: /* expr: expr tBOR expr  */
+#line 321 "parser.y"
+                   { (yyval.node) = pd_ast_binary_op_create(ARENA, (yylsp[-2]).first_line, PD_BIN_BOR, (yyvsp[-2].node), (yyvsp[0].node)); }
+#line 2273 "parser.c"
+    break;
+
+  case 86: /* expr: expr tBAND expr  */
+#line 323 "parser.y"
+                    { (yyval.node) = pd_ast_binary_op_create(ARENA, (yylsp[-2]).first_line, PD_BIN_BAND, (yyvsp[-2].node), (yyvsp[0].node)); }
+#line 2279 "parser.c"
+    break;
+
+  case 87: /* expr: expr tEQEQ expr  */
+#line 325 "parser.y"
+                    { (yyval.node) = pd_ast_binary_op_create(ARENA, (yylsp[-2]).first_line, PD_BIN_EQ, (yyvsp[-2].node), (yyvsp[0].node)); }
+#line 2285 "parser.c"
+    break;
+
+  case 88: /* expr: expr tXOR expr  */
+#line 327 "parser.y"
+                   { (yyval.node) = pd_ast_binary_op_create(ARENA, (yylsp[-2]).first_line, PD_BIN_XOR, (yyvsp[-2].node), (yyvsp[0].node)); }
+#line 2291 "parser.c"
+    break;
+
+  case 89: /* expr: expr tNEQ expr  */
+#line 329 "parser.y"
+                   { (yyval.node) = pd_ast_binary_op_create(ARENA, (yylsp[-2]).first_line, PD_BIN_NEQ, (yyvsp[-2].node), (yyvsp[0].node)); }
+#line 2297 "parser.c"
+    break;
+
+  case 90: /* expr: expr tAND expr  */
+#line 331 "parser.y"
+                   { (yyval.node) = pd_ast_binary_op_create(ARENA, (yylsp[-2]).first_line, PD_BIN_AND, (yyvsp[-2].node), (yyvsp[0].node)); }
+#line 2303 "parser.c"
+    break;
+
+  case 91: /* expr: expr tOR expr  */
+#line 333 "parser.y"
+                  { (yyval.node) = pd_ast_binary_op_create(ARENA, (yylsp[-2]).first_line, PD_BIN_OR, (yyvsp[-2].node), (yyvsp[0].node)); }
+#line 2309 "parser.c"
+    break;
+
+  case 92: /* expr: tBNOT expr  */
+#line 335 "parser.y"
+                           { (yyval.node) = pd_ast_unary_op_create(ARENA, (yylsp[-1]).first_line, PD_UNARY_BNOT, (yyvsp[0].node)); }
+#line 2315 "parser.c"
+    break;
+
+  case 93: /* expr: tMINUS expr  */
+#line 337 "parser.y"
+                            { (yyval.node) = pd_ast_unary_op_create(ARENA, (yylsp[-1]).first_line, PD_UNARY_MINUS, (yyvsp[0].node)); /* pd_ast_binary_op_create(ARENA, @1.first_line, PD_BIN_MINUS, pd_ast_number_create(ARENA, @1.first_line, 0), $2); */ }
+#line 2321 "parser.c"
+    break;
+
+  case 94: /* expr: tNOT expr  */
+#line 339 "parser.y"
+                          { (yyval.node) = pd_ast_unary_op_create(ARENA, (yylsp[-1]).first_line, PD_UNARY_NOT, (yyvsp[0].node)); }
+#line 2327 "parser.c"
+    break;
+
+  case 95: /* expr: tAWAIT expr  */
+#line 341 "parser.y"
+                            { (yyval.node) = pd_ast_unary_op_create(ARENA, (yylsp[-1]).first_line, PD_UNARY_AWAIT, (yyvsp[0].node)); }
+#line 2333 "parser.c"
+    break;
+
+  case 96: /* expr: tDELETE expr  */
+#line 343 "parser.y"
+                             {
+      /* Parsing delete dict[key] directly would conflict with the index rule, so accept any expression and check here. */
+      if((yyvsp[0].node)->type != PD_AST_INDEX || (yyvsp[0].node)->index.value != NULL) {
+        yyerror(&(yylsp[-1]), lexer, ast, "delete expects an index expression like delete dict[key]");
+        YYERROR;
+      }
+      (yyvsp[0].node)->type = PD_AST_DELETE;
+      (yyval.node) = (yyvsp[0].node);
+    }
+#line 2347 "parser.c"
+    break;
+
+
+#line 2351 "parser.c"
 
       default: break;
     }
@@ -1932,11 +2362,10 @@ yyreduce:
      case of YYERROR or YYBACKUP, subsequent parser actions might lead
      to an incorrect destructor call or verbose syntax error message
      before the lookahead is translated.  */
-  YY_SYMBOL_PRINT ("-> $$ =", yyr1[yyn], &yyval, &yyloc);
+  YY_SYMBOL_PRINT ("-> $$ =", YY_CAST (yysymbol_kind_t, yyr1[yyn]), &yyval, &yyloc);
 
   YYPOPSTACK (yylen);
   yylen = 0;
-  YY_STACK_PRINT (yyss, yyssp);
 
   *++yyvsp = yyval;
   *++yylsp = yyloc;
@@ -1961,50 +2390,45 @@ yyreduce:
 yyerrlab:
   /* Make sure we have latest lookahead translation.  See comments at
      user semantic actions for why this is necessary.  */
-  yytoken = yychar == YYEMPTY ? YYEMPTY : YYTRANSLATE (yychar);
-
+  yytoken = yychar == YYEMPTY ? YYSYMBOL_YYEMPTY : YYTRANSLATE (yychar);
   /* If not already recovering from an error, report this error.  */
   if (!yyerrstatus)
     {
       ++yynerrs;
-#if ! YYERROR_VERBOSE
-      yyerror (&yylloc, scanner, ast, YY_("syntax error"));
-#else
-# define YYSYNTAX_ERROR yysyntax_error (&yymsg_alloc, &yymsg, \
-                                        yyssp, yytoken)
       {
+        yypcontext_t yyctx
+          = {yyssp, yytoken, &yylloc};
         char const *yymsgp = YY_("syntax error");
         int yysyntax_error_status;
-        yysyntax_error_status = YYSYNTAX_ERROR;
+        yysyntax_error_status = yysyntax_error (&yymsg_alloc, &yymsg, &yyctx);
         if (yysyntax_error_status == 0)
           yymsgp = yymsg;
-        else if (yysyntax_error_status == 1)
+        else if (yysyntax_error_status == -1)
           {
             if (yymsg != yymsgbuf)
               YYSTACK_FREE (yymsg);
-            yymsg = (char *) YYSTACK_ALLOC (yymsg_alloc);
-            if (!yymsg)
+            yymsg = YY_CAST (char *,
+                             YYSTACK_ALLOC (YY_CAST (YYSIZE_T, yymsg_alloc)));
+            if (yymsg)
               {
-                yymsg = yymsgbuf;
-                yymsg_alloc = sizeof yymsgbuf;
-                yysyntax_error_status = 2;
+                yysyntax_error_status
+                  = yysyntax_error (&yymsg_alloc, &yymsg, &yyctx);
+                yymsgp = yymsg;
               }
             else
               {
-                yysyntax_error_status = YYSYNTAX_ERROR;
-                yymsgp = yymsg;
+                yymsg = yymsgbuf;
+                yymsg_alloc = sizeof yymsgbuf;
+                yysyntax_error_status = YYENOMEM;
               }
           }
-        yyerror (&yylloc, scanner, ast, yymsgp);
-        if (yysyntax_error_status == 2)
-          goto yyexhaustedlab;
+        yyerror (&yylloc, lexer, ast, yymsgp);
+        if (yysyntax_error_status == YYENOMEM)
+          YYNOMEM;
       }
-# undef YYSYNTAX_ERROR
-#endif
     }
 
   yyerror_range[1] = yylloc;
-
   if (yyerrstatus == 3)
     {
       /* If just tried and failed to reuse lookahead token after an
@@ -2019,7 +2443,7 @@ yyerrlab:
       else
         {
           yydestruct ("Error: discarding",
-                      yytoken, &yylval, &yylloc, scanner, ast);
+                      yytoken, &yylval, &yylloc, lexer, ast);
           yychar = YYEMPTY;
         }
     }
@@ -2037,6 +2461,7 @@ yyerrorlab:
      label yyerrorlab therefore never appears in user code.  */
   if (0)
     YYERROR;
+  ++yynerrs;
 
   /* Do not reclaim the symbols of the rule whose action triggered
      this YYERROR.  */
@@ -2053,13 +2478,14 @@ yyerrorlab:
 yyerrlab1:
   yyerrstatus = 3;      /* Each real token shifted decrements this.  */
 
+  /* Pop stack until we find a state that shifts the error token.  */
   for (;;)
     {
       yyn = yypact[yystate];
       if (!yypact_value_is_default (yyn))
         {
-          yyn += YYTERROR;
-          if (0 <= yyn && yyn <= YYLAST && yycheck[yyn] == YYTERROR)
+          yyn += YYSYMBOL_YYerror;
+          if (0 <= yyn && yyn <= YYLAST && yycheck[yyn] == YYSYMBOL_YYerror)
             {
               yyn = yytable[yyn];
               if (0 < yyn)
@@ -2073,7 +2499,7 @@ yyerrlab1:
 
       yyerror_range[1] = *yylsp;
       yydestruct ("Error: popping",
-                  yystos[yystate], yyvsp, yylsp, scanner, ast);
+                  YY_ACCESSING_SYMBOL (yystate), yyvsp, yylsp, lexer, ast);
       YYPOPSTACK (1);
       yystate = *yyssp;
       YY_STACK_PRINT (yyss, yyssp);
@@ -2084,13 +2510,11 @@ yyerrlab1:
   YY_IGNORE_MAYBE_UNINITIALIZED_END
 
   yyerror_range[2] = yylloc;
-  /* Using YYLLOC is tempting, but would change the location of
-     the lookahead.  YYLOC is available though.  */
-  YYLLOC_DEFAULT (yyloc, yyerror_range, 2);
-  *++yylsp = yyloc;
+  ++yylsp;
+  YYLLOC_DEFAULT (*yylsp, yyerror_range, 2);
 
   /* Shift the error token.  */
-  YY_SYMBOL_PRINT ("Shifting", yystos[yyn], yyvsp, yylsp);
+  YY_SYMBOL_PRINT ("Shifting", YY_ACCESSING_SYMBOL (yyn), yyvsp, yylsp);
 
   yystate = yyn;
   goto yynewstate;
@@ -2101,7 +2525,7 @@ yyerrlab1:
 `-------------------------------------*/
 yyacceptlab:
   yyresult = 0;
-  goto yyreturn;
+  goto yyreturnlab;
 
 
 /*-----------------------------------.
@@ -2109,31 +2533,29 @@ yyacceptlab:
 `-----------------------------------*/
 yyabortlab:
   yyresult = 1;
-  goto yyreturn;
+  goto yyreturnlab;
 
 
-#if !defined yyoverflow || YYERROR_VERBOSE
-/*-------------------------------------------------.
-| yyexhaustedlab -- memory exhaustion comes here.  |
-`-------------------------------------------------*/
+/*-----------------------------------------------------------.
+| yyexhaustedlab -- YYNOMEM (memory exhaustion) comes here.  |
+`-----------------------------------------------------------*/
 yyexhaustedlab:
-  yyerror (&yylloc, scanner, ast, YY_("memory exhausted"));
+  yyerror (&yylloc, lexer, ast, YY_("memory exhausted"));
   yyresult = 2;
-  /* Fall through.  */
-#endif
+  goto yyreturnlab;
 
 
-/*-----------------------------------------------------.
-| yyreturn -- parsing is finished, return the result.  |
-`-----------------------------------------------------*/
-yyreturn:
+/*----------------------------------------------------------.
+| yyreturnlab -- parsing is finished, clean up and return.  |
+`----------------------------------------------------------*/
+yyreturnlab:
   if (yychar != YYEMPTY)
     {
       /* Make sure we have latest lookahead translation.  See comments at
          user semantic actions for why this is necessary.  */
       yytoken = YYTRANSLATE (yychar);
       yydestruct ("Cleanup: discarding lookahead",
-                  yytoken, &yylval, &yylloc, scanner, ast);
+                  yytoken, &yylval, &yylloc, lexer, ast);
     }
   /* Do not reclaim the symbols of the rule whose action triggered
      this YYABORT or YYACCEPT.  */
@@ -2142,29 +2564,27 @@ yyreturn:
   while (yyssp != yyss)
     {
       yydestruct ("Cleanup: popping",
-                  yystos[*yyssp], yyvsp, yylsp, scanner, ast);
+                  YY_ACCESSING_SYMBOL (+*yyssp), yyvsp, yylsp, lexer, ast);
       YYPOPSTACK (1);
     }
 #ifndef yyoverflow
   if (yyss != yyssa)
     YYSTACK_FREE (yyss);
 #endif
-#if YYERROR_VERBOSE
   if (yymsg != yymsgbuf)
     YYSTACK_FREE (yymsg);
-#endif
   return yyresult;
 }
-#line 268 "parser.y"
+
+#line 354 "parser.y"
 
 
 // TODO improve error handling, find out how to point the locations etc.
-int yyerror(YYLTYPE* yylloc, void* scanner, pd_ast_node* ast, const char* msg) {
+int yyerror(YYLTYPE* yylloc, struct pd_lexer* lexer, pd_ast_node* ast, const char* msg) {
   // Supress warnings
   (void)ast;
-  (void)scanner;
+  (void)lexer;
 
-  // fprintf(stderr, "ParseError: (line: %d) %s\n", yyget_lineno(scanner), msg);
   // fprintf(stderr, "ParseError: (line %d) %s\n", yylloc->first_line, msg);
   fprintf(stderr, "[line %d] Error: %s\n", yylloc->first_line, msg);
   return 0;
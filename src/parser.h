@@ -1,8 +1,8 @@
-/* A Bison parser, made by GNU Bison 3.4.2.  */
+/* A Bison parser, made by GNU Bison 3.8.2.  */
 
 /* Bison interface for Yacc-like parsers in C
 
-   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2019 Free Software Foundation,
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
    Inc.
 
    This program is free software: you can redistribute it and/or modify
@@ -16,7 +16,7 @@
    GNU General Public License for more details.
 
    You should have received a copy of the GNU General Public License
-   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
 
 /* As a special exception, you may create a larger work that contains
    part or all of the Bison parser skeleton and distribute that work
@@ -31,8 +31,9 @@
    This special exception was added by the Free Software Foundation in
    version 2.2 of Bison.  */
 
-/* Undocumented macros, especially those whose name start with YY_,
-   are private implementation details.  Do not rely on them.  */
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
 
 #ifndef YY_YY_PARSER_H_INCLUDED
 # define YY_YY_PARSER_H_INCLUDED
@@ -44,86 +45,105 @@
 extern int yydebug;
 #endif
 /* "%code requires" blocks.  */
-#line 16 "parser.y"
+#line 19 "parser.y"
 
 #include "ast.h"
+struct pd_lexer;
 
-#line 52 "parser.h"
+#line 54 "parser.h"
 
-/* Token type.  */
+/* Token kinds.  */
 #ifndef YYTOKENTYPE
 # define YYTOKENTYPE
   enum yytokentype
   {
-    tIDENT = 258,
-    tSTRING = 259,
-    tNUMBER = 260,
-    tTRUE = 261,
-    tFALSE = 262,
-    tNULL = 263,
-    tGT = 264,
-    tGE = 265,
-    tLT = 266,
-    tLE = 267,
-    tPLUS = 268,
-    tMINUS = 269,
-    tSLASH = 270,
-    tSTAR = 271,
-    tEQ = 272,
-    tEQEQ = 273,
-    tNOT = 274,
-    tNEQ = 275,
-    tAND = 276,
-    tOR = 277,
-    tQU = 278,
-    tSHR = 279,
-    tSHL = 280,
-    tBOR = 281,
-    tBAND = 282,
-    tBNOT = 283,
-    tXOR = 284,
-    tCOLON = 285,
-    tDOT = 286,
-    tFUNCTION = 287,
-    tWHILE = 288,
-    tEND = 289,
-    tFILE = 290,
-    tMACRO = 291,
-    tRETURN = 292,
-    tIF = 293,
-    tELSE = 294,
-    tDO = 295,
-    tCLASS = 296,
-    tSTATIC = 297,
-    tIMPORT = 298,
-    tLPAREN = 299,
-    tRPAREN = 300,
-    tLBRACE = 301,
-    tRBRACE = 302,
-    tCOMMA = 303,
-    tSEMI = 304,
-    UNARY = 305
+    YYEMPTY = -2,
+    YYEOF = 0,                     /* "end of file"  */
+    YYerror = 256,                 /* error  */
+    YYUNDEF = 257,                 /* "invalid token"  */
+    tIDENT = 258,                  /* tIDENT  */
+    tSTRING = 259,                 /* tSTRING  */
+    tNUMBER = 260,                 /* tNUMBER  */
+    tTRUE = 261,                   /* tTRUE  */
+    tFALSE = 262,                  /* tFALSE  */
+    tNULL = 263,                   /* tNULL  */
+    tGT = 264,                     /* tGT  */
+    tGE = 265,                     /* tGE  */
+    tLT = 266,                     /* tLT  */
+    tLE = 267,                     /* tLE  */
+    tPLUS = 268,                   /* tPLUS  */
+    tMINUS = 269,                  /* tMINUS  */
+    tSLASH = 270,                  /* tSLASH  */
+    tSTAR = 271,                   /* tSTAR  */
+    tEQ = 272,                     /* tEQ  */
+    tEQEQ = 273,                   /* tEQEQ  */
+    tNOT = 274,                    /* tNOT  */
+    tNEQ = 275,                    /* tNEQ  */
+    tAND = 276,                    /* tAND  */
+    tOR = 277,                     /* tOR  */
+    tQU = 278,                     /* tQU  */
+    tSHR = 279,                    /* tSHR  */
+    tSHL = 280,                    /* tSHL  */
+    tBOR = 281,                    /* tBOR  */
+    tBAND = 282,                   /* tBAND  */
+    tBNOT = 283,                   /* tBNOT  */
+    tXOR = 284,                    /* tXOR  */
+    tCOLON = 285,                  /* tCOLON  */
+    tDOT = 286,                    /* tDOT  */
+    tDOTDOT = 287,                 /* tDOTDOT  */
+    tFUNCTION = 288,               /* tFUNCTION  */
+    tWHILE = 289,                  /* tWHILE  */
+    tEND = 290,                    /* tEND  */
+    tFILE = 291,                   /* tFILE  */
+    tMACRO = 292,                  /* tMACRO  */
+    tRETURN = 293,                 /* tRETURN  */
+    tIF = 294,                     /* tIF  */
+    tELSE = 295,                   /* tELSE  */
+    tDO = 296,                     /* tDO  */
+    tCLASS = 297,                  /* tCLASS  */
+    tSTATIC = 298,                 /* tSTATIC  */
+    tIMPORT = 299,                 /* tIMPORT  */
+    tDELETE = 300,                 /* tDELETE  */
+    tFOR = 301,                    /* tFOR  */
+    tIN = 302,                     /* tIN  */
+    tASYNC = 303,                  /* tASYNC  */
+    tAWAIT = 304,                  /* tAWAIT  */
+    tLPAREN = 305,                 /* tLPAREN  */
+    tRPAREN = 306,                 /* tRPAREN  */
+    tLBRACE = 307,                 /* tLBRACE  */
+    tRBRACE = 308,                 /* tRBRACE  */
+    tLBRACKET = 309,               /* tLBRACKET  */
+    tRBRACKET = 310,               /* tRBRACKET  */
+    tCOMMA = 311,                  /* tCOMMA  */
+    tSEMI = 312,                   /* tSEMI  */
+    UNARY = 313                    /* UNARY  */
   };
+  typedef enum yytokentype yytoken_kind_t;
 #endif
 
 /* Value type.  */
 #if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
 union YYSTYPE
 {
-#line 40 "parser.y"
+#line 46 "parser.y"
 
-  char* str;
+  pd_ast_text str;
   double num;
   pd_ast_node* node;
   struct {
     int count;
     union {
-      char** args;
+      pd_ast_text* args;
       pd_ast_node** call;
     };
   } fnargs;
+  struct {
+    int count;
+    pd_ast_node** keys;
+    pd_ast_node** values;
+  } pairs;
 
-#line 127 "parser.h"
+#line 147 "parser.h"
 
 };
 typedef union YYSTYPE YYSTYPE;
@@ -147,12 +167,14 @@ struct YYLTYPE
 
 
 
-int yyparse (void* scanner, pd_ast_node* ast);
+
+int yyparse (struct pd_lexer* lexer, pd_ast_node* ast);
+
 /* "%code provides" blocks.  */
-#line 19 "parser.y"
+#line 23 "parser.y"
 
-int yyerror(YYLTYPE* yylloc, void* scanner, pd_ast_node* ast, const char* msg);
+int yyerror(YYLTYPE* yylloc, struct pd_lexer* lexer, pd_ast_node* ast, const char* msg);
 
-#line 157 "parser.h"
+#line 179 "parser.h"
 
 #endif /* !YY_YY_PARSER_H_INCLUDED  */
@@ -11,13 +11,17 @@
 #include "parser.h"
 #include "lexer.h"
 #include "ast.h"
+
+// Nodes and token text all go in the arena of the parse, the lexer carries it.
+#define ARENA (lexer->arena)
 %}
 
 %code requires {
 #include "ast.h"
+struct pd_lexer;
 }
 %code provides {
-int yyerror(YYLTYPE* yylloc, void* scanner, pd_ast_node* ast, const char* msg);
+int yyerror(YYLTYPE* yylloc, struct pd_lexer* lexer, pd_ast_node* ast, const char* msg);
 }
 
 /* Output target */
@@ -27,27 +31,34 @@ int yyerror(YYLTYPE* yylloc, void* scanner, pd_ast_node* ast, const char* msg);
 %expect 0
 /* Tell bison we want a Reentrant/Thread-Safe parser */
 %define api.pure
+/* Verbose syntax errors, newer bison ignores YYERROR_VERBOSE. */
+%define parse.error verbose
 /* Debugging and verbose output file. */
 %debug
 %verbose
 /* Params for the lexer/parser */
-%lex-param {void* scanner}
-%parse-param {void* scanner}
+%lex-param {struct pd_lexer* lexer}
+%parse-param {struct pd_lexer* lexer}
 /* This argument is a pointer to write out the final ast to. */
 %parse-param {pd_ast_node* ast}
 %locations
 
 %union {
-  char* str;
+  pd_ast_text str;
   double num;
   pd_ast_node* node;
   struct {
     int count;
     union {
-      char** args;
+      pd_ast_text* args;
       pd_ast_node** call;
     };
   } fnargs;
+  struct {
+    int count;
+    pd_ast_node** keys;
+    pd_ast_node** values;
+  } pairs;
 }
 
 /* Literals */
@@ -56,14 +67,14 @@ int yyerror(YYLTYPE* yylloc, void* scanner, pd_ast_node* ast, const char* msg);
 %token tTRUE tFALSE tNULL
 /* Operators */
 %token tGT tGE tLT tLE tPLUS tMINUS tSLASH tSTAR tEQ tEQEQ tNOT tNEQ tAND tOR tQU tSHR tSHL tBOR tBAND tBNOT tXOR
-%token tCOLON tDOT
+%token tCOLON tDOT tDOTDOT
 /* Keywords */
-%token tFUNCTION tWHILE tEND tFILE tMACRO tRETURN tIF tELSE tDO tCLASS tSTATIC tIMPORT
+%token tFUNCTION tWHILE tEND tFILE tMACRO tRETURN tIF tELSE tDO tCLASS tSTATIC tIMPORT tDELETE tFOR tIN tASYNC tAWAIT
 /* Symbols */
-%token tLPAREN tRPAREN tLBRACE tRBRACE tCOMMA tSEMI
+%token tLPAREN tRPAREN tLBRACE tRBRACE tLBRACKET tRBRACKET tCOMMA tSEMI
 
 /* Operator precedence */
-%precedence tIDENT
+%precedence tIDENT tRBRACKET
 /*%precedence tLPAREN*/
 %right tEQ
 %left tQU tCOLON
@@ -71,26 +82,28 @@ int yyerror(YYLTYPE* yylloc, void* scanner, pd_ast_node* ast, const char* msg);
 %left tPLUS tMINUS
 %left tSTAR tSLASH
 %precedence UNARY
+%precedence tLBRACKET tDOT
 
 /* Types of each non-terminal */
 %type <node> expr number ternary stmt stmts func proto ident bool string return_expr import_stmt class_stmt
-%type <node> cond call file assign do_block while_loop
+%type <node> cond call file assign do_block while_loop for_loop for_step array index dict
 %type <fnargs> fnargs args
+%type <pairs> pairs
 
 /* Start symbol */
 %start program
 
 %%
 
-program: /* empty */ { *ast = *pd_ast_empty_create(); }
+program: /* empty */ { *ast = *pd_ast_empty_create(ARENA); }
        |
        stmts { *ast = *$1; }
        ;
 
 stmts:
-     stmt tSEMI { $$ = pd_ast_block_create($1); }
+     stmt tSEMI { $$ = pd_ast_block_create(ARENA, $1); }
      |
-     stmts stmt tSEMI { $$ = pd_ast_block_append($1, $2); }
+     stmts stmt tSEMI { $$ = pd_ast_block_append(ARENA, $1, $2); }
      ;
 
 stmt:
@@ -106,12 +119,15 @@ stmt:
     |
     while_loop
     |
+    for_loop
+    |
     import_stmt
     |
     class_stmt
     ;
 
-import_stmt: tIMPORT tIDENT { $$ = pd_ast_empty_create(); } /* TODO */
+/* Only builtin modules for now, import net is net = <the module> */
+import_stmt: tIMPORT tIDENT { $$ = pd_ast_assign_create(ARENA, @1.first_line, $2, pd_ast_import_create(ARENA, @1.first_line, $2)); }
            ;
 
 class_method: proto tSEMI stmts tEND /* TODO */
@@ -124,87 +140,137 @@ class_body: class_method tSEMI /* TODO */
           class_body class_method tSEMI /* TODO */
           ;
 
-class_stmt: tCLASS tIDENT tSEMI /* empty */ tEND { $$ = pd_ast_class_create(@1.first_line, $2); free($2); }
+class_stmt: tCLASS tIDENT tSEMI /* empty */ tEND { $$ = pd_ast_class_create(ARENA, @1.first_line, $2); }
           |
-          tCLASS tIDENT tSEMI class_body tEND { $$ = pd_ast_empty_create(); } /* TODO */
+          tCLASS tIDENT tSEMI class_body tEND { $$ = pd_ast_empty_create(ARENA); } /* TODO */
           ;
 
 do_block: tDO stmts tEND { $$ = $2; }
         ;
 
 while_loop:
-          tWHILE expr tSEMI stmts tEND { $$ = pd_ast_while_create(@1.first_line, $2, $4); }
+          tWHILE expr tSEMI stmts tEND { $$ = pd_ast_while_create(ARENA, @1.first_line, $2, $4); }
           |
-          tWHILE expr tSEMI tEND { $$ = pd_ast_while_create(@1.first_line, $2, NULL); }
+          tWHILE expr tSEMI tEND { $$ = pd_ast_while_create(ARENA, @1.first_line, $2, NULL); }
           ;
 
+/* The range is inclusive like Lua's numeric for, e.g for i in 10..1, -1 counts down. */
+for_loop:
+        tFOR tIDENT tIN expr tDOTDOT expr for_step tSEMI stmts tEND { $$ = pd_ast_for_create(ARENA, @1.first_line, $2, $4, $6, $7, $9); }
+        |
+        tFOR tIDENT tIN expr tDOTDOT expr for_step tSEMI tEND { $$ = pd_ast_for_create(ARENA, @1.first_line, $2, $4, $6, $7, NULL); }
+        ;
+
+for_step: /* empty */ { $$ = NULL; }
+        |
+        tCOMMA expr { $$ = $2; }
+        ;
+
 func:
-    tFUNCTION proto tSEMI stmts tEND { $$ = pd_ast_function_create(@1.first_line, $2, $4); }
+    tFUNCTION proto tSEMI stmts tEND { $$ = pd_ast_function_create(ARENA, @1.first_line, $2, $4); }
     |
-    tFUNCTION proto tSEMI tEND { $$ = pd_ast_function_create(@1.first_line, $2, NULL); }
+    tFUNCTION proto tSEMI tEND { $$ = pd_ast_function_create(ARENA, @1.first_line, $2, NULL); }
+    |
+    tASYNC tFUNCTION proto tSEMI stmts tEND { $$ = pd_ast_function_create(ARENA, @1.first_line, $3, $5); $$->function.async = true; }
+    |
+    tASYNC tFUNCTION proto tSEMI tEND { $$ = pd_ast_function_create(ARENA, @1.first_line, $3, NULL); $$->function.async = true; }
     ;
 
 proto:
-     tIDENT tLPAREN fnargs tRPAREN {
-       $$ = pd_ast_prototype_create(@1.first_line, $1, $3.args, $3.count);
-       free($1);
-       for(int x = 0; x < $3.count; x++) free($3.args[x]);
-     }
+     tIDENT tLPAREN fnargs tRPAREN { $$ = pd_ast_prototype_create(ARENA, @1.first_line, $1, $3.args, $3.count); }
      ;
 
 fnargs: /* empty */ { $$.count = 0; $$.args = NULL; }
       |
-      tIDENT { $$.count = 1; $$.args = malloc(sizeof(char*)); $$.args[0] = strdup($1); }
-      | fnargs tCOMMA tIDENT { $1.count++; $1.args = realloc($1.args, sizeof(char*) * $1.count); $1.args[$1.count-1] = strdup($3); $$ = $1; }
+      tIDENT { $$.count = 1; $$.args = pd_arena_append(ARENA, NULL, 0, sizeof(pd_ast_text)); $$.args[0] = $1; }
+      | fnargs tCOMMA tIDENT { $1.args = pd_arena_append(ARENA, $1.args, $1.count, sizeof(pd_ast_text)); $1.args[$1.count++] = $3; $$ = $1; }
       ;
 
 args: /* empty */ { $$.count = 0; $$.call = NULL; }
     |
-    expr { $$.count = 1; $$.call = malloc(sizeof(pd_ast_node*)); $$.call[0] = $1; }
+    expr { $$.count = 1; $$.call = pd_arena_append(ARENA, NULL, 0, sizeof(pd_ast_node*)); $$.call[0] = $1; }
     |
-    args tCOMMA expr { $1.count++; $1.call = realloc($1.call, sizeof(pd_ast_node*) * $1.count); $1.call[$1.count - 1] = $3; $$ = $1; }
+    args tCOMMA expr { $1.call = pd_arena_append(ARENA, $1.call, $1.count, sizeof(pd_ast_node*)); $1.call[$1.count++] = $3; $$ = $1; }
     ;
 
-number: tNUMBER { $$ = pd_ast_number_create(@1.first_line, $1); }
+number: tNUMBER { $$ = pd_ast_number_create(ARENA, @1.first_line, $1); }
       ;
 
-bool: tTRUE { $$ = pd_ast_boolean_create(@1.first_line, true); }
-    | tFALSE { $$ = pd_ast_boolean_create(@1.first_line, false); }
+bool: tTRUE { $$ = pd_ast_boolean_create(ARENA, @1.first_line, true); }
+    | tFALSE { $$ = pd_ast_boolean_create(ARENA, @1.first_line, false); }
     ;
 
 return_expr:
-           tRETURN { $$ = pd_ast_return_create(@1.first_line, NULL); }
+           tRETURN { $$ = pd_ast_return_create(ARENA, @1.first_line, NULL); }
            |
-           tRETURN expr { $$ = pd_ast_return_create(@1.first_line, $2); }
+           tRETURN expr { $$ = pd_ast_return_create(ARENA, @1.first_line, $2); }
            ;
 
-string: tSTRING { $$ = pd_ast_string_create(@1.first_line, $1); }
+string: tSTRING { $$ = pd_ast_string_create(ARENA, @1.first_line, $1); }
       ;
 
 ternary:
-       expr tQU expr tCOLON expr { $$ = pd_ast_ternary_create(@1.first_line, $1, $3, $5); }
+       expr tQU expr tCOLON expr { $$ = pd_ast_ternary_create(ARENA, @1.first_line, $1, $3, $5); }
        ;
 
-ident: tIDENT { $$ = pd_ast_variable_create(@1.first_line, $1); }
+ident: tIDENT { $$ = pd_ast_variable_create(ARENA, @1.first_line, $1); }
      |
      file
      ;
 
-file: tFILE { $$ = pd_ast_file_create(@1.first_line); }
+file: tFILE { $$ = pd_ast_file_create(ARENA, @1.first_line); }
 
 call:
-    tIDENT tLPAREN args tRPAREN { $$ = pd_ast_call_create(@1.first_line, $1, $3.call, $3.count); free($1); free($3.call); }
+    tIDENT tLPAREN args tRPAREN { $$ = pd_ast_call_create(ARENA, @1.first_line, $1, $3.call, $3.count); }
+    |
+    expr tDOT tIDENT tLPAREN args tRPAREN {
+      $$ = pd_ast_call_create(ARENA, @1.first_line, $3, $5.call, $5.count);
+      $$->call.callee = pd_ast_property_create(ARENA, @1.first_line, $1, $3);
+    }
     ;
 
 cond:
-    tIF expr tSEMI stmts tEND { $$ = pd_ast_conditional_create(@1.first_line, $2, $4, NULL); }
+    tIF expr tSEMI stmts tEND { $$ = pd_ast_conditional_create(ARENA, @1.first_line, $2, $4, NULL); }
     |
-    tIF expr tSEMI stmts tELSE stmts tEND { $$ = pd_ast_conditional_create(@1.first_line, $2, $4, $6); }
+    tIF expr tSEMI stmts tELSE stmts tEND { $$ = pd_ast_conditional_create(ARENA, @1.first_line, $2, $4, $6); }
     ;
 
-assign: tIDENT tEQ expr { $$ = pd_ast_assign_create(@1.first_line, $1, $3); }
+assign: tIDENT tEQ expr { $$ = pd_ast_assign_create(ARENA, @1.first_line, $1, $3); }
       ;
 
+array: tLBRACKET args tRBRACKET { $$ = pd_ast_array_create(ARENA, @1.first_line, $2.call, $2.count); }
+     ;
+
+dict: tLBRACE pairs tRBRACE { $$ = pd_ast_dict_create(ARENA, @1.first_line, $2.keys, $2.values, $2.count); }
+    ;
+
+pairs: /* empty */ { $$.count = 0; $$.keys = NULL; $$.values = NULL; }
+     |
+     expr tCOLON expr {
+       $$.count = 1;
+       $$.keys = pd_arena_append(ARENA, NULL, 0, sizeof(pd_ast_node*));
+       $$.values = pd_arena_append(ARENA, NULL, 0, sizeof(pd_ast_node*));
+       $$.keys[0] = $1;
+       $$.values[0] = $3;
+     }
+     |
+     pairs tCOMMA expr tCOLON expr {
+       $1.keys = pd_arena_append(ARENA, $1.keys, $1.count, sizeof(pd_ast_node*));
+       $1.values = pd_arena_append(ARENA, $1.values, $1.count, sizeof(pd_ast_node*));
+       $1.keys[$1.count] = $3;
+       $1.values[$1.count] = $5;
+       $1.count++;
+       $$ = $1;
+     }
+     ;
+
+/* tRBRACKET has a lower precedence than tEQ so x[i] = y shifts into an assignment instead of reducing x[i] first. */
+index:
+     expr tLBRACKET expr tRBRACKET { $$ = pd_ast_index_create(ARENA, @1.first_line, $1, $3, NULL); }
+     |
+     expr tLBRACKET expr tRBRACKET tEQ expr { $$ = pd_ast_index_create(ARENA, @1.first_line, $1, $3, $6); }
+     ;
+
 expr:
     number
     |
@@ -212,7 +278,7 @@ expr:
     |
     bool
     |
-    tNULL { $$ = pd_ast_null_create(@1.first_line); }
+    tNULL { $$ = pd_ast_null_create(ARENA, @1.first_line); }
     |
     assign
     |
@@ -222,58 +288,77 @@ expr:
     |
     call
     |
+    array
+    |
+    dict
+    |
+    index
+    |
+    expr tDOT tIDENT %prec tIDENT { $$ = pd_ast_property_create(ARENA, @1.first_line, $1, $3); }
+    |
     tLPAREN expr tRPAREN { $$ = $2; }
     |
-    expr tPLUS expr { $$ = pd_ast_binary_op_create(@1.first_line, PD_BIN_PLUS, $1, $3); }
+    expr tPLUS expr { $$ = pd_ast_binary_op_create(ARENA, @1.first_line, PD_BIN_PLUS, $1, $3); }
+    |
+    expr tMINUS expr { $$ = pd_ast_binary_op_create(ARENA, @1.first_line, PD_BIN_MINUS, $1, $3); }
+    |
+    expr tSLASH expr { $$ = pd_ast_binary_op_create(ARENA, @1.first_line, PD_BIN_DIV, $1, $3); }
     |
-    expr tMINUS expr { $$ = pd_ast_binary_op_create(@1.first_line, PD_BIN_MINUS, $1, $3); }
+    expr tSTAR expr { $$ = pd_ast_binary_op_create(ARENA, @1.first_line, PD_BIN_MUL, $1, $3); }
     |
-    expr tSLASH expr { $$ = pd_ast_binary_op_create(@1.first_line, PD_BIN_DIV, $1, $3); }
+    expr tGT expr { $$ = pd_ast_binary_op_create(ARENA, @1.first_line, PD_BIN_GT, $1, $3); }
     |
-    expr tSTAR expr { $$ = pd_ast_binary_op_create(@1.first_line, PD_BIN_MUL, $1, $3); }
+    expr tGE expr { $$ = pd_ast_binary_op_create(ARENA, @1.first_line, PD_BIN_GE, $1, $3); }
     |
-    expr tGT expr { $$ = pd_ast_binary_op_create(@1.first_line, PD_BIN_GT, $1, $3); }
+    expr tLT expr { $$ = pd_ast_binary_op_create(ARENA, @1.first_line, PD_BIN_LT, $1, $3); }
     |
-    expr tGE expr { $$ = pd_ast_binary_op_create(@1.first_line, PD_BIN_GE, $1, $3); }
+    expr tLE expr { $$ = pd_ast_binary_op_create(ARENA, @1.first_line, PD_BIN_LE, $1, $3); }
     |
-    expr tLT expr { $$ = pd_ast_binary_op_create(@1.first_line, PD_BIN_LT, $1, $3); }
+    expr tSHR expr { $$ = pd_ast_binary_op_create(ARENA, @1.first_line, PD_BIN_SHR, $1, $3); }
     |
-    expr tLE expr { $$ = pd_ast_binary_op_create(@1.first_line, PD_BIN_LE, $1, $3); }
+    expr tSHL expr { $$ = pd_ast_binary_op_create(ARENA, @1.first_line, PD_BIN_SHL, $1, $3); }
     |
-    expr tSHR expr { $$ = pd_ast_binary_op_create(@1.first_line, PD_BIN_SHR, $1, $3); }
+    expr tBOR expr { $$ = pd_ast_binary_op_create(ARENA, @1.first_line, PD_BIN_BOR, $1, $3); }
     |
-    expr tSHL expr { $$ = pd_ast_binary_op_create(@1.first_line, PD_BIN_SHL, $1, $3); }
+    expr tBAND expr { $$ = pd_ast_binary_op_create(ARENA, @1.first_line, PD_BIN_BAND, $1, $3); }
     |
-    expr tBOR expr { $$ = pd_ast_binary_op_create(@1.first_line, PD_BIN_BOR, $1, $3); }
+    expr tEQEQ expr { $$ = pd_ast_binary_op_create(ARENA, @1.first_line, PD_BIN_EQ, $1, $3); }
     |
-    expr tBAND expr { $$ = pd_ast_binary_op_create(@1.first_line, PD_BIN_BAND, $1, $3); }
+    expr tXOR expr { $$ = pd_ast_binary_op_create(ARENA, @1.first_line, PD_BIN_XOR, $1, $3); }
     |
-    expr tEQEQ expr { $$ = pd_ast_binary_op_create(@1.first_line, PD_BIN_EQ, $1, $3); }
+    expr tNEQ expr { $$ = pd_ast_binary_op_create(ARENA, @1.first_line, PD_BIN_NEQ, $1, $3); }
     |
-    expr tXOR expr { $$ = pd_ast_binary_op_create(@1.first_line, PD_BIN_XOR, $1, $3); }
+    expr tAND expr { $$ = pd_ast_binary_op_create(ARENA, @1.first_line, PD_BIN_AND, $1, $3); }
     |
-    expr tNEQ expr { $$ = pd_ast_binary_op_create(@1.first_line, PD_BIN_NEQ, $1, $3); }
+    expr tOR expr { $$ = pd_ast_binary_op_create(ARENA, @1.first_line, PD_BIN_OR, $1, $3); }
     |
-    expr tAND expr { $$ = pd_ast_binary_op_create(@1.first_line, PD_BIN_AND, $1, $3); }
+    tBNOT expr %prec UNARY { $$ = pd_ast_unary_op_create(ARENA, @1.first_line, PD_UNARY_BNOT, $2); }
     |
-    expr tOR expr { $$ = pd_ast_binary_op_create(@1.first_line, PD_BIN_OR, $1, $3); }
+    tMINUS expr %prec UNARY { $$ = pd_ast_unary_op_create(ARENA, @1.first_line, PD_UNARY_MINUS, $2); /* pd_ast_binary_op_create(ARENA, @1.first_line, PD_BIN_MINUS, pd_ast_number_create(ARENA, @1.first_line, 0), $2); */ }
     |
-    tBNOT expr %prec UNARY { $$ = pd_ast_unary_op_create(@1.first_line, PD_UNARY_BNOT, $2); }
+    tNOT expr %prec UNARY { $$ = pd_ast_unary_op_create(ARENA, @1.first_line, PD_UNARY_NOT, $2); }
     |
-    tMINUS expr %prec UNARY { $$ = pd_ast_unary_op_create(@1.first_line, PD_UNARY_MINUS, $2); /* pd_ast_binary_op_create(@1.first_line, PD_BIN_MINUS, pd_ast_number_create(@1.first_line, 0), $2); */ }
+    tAWAIT expr %prec UNARY { $$ = pd_ast_unary_op_create(ARENA, @1.first_line, PD_UNARY_AWAIT, $2); }
     |
-    tNOT expr %prec UNARY { $$ = pd_ast_unary_op_create(@1.first_line, PD_UNARY_NOT, $2); }
+    tDELETE expr %prec UNARY {
+      /* Parsing delete dict[key] directly would conflict with the index rule, so accept any expression and check here. */
+      if($2->type != PD_AST_INDEX || $2->index.value != NULL) {
+        yyerror(&@1, lexer, ast, "delete expects an index expression like delete dict[key]");
+        YYERROR;
+      }
+      $2->type = PD_AST_DELETE;
+      $$ = $2;
+    }
     ;
 
 %%
 
 // TODO improve error handling, find out how to point the locations etc.
-int yyerror(YYLTYPE* yylloc, void* scanner, pd_ast_node* ast, const char* msg) {
+int yyerror(YYLTYPE* yylloc, struct pd_lexer* lexer, pd_ast_node* ast, const char* msg) {
   // Supress warnings
   (void)ast;
-  (void)scanner;
+  (void)lexer;
 
-  // fprintf(stderr, "ParseError: (line: %d) %s\n", yyget_lineno(scanner), msg);
   // fprintf(stderr, "ParseError: (line %d) %s\n", yylloc->first_line, msg);
   fprintf(stderr, "[line %d] Error: %s\n", yylloc->first_line, msg);
   return 0;
@@ -4,11 +4,46 @@
 #include "opcodes.h"
 #include "runtime.h"
 #include "gc.h"
+#include "array.h"
+#include "typed_array.h"
+#include "dict.h"
+#include "bytecode.h"
+#include "task.h"
+#include "timers.h"
 // Experimental libuv attempts.
 #include <uv.h>
 
+// Grows the stack so it has room for at least [needed] more values.
+// The stack moves so everything pointing into it is relocated, that's the frame slots, the open upvalues and the top.
+static void growStack(pvm_t* vm, int needed) {
+  int count = (int)(vm->stack_top - vm->stack);
+  int capacity = (int)(vm->stack_end - vm->stack);
+  while(capacity < count + needed) capacity *= 2;
+
+  pd_value* stack = malloc(sizeof(pd_value) * capacity);
+  pd_upvalue** open = calloc(capacity, sizeof(pd_upvalue*));
+  if(stack == NULL || open == NULL) {
+    fprintf(stderr, "Out of memory.\n");
+    exit(1);
+  }
+  memcpy(stack, vm->stack, sizeof(pd_value) * count);
+  memcpy(open, vm->open_upvalues, sizeof(pd_upvalue*) * count);
+  for(int i = 0; i < vm->frame_count; i++)
+    vm->frames[i].slots = stack + (vm->frames[i].slots - vm->stack);
+  for(int i = 0; i < count; i++)
+    if(open[i] != NULL) open[i]->location = stack + i;
+
+  free(vm->stack);
+  free(vm->open_upvalues);
+  vm->open_upvalues = open;
+  vm->stack = stack;
+  vm->stack_top = stack + count;
+  vm->stack_end = stack + capacity;
+}
+
 // Pushes a value on top of the stack.
 void pvm_push(pvm_t* vm, pd_value value) {
+  if(vm->stack_top == vm->stack_end) growStack(vm, 1);
   *vm->stack_top = value;
   vm->stack_top++;
 }
@@ -20,9 +55,18 @@ pd_value pvm_pop(pvm_t* vm) {
 }
 
 static void resetStack(pvm_t* vm) {
+  // After an error the frames are gone but closures may still see their variables, close what's left open.
+  // (the stack of a failed task is even freed)
+  for(pd_value* slot = vm->stack; slot < vm->stack_top; slot++) {
+    pd_upvalue* upvalue = vm->open_upvalues[slot - vm->stack];
+    if(upvalue == NULL) continue;
+    upvalue->closed = *slot;
+    upvalue->location = &upvalue->closed;
+    upvalue->task = NULL;
+    vm->open_upvalues[slot - vm->stack] = NULL;
+  }
   vm->stack_top = vm->stack;
   vm->frame_count = 0;
-  vm->open_upvalues = NULL;
 }
 
 // Peek into the stack without popping it.
@@ -41,15 +85,36 @@ pvm_t* pvm_new() {
   vm->compiler = NULL;
   vm->mark_bit = true;
   vm->loop = uv_default_loop();
+  vm->stack = malloc(sizeof(pd_value) * PVM_STACK_INITIAL);
+  vm->stack_end = vm->stack + PVM_STACK_INITIAL;
+  vm->stack_top = vm->stack;
+  vm->open_upvalues = calloc(PVM_STACK_INITIAL, sizeof(pd_upvalue*));
+  vm->frames = malloc(sizeof(pvm_frame) * PVM_FRAMES_INITIAL);
+  vm->frame_capacity = PVM_FRAMES_INITIAL;
   resetStack(vm);
   pd_table_init(&vm->strings);
+  pd_table_init(&vm->globals);
+  pd_value_array_init(&vm->global_values);
+  vm->mappings = NULL;
+  vm->task = NULL;
+  vm->ready = NULL;
+  vm->ready_tail = NULL;
+  vm->retained = NULL;
+  vm->timers = NULL;
   return vm;
 }
 
 void pvm_free(pvm_t* vm) {
   pd_table_free(vm, &vm->strings);
+  pd_table_free(vm, &vm->globals);
+  pd_value_array_clear(vm, &vm->global_values);
+  // This also frees the gray stack.
   pd_gc_free_objects(vm);
-  free(vm->gray_stack);
+  pd_bytecode_unmap_all(vm);
+  pd_timers_free(vm);
+  free(vm->stack);
+  free(vm->open_upvalues);
+  free(vm->frames);
   free(vm);
   // uv_loop_close(vm->loop);
 }
@@ -65,11 +130,16 @@ static void runtimeError(pvm_t* vm, const char* format, ...) {
   fputs("\n", stderr);
 
   for(int i = vm->frame_count - 1; i >= 0; i--) {
+    // Deep recursion would flood the terminal, show the innermost calls and the outermost few.
+    if(vm->frame_count > 20 && i == vm->frame_count - 11) {
+      fprintf(stderr, "  ... %d more calls\n", vm->frame_count - 20);
+      i = 9;
+    }
     pvm_frame* frame = &vm->frames[i];                            
     pd_function* function = frame->closure->function;
     // -1 because the IP is sitting on the next instruction to be executed.
     size_t instruction = frame->ip - function->chunk.code - 1;
-    fprintf(stderr, "  [line %d] in ", function->chunk.lines[instruction]);
+    fprintf(stderr, "  [line %d] in ", pvm_chunk_line(&function->chunk, (int)instruction));
     if(function->name == NULL) {
       fprintf(stderr, "script\n");
     } else {
@@ -82,47 +152,120 @@ static void runtimeError(pvm_t* vm, const char* format, ...) {
 
 void pvm_define_function(pvm_t* vm, char* name, pd_native function) {
   // GC guards
-  pvm_push(vm, PD_FROM(pd_str_new(vm, name, (int)strlen(name))));
+  pvm_push(vm, PD_FROM(pd_str_intern(vm, name, strlen(name))));
   pvm_push(vm, PD_FROM(pd_native_function_new(vm, function)));
 
   pd_value index;
-  pd_str* identifier = PD_AS_STRING(vm->stack[0]);
-  if(pd_table_get(&vm->globals, identifier, &index)) {
-    vm->global_values.data[(uint8_t)AS_DOUBLE(index)] = vm->stack[1];
+  pd_str* identifier = PD_AS_STRING(vm->stack_top[-2]);
+  // Create the global if nothing used it yet, code compiled later (lazy functions, repl lines) may still refer to it.
+  if(!pd_table_get(&vm->globals, identifier, &index)) {
+    if(vm->global_values.count > UINT16_MAX) {
+      pvm_pop(vm);
+      pvm_pop(vm);
+      return;
+    }
+    index = NUMBER_VAL((double)vm->global_values.count);
+    pd_value_array_write(vm, &vm->global_values, UNDEFINED_VALUE);
+    pd_table_set(vm, &vm->globals, identifier, index);
+  }
+  // Only fill globals that aren't set yet, a VM restored from a snapshot (or an earlier repl line) may have replaced it.
+  if(IS_UNDEFINED(vm->global_values.data[(int)AS_DOUBLE(index)])) {
+    vm->global_values.data[(int)AS_DOUBLE(index)] = vm->stack_top[-1];
   }
   
   pvm_pop(vm);
   pvm_pop(vm);
 }
 
+// Compiles a lazy function (see pd_compile_lazy()) on its first call, this is a single check for the rest.
+static bool ensureCompiled(pvm_t* vm, pd_function* function) {
+  if(function->ast == NULL && !function->failed) return true;
+  if(function->failed || !pd_compile_lazy(vm, function, false)) {
+    runtimeError(vm, "Failed to compile function '%s'.", function->name->bytes);
+    return false;
+  }
+  return true;
+}
+
+// Calls to async functions start a task instead, the callee and arguments move to a stack of its own
+// and the call gives the task. It runs once whatever is running now is done. (see pvm_run_tasks())
+static bool startTask(pvm_t* vm, pd_closure* closure, int argCount) {
+  pd_task* task = pd_task_new(vm);
+  // Room for all the locals like call() makes sure of.
+  int capacity = argCount + 1 + 256;
+  task->stack = malloc(sizeof(pd_value) * capacity);
+  task->open_upvalues = calloc(capacity, sizeof(pd_upvalue*));
+  task->frames = malloc(sizeof(pvm_frame) * PVM_FRAMES_INITIAL);
+  if(task->stack == NULL || task->open_upvalues == NULL || task->frames == NULL) {
+    fprintf(stderr, "Out of memory.\n");
+    exit(1);
+  }
+  task->stack_end = task->stack + capacity;
+  task->frame_capacity = PVM_FRAMES_INITIAL;
+
+  pd_value* args = vm->stack_top - argCount - 1;
+  memcpy(task->stack, args, sizeof(pd_value) * (argCount + 1));
+  task->stack_top = task->stack + argCount + 1;
+  pvm_frame* frame = &task->frames[task->frame_count++];
+  frame->closure = closure;
+  frame->ip = closure->function->chunk.code;
+  frame->slots = task->stack;
+  frame->open = 0;
+
+  vm->stack_top = args;
+  pvm_push(vm, PD_FROM(task));
+  pd_task_schedule(vm, task);
+  return true;
+}
+
 static bool call(pvm_t* vm, pd_closure* closure, int argCount) {
   if(argCount != closure->function->arity) {
     runtimeError(vm, "Expected %d arguments but got %d.", closure->function->arity, argCount);
     return false;
   }
+  if(!ensureCompiled(vm, closure->function)) return false;
+  if(closure->function->async) return startTask(vm, closure, argCount);
 
-  if(vm->frame_count == PVM_FRAMES_MAX) {
+  // A function can have up to 256 locals, make sure they all fit so we only grow on push for deep expressions.
+  if(vm->frame_count == PVM_FRAMES_MAX || vm->stack_top - vm->stack + 256 > PVM_STACK_MAX) {
     runtimeError(vm, "Stack overflow.");
     return false;
   }
+  if(vm->stack_end - vm->stack_top < 256) growStack(vm, 256);
+
+  if(vm->frame_count == vm->frame_capacity) {
+    // Frames are only referenced by index, except the current one cached in run() which is reloaded after calls.
+    vm->frame_capacity *= 2;
+    vm->frames = realloc(vm->frames, sizeof(pvm_frame) * vm->frame_capacity);
+    if(vm->frames == NULL) {
+      fprintf(stderr, "Out of memory.\n");
+      exit(1);
+    }
+  }
 
   pvm_frame* frame = &vm->frames[vm->frame_count++];
   frame->closure = closure;
   frame->ip = closure->function->chunk.code;
   
   frame->slots = vm->stack_top - argCount - 1;
+  frame->open = 0;
   return true;
 }
 
 bool pvm_call(pvm_t* vm, pd_value callee, int argCount) {
   if(IS_OBJECT(callee)) {
-    switch (OBJECT_TYPE(callee)) {
+    switch (OBJECT_TYPE(AS_OBJECT(callee))) {
       case PD_OBJ_CLOSURE:
         return call(vm, PD_AS_CLOSURE(callee), argCount);
       case PD_OBJ_NATIVE: {
         pd_native native = PD_AS_NATIVE(callee);
-        pd_value result = native(vm, argCount, vm->stack_top - argCount);
-        vm->stack_top -= argCount + 1;
+        // Remember where the arguments are as an offset, the stack might move if the native pushes or calls back into the VM.
+        ptrdiff_t args = vm->stack_top - argCount - vm->stack;
+        pd_value result = native(vm, argCount, vm->stack + args);
+        // The native may have called back into the VM (see pvm_call_value()) and hit a runtime error
+        // which resets the stack below the arguments, in that case the error is already reported.
+        if(vm->stack_top - vm->stack < args) return false;
+        vm->stack_top = vm->stack + args - 1;
         pvm_push(vm, result);
         return true;
       }
@@ -136,39 +279,84 @@ bool pvm_call(pvm_t* vm, pd_value callee, int argCount) {
   return false;
 }
 
-static pd_upvalue* captureUpvalue(pvm_t* vm, pd_value* local) {
-  pd_upvalue* prevUpvalue = NULL;
-  pd_upvalue* upvalue = vm->open_upvalues;
-  
-  while(upvalue != NULL && upvalue->location > local) {
-    prevUpvalue = upvalue;
-    upvalue = upvalue->next;
+// Captures the [local] of [frame], closures capturing the same local share its upvalue.
+static pd_upvalue* captureUpvalue(pvm_t* vm, pvm_frame* frame, pd_value* local) {
+  pd_upvalue* upvalue = vm->open_upvalues[local - vm->stack];
+  if(upvalue != NULL) return upvalue;
+
+  upvalue = pd_upvalue_new(vm, local);
+  upvalue->task = vm->task;
+  vm->open_upvalues[local - vm->stack] = upvalue;
+  frame->open++;
+  return upvalue;
+}
+
+// Reports why indexing failed, this is the slow path of GET_INDEX/SET_INDEX
+// so we take our time figuring out what exactly is wrong.
+// The bytes of a name constant for errors, short strings are unpacked to [bytes] which holds PD_SSTR_MAX + 1.
+static const char* nameChars(pd_value name, char* bytes, int* len) {
+  if(IS_SHORT_STRING(name)) {
+    *len = pd_sstr_read(name, bytes);
+    return bytes;
+  }
+  *len = (int)PD_STRLEN(name);
+  return PD_AS_CSTRING(name);
+}
+
+static void propertyError(pvm_t* vm, pd_value target, pd_value name) {
+  if(!IS_OBJECT(target) || !PD_IS_DICT(target)) {
+    runtimeError(vm, "Only dictionaries have properties.");
+    return;
+  }
+  char bytes[PD_SSTR_MAX + 1];
+  int len;
+  const char* chars = nameChars(name, bytes, &len);
+  runtimeError(vm, "Undefined property '%.*s'.", len, chars);
+}
+
+static void indexError(pvm_t* vm, pd_value target, pd_value index) {
+  int count;
+  if(IS_OBJECT(target) && PD_IS_ARRAY(target)) {
+    count = PD_AS_ARRAY(target)->values.count;
+  } else if(IS_OBJECT(target) && PD_IS_TYPED_ARRAY(target)) {
+    count = PD_AS_TYPED_ARRAY(target)->count;
+  } else {
+    runtimeError(vm, "Only arrays and dictionaries can be indexed.");
+    return;
   }
-  if(upvalue != NULL && upvalue->location == local) return upvalue;
 
-  pd_upvalue* createdUpvalue = pd_upvalue_new(vm, local);
-  createdUpvalue->next = upvalue;
-  if(prevUpvalue == NULL) {
-    vm->open_upvalues = createdUpvalue;
+  if(!IS_NUMBER(index)) {
+    runtimeError(vm, "Array index must be a number.");
+  } else if(AS_DOUBLE(index) > INT32_MIN && AS_DOUBLE(index) < INT32_MAX && AS_DOUBLE(index) != (double)(int)AS_DOUBLE(index)) {
+    // The range check is so the int conversion is safe, anything outside it is out of bounds anyway.
+    runtimeError(vm, "Array index must be an integer.");
   } else {
-    prevUpvalue->next = createdUpvalue;
+    runtimeError(vm, "Array index %g out of bounds. (length %d)", AS_DOUBLE(index), count);
   }
-  return createdUpvalue;
 }
 
-static void closeUpvalues(pvm_t* vm, pd_value* last) {
-  while(vm->open_upvalues != NULL && vm->open_upvalues->location >= last) {
-    pd_upvalue* upvalue = vm->open_upvalues;
-    upvalue->closed = *upvalue->location;
+// Closes the upvalues open on the slots of [frame] from [last] up.
+// Most frames never had anything captured (or only copies, see OP_GET_UPVALUE_COPY) so this is usually just the check.
+static inline void closeUpvalues(pvm_t* vm, pvm_frame* frame, pd_value* last) {
+  if(frame->open == 0) return;
+  for(pd_value* slot = last; slot < vm->stack_top; slot++) {
+    pd_upvalue* upvalue = vm->open_upvalues[slot - vm->stack];
+    if(upvalue == NULL) continue;
+    upvalue->closed = *slot;
     upvalue->location = &upvalue->closed;
-    vm->open_upvalues = upvalue->next;
+    upvalue->task = NULL;
+    vm->open_upvalues[slot - vm->stack] = NULL;
+    if(--frame->open == 0) break;
   }
 }
 
 // This is it, the core of the VM.
 // The interpreter loop, it executes all instructions
 // which means that this part is highly performance critical so we want to squeeze every bit of performance we can here.
-void pvm_run(pvm_t* vm) {
+//
+// It runs until the frame count drops back to [exitFrame] leaving the returned value on the stack.
+// Returns false if a runtime error happened, the error is reported and the VM is reset by then.
+static bool run(pvm_t* vm, int exitFrame) {
   //vm->chunk = chunk;
   //vm->ip = vm->chunk->code;
   pvm_frame* frame = &vm->frames[vm->frame_count - 1];
@@ -182,22 +370,69 @@ void pvm_run(pvm_t* vm) {
 
 #define BINARY_OP(cast, op) \
   do { \
-    if (!IS_DOUBLE(peek(vm, 0)) || !IS_DOUBLE(peek(vm, 1))) { \
+    if (!IS_NUMBER(peek(vm, 0)) || !IS_NUMBER(peek(vm, 1))) { \
       frame->ip = ip; \
       runtimeError(vm, "Operands must be numbers."); \
-      return; \
+      return false; \
     } \
     double b = AS_DOUBLE(pvm_pop(vm)); \
     double a = AS_DOUBLE(pvm_pop(vm)); \
     pvm_push(vm, cast(a op b)); \
   } while (false)
 
-// Bitwise operations should be done on pure integers, so cast to int first.
-#define BITWISE_OP(op) \
+// Arithmetic with a fast path for two small ints, the result is computed in 64 bits so an overflow can be caught.
+// Anything that doesn't fit is redone with doubles, so is a zero product with a negative operand since
+// that's -0 which only a double can hold. (sums and differences of ints are never -0)
+#define ARITH_OP(op, mayBeNegZero) \
+  do { \
+    pd_value b = peek(vm, 0); \
+    pd_value a = peek(vm, 1); \
+    if(IS_INT(a) && IS_INT(b)) { \
+      int64_t result = (int64_t)AS_INT(a) op (int64_t)AS_INT(b); \
+      if(result == (int32_t)result && (!(mayBeNegZero) || result != 0 || (AS_INT(a) >= 0 && AS_INT(b) >= 0))) { \
+        vm->stack_top--; \
+        vm->stack_top[-1] = INT_VAL(result); \
+        break; \
+      } \
+    } \
+    BINARY_OP(DOUBLE_VAL, op); \
+  } while(0)
+
+// Comparisons can stay in ints when both sides are.
+#define COMPARE_OP(op) \
   do { \
-    int b = (int) AS_DOUBLE(pvm_pop(vm)); \
-    int a = (int) AS_DOUBLE(pvm_pop(vm)); \
-    pvm_push(vm, DOUBLE_VAL((double)(a op b))); \
+    pd_value b = peek(vm, 0); \
+    pd_value a = peek(vm, 1); \
+    if(IS_INT(a) && IS_INT(b)) { \
+      vm->stack_top--; \
+      vm->stack_top[-1] = BOOL_VAL(AS_INT(a) op AS_INT(b)); \
+      break; \
+    } \
+    BINARY_OP(BOOL_VAL, op); \
+  } while(0)
+
+// Bitwise operations should be done on pure integers, small ints are used as is and doubles wrap around first.
+// The result of a bitwise operation always fits in a small int. [fn] is one of the below or pd_shl/pd_shr (see value.h)
+#define TO_INT(v) (IS_INT(v) ? AS_INT(v) : pd_to_int32(AS_DOUBLE(v)))
+#define BAND(x, y) ((x) & (y))
+#define BOR(x, y) ((x) | (y))
+#define BXOR(x, y) ((x) ^ (y))
+#define BITWISE_OP(fn) \
+  do { \
+    pd_value b = peek(vm, 0); \
+    pd_value a = peek(vm, 1); \
+    if(IS_INT(a) && IS_INT(b)) { \
+      vm->stack_top--; \
+      vm->stack_top[-1] = INT_VAL(fn(AS_INT(a), AS_INT(b))); \
+      break; \
+    } \
+    if(!IS_NUMBER(a) || !IS_NUMBER(b)) { \
+      frame->ip = ip; \
+      runtimeError(vm, "Operands must be numbers."); \
+      return false; \
+    } \
+    vm->stack_top--; \
+    vm->stack_top[-1] = INT_VAL(fn(TO_INT(a), TO_INT(b))); \
   } while(0)
 
 // To allow string operands for == and !=
@@ -205,7 +440,7 @@ void pvm_run(pvm_t* vm) {
   do { \
     pd_value b = pvm_pop(vm); \
     pd_value a = pvm_pop(vm); \
-    pvm_push(vm, BOOL_VAL(a == b)); \
+    pvm_push(vm, BOOL_VAL(a op b)); \
   } while(0)
 
   for (;;) {
@@ -227,6 +462,17 @@ void pvm_run(pvm_t* vm) {
       case PVM_OP_POPN:
         vm->stack_top -= READ_BYTE();
         break;
+      case PVM_OP_PEEK: {
+        pd_value value = peek(vm, READ_BYTE());
+        pvm_push(vm, value);
+        break;
+      }
+      case PVM_OP_POP_UNDER: {
+        uint8_t count = READ_BYTE();
+        vm->stack_top -= count;
+        vm->stack_top[-1] = vm->stack_top[count - 1];
+        break;
+      }
       case PVM_OP_CONSTANT:
         pvm_push(vm, READ_CONSTANT());
         break;
@@ -243,31 +489,36 @@ void pvm_run(pvm_t* vm) {
         pvm_push(vm, FALSE_VALUE);
         break;
       case PVM_OP_PUSH_NEG_ONE:
-        pvm_push(vm, DOUBLE_VAL(-1));
+        pvm_push(vm, INT_VAL(-1));
         break;
       case PVM_OP_PUSH_ZERO:
-        pvm_push(vm, DOUBLE_VAL(0));
+        pvm_push(vm, INT_VAL(0));
         break;
       case PVM_OP_PUSH_ONE:
-        pvm_push(vm, DOUBLE_VAL(1));
+        pvm_push(vm, INT_VAL(1));
         break;
       case PVM_OP_PUSH_TWO:
-        pvm_push(vm, DOUBLE_VAL(2));
+        pvm_push(vm, INT_VAL(2));
         break;
       case PVM_OP_PUSH_THREE:
-        pvm_push(vm, DOUBLE_VAL(3));
+        pvm_push(vm, INT_VAL(3));
         break;
       case PVM_OP_PUSH_FOUR:
-        pvm_push(vm, DOUBLE_VAL(4));
+        pvm_push(vm, INT_VAL(4));
         break;
       case PVM_OP_PUSH_FIVE:
-        pvm_push(vm, DOUBLE_VAL(5));
+        pvm_push(vm, INT_VAL(5));
         break;
       case PVM_OP_NEGATE:
-        if(!IS_DOUBLE(peek(vm, 0))) {
+        // Negating 0 gives -0 and INT32_MIN has no positive int, both of those go through doubles.
+        if(IS_INT(peek(vm, 0)) && AS_INT(peek(vm, 0)) != 0 && AS_INT(peek(vm, 0)) != INT32_MIN) {
+          vm->stack_top[-1] = INT_VAL(-AS_INT(peek(vm, 0)));
+          break;
+        }
+        if(!IS_NUMBER(peek(vm, 0))) {
           frame->ip = ip;
           runtimeError(vm, "Operand must be a number.");
-          return;
+          return false;
         }
         
         pvm_push(vm, DOUBLE_VAL(-AS_DOUBLE(pvm_pop(vm))));        
@@ -277,28 +528,28 @@ void pvm_run(pvm_t* vm) {
         pvm_push(vm, BOOL_VAL(!AS_BOOL(pvm_pop(vm))));
         break;
       case PVM_OP_ADD:
-        BINARY_OP(DOUBLE_VAL, +);
+        ARITH_OP(+, false);
         break;
       case PVM_OP_SUBTRACT:
-        BINARY_OP(DOUBLE_VAL, -);
+        ARITH_OP(-, false);
         break;
       case PVM_OP_MULTIPLY:
-        BINARY_OP(DOUBLE_VAL, *);
+        ARITH_OP(*, true);
         break;
       case PVM_OP_DIVIDE:
         BINARY_OP(DOUBLE_VAL, /);
         break;
       case PVM_OP_GT:
-        BINARY_OP(BOOL_VAL, >);
+        COMPARE_OP(>);
         break;
       case PVM_OP_LT:
-        BINARY_OP(BOOL_VAL, <);
+        COMPARE_OP(<);
         break;
       case PVM_OP_GE:
-        BINARY_OP(BOOL_VAL, >=);
+        COMPARE_OP(>=);
         break;
       case PVM_OP_LE:
-        BINARY_OP(BOOL_VAL, <=);
+        COMPARE_OP(<=);
         break;
       case PVM_OP_EQ:
         CMP(==);
@@ -307,20 +558,169 @@ void pvm_run(pvm_t* vm) {
         CMP(!=);
         break;
       case PVM_OP_SHL:
-        BITWISE_OP(<<);
+        BITWISE_OP(pd_shl);
         break;
       case PVM_OP_SHR:
-        BITWISE_OP(>>);
+        BITWISE_OP(pd_shr);
         break;
       case PVM_OP_BAND:
-        BITWISE_OP(&);
+        BITWISE_OP(BAND);
         break;
       case PVM_OP_BOR:
-        BITWISE_OP(|);
+        BITWISE_OP(BOR);
         break;
       case PVM_OP_XOR:
-        BITWISE_OP(^);
+        BITWISE_OP(BXOR);
+        break;
+      case PVM_OP_BNOT:
+        if(!IS_NUMBER(peek(vm, 0))) {
+          frame->ip = ip;
+          runtimeError(vm, "Operand must be a number.");
+          return false;
+        }
+        vm->stack_top[-1] = INT_VAL(~TO_INT(peek(vm, 0)));
+        break;
+      case PVM_OP_ARRAY: {
+        uint16_t count = READ_SHORT();
+        // The elements stay on the stack while the array is allocated so the GC can still see them.
+        pd_array* array = pd_array_new(vm, vm->stack_top - count, count);
+        vm->stack_top -= count;
+        pvm_push(vm, PD_FROM(array));
+        break;
+      }
+      case PVM_OP_GET_INDEX: {
+        pd_value target = peek(vm, 1);
+        pd_value index = peek(vm, 0);
+        // Fast path: an array indexed by an integer within bounds.
+        // Integral numbers are always small ints so any double index is either fractional or out of range anyway.
+        if(IS_OBJECT(target) && IS_INT(index)) {
+          int32_t i = AS_INT(index);
+          if(PD_IS_ARRAY(target)) {
+            pd_value_array* values = &PD_AS_ARRAY(target)->values;
+            if(i >= 0 && i < values->count) {
+              vm->stack_top[-2] = values->data[i];
+              vm->stack_top--;
+              break;
+            }
+          } else if(PD_IS_TYPED_ARRAY(target)) {
+            pd_typed_array* typed = PD_AS_TYPED_ARRAY(target);
+            if(i >= 0 && i < typed->count) {
+              vm->stack_top[-2] = DOUBLE_VAL(pd_typed_array_get(typed, i));
+              vm->stack_top--;
+              break;
+            }
+          }
+        }
+        if(IS_OBJECT(target) && PD_IS_DICT(target)) {
+          // Missing keys are null.
+          pd_value value;
+          if(!pd_dict_get(PD_AS_DICT(target), index, &value)) value = NULL_VALUE;
+          vm->stack_top[-2] = value;
+          vm->stack_top--;
+          break;
+        }
+        frame->ip = ip;
+        indexError(vm, target, index);
+        return false;
+      }
+      case PVM_OP_GET_PROPERTY: {
+        pd_value target = peek(vm, 0);
+        pd_value name = READ_CONSTANT_LONG();
+        pd_value value;
+        if(!IS_OBJECT(target) || !PD_IS_DICT(target) || !pd_dict_get(PD_AS_DICT(target), name, &value)) {
+          frame->ip = ip;
+          propertyError(vm, target, name);
+          return false;
+        }
+        vm->stack_top[-1] = value;
+        break;
+      }
+      case PVM_OP_IMPORT: {
+        pd_value name = READ_CONSTANT_LONG();
+        frame->ip = ip; // The module is built here and may trigger a GC.
+        pd_value module;
+        if(!pd_builtin_import(vm, name, &module)) {
+          char bytes[PD_SSTR_MAX + 1];
+          int len;
+          const char* chars = nameChars(name, bytes, &len);
+          runtimeError(vm, "Unknown module '%.*s'.", len, chars);
+          return false;
+        }
+        pvm_push(vm, module);
         break;
+      }
+      case PVM_OP_SET_INDEX: {
+        pd_value target = peek(vm, 2);
+        pd_value index = peek(vm, 1);
+        pd_value value = peek(vm, 0);
+        if(IS_OBJECT(target) && IS_INT(index)) {
+          int32_t i = AS_INT(index);
+          if(PD_IS_ARRAY(target)) {
+            pd_array* array = PD_AS_ARRAY(target);
+            if(i >= 0 && i <= array->values.count) {
+              // Everything is still on the stack in case appending triggers the GC.
+              if(i == array->values.count) pd_array_push(vm, array, value);
+              else array->values.data[i] = value;
+              vm->stack_top -= 2;
+              vm->stack_top[-1] = value;
+              break;
+            }
+          } else if(PD_IS_TYPED_ARRAY(target)) {
+            // Typed arrays have a fixed size, no appending here.
+            pd_typed_array* typed = PD_AS_TYPED_ARRAY(target);
+            if(i >= 0 && i < typed->count) {
+              if(!IS_NUMBER(value)) {
+                frame->ip = ip;
+                runtimeError(vm, "Typed arrays can only hold numbers.");
+                return false;
+              }
+              if(PD_TYPED_ARRAY_READ_ONLY(typed)) {
+                frame->ip = ip;
+                runtimeError(vm, "Typed array is read-only.");
+                return false;
+              }
+              pd_typed_array_set(typed, i, AS_DOUBLE(value));
+              vm->stack_top -= 2;
+              vm->stack_top[-1] = value;
+              break;
+            }
+          }
+        }
+        if(IS_OBJECT(target) && PD_IS_DICT(target)) {
+          // All of them are still on the stack in case the dictionary grows and triggers the GC.
+          pd_dict_set(vm, PD_AS_DICT(target), index, value);
+          vm->stack_top -= 2;
+          vm->stack_top[-1] = value;
+          break;
+        }
+        frame->ip = ip;
+        indexError(vm, target, index);
+        return false;
+      }
+      case PVM_OP_DICT: {
+        uint16_t count = READ_SHORT();
+        pd_dict* dict = pd_dict_new(vm);
+        // Keep the pairs on the stack while the dictionary allocates, and the dictionary itself on top of them.
+        pvm_push(vm, PD_FROM(dict));
+        pd_value* pairs = vm->stack_top - 1 - count * 2;
+        for(int i = 0; i < count; i++)
+          pd_dict_set(vm, dict, pairs[i * 2], pairs[i * 2 + 1]);
+        vm->stack_top = pairs;
+        pvm_push(vm, PD_FROM(dict));
+        break;
+      }
+      case PVM_OP_DELETE_INDEX: {
+        pd_value target = peek(vm, 1);
+        if(!IS_OBJECT(target) || !PD_IS_DICT(target)) {
+          frame->ip = ip;
+          runtimeError(vm, "Can only delete keys from dictionaries.");
+          return false;
+        }
+        bool deleted = pd_dict_delete(PD_AS_DICT(target), peek(vm, 0));
+        vm->stack_top--;
+        vm->stack_top[-1] = BOOL_VAL(deleted);
+        break;
+      }
       case PVM_OP_JUMP: {
         uint16_t offset = READ_SHORT();
         ip += offset;
@@ -331,31 +731,79 @@ void pvm_run(pvm_t* vm) {
         ip -= offset;
         break;
       }
+      case PVM_OP_FOR_PREP: {
+        pd_value* slots = frame->slots + READ_BYTE();
+        uint16_t offset = READ_SHORT();
+        if(!IS_NUMBER(slots[0]) || !IS_NUMBER(slots[1]) || !IS_NUMBER(slots[2])) {
+          frame->ip = ip;
+          runtimeError(vm, "For loop range must be numbers.");
+          return false;
+        }
+        double start = AS_DOUBLE(slots[0]);
+        double limit = AS_DOUBLE(slots[1]);
+        double step = AS_DOUBLE(slots[2]);
+        // NaN compares false with everything, the body would run once and the loop could never end properly.
+        if(start != start || limit != limit || step != step) {
+          frame->ip = ip;
+          runtimeError(vm, "For loop range must be numbers.");
+          return false;
+        }
+        if(step == 0) {
+          frame->ip = ip;
+          runtimeError(vm, "For loop step cannot be zero.");
+          return false;
+        }
+        // The loop variable, a separate slot so the body can freely reassign it without messing up the counter.
+        pvm_push(vm, slots[0]);
+        if(step > 0 ? start > limit : start < limit) ip += offset;
+        break;
+      }
+      case PVM_OP_FOR_LOOP: {
+        pd_value* slots = frame->slots + READ_BYTE();
+        uint16_t offset = READ_SHORT();
+        // All ints is the common case, the next index can't overflow as long as it stays within the int limit.
+        if(IS_INT(slots[0]) && IS_INT(slots[1]) && IS_INT(slots[2])) {
+          int32_t step = AS_INT(slots[2]);
+          int64_t index = (int64_t)AS_INT(slots[0]) + step;
+          if(step > 0 ? index <= AS_INT(slots[1]) : index >= AS_INT(slots[1])) {
+            closeUpvalues(vm, frame, &slots[3]);
+            slots[0] = INT_VAL(index);
+            slots[3] = slots[0];
+            ip -= offset;
+          }
+          break;
+        }
+        double step = AS_DOUBLE(slots[2]);
+        double index = AS_DOUBLE(slots[0]) + step;
+        if(step > 0 ? index <= AS_DOUBLE(slots[1]) : index >= AS_DOUBLE(slots[1])) {
+          // Each iteration gets a fresh loop variable, closures that captured the last one keep their own value.
+          closeUpvalues(vm, frame, &slots[3]);
+          slots[0] = DOUBLE_VAL(index);
+          slots[3] = slots[0];
+          ip -= offset;
+        }
+        break;
+      }
       case PVM_OP_RETURN_NULL: {
-        closeUpvalues(vm, frame->slots);
+        closeUpvalues(vm, frame, frame->slots);
         vm->frame_count--;
-        if(vm->frame_count == 0) {
-          pvm_pop(vm);
-          return;
-        }
         vm->stack_top = frame->slots;
         pvm_push(vm, NULL_VALUE);
+        // Returning to whoever started this run (the script's caller or a native function) ends it
+        // the result is left on the stack for them.
+        if(vm->frame_count == exitFrame) return true;
         frame = &vm->frames[vm->frame_count - 1];
         ip = frame->ip;
         break;
       }
       case PVM_OP_RETURN: {
         pd_value result = pvm_pop(vm);
-        closeUpvalues(vm, frame->slots);
+        closeUpvalues(vm, frame, frame->slots);
         vm->frame_count--;
-        if(vm->frame_count == 0) {
-          pvm_pop(vm);
-          return;
-        }
-        
         vm->stack_top = frame->slots;
         pvm_push(vm, result);
-        
+        if(vm->frame_count == exitFrame) return true;
+
         frame = &vm->frames[vm->frame_count - 1];
         ip = frame->ip;
         break;
@@ -364,11 +812,73 @@ void pvm_run(pvm_t* vm) {
         int argCount = READ_BYTE();
         frame->ip = ip;
         if(!pvm_call(vm, peek(vm, argCount), argCount))
-          return;
+          return false;
         frame = &vm->frames[vm->frame_count - 1];
         ip = frame->ip;
         break;
       }
+      case PVM_OP_TAIL_CALL: {
+        int argCount = READ_BYTE();
+        pd_value callee = peek(vm, argCount);
+        if(!IS_OBJECT(callee) || !PD_IS_CLOSURE(callee) || PD_AS_CLOSURE(callee)->function->async) {
+          // Natives and async functions don't use frames here, so just call it normally, the RETURN after us returns the result.
+          frame->ip = ip;
+          if(!pvm_call(vm, callee, argCount)) return false;
+          frame = &vm->frames[vm->frame_count - 1];
+          break;
+        }
+        pd_closure* closure = PD_AS_CLOSURE(callee);
+        if(argCount != closure->function->arity) {
+          frame->ip = ip;
+          runtimeError(vm, "Expected %d arguments but got %d.", closure->function->arity, argCount);
+          return false;
+        }
+        if(closure->function->ast != NULL || closure->function->failed) {
+          frame->ip = ip;
+          if(!ensureCompiled(vm, closure->function)) return false;
+        }
+        // We are done with the current frame so reuse it for the callee.
+        // Close anything captured from it first then slide the callee and arguments down into it's slots.
+        closeUpvalues(vm, frame, frame->slots);
+        pd_value* args = vm->stack_top - argCount - 1;
+        memmove(frame->slots, args, sizeof(pd_value) * (argCount + 1));
+        vm->stack_top = frame->slots + argCount + 1;
+        frame->closure = closure;
+        ip = closure->function->chunk.code;
+        break;
+      }
+      case PVM_OP_AWAIT: {
+        pd_value value = peek(vm, 0);
+        if(!IS_OBJECT(value) || !PD_IS_TASK(value)) break;
+        pd_task* task = PD_AS_TASK(value);
+        if(task->state == PD_TASK_DONE) {
+          vm->stack_top[-1] = task->result;
+          break;
+        }
+        frame->ip = ip;
+        if(task->state == PD_TASK_FAILED) {
+          runtimeError(vm, "Awaited task failed.");
+          return false;
+        }
+        // The compiler only allows await in async functions, whose body is always the first frame of a task.
+        if(vm->task == NULL || vm->frame_count != 1) {
+          runtimeError(vm, "Can only await inside async functions.");
+          return false;
+        }
+        if(task == vm->task) {
+          runtimeError(vm, "A task can't await itself.");
+          return false;
+        }
+        // Suspend, the frames stay as they are and we go back to pvm_run_tasks()
+        // The AWAIT runs again once the task is done and wakes us up, then it's got the result.
+        frame->ip = ip - 1;
+        vm->task->state = PD_TASK_WAITING;
+        pd_task** waiters = &task->waiters;
+        while(*waiters != NULL) waiters = &(*waiters)->next;
+        *waiters = vm->task;
+        vm->task->next = NULL;
+        return true;
+      }
       case PVM_OP_AND: {
         uint16_t offset = READ_SHORT();
         if(!AS_BOOL(peek(vm, 0))) ip += offset;
@@ -386,7 +896,15 @@ void pvm_run(pvm_t* vm) {
         if(!AS_BOOL(pvm_pop(vm))) ip += offset;
         break;
       }
-      // TODO bitwise ~, it's unary so we can't use BITWISE_OP macro.
+      case PVM_OP_INLINE_GUARD: {
+        pd_value callee = vm->global_values.data[READ_SHORT()];
+        uint64_t hash = 0;
+        for(int x = 0; x < 8; x++) hash |= (uint64_t)ip[x] << (x * 8);
+        ip += 8;
+        uint16_t offset = READ_SHORT();
+        if(IS_OBJECT(callee) && PD_IS_CLOSURE(callee) && PD_AS_CLOSURE(callee)->function->inline_hash == hash) ip += offset;
+        break;
+      }
       case PVM_OP_GET_LOCAL:
         pvm_push(vm, frame->slots[READ_BYTE()]);
         break;
@@ -396,30 +914,41 @@ void pvm_run(pvm_t* vm) {
       case PVM_OP_SET_GLOBAL:
         vm->global_values.data[READ_BYTE()] = peek(vm, 0);
         break;
+      case PVM_OP_SET_GLOBAL_LONG:
+        vm->global_values.data[READ_SHORT()] = peek(vm, 0);
+        break;
       case PVM_OP_CLOSE_UPVALUE:
-        closeUpvalues(vm, vm->stack_top - 1);
+        closeUpvalues(vm, frame, vm->stack_top - 1);
         pvm_pop(vm);
         break;
-      case PVM_OP_GET_GLOBAL: {
-        pd_value value = vm->global_values.data[READ_BYTE()];
+      case PVM_OP_GET_GLOBAL:
+      case PVM_OP_GET_GLOBAL_LONG: {
+        pd_value value = vm->global_values.data[instruction == PVM_OP_GET_GLOBAL ? READ_BYTE() : READ_SHORT()];
         if(IS_UNDEFINED(value)) {
           frame->ip = ip;
           runtimeError(vm, "Undefined variable.");
-          return;
+          return false;
         }
         pvm_push(vm, value);
         break;
       }
-      case PVM_OP_CLOSURE: {
-        pd_function* function = PD_AS_FUNCTION(READ_CONSTANT());
+      case PVM_OP_CLOSURE:
+      case PVM_OP_CLOSURE_LONG: {
+        pd_function* function = PD_AS_FUNCTION(instruction == PVM_OP_CLOSURE ? READ_CONSTANT() : READ_CONSTANT_LONG());
+        // Functions from a mapped file load their constants on first use.
+        if(function->chunk.pending != NULL) pd_bytecode_load_constants(vm, function);
         pd_closure* closure = pd_closure_new(vm, function);
         pvm_push(vm, PD_FROM(closure));
         for(int i = 0; i < closure->upvalue_count; i++) {
-          uint8_t isLocal = READ_BYTE();
+          uint8_t kind = READ_BYTE();
           uint8_t index = READ_BYTE();
-          if(isLocal) {
-            closure->upvalues[i] = captureUpvalue(vm, frame->slots + index);
+          if(kind == 1) {
+            closure->upvalues[i] = PD_FROM(captureUpvalue(vm, frame, frame->slots + index));
+          } else if(kind == 2) {
+            // Never assigned again so the closure can just have the value, no upvalue to allocate and close later.
+            closure->upvalues[i] = frame->slots[index];
           } else {
+            // Whatever the enclosing closure has, shared upvalue or copy.
             closure->upvalues[i] = frame->closure->upvalues[index];
           }
         }
@@ -427,12 +956,15 @@ void pvm_run(pvm_t* vm) {
       }
       case PVM_OP_GET_UPVALUE: {
         uint8_t slot = READ_BYTE();
-        pvm_push(vm, *frame->closure->upvalues[slot]->location);
+        pvm_push(vm, *PD_AS_UPVALUE(frame->closure->upvalues[slot])->location);
         break;                                          
       }
+      case PVM_OP_GET_UPVALUE_COPY:
+        pvm_push(vm, frame->closure->upvalues[READ_BYTE()]);
+        break;
       case PVM_OP_SET_UPVALUE: {
         uint8_t slot = READ_BYTE();
-        *frame->closure->upvalues[slot]->location = peek(vm, 0);
+        *PD_AS_UPVALUE(frame->closure->upvalues[slot])->location = peek(vm, 0);
         break;                                              
       }
       default:
@@ -445,18 +977,111 @@ void pvm_run(pvm_t* vm) {
 #undef READ_CONSTANT
 #undef BINARY_OP
 #undef BITWISE_OP
+#undef BAND
+#undef BOR
+#undef BXOR
 #undef CMP
 }
 
+void pvm_run(pvm_t* vm) {
+  if(run(vm, 0)) pvm_pop(vm);
+}
+
+bool pvm_call_value(pvm_t* vm, pd_value callee, int argc, pd_value* args, pd_value* result) {
+  int exitFrame = vm->frame_count;
+  pvm_push(vm, callee);
+  for(int i = 0; i < argc; i++) pvm_push(vm, args[i]);
+  if(!pvm_call(vm, callee, argc)) return false;
+  // Closures push a frame that we have to run, natives have already left their result on the stack.
+  if(vm->frame_count > exitFrame && !run(vm, exitFrame)) return false;
+  *result = pvm_pop(vm);
+  return true;
+}
+
+// Swaps the stack and frames of [task] with the ones of the VM, to run it and then to go back to what ran before.
+static void swapStacks(pvm_t* vm, pd_task* task) {
+  pd_value* stack = vm->stack;
+  pd_value* stack_top = vm->stack_top;
+  pd_value* stack_end = vm->stack_end;
+  pd_upvalue** open_upvalues = vm->open_upvalues;
+  pvm_frame* frames = vm->frames;
+  int frame_count = vm->frame_count;
+  int frame_capacity = vm->frame_capacity;
+  vm->stack = task->stack;
+  vm->stack_top = task->stack_top;
+  vm->stack_end = task->stack_end;
+  vm->open_upvalues = task->open_upvalues;
+  vm->frames = task->frames;
+  vm->frame_count = task->frame_count;
+  vm->frame_capacity = task->frame_capacity;
+  task->stack = stack;
+  task->stack_top = stack_top;
+  task->stack_end = stack_end;
+  task->open_upvalues = open_upvalues;
+  task->frames = frames;
+  task->frame_count = frame_count;
+  task->frame_capacity = frame_capacity;
+}
+
+// Runs [task] until it returns, fails or awaits something that isn't done yet.
+static void resumeTask(pvm_t* vm, pd_task* task) {
+  swapStacks(vm, task);
+  vm->task = task;
+  task->state = PD_TASK_RUNNING;
+  bool ok = run(vm, 0);
+  bool done = ok && task->state == PD_TASK_RUNNING;
+  pd_value result = done ? pvm_pop(vm) : NULL_VALUE;
+  vm->task = NULL;
+  swapStacks(vm, task);
+  // Still waiting means it's suspended in an AWAIT, its stack is needed to carry on.
+  if(ok && !done) return;
+  pd_task_free_stack(task);
+  if(done) pd_task_complete(vm, task, result);
+  else pd_task_fail(vm, task);
+}
+
+void pvm_run_tasks(pvm_t* vm) {
+  // Tasks start and resume from the main stack only, a task running already just queues them.
+  if(vm->task != NULL) return;
+  while(vm->ready != NULL) {
+    pd_task* task = vm->ready;
+    vm->ready = task->next;
+    if(vm->ready == NULL) vm->ready_tail = NULL;
+    task->next = NULL;
+    resumeTask(vm, task);
+  }
+}
+
+void pvm_retain(pvm_t* vm, pd_value value) {
+  if(!IS_OBJECT(value)) return;
+  pvm_push(vm, value); // GC guard, the dictionary may allocate.
+  if(vm->retained == NULL) vm->retained = pd_dict_new(vm);
+  pd_value count = NUMBER_VAL(0);
+  pd_dict_get(vm->retained, value, &count);
+  pd_dict_set(vm, vm->retained, value, NUMBER_VAL(AS_DOUBLE(count) + 1));
+  pvm_pop(vm);
+}
+
+void pvm_release(pvm_t* vm, pd_value value) {
+  pd_value count;
+  if(vm->retained == NULL || !pd_dict_get(vm->retained, value, &count)) return;
+  if(AS_DOUBLE(count) <= 1) pd_dict_delete(vm->retained, value);
+  else pd_dict_set(vm, vm->retained, value, NUMBER_VAL(AS_DOUBLE(count) - 1));
+}
+
 // Executes the top-level function.
 void pvm_exec(pvm_t* vm, pd_function* fn) {
   vm->compiler = NULL; // We don't need it at runtime, it's only a compile-time GC guard.
-  pvm_init_builtins(vm);
+  // Nothing else holds the function now, so guard it before defining the builtins.
   pvm_push(vm, PD_FROM(fn));
+  if(fn->chunk.pending != NULL) pd_bytecode_load_constants(vm, fn);
+  pvm_init_builtins(vm);
   pd_closure* closure = pd_closure_new(vm, fn);
   pvm_pop(vm);
   pvm_push(vm, PD_FROM(closure));
   pvm_call(vm, PD_FROM(closure), 0);
   pvm_run(vm);
+  // Async functions called by the script start now.
+  pvm_run_tasks(vm);
   //uv_run(vm->loop, UV_RUN_DEFAULT);
 }
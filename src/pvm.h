@@ -4,15 +4,19 @@
 // Peridot's Virtual Machine for executing bytecode
 // in the future this will be able to do basic Just in time compilation for faster speed.
 
-// The max stack size before overflowing.
-#define PVM_FRAMES_MAX 64
-#define PVM_STACK_MAX (PVM_FRAMES_MAX * 256)
+// The stack and frames start small and grow on demand, most VMs never need more than the initial size.
+#define PVM_FRAMES_INITIAL 8
+#define PVM_STACK_INITIAL 256
+// The max call depth and stack size before overflowing.
+#define PVM_FRAMES_MAX 100000
+#define PVM_STACK_MAX (1024 * 1024)
 
 #include <stdint.h>
 #include "value.h"
 #include "table.h"
 #include "function.h"
 #include "compiler.h"
+#include "dict.h"
 
 // TEMP TRY
 #include <uv.h>
@@ -22,22 +26,36 @@ typedef struct {
   pd_closure* closure;
   uint8_t* ip;
   pd_value* slots;
+  int open; // How many upvalues are open on its slots, returning only has to close them if there's any.
 } pvm_frame;
 
+// A bytecode file mapped in memory, see pd_bytecode_map()
+typedef struct pd_mapping pd_mapping;
+
 typedef struct pvm_t {
   // Stores the inner most compiler, this is to keep track of values allocated during compile time
   // To avoid freeing values at compile time, (i.e the functions/strings)
   // This is set back to NULL at runtime.
   pd_code_ctx* compiler;
   // Stack stuff.
-  pd_value stack[PVM_STACK_MAX];
+  // The stack may move when it grows, anything pointing into it must be updated in growStack() (see pvm.c)
+  pd_value* stack;
   pd_value* stack_top;
+  pd_value* stack_end; // One past the last slot we have room for.
 
-  pd_upvalue* open_upvalues;
+  // The open upvalue of each stack slot or NULL, it's as big as the stack so capturing a local is just an index.
+  pd_upvalue** open_upvalues;
 
   // Instructions stuff
-  pvm_frame frames[PVM_FRAMES_MAX];
+  pvm_frame* frames;
   int frame_count;
+  int frame_capacity;
+
+  // Async functions run as tasks with a stack of their own which is swapped with the one above while they run.
+  struct pd_task* task; // The task running now, NULL for the main stack.
+  // Tasks ready to start or resume in order, chained through their next. (see pvm_run_tasks())
+  struct pd_task* ready;
+  struct pd_task* ready_tail;
 
   // GC stuff.
   size_t bytes_allocated;
@@ -71,6 +89,15 @@ typedef struct pvm_t {
   pd_table globals;
   pd_value_array global_values;
 
+  // Bytecode files mapped in memory, the functions loaded from them point into these so they live as long as the VM.
+  pd_mapping* mappings;
+
+  // setTimeout() and friends, created on first use. (see timers.h)
+  struct pd_timers* timers;
+
+  // Values native code holds on to outside the heap mapped to how many times, see pvm_retain(). NULL until first used.
+  pd_dict* retained;
+
   // The libuv event-loop.
   // TODO: We will always use uv_default_loop() pretty much, do we need this?
   uv_loop_t* loop;
@@ -85,5 +112,17 @@ void pvm_free(pvm_t* vm);
 void pvm_exec(pvm_t* vm, pd_function* fn);
 void pvm_define_function(pvm_t* vm, char* name, pd_native fn);
 bool pvm_call(pvm_t* vm, pd_value value, int argc);
+// Calls a function from native code and waits for it to return, the returned value is written to [result]
+// Returns false if a runtime error happened, natives should stop what they are doing and return in that case.
+// The stack may grow during the call which moves it, so natives must not use their args pointer after calling this
+// and [args] itself must not point into the stack.
+bool pvm_call_value(pvm_t* vm, pd_value callee, int argc, pd_value* args, pd_value* result);
+// Runs the queued tasks until none is ready, the ones left are waiting on something. (see task.h)
+// Anything that runs code from an event loop callback calls this after so the tasks it woke up get to run.
+void pvm_run_tasks(pvm_t* vm);
+// Keeps [value] alive while something the GC can't see holds it, like a libuv handle that calls back into the VM later.
+// Every retain needs a release, the value can be collected once they balance out.
+void pvm_retain(pvm_t* vm, pd_value value);
+void pvm_release(pvm_t* vm, pd_value value);
 
 #endif // _PERIDOT_PVM_H
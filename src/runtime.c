@@ -5,6 +5,10 @@
 #include <time.h>
 #include "pvm.h"
 #include "class.h"
+#include "array.h"
+#include "typed_array.h"
+#include "dict.h"
+#include "task.h"
 
 // These two print functions are mainly here due to dependency cycles i couldn't think where to put them other than here.
 static PD_INLINE void printObj(pd_value value) {
@@ -30,6 +34,56 @@ static PD_INLINE void printObj(pd_value value) {
     case PD_OBJ_UPVALUE:
       printf("upvalue");
       break;
+    case PD_OBJ_ARRAY: {
+      pd_value_array* values = &PD_AS_ARRAY(value)->values;
+      printf("[");
+      for(int i = 0; i < values->count; i++) {
+        if(i > 0) printf(", ");
+        // Don't recurse forever when an array contains itself.
+        if(values->data[i] == value) printf("[...]");
+        else pd_value_print(values->data[i]);
+      }
+      printf("]");
+      break;
+    }
+    case PD_OBJ_TYPED_ARRAY: {
+      static const char* names[] = { "Float64Array", "Int32Array", "Uint8Array" };
+      pd_typed_array* array = PD_AS_TYPED_ARRAY(value);
+      printf("%s(%d) [", names[array->kind], array->count);
+      for(int i = 0; i < array->count; i++) {
+        if(i > 0) printf(", ");
+        printf("%g", pd_typed_array_get(array, i));
+      }
+      printf("]");
+      break;
+    }
+    case PD_OBJ_DICT: {
+      pd_dict* dict = PD_AS_DICT(value);
+      bool first = true;
+      printf("{");
+      for(int i = 0; i < dict->used; i++) {
+        pd_dict_entry* entry = &dict->entries[i];
+        if(PD_DICT_ENTRY_DELETED(entry)) continue;
+        if(!first) printf(", ");
+        first = false;
+        pd_value_print(entry->key);
+        printf(": ");
+        // Don't recurse forever when a dictionary contains itself.
+        if(entry->value == value) printf("{...}");
+        else pd_value_print(entry->value);
+      }
+      printf("}");
+      break;
+    }
+    case PD_OBJ_TASK:
+      printf("<task at %p>", AS_OBJECT(value));
+      break;
+    case PD_OBJ_SOCKET:
+      printf("<socket at %p>", AS_OBJECT(value));
+      break;
+    case PD_OBJ_FILE_STREAM:
+      printf("<file stream at %p>", AS_OBJECT(value));
+      break;
     default:
       pd_unreachable();
   }
@@ -53,6 +107,12 @@ void pd_value_print(pd_value value) {
     case PD_UNDEFINED:
       printf("<undefined>");
       break;
+    case PD_SHORT_STRING: {
+      char bytes[PD_SSTR_MAX + 1];
+      int len = pd_sstr_read(value, bytes);
+      printf("%.*s", len, bytes);
+      break;
+    }
     case PD_OBJECT:
       return printObj(value);
     default:
@@ -2,12 +2,27 @@
 #define _PERIDOT_RUNTIME_H
 
 #include "value.h"
+#include "function.h"
 
 // Functions callable at runtime
 
+// A native function by the name it's known as, functions of builtin modules are named like "net.listen"
+// Lists of them end with a { NULL, NULL } entry.
+typedef struct {
+  const char* name;
+  pd_native function;
+} pd_builtin;
+
 // Prints a value to stdout.
 void pd_value_print(pd_value value);
 void pvm_init_builtins(pvm_t* vm);
+// Name of a builtin native function, NULL if it isn't one.
+const char* pd_builtin_name(pd_native function);
+// Finds a builtin by name, NULL if there isn't one.
+pd_native pd_builtin_find(const char* name, size_t len);
+// Creates the dictionary of functions for `import name` in [module], returns false if there's no such builtin module.
+// [name] is a string value.
+bool pd_builtin_import(pvm_t* vm, pd_value name, pd_value* module);
 
 /*
 pd_value pd_println(pvm_t* vm, int argc, pd_value* args);
@@ -0,0 +1,550 @@
+// Implements heap snapshots, see snapshot.h
+//
+// The layout is simple since it never leaves the machine:
+//   header: magic u4, bytecode major u1, minor u1, object count u4, global count u4
+//   objects: type u1 followed by its fields, references to other objects are their index (u4)
+//   globals: name (index of a string) and value, in global index order
+// Values are a u1 tag followed by either the raw bits (u8) or the index of an object (u4).
+
+#include <stdlib.h>
+#include <string.h>
+#include "snapshot.h"
+#include "bytecode.h"
+#include "pvm.h"
+#include "gc.h"
+#include "str.h"
+#include "table.h"
+#include "function.h"
+#include "class.h"
+#include "array.h"
+#include "typed_array.h"
+#include "dict.h"
+#include "runtime.h"
+#include "compiler.h"
+
+#define VALUE_RAW 0
+#define VALUE_OBJECT 1
+
+// Written in place of a reference that is NULL (the name of a script function)
+#define NO_OBJECT UINT32_MAX
+
+// == Writer ==
+
+typedef struct {
+  pvm_t* vm;
+  FILE* out;
+  // Maps every object found to its index and lists them in index order.
+  // Both are regular objects kept on the VM stack, they aren't reachable from the globals so they don't end up in the file.
+  pd_dict* indices;
+  pd_array* objects;
+  bool error;
+} writer;
+
+static void writeU1(writer* w, uint8_t value) {
+  fwrite(&value, sizeof(value), 1, w->out);
+}
+
+static void writeU2(writer* w, uint16_t value) {
+  fwrite(&value, sizeof(value), 1, w->out);
+}
+
+static void writeU4(writer* w, uint32_t value) {
+  fwrite(&value, sizeof(value), 1, w->out);
+}
+
+static void writeU8(writer* w, uint64_t value) {
+  fwrite(&value, sizeof(value), 1, w->out);
+}
+
+static void writeBytes(writer* w, const void* bytes, size_t len) {
+  writeU4(w, (uint32_t)len);
+  fwrite(bytes, 1, len, w->out);
+}
+
+// Gives [object] an index if it doesn't have one yet.
+static void addObject(writer* w, pd_object* object) {
+  if(object == NULL) return;
+  pd_value index;
+  if(pd_dict_get(w->indices, PD_FROM(object), &index)) return;
+  // Closures are created with their function when restoring so the function has to come first.
+  if(object->type == PD_OBJ_CLOSURE) addObject(w, (pd_object*)((pd_closure*)object)->function);
+  pd_dict_set(w->vm, w->indices, PD_FROM(object), NUMBER_VAL((double)w->objects->values.count));
+  pd_array_push(w->vm, w->objects, PD_FROM(object));
+}
+
+static void addValue(writer* w, pd_value value) {
+  if(IS_OBJECT(value)) addObject(w, AS_OBJECT(value));
+}
+
+// Finds everything [object] refers to, the same things the GC marks in blackenObject()
+static void addReferences(writer* w, pd_object* object) {
+  switch(object->type) {
+    case PD_OBJ_CLASS:
+      addObject(w, (pd_object*)((pd_class*)object)->name);
+      break;
+    case PD_OBJ_CLOSURE: {
+      pd_closure* closure = (pd_closure*)object;
+      for(int i = 0; i < closure->upvalue_count; i++) addValue(w, closure->upvalues[i]);
+      break;
+    }
+    case PD_OBJ_FUNCTION: {
+      pd_function* function = (pd_function*)object;
+      // Functions that never ran may not be compiled or have their constants loaded yet.
+      if(function->failed || (function->ast != NULL && !pd_compile_lazy(w->vm, function, false))) w->error = true;
+      if(function->chunk.pending != NULL) pd_bytecode_load_constants(w->vm, function);
+      addObject(w, (pd_object*)function->name);
+      for(int i = 0; i < function->chunk.constants.count; i++) addValue(w, function->chunk.constants.data[i]);
+      break;
+    }
+    case PD_OBJ_UPVALUE:
+      addValue(w, *((pd_upvalue*)object)->location);
+      break;
+    case PD_OBJ_ARRAY: {
+      pd_value_array* values = &((pd_array*)object)->values;
+      for(int i = 0; i < values->count; i++) addValue(w, values->data[i]);
+      break;
+    }
+    case PD_OBJ_DICT: {
+      pd_dict* dict = (pd_dict*)object;
+      for(int i = 0; i < dict->used; i++) {
+        addValue(w, dict->entries[i].key);
+        addValue(w, dict->entries[i].value);
+      }
+      break;
+    }
+    case PD_OBJ_STRING:
+    case PD_OBJ_NATIVE:
+    case PD_OBJ_TYPED_ARRAY:
+    case PD_OBJ_TASK:
+    case PD_OBJ_SOCKET:
+    case PD_OBJ_FILE_STREAM:
+      break;
+  }
+}
+
+static uint32_t indexOf(writer* w, pd_object* object) {
+  if(object == NULL) return NO_OBJECT;
+  pd_value index;
+  pd_dict_get(w->indices, PD_FROM(object), &index);
+  return (uint32_t)AS_DOUBLE(index);
+}
+
+static void writeValue(writer* w, pd_value value) {
+  if(IS_OBJECT(value)) {
+    writeU1(w, VALUE_OBJECT);
+    writeU4(w, indexOf(w, AS_OBJECT(value)));
+  } else {
+    writeU1(w, VALUE_RAW);
+    writeU8(w, value);
+  }
+}
+
+static void writeFunction(writer* w, pd_function* function) {
+  writeU4(w, indexOf(w, (pd_object*)function->name));
+  writeU2(w, (uint16_t)function->arity);
+  writeU2(w, (uint16_t)function->upvalue_count);
+  writeU2(w, (uint16_t)function->scope);
+  writeU8(w, function->inline_hash);
+  writeU1(w, function->async);
+
+  pvm_chunk* chunk = &function->chunk;
+  writeBytes(w, chunk->code, chunk->count);
+  // Runs of lines like .pvm files, pvm_chunk_line() reads both the mapped and the regular form.
+  uint32_t runs = 0;
+  for(int i = 0; i < chunk->count; i++) {
+    if(i == 0 || pvm_chunk_line(chunk, i) != pvm_chunk_line(chunk, i - 1)) runs++;
+  }
+  writeU4(w, runs);
+  for(int i = 0; i < chunk->count;) {
+    int start = i;
+    int line = pvm_chunk_line(chunk, start);
+    while(i < chunk->count && pvm_chunk_line(chunk, i) == line) i++;
+    writeU4(w, (uint32_t)line);
+    writeU4(w, (uint32_t)(i - start));
+  }
+
+  writeU4(w, (uint32_t)chunk->constants.count);
+  for(int i = 0; i < chunk->constants.count; i++) writeValue(w, chunk->constants.data[i]);
+}
+
+static void writeObject(writer* w, pd_object* object) {
+  writeU1(w, (uint8_t)object->type);
+  switch(object->type) {
+    case PD_OBJ_STRING: {
+      pd_str* string = (pd_str*)object;
+      writeBytes(w, string->bytes, string->len);
+      break;
+    }
+    case PD_OBJ_NATIVE: {
+      const char* name = pd_builtin_name(((pd_native_function*)object)->function);
+      if(name == NULL) {
+        w->error = true;
+        break;
+      }
+      writeBytes(w, name, strlen(name));
+      break;
+    }
+    case PD_OBJ_CLASS:
+      // Nothing creates classes yet, write them once they actually exist.
+      w->error = true;
+      break;
+    case PD_OBJ_TASK:
+      // Tasks are running code, nothing is running when a snapshot is written but a global can still hold a finished one.
+      w->error = true;
+      break;
+    case PD_OBJ_SOCKET:
+    case PD_OBJ_FILE_STREAM:
+      // An open connection or file doesn't survive the process anyway.
+      w->error = true;
+      break;
+    case PD_OBJ_FUNCTION:
+      writeFunction(w, (pd_function*)object);
+      break;
+    case PD_OBJ_CLOSURE: {
+      pd_closure* closure = (pd_closure*)object;
+      writeU4(w, indexOf(w, (pd_object*)closure->function));
+      writeU4(w, (uint32_t)closure->upvalue_count);
+      for(int i = 0; i < closure->upvalue_count; i++) writeValue(w, closure->upvalues[i]);
+      break;
+    }
+    case PD_OBJ_UPVALUE:
+      // Nothing is running so every upvalue is closed, they are restored as closed ones anyway.
+      writeValue(w, *((pd_upvalue*)object)->location);
+      break;
+    case PD_OBJ_ARRAY: {
+      pd_value_array* values = &((pd_array*)object)->values;
+      writeU4(w, (uint32_t)values->count);
+      for(int i = 0; i < values->count; i++) writeValue(w, values->data[i]);
+      break;
+    }
+    case PD_OBJ_TYPED_ARRAY: {
+      pd_typed_array* array = (pd_typed_array*)object;
+      writeU1(w, (uint8_t)array->kind);
+      writeU4(w, (uint32_t)array->count);
+      fwrite(array->data, pd_typed_array_element_size(array->kind), array->count, w->out);
+      break;
+    }
+    case PD_OBJ_DICT: {
+      // Only the entries in order, the hashes of object keys are their addresses so the index is built again anyway.
+      pd_dict* dict = (pd_dict*)object;
+      writeU4(w, (uint32_t)dict->count);
+      for(int i = 0; i < dict->used; i++) {
+        pd_dict_entry* entry = &dict->entries[i];
+        if(PD_DICT_ENTRY_DELETED(entry)) continue;
+        writeValue(w, entry->key);
+        writeValue(w, entry->value);
+      }
+      break;
+    }
+  }
+}
+
+bool pd_snapshot_write(pvm_t* vm, FILE* out) {
+  if(vm->frame_count > 0) return false;
+  writer w = { vm, out, NULL, NULL, false };
+  w.indices = pd_dict_new(vm);
+  pvm_push(vm, PD_FROM(w.indices));
+  w.objects = pd_array_new(vm, NULL, 0);
+  pvm_push(vm, PD_FROM(w.objects));
+
+  // The table doesn't keep any order so we put the names back in index order first.
+  int globals = vm->global_values.count;
+  pd_str** names = calloc(globals, sizeof(pd_str*));
+  for(int i = 0; i < vm->globals.capacity; i++) {
+    pd_table_entry* entry = &vm->globals.entries[i];
+    if(entry->key == NULL) continue;
+    names[(int)AS_DOUBLE(entry->value)] = entry->key;
+  }
+
+  // Find everything reachable from the globals, the objects array doubles as the work list.
+  for(int i = 0; i < globals; i++) {
+    addObject(&w, (pd_object*)names[i]);
+    addValue(&w, vm->global_values.data[i]);
+  }
+  for(int i = 0; i < w.objects->values.count; i++) {
+    addReferences(&w, AS_OBJECT(w.objects->values.data[i]));
+  }
+
+  int count = w.objects->values.count;
+  writeU4(&w, PD_SNAPSHOT_MAGIC);
+  writeU1(&w, PD_BYTECODE_MAJOR);
+  writeU1(&w, PD_BYTECODE_MINOR);
+  writeU4(&w, (uint32_t)count);
+  writeU4(&w, (uint32_t)globals);
+  for(int i = 0; i < count && !w.error; i++) {
+    writeObject(&w, AS_OBJECT(w.objects->values.data[i]));
+  }
+  for(int i = 0; i < globals; i++) {
+    writeU4(&w, indexOf(&w, (pd_object*)names[i]));
+    writeValue(&w, vm->global_values.data[i]);
+  }
+
+  free(names);
+  pvm_pop(vm);
+  pvm_pop(vm);
+  return !w.error && !ferror(out);
+}
+
+// == Reader ==
+
+// Objects are restored in two passes over the file, the first one creates every object and fills in the plain data
+// (strings, code, typed array elements) then the second one links them together once every index has an object.
+// That way objects can refer to ones later in the file, which cycles need.
+typedef enum {
+  PASS_CREATE,
+  PASS_LINK
+} readPass;
+
+typedef struct {
+  pvm_t* vm;
+  const uint8_t* data;
+  size_t size;
+  size_t offset;
+  // Set when reading past the end or finding something invalid, every read returns 0 from then on.
+  bool error;
+  // The restored objects by index, kept on the VM stack.
+  pd_array* objects;
+  readPass pass;
+} reader;
+
+static const uint8_t* readBytes(reader* r, size_t len) {
+  if(r->error || r->size - r->offset < len) {
+    r->error = true;
+    return NULL;
+  }
+  const uint8_t* bytes = r->data + r->offset;
+  r->offset += len;
+  return bytes;
+}
+
+// Reads a number of [size] bytes in the machine's byte order, 0 if there isn't enough.
+static uint64_t readNumber(reader* r, size_t size) {
+  const uint8_t* bytes = readBytes(r, size);
+  if(bytes == NULL) return 0;
+  switch(size) {
+    case 1: return *bytes;
+    case 2: { uint16_t value; memcpy(&value, bytes, size); return value; }
+    case 4: { uint32_t value; memcpy(&value, bytes, size); return value; }
+    default: { uint64_t value; memcpy(&value, bytes, size); return value; }
+  }
+}
+
+static uint8_t readU1(reader* r) { return (uint8_t)readNumber(r, 1); }
+static uint16_t readU2(reader* r) { return (uint16_t)readNumber(r, 2); }
+static uint32_t readU4(reader* r) { return (uint32_t)readNumber(r, 4); }
+static uint64_t readU8(reader* r) { return readNumber(r, 8); }
+
+// Reads a reference to an object of the given type, NULL for NO_OBJECT.
+static pd_object* readObject(reader* r, pd_object_type type) {
+  uint32_t index = readU4(r);
+  if(index == NO_OBJECT || r->error) return NULL;
+  if(index >= (uint32_t)r->objects->values.count || !IS_OBJECT(r->objects->values.data[index]) ||
+     OBJECT_TYPE(AS_OBJECT(r->objects->values.data[index])) != type) {
+    r->error = true;
+    return NULL;
+  }
+  return AS_OBJECT(r->objects->values.data[index]);
+}
+
+// Reads a value, objects are only looked up when linking since they may not exist yet before that.
+static pd_value readValue(reader* r) {
+  if(readU1(r) == VALUE_RAW) return (pd_value)readU8(r);
+  uint32_t index = readU4(r);
+  if(r->pass == PASS_CREATE) return NULL_VALUE;
+  if(r->error || index >= (uint32_t)r->objects->values.count || !IS_OBJECT(r->objects->values.data[index])) {
+    r->error = true;
+    return NULL_VALUE;
+  }
+  return r->objects->values.data[index];
+}
+
+
+static void readFunction(reader* r, pd_function* function) {
+  pvm_t* vm = r->vm;
+  if(r->pass == PASS_LINK) {
+    function->name = (pd_str*)readObject(r, PD_OBJ_STRING);
+  } else {
+    readU4(r);
+  }
+  function->arity = readU2(r);
+  function->upvalue_count = readU2(r);
+  function->scope = readU2(r);
+  function->inline_hash = readU8(r);
+  function->async = readU1(r);
+
+  pvm_chunk* chunk = &function->chunk;
+  uint32_t count = readU4(r);
+  const uint8_t* code = readBytes(r, count);
+  if(r->pass == PASS_CREATE && code != NULL && count > 0) {
+    chunk->code = PD_GROW_ARRAY(vm, chunk->code, uint8_t, 0, count);
+    chunk->lines = PD_GROW_ARRAY(vm, chunk->lines, int, 0, count);
+    chunk->capacity = count;
+    chunk->count = count;
+    memcpy(chunk->code, code, count);
+  }
+
+  uint32_t runs = readU4(r);
+  uint32_t filled = 0;
+  for(uint32_t i = 0; i < runs && !r->error; i++) {
+    int line = (int)readU4(r);
+    uint32_t length = readU4(r);
+    if(length > count - filled) {
+      r->error = true;
+      break;
+    }
+    if(r->pass == PASS_CREATE) {
+      for(uint32_t j = 0; j < length; j++) chunk->lines[filled + j] = line;
+    }
+    filled += length;
+  }
+  if(filled != count) r->error = true;
+
+  uint32_t constants = readU4(r);
+  for(uint32_t i = 0; i < constants && !r->error; i++) {
+    pd_value value = readValue(r);
+    if(r->pass == PASS_LINK) pvm_add_constant(vm, chunk, value);
+  }
+}
+
+// Reads the object at [index], creating it or linking it depending on the pass.
+static void readObjectAt(reader* r, uint32_t index) {
+  pvm_t* vm = r->vm;
+  pd_value* slot = &r->objects->values.data[index];
+  uint8_t type = readU1(r);
+  if(r->pass == PASS_LINK && OBJECT_TYPE(AS_OBJECT(*slot)) != type) r->error = true;
+  if(r->error) return;
+
+  // Each object goes in its slot right away so the GC can see it while we fill it.
+  switch(type) {
+    case PD_OBJ_STRING: {
+      uint32_t len = readU4(r);
+      const uint8_t* bytes = readBytes(r, len);
+      if(r->pass == PASS_CREATE && bytes != NULL) *slot = PD_FROM(pd_str_intern(vm, (char*)bytes, len));
+      break;
+    }
+    case PD_OBJ_NATIVE: {
+      uint32_t len = readU4(r);
+      const uint8_t* name = readBytes(r, len);
+      if(r->pass != PASS_CREATE || name == NULL) break;
+      pd_native function = pd_builtin_find((const char*)name, len);
+      if(function == NULL) {
+        r->error = true;
+        break;
+      }
+      *slot = PD_FROM(pd_native_function_new(vm, function));
+      break;
+    }
+    case PD_OBJ_FUNCTION:
+      if(r->pass == PASS_CREATE) *slot = PD_FROM(pd_function_new(vm));
+      readFunction(r, (pd_function*)AS_OBJECT(*slot));
+      break;
+    case PD_OBJ_CLOSURE: {
+      // The function always comes before its closures, see addObject()
+      pd_function* function = (pd_function*)readObject(r, PD_OBJ_FUNCTION);
+      uint32_t count = readU4(r);
+      if(function == NULL || count != (uint32_t)function->upvalue_count) {
+        r->error = true;
+        break;
+      }
+      if(r->pass == PASS_CREATE) *slot = PD_FROM(pd_closure_new(vm, function));
+      pd_closure* closure = (pd_closure*)AS_OBJECT(*slot);
+      // Upvalue objects or copied values, see pd_closure.upvalues
+      for(uint32_t i = 0; i < count; i++) {
+        pd_value value = readValue(r);
+        if(r->pass == PASS_LINK) closure->upvalues[i] = value;
+      }
+      break;
+    }
+    case PD_OBJ_UPVALUE: {
+      if(r->pass == PASS_CREATE) {
+        pd_upvalue* upvalue = pd_upvalue_new(vm, NULL);
+        upvalue->location = &upvalue->closed;
+        *slot = PD_FROM(upvalue);
+      }
+      pd_value value = readValue(r);
+      if(r->pass == PASS_LINK) ((pd_upvalue*)AS_OBJECT(*slot))->closed = value;
+      break;
+    }
+    case PD_OBJ_ARRAY: {
+      if(r->pass == PASS_CREATE) *slot = PD_FROM(pd_array_new(vm, NULL, 0));
+      pd_array* array = (pd_array*)AS_OBJECT(*slot);
+      uint32_t count = readU4(r);
+      for(uint32_t i = 0; i < count && !r->error; i++) {
+        pd_value value = readValue(r);
+        if(r->pass == PASS_LINK) pd_array_push(vm, array, value);
+      }
+      break;
+    }
+    case PD_OBJ_TYPED_ARRAY: {
+      uint8_t kind = readU1(r);
+      uint32_t count = readU4(r);
+      if(kind > PD_TYPED_UINT8 || count > INT32_MAX) {
+        r->error = true;
+        break;
+      }
+      size_t size = pd_typed_array_element_size(kind) * count;
+      const uint8_t* data = readBytes(r, size);
+      if(r->pass != PASS_CREATE || data == NULL) break;
+      pd_typed_array* array = pd_typed_array_new(vm, kind, (int)count);
+      if(size > 0) memcpy(array->data, data, size);
+      *slot = PD_FROM(array);
+      break;
+    }
+    case PD_OBJ_DICT: {
+      if(r->pass == PASS_CREATE) *slot = PD_FROM(pd_dict_new(vm));
+      pd_dict* dict = (pd_dict*)AS_OBJECT(*slot);
+      uint32_t count = readU4(r);
+      for(uint32_t i = 0; i < count && !r->error; i++) {
+        pd_value key = readValue(r);
+        pd_value value = readValue(r);
+        if(r->pass == PASS_LINK && !r->error) pd_dict_set(vm, dict, key, value);
+      }
+      break;
+    }
+    default:
+      r->error = true;
+      break;
+  }
+}
+
+bool pd_snapshot_is(const uint8_t* data, size_t size) {
+  uint32_t magic;
+  if(size < sizeof(magic)) return false;
+  memcpy(&magic, data, sizeof(magic));
+  return magic == PD_SNAPSHOT_MAGIC;
+}
+
+bool pd_snapshot_read(pvm_t* vm, const uint8_t* data, size_t size) {
+  // Globals are referred to by index in code, the ones in the snapshot must be the only ones.
+  if(vm->global_values.count > 0 || !pd_snapshot_is(data, size)) return false;
+  reader r = { vm, data, size, 4, false, NULL, PASS_CREATE };
+  if(readU1(&r) != PD_BYTECODE_MAJOR || readU1(&r) != PD_BYTECODE_MINOR) return false;
+  uint32_t count = readU4(&r);
+  uint32_t globals = readU4(&r);
+  // Every object takes at least a byte, this stops a corrupted count from allocating a huge array.
+  if(r.error || count > size || globals > UINT16_MAX + 1) return false;
+
+  r.objects = pd_array_new(vm, NULL, 0);
+  pvm_push(vm, PD_FROM(r.objects));
+  for(uint32_t i = 0; i < count; i++) pd_array_push(vm, r.objects, NULL_VALUE);
+
+  size_t start = r.offset;
+  for(uint32_t i = 0; i < count && !r.error; i++) readObjectAt(&r, i);
+  r.offset = start;
+  r.pass = PASS_LINK;
+  for(uint32_t i = 0; i < count && !r.error; i++) readObjectAt(&r, i);
+
+  for(uint32_t i = 0; i < globals && !r.error; i++) {
+    pd_str* name = (pd_str*)readObject(&r, PD_OBJ_STRING);
+    pd_value value = readValue(&r);
+    if(name == NULL) {
+      r.error = true;
+      break;
+    }
+    pd_value_array_write(vm, &vm->global_values, value);
+    pd_table_set(vm, &vm->globals, name, NUMBER_VAL((double)i));
+  }
+
+  pvm_pop(vm);
+  return !r.error;
+}
@@ -0,0 +1,37 @@
+#ifndef _PERIDOT_SNAPSHOT_H
+#define _PERIDOT_SNAPSHOT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "peridot.h"
+#include "value.h"
+PERIDOT_EXTERN_C_BEGIN
+
+// Heap snapshots, the state of a VM after running some setup code saved to a file so new VMs can start from there
+// instead of running the setup again, in the spirit of V8 snapshots or Emacs dumps.
+//
+// Everything reachable from the globals is written: the objects, the strings they hold (interned again when restored)
+// and the globals table with its values. Objects refer to each other by their index in the file and get new addresses
+// when restored, native functions are written by their builtin name since their address changes between processes.
+//
+// Unlike .pvm files these are tied to the machine, numbers are written in its byte order as is.
+// The file also records the bytecode version since functions are written with their code.
+
+// "Peridot Snapshot"
+#define PD_SNAPSHOT_MAGIC 0x50D5A9
+
+// Writes the heap of [vm] to [out], it must not be running anything. (i.e after pvm_exec() and the event loop returned)
+// Returns false if writing failed or something can't be written. (a native that isn't a builtin)
+bool pd_snapshot_write(pvm_t* vm, FILE* out);
+
+// Restores a snapshot in [vm] which must be fresh, that is nothing was compiled or loaded in it yet.
+// Code can then be compiled and ran on top of it like usual, the globals of the snapshot are there already.
+// Returns false if the file is not a valid snapshot or was written by another version, the VM can't be used then.
+bool pd_snapshot_read(pvm_t* vm, const uint8_t* data, size_t size);
+
+// Checks if [data] starts like a snapshot.
+bool pd_snapshot_is(const uint8_t* data, size_t size);
+
+PERIDOT_EXTERN_C_END
+
+#endif // _PERIDOT_SNAPSHOT_H
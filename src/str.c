@@ -5,22 +5,10 @@
 #include <string.h>
 #include "peridot.h"
 
-// FNV-1a algorithm for hashing.
-// TODO: try out a few more hash algorithms and see if they perform better than this
-static uint32_t hashString(const char* key, int length) {
-  uint32_t hash = 2166136261u;
-  
-  for(int i = 0; i < length; i++) {
-    hash ^= key[i];
-    hash *= 16777619;
-  }
-  return hash;
-}
-
-pd_value pd_str_new(pvm_t* vm, char* cstr, size_t len) {
-  uint32_t hash = hashString(cstr, len);
+pd_str* pd_str_intern(pvm_t* vm, char* cstr, size_t len) {
+  uint32_t hash = pd_str_hash_bytes(cstr, len);
   pd_str* interned = pd_table_find_string(&vm->strings, cstr, len, hash);
-  if(interned != NULL) return PD_FROM(interned);
+  if(interned != NULL) return interned;
   pd_str* str = (pd_str*) pd_alloc_object(vm, sizeof(pd_str) + len + 1, PD_OBJ_STRING);
   str->hash = hash;
   pvm_push(vm, PD_FROM(str));
@@ -29,5 +17,25 @@ pd_value pd_str_new(pvm_t* vm, char* cstr, size_t len) {
   memcpy(str->bytes, cstr, len);
   str->bytes[len] = '\0';
   str->len = len;
-  return PD_FROM(str);
+  return str;
+}
+
+pd_value pd_str_new(pvm_t* vm, char* cstr, size_t len) {
+  // Short strings don't need to be allocated nor interned, the value itself is unique.
+  if(len <= PD_SSTR_MAX) return pd_sstr_value(cstr, len);
+  return PD_FROM(pd_str_intern(vm, cstr, len));
+}
+
+uint32_t pd_str_hash(pd_value value) {
+  if(IS_SHORT_STRING(value)) {
+    char bytes[PD_SSTR_MAX + 1];
+    int len = pd_sstr_read(value, bytes);
+    return pd_str_hash_bytes(bytes, len);
+  }
+  return PD_AS_STRING(value)->hash;
+}
+
+size_t pd_str_len(pd_value value) {
+  if(IS_SHORT_STRING(value)) return PD_SSTR_LEN(value);
+  return PD_STRLEN(value);
 }
@@ -13,13 +13,40 @@ typedef struct {
   char bytes[];
 } pd_str;
 
-// Create a new string.
+// Create a new string value.
+// Strings that fit in PD_SSTR_MAX bytes are packed in the value itself without allocating, see value.h
+// Longer strings are allocated and interned.
 pd_value pd_str_new(pvm_t* vm, char* cstr, size_t len);
 
+// Create an interned heap string regardless of the length.
+// Used internally for names and identifiers where we need an actual pd_str* such as keys for pd_table
+// This must not be used for values visible to the program, those must go through pd_str_new()
+pd_str* pd_str_intern(pvm_t* vm, char* cstr, size_t len);
+
+// Hash of a string value, short strings hash exactly the same as a heap string with the same bytes.
+uint32_t pd_str_hash(pd_value value);
+
+// FNV-1a, the hash of strings. The compiler hashes names with it too.
+// TODO: try out a few more hash algorithms and see if they perform better than this
+static PD_INLINE uint32_t pd_str_hash_bytes(const char* bytes, size_t len) {
+  uint32_t hash = 2166136261u;
+  for(size_t i = 0; i < len; i++) {
+    hash ^= (uint8_t)bytes[i];
+    hash *= 16777619;
+  }
+  return hash;
+}
+
+// Length of a string value.
+size_t pd_str_len(pd_value value);
+
 // Cast macros.
 #define PD_AS_STRING(val) ((pd_str*)AS_OBJECT(val))
 #define PD_AS_CSTRING(val) (PD_AS_STRING(val)->bytes)
 #define PD_STRLEN(val) (PD_AS_STRING(val)->len)
 #define PD_IS_STRING(val) (OBJECT_TYPE(AS_OBJECT(val)) == PD_OBJ_STRING)
 
+// Checks for both representations of strings, PD_IS_STRING only checks heap strings and assumes an object.
+#define PD_IS_ANY_STRING(val) (IS_SHORT_STRING(val) || (IS_OBJECT(val) && PD_IS_STRING(val)))
+
 #endif // _PERIDOT_STR_H
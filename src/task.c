@@ -0,0 +1,62 @@
+#include <stdlib.h>
+#include "task.h"
+#include "gc.h"
+
+pd_task* pd_task_new(pvm_t* vm) {
+  pd_task* task = ALLOC_OBJECT(vm, pd_task, PD_OBJ_TASK);
+  task->state = PD_TASK_WAITING;
+  task->result = NULL_VALUE;
+  task->stack = NULL;
+  task->stack_top = NULL;
+  task->stack_end = NULL;
+  task->open_upvalues = NULL;
+  task->frames = NULL;
+  task->frame_count = 0;
+  task->frame_capacity = 0;
+  task->waiters = NULL;
+  task->next = NULL;
+  return task;
+}
+
+void pd_task_schedule(pvm_t* vm, pd_task* task) {
+  task->state = PD_TASK_READY;
+  task->next = NULL;
+  if(vm->ready_tail == NULL) vm->ready = task;
+  else vm->ready_tail->next = task;
+  vm->ready_tail = task;
+}
+
+// Queues everything awaiting [task], they run the AWAIT again which picks up the result.
+static void wakeWaiters(pvm_t* vm, pd_task* task) {
+  pd_task* waiter = task->waiters;
+  task->waiters = NULL;
+  while(waiter != NULL) {
+    pd_task* next = waiter->next;
+    pd_task_schedule(vm, waiter);
+    waiter = next;
+  }
+}
+
+void pd_task_complete(pvm_t* vm, pd_task* task, pd_value result) {
+  task->state = PD_TASK_DONE;
+  task->result = result;
+  wakeWaiters(vm, task);
+}
+
+void pd_task_fail(pvm_t* vm, pd_task* task) {
+  task->state = PD_TASK_FAILED;
+  wakeWaiters(vm, task);
+}
+
+void pd_task_free_stack(pd_task* task) {
+  free(task->stack);
+  free(task->open_upvalues);
+  free(task->frames);
+  task->stack = NULL;
+  task->stack_top = NULL;
+  task->stack_end = NULL;
+  task->open_upvalues = NULL;
+  task->frames = NULL;
+  task->frame_count = 0;
+  task->frame_capacity = 0;
+}
@@ -0,0 +1,64 @@
+#ifndef _PERIDOT_TASK_H
+#define _PERIDOT_TASK_H
+
+#include "peridot.h"
+#include "object.h"
+#include "value.h"
+#include "pvm.h"
+
+// Tasks are how async code runs, calling an async function gives a task running it and `await task` waits for one.
+//
+// Each call of an async function is a coroutine with a stack and frames of its own, the VM swaps them in while it runs
+// and swaps them back out when it awaits something that isn't done yet. So suspending is just returning out of the
+// interpreter loop, the frames stay where they are and it carries on from the AWAIT when it's resumed.
+// Tasks don't start right away, they are queued and ran one after the other once the code that started them is done
+// (the script or a callback from the event loop) see pvm_run_tasks().
+//
+// Natives create tasks without a stack for things that finish later, like a timer or a read,
+// and complete them from their libuv callback which wakes up whoever awaits them.
+
+typedef enum {
+  PD_TASK_READY, // Queued to run or resume.
+  PD_TASK_RUNNING,
+  PD_TASK_WAITING, // Awaiting another task, or waiting on the event loop for native tasks.
+  PD_TASK_DONE,
+  PD_TASK_FAILED // A runtime error ended it, awaiting it fails too.
+} pd_task_state;
+
+typedef struct pd_task {
+  pd_object obj;
+  pd_task_state state;
+  pd_value result; // What it returned once done.
+
+  // The stack, open upvalues and frames of the coroutine, the same fields as the VM's and swapped with them while it runs.
+  // So while it's running these hold whatever was running before it. Native tasks have none.
+  pd_value* stack;
+  pd_value* stack_top;
+  pd_value* stack_end;
+  pd_upvalue** open_upvalues;
+  pvm_frame* frames;
+  int frame_count;
+  int frame_capacity;
+
+  struct pd_task* waiters; // Tasks awaiting this one, chained through their next.
+  struct pd_task* next; // Next task in the ready queue or in the waiters of the task this one awaits.
+} pd_task;
+
+// Creates a waiting task without a stack, natives return these and complete them later.
+pd_task* pd_task_new(pvm_t* vm);
+
+// Finishes a [task] with [result] (or as failed) and queues the tasks awaiting it.
+// Natives completing a task from a libuv callback should run pvm_run_tasks() after so they actually resume.
+void pd_task_complete(pvm_t* vm, pd_task* task, pd_value result);
+void pd_task_fail(pvm_t* vm, pd_task* task);
+
+// Adds [task] to the end of the ready queue.
+void pd_task_schedule(pvm_t* vm, pd_task* task);
+
+// Frees the stack of a task, used by the GC and once a coroutine is done.
+void pd_task_free_stack(pd_task* task);
+
+#define PD_IS_TASK(val) (OBJECT_TYPE(AS_OBJECT(val)) == PD_OBJ_TASK)
+#define PD_AS_TASK(val) ((pd_task*)AS_OBJECT(val))
+
+#endif // _PERIDOT_TASK_H
@@ -0,0 +1,260 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "timers.h"
+#include "gc.h"
+#include "task.h"
+
+#define MASK (PD_TIMERS_SLOTS - 1)
+// Generations are kept small enough for the handle to fit a double exactly along with the index.
+#define GENERATION_MASK 0x1FFFFF
+// Longer delays wait this long instead (over 285000 years) so the conversion and the expiry tick can't overflow.
+#define MAX_DELAY 9007199254740992.0
+
+static pd_timers* getTimers(pvm_t* vm) {
+  if(vm->timers != NULL) return vm->timers;
+  pd_timers* timers = malloc(sizeof(pd_timers));
+  if(timers == NULL) {
+    fprintf(stderr, "Out of memory.\n");
+    exit(1);
+  }
+  uv_timer_init(vm->loop, &timers->handle);
+  timers->handle.data = vm;
+  timers->start = uv_now(vm->loop);
+  timers->now = 0;
+  timers->due = UINT64_MAX;
+  timers->firing = false;
+  for(int i = 0; i < PD_TIMERS_LEVELS * PD_TIMERS_SLOTS; i++) timers->slots[i] = -1;
+  for(int i = 0; i < PD_TIMERS_LEVELS; i++) timers->pending[i] = 0;
+  timers->records = NULL;
+  timers->capacity = 0;
+  timers->free = -1;
+  vm->timers = timers;
+  return timers;
+}
+
+// The tick the event loop is at, the wheel may lag behind it until the libuv timer fires.
+static uint64_t currentTick(pvm_t* vm) {
+  return uv_now(vm->loop) - vm->timers->start;
+}
+
+static int allocRecord(pd_timers* timers) {
+  if(timers->free == -1) {
+    int capacity = PD_GROW_CAPACITY(timers->capacity);
+    pd_timer* records = realloc(timers->records, sizeof(pd_timer) * capacity);
+    if(records == NULL) {
+      fprintf(stderr, "Out of memory.\n");
+      exit(1);
+    }
+    // Chain the new records into the free list, in order so the lower ones get used first.
+    for(int i = timers->capacity; i < capacity; i++) {
+      records[i].generation = 0;
+      records[i].slot = -1;
+      records[i].next = i + 1 < capacity ? i + 1 : -1;
+    }
+    timers->free = timers->capacity;
+    timers->records = records;
+    timers->capacity = capacity;
+  }
+  int index = timers->free;
+  timers->free = timers->records[index].next;
+  return index;
+}
+
+static void freeRecord(pd_timers* timers, int index) {
+  pd_timer* timer = &timers->records[index];
+  timer->callback = NULL_VALUE;
+  timer->slot = -1;
+  timer->generation = (timer->generation + 1) & GENERATION_MASK;
+  timer->next = timers->free;
+  timers->free = index;
+}
+
+// Links a timer in the slot for its expiry, relative to the tick the wheel is at.
+static void link(pd_timers* timers, int index) {
+  pd_timer* timer = &timers->records[index];
+  // Never before now, a timer due now is only linked while cascading and goes in the slot that's about to run.
+  uint64_t delta = timer->expires - timers->now;
+  int level = 0;
+  while(level < PD_TIMERS_LEVELS - 1 && delta >= (uint64_t)1 << (PD_TIMERS_BITS * (level + 1))) level++;
+  uint64_t expires = timer->expires;
+  // Too far even for the last level, park it in the slot that comes around last and put it back from there.
+  // That's the one behind the current slot, which may be the one cascading right now.
+  if(delta >= (uint64_t)1 << (PD_TIMERS_BITS * PD_TIMERS_LEVELS)) {
+    expires = timers->now - ((uint64_t)1 << (PD_TIMERS_BITS * level));
+  }
+  int slot = level * PD_TIMERS_SLOTS + ((expires >> (PD_TIMERS_BITS * level)) & MASK);
+
+  timer->slot = slot;
+  timer->prev = -1;
+  timer->next = timers->slots[slot];
+  if(timer->next != -1) timers->records[timer->next].prev = index;
+  timers->slots[slot] = index;
+  timers->pending[level]++;
+}
+
+static void unlink(pd_timers* timers, int index) {
+  pd_timer* timer = &timers->records[index];
+  if(timer->prev != -1) timers->records[timer->prev].next = timer->next;
+  else timers->slots[timer->slot] = timer->next;
+  if(timer->next != -1) timers->records[timer->next].prev = timer->prev;
+  timers->pending[timer->slot / PD_TIMERS_SLOTS]--;
+  timer->slot = -1;
+}
+
+// Arms the libuv timer for [tick] if it isn't armed for something sooner already.
+static void arm(pvm_t* vm, uint64_t tick);
+
+double pd_timers_add(pvm_t* vm, double ms, double interval, pd_value callback) {
+  pd_timers* timers = getTimers(vm);
+  int index = allocRecord(timers);
+  pd_timer* timer = &timers->records[index];
+  timer->callback = callback;
+  // NaN fails both comparisons and waits for nothing like negative delays.
+  timer->expires = currentTick(vm) + (ms > 0 ? (uint64_t)(ms < MAX_DELAY ? ms : MAX_DELAY) : 0);
+  // Ticks up to now are done already, anything due by then runs on the next one.
+  if(timer->expires <= timers->now) timer->expires = timers->now + 1;
+  // An interval always waits at least a tick, otherwise it would keep running in the same one.
+  timer->interval = !(interval > 0) ? 0 : interval < 1 ? 1 : (uint64_t)(interval < MAX_DELAY ? interval : MAX_DELAY);
+  link(timers, index);
+  arm(vm, timer->expires);
+  return (double)(((uint64_t)timer->generation << 32) | (uint32_t)index);
+}
+
+bool pd_timers_cancel(pvm_t* vm, double handle) {
+  pd_timers* timers = vm->timers;
+  if(timers == NULL || handle < 0 || handle >= (double)((uint64_t)1 << 53)) return false;
+  uint64_t bits = (uint64_t)handle;
+  uint32_t index = (uint32_t)bits;
+  if((double)bits != handle || index >= (uint32_t)timers->capacity) return false;
+  pd_timer* timer = &timers->records[index];
+  if(timer->slot == -1 || timer->generation != bits >> 32) return false;
+  unlink(timers, index);
+  freeRecord(timers, index);
+  // The libuv timer may still be armed for it, waking up for nothing once is cheaper than finding out
+  // but once nothing is left it has to stop or the event loop would wait for it.
+  int pending = 0;
+  for(int i = 0; i < PD_TIMERS_LEVELS; i++) pending += timers->pending[i];
+  if(pending == 0 && !timers->firing) {
+    uv_timer_stop(&timers->handle);
+    timers->due = UINT64_MAX;
+  }
+  return true;
+}
+
+// Empties the slot of [level] the wheel just got to, its timers go back in closer to the bottom.
+// The levels above cascade too if this one wrapped around.
+static void cascade(pd_timers* timers, int level) {
+  int index = (timers->now >> (PD_TIMERS_BITS * level)) & MASK;
+  int slot = level * PD_TIMERS_SLOTS + index;
+  while(timers->slots[slot] != -1) {
+    int timer = timers->slots[slot];
+    unlink(timers, timer);
+    link(timers, timer);
+  }
+  if(index == 0 && level + 1 < PD_TIMERS_LEVELS) cascade(timers, level + 1);
+}
+
+static void fire(pvm_t* vm, int index) {
+  pd_timers* timers = vm->timers;
+  pd_timer* timer = &timers->records[index];
+  pd_value callback = timer->callback;
+  // Queue the next run before calling so the callback can clear its own interval.
+  unlink(timers, index);
+  if(timer->interval != 0) {
+    timer->expires = timers->now + timer->interval;
+    link(timers, index);
+  } else {
+    freeRecord(timers, index);
+  }
+
+  if(IS_OBJECT(callback) && PD_IS_TASK(callback)) {
+    pd_task_complete(vm, PD_AS_TASK(callback), NULL_VALUE);
+    return;
+  }
+  // The record may be gone already but the callback is on the stack during the call.
+  // Errors are reported by the VM, the other timers still run.
+  pd_value result;
+  pvm_call_value(vm, callback, 0, NULL, &result);
+}
+
+// Processes the ticks up to [target], firing what's due on the way.
+static void advance(pvm_t* vm, uint64_t target) {
+  pd_timers* timers = vm->timers;
+  while(timers->now < target) {
+    // Nothing in the bottom level, skip to the end of its round where the next cascade happens.
+    if(timers->pending[0] == 0) {
+      uint64_t last = timers->now | MASK;
+      if(last >= target) {
+        timers->now = target;
+        break;
+      }
+      timers->now = last;
+    }
+    timers->now++;
+    int index = timers->now & MASK;
+    if(index == 0) cascade(timers, 1);
+    // Callbacks can add timers, those always go in a later slot. (see pd_timers_add())
+    while(timers->slots[index] != -1) fire(vm, timers->slots[index]);
+  }
+}
+
+// Finds the next tick that has something to do, a level 0 timer or a cascade of a non empty slot.
+static uint64_t nextTick(pd_timers* timers) {
+  uint64_t next = UINT64_MAX;
+  for(int level = 0; level < PD_TIMERS_LEVELS; level++) {
+    if(timers->pending[level] == 0) continue;
+    int shift = PD_TIMERS_BITS * level;
+    uint64_t current = timers->now >> shift;
+    for(int distance = 1; distance <= PD_TIMERS_SLOTS; distance++) {
+      if(timers->slots[level * PD_TIMERS_SLOTS + ((current + distance) & MASK)] == -1) continue;
+      uint64_t tick = (current + distance) << shift;
+      if(tick < next) next = tick;
+      break;
+    }
+  }
+  return next;
+}
+
+static void onTimer(uv_timer_t* handle) {
+  pvm_t* vm = handle->data;
+  pd_timers* timers = vm->timers;
+  timers->due = UINT64_MAX;
+  timers->firing = true;
+  advance(vm, currentTick(vm));
+  timers->firing = false;
+  pvm_run_tasks(vm);
+  uint64_t next = nextTick(timers);
+  if(next == UINT64_MAX) uv_timer_stop(&timers->handle);
+  else arm(vm, next);
+}
+
+static void arm(pvm_t* vm, uint64_t tick) {
+  pd_timers* timers = vm->timers;
+  if(timers->firing || tick >= timers->due) return;
+  uint64_t current = currentTick(vm);
+  timers->due = tick;
+  uv_timer_start(&timers->handle, onTimer, tick > current ? tick - current : 0, 0);
+}
+
+void pd_timers_mark(pvm_t* vm) {
+  pd_timers* timers = vm->timers;
+  if(timers == NULL) return;
+  for(int i = 0; i < timers->capacity; i++) {
+    if(timers->records[i].slot != -1) pd_gc_gray_value(vm, timers->records[i].callback);
+  }
+}
+
+static void freeTimers(uv_handle_t* handle) {
+  free(handle->data);
+}
+
+void pd_timers_free(pvm_t* vm) {
+  pd_timers* timers = vm->timers;
+  if(timers == NULL) return;
+  vm->timers = NULL;
+  free(timers->records);
+  // The handle lives in the struct so it can only go once libuv is done with it, the next time the loop runs.
+  // (we may be in a callback of the loop right now if the script called exit())
+  timers->handle.data = timers;
+  uv_close((uv_handle_t*)&timers->handle, freeTimers);
+}
@@ -0,0 +1,71 @@
+#ifndef _PERIDOT_TIMERS_H
+#define _PERIDOT_TIMERS_H
+
+#include <stdint.h>
+#include <uv.h>
+#include "value.h"
+#include "pvm.h"
+
+// Timers for setTimeout(), setInterval() and sleep()
+//
+// Giving each timer its own uv_timer_t means a malloc per timer and libuv keeps them all in a heap,
+// that's a lot of work for timeouts that mostly get cancelled before they fire.
+// Instead all timers live in a hierarchical timing wheel driven by a single libuv timer.
+//
+// Time is counted in ticks of a millisecond. The wheel has a few levels of 64 slots each, level 0 holds timers
+// expiring in the next 64 ticks, one per slot. Level 1 slots each cover 64 ticks, level 2 slots 64 * 64 and so on.
+// When the first level wraps around the next slot of the level above is emptied and its timers are put back in,
+// landing in lower levels as they get closer (cascading). So adding or cancelling a timer is just linking it
+// in or out of a slot list, and each timer moves down at most once per level.
+// Timers further away than the last level covers (about 4.6 hours) wait in it and get put back until they fit.
+//
+// The records are pooled in one array and linked by index so the array can grow, freed ones are reused.
+// Scripts get a handle with the index and a generation that changes every time the record is reused,
+// so cancelling a timer that already fired doesn't cancel whatever reused its record.
+
+#define PD_TIMERS_BITS 6
+#define PD_TIMERS_SLOTS (1 << PD_TIMERS_BITS)
+#define PD_TIMERS_LEVELS 4
+
+typedef struct {
+  // A function to call or a task to complete, the GC marks it while the timer is queued.
+  pd_value callback;
+  uint64_t expires; // The tick it's due.
+  uint64_t interval; // Ticks between runs of an interval, 0 for a one shot.
+  uint32_t generation;
+  int slot; // Level * PD_TIMERS_SLOTS + index of the slot it's linked in, -1 if it isn't queued.
+  // The slot list, or the free list through next for free records. -1 ends them.
+  int prev;
+  int next;
+} pd_timer;
+
+typedef struct pd_timers {
+  uv_timer_t handle; // The one libuv timer, armed for the next tick that has something to do.
+  uint64_t start; // uv_now() when the wheel was created, ticks count from there.
+  uint64_t now; // Every tick up to this one has been processed.
+  uint64_t due; // The tick the libuv timer is armed for, UINT64_MAX if it isn't.
+  bool firing; // Processing ticks, the libuv timer is armed once we are done.
+
+  int slots[PD_TIMERS_LEVELS * PD_TIMERS_SLOTS]; // Head of each slot list.
+  int pending[PD_TIMERS_LEVELS]; // How many timers each level has, so we can skip over empty ones.
+
+  pd_timer* records;
+  int capacity;
+  int free; // First free record.
+} pd_timers;
+
+// Queues [callback] to run after [ms] milliseconds and then every [interval] milliseconds if it's not 0.
+// A task is completed instead of called. Returns the handle for pd_timers_cancel()
+// [callback] must be reachable by the GC until this returns.
+double pd_timers_add(pvm_t* vm, double ms, double interval, pd_value callback);
+
+// Cancels the timer of [handle], returns false if it isn't queued anymore. (fired, cancelled or not a handle)
+bool pd_timers_cancel(pvm_t* vm, double handle);
+
+// Marks the callbacks of queued timers, used by the GC.
+void pd_timers_mark(pvm_t* vm);
+
+// Closes the libuv timer and frees everything, used by pvm_free()
+void pd_timers_free(pvm_t* vm);
+
+#endif // _PERIDOT_TIMERS_H
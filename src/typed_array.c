@@ -0,0 +1,109 @@
+#include "typed_array.h"
+#include "gc.h"
+
+size_t pd_typed_array_element_size(pd_typed_kind kind) {
+  switch(kind) {
+    case PD_TYPED_FLOAT64: return sizeof(double);
+    case PD_TYPED_INT32: return sizeof(int32_t);
+    case PD_TYPED_UINT8: return sizeof(uint8_t);
+  }
+  return 0;
+}
+
+pd_typed_array* pd_typed_array_new(pvm_t* vm, pd_typed_kind kind, int count) {
+  pd_typed_array* array = ALLOC_OBJECT(vm, pd_typed_array, PD_OBJ_TYPED_ARRAY);
+  array->kind = kind;
+  array->count = 0;
+  array->data = NULL;
+  array->mapping = NULL;
+  array->mapping_size = 0;
+  if(count == 0) return array;
+
+  // The buffer allocation can trigger the GC, guard the array on the stack.
+  size_t size = pd_typed_array_element_size(kind) * count;
+  pvm_push(vm, PD_FROM(array));
+  array->data = pd_gc_malloc(vm, size);
+  pvm_pop(vm);
+  memset(array->data, 0, size);
+  array->count = count;
+  return array;
+}
+
+// The floating point sums use 4 independent accumulators.
+// A single accumulator forces the compiler to add in order which it can't vectorize without -ffast-math
+// splitting it into lanes lets it use SIMD registers and also breaks the dependency chain.
+double pd_typed_array_sum(pd_typed_array* array) {
+  int count = array->count;
+  switch(array->kind) {
+    case PD_TYPED_FLOAT64: {
+      double* data = array->data;
+      double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+      int i = 0;
+      for(; i + 4 <= count; i += 4) {
+        s0 += data[i];
+        s1 += data[i + 1];
+        s2 += data[i + 2];
+        s3 += data[i + 3];
+      }
+      for(; i < count; i++) s0 += data[i];
+      return (s0 + s1) + (s2 + s3);
+    }
+    case PD_TYPED_INT32: {
+      // Integer addition is associative so this vectorizes as is, sum in 64 bits to not overflow.
+      int32_t* data = array->data;
+      int64_t sum = 0;
+      for(int i = 0; i < count; i++) sum += data[i];
+      return (double)sum;
+    }
+    case PD_TYPED_UINT8: {
+      uint8_t* data = array->data;
+      uint64_t sum = 0;
+      for(int i = 0; i < count; i++) sum += data[i];
+      return (double)sum;
+    }
+  }
+  return 0;
+}
+
+double pd_typed_array_dot(pd_typed_array* a, pd_typed_array* b) {
+  int count = a->count;
+  // Float64 is the common case for numeric code, mixed kinds go through the generic path.
+  if(a->kind == PD_TYPED_FLOAT64 && b->kind == PD_TYPED_FLOAT64) {
+    double* x = a->data;
+    double* y = b->data;
+    double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    int i = 0;
+    for(; i + 4 <= count; i += 4) {
+      s0 += x[i] * y[i];
+      s1 += x[i + 1] * y[i + 1];
+      s2 += x[i + 2] * y[i + 2];
+      s3 += x[i + 3] * y[i + 3];
+    }
+    for(; i < count; i++) s0 += x[i] * y[i];
+    return (s0 + s1) + (s2 + s3);
+  }
+
+  double sum = 0;
+  for(int i = 0; i < count; i++) sum += pd_typed_array_get(a, i) * pd_typed_array_get(b, i);
+  return sum;
+}
+
+void pd_typed_array_fill(pd_typed_array* array, double value) {
+  int count = array->count;
+  switch(array->kind) {
+    case PD_TYPED_FLOAT64: {
+      double* data = array->data;
+      for(int i = 0; i < count; i++) data[i] = value;
+      break;
+    }
+    case PD_TYPED_INT32: {
+      int32_t* data = array->data;
+      int32_t v = (int32_t)(uint32_t)pd_typed_to_int(value);
+      for(int i = 0; i < count; i++) data[i] = v;
+      break;
+    }
+    case PD_TYPED_UINT8:
+      memset(array->data, (uint8_t)pd_typed_to_int(value), count);
+      break;
+  }
+}
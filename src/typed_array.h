@@ -0,0 +1,102 @@
+#ifndef _PERIDOT_TYPED_ARRAY_H
+#define _PERIDOT_TYPED_ARRAY_H
+
+#include <stdint.h>
+#include <string.h>
+#include "peridot.h"
+#include "object.h"
+#include "value.h"
+
+// Typed arrays are fixed size arrays of unboxed numbers.
+// Unlike regular arrays the elements aren't values so the GC has nothing to scan inside them
+// and they are laid out densely which is what numeric code wants.
+
+// The element type of a typed array.
+typedef enum {
+  PD_TYPED_FLOAT64, // Float64Array
+  PD_TYPED_INT32, // Int32Array
+  PD_TYPED_UINT8 // Uint8Array
+} pd_typed_kind;
+
+typedef struct {
+  pd_object obj;
+  pd_typed_kind kind;
+  int count; // Number of elements, not bytes.
+  // The raw storage, it's a plain buffer so it can be handed out as-is (e.g to libuv as a uv_buf_t) without copying.
+  void* data;
+  // Set for a view of a file mapped by fs.map(), data points inside the mapping.
+  // Those are read-only and get unmapped instead of freed. (see fs.h)
+  void* mapping;
+  size_t mapping_size;
+} pd_typed_array;
+
+// Creates a zero filled typed array of [count] elements.
+pd_typed_array* pd_typed_array_new(pvm_t* vm, pd_typed_kind kind, int count);
+
+// Size in bytes of a single element of the given kind.
+size_t pd_typed_array_element_size(pd_typed_kind kind);
+
+// Bulk operations, these are written as plain loops over the unboxed data so the C compiler can vectorize them.
+double pd_typed_array_sum(pd_typed_array* array);
+// Both arrays must be the same length.
+double pd_typed_array_dot(pd_typed_array* a, pd_typed_array* b);
+void pd_typed_array_fill(pd_typed_array* array, double value);
+
+#define PD_IS_TYPED_ARRAY(val) (OBJECT_TYPE(AS_OBJECT(val)) == PD_OBJ_TYPED_ARRAY)
+#define PD_AS_TYPED_ARRAY(val) ((pd_typed_array*)AS_OBJECT(val))
+#define PD_TYPED_ARRAY_READ_ONLY(array) ((array)->mapping != NULL)
+
+#ifdef __clang__
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunused-function"
+#else
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-function"
+#endif // __clang__
+
+// Converts a double to an integer the way a store into an integer typed array does.
+// Out of range numbers wrap around instead of being undefined behaviour, NaN and infinities become 0.
+static PD_INLINE int64_t pd_typed_to_int(double value) {
+  if(!(value > -9.2e18 && value < 9.2e18)) return 0;
+  return (int64_t)value;
+}
+
+// Reads the element at [index] as a double, index must be within bounds.
+static PD_INLINE double pd_typed_array_get(pd_typed_array* array, int index) {
+  switch(array->kind) {
+    case PD_TYPED_FLOAT64: {
+      double value = ((double*)array->data)[index];
+      // The buffer can hold any bit pattern, a NaN with a payload could look like a boxed value so use the plain NaN.
+      if(value != value) return pd_as_double(0x7ff8000000000000);
+      return value;
+    }
+    case PD_TYPED_INT32:
+      return (double)((int32_t*)array->data)[index];
+    case PD_TYPED_UINT8:
+      return (double)((uint8_t*)array->data)[index];
+  }
+  return 0;
+}
+
+// Writes a number at [index], index must be within bounds.
+static PD_INLINE void pd_typed_array_set(pd_typed_array* array, int index, double value) {
+  switch(array->kind) {
+    case PD_TYPED_FLOAT64:
+      ((double*)array->data)[index] = value;
+      break;
+    case PD_TYPED_INT32:
+      ((int32_t*)array->data)[index] = (int32_t)(uint32_t)pd_typed_to_int(value);
+      break;
+    case PD_TYPED_UINT8:
+      ((uint8_t*)array->data)[index] = (uint8_t)pd_typed_to_int(value);
+      break;
+  }
+}
+
+#ifdef __clang__
+#pragma clang diagnostic pop
+#else
+#pragma GCC diagnostic pop
+#endif // __clang__
+
+#endif // _PERIDOT_TYPED_ARRAY_H
@@ -2,6 +2,7 @@
 #define _PERIDOT_VALUE_H
 
 #include <stdint.h>
+#include <stddef.h>
 #include "object.h"
 #include "peridot.h"
 #include "debug.h"
@@ -50,7 +51,9 @@ typedef enum {
   PD_NULL,     // 2
   PD_NUMBER,   // 3
   PD_OBJECT,    // 4
-  PD_UNDEFINED  // 5
+  PD_UNDEFINED, // 5
+  PD_SHORT_STRING, // 6
+  PD_INT // 7, small integers, PD_TYPE() reports them as PD_NUMBER since that's what they are to the user.
 } pd_vtype;
 
 // The mask for the 3 Bits of type tag.
@@ -59,8 +62,29 @@ typedef enum {
 // Retrieve the type tag
 #define PD_TAG(v) ((int)((v) & TAG_MASK))
 
+// Small integers
+// Numbers with an integral value that fits in 32 bits are packed in the payload instead of being a double:
+//
+// unused (16 Bits) Integer (32 Bits)                  Type tag (3 Bits)
+// |                |                                  |
+// MMMMMMMMMMMMMMMM MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM TTT
+//
+// Like short strings a number that fits is *always* stored this way (see pd_number_value()) so 1 and 1.0
+// can't end up with different bits and equality stays a plain comparison.
+// This lets the VM do integer math on loop counters, indices and bitwise operations without going through doubles.
+#define IS_INT(v) (((v) & (QNAN | SIGN_BIT | TAG_MASK)) == (QNAN | PD_INT))
+
+// Boxes a 32 bit integer, the caller is responsible for it being in range.
+#define INT_VAL(i) ((pd_value)(QNAN | ((uint64_t)(uint32_t)(i) << 3) | PD_INT))
+
+// Unboxes a small integer.
+#define AS_INT(v) ((int32_t)(uint32_t)((v) >> 3))
+
+// Either representation of a number.
+#define IS_NUMBER(v) (IS_DOUBLE(v) || IS_INT(v))
+
 // Get typeof a value, doubles and objects aren't exactly tagged so we check for those.
-#define PD_TYPE(v) (IS_DOUBLE(v) ? PD_NUMBER : IS_OBJECT(v) ? PD_OBJECT : PD_TAG(v))
+#define PD_TYPE(v) (IS_NUMBER(v) ? PD_NUMBER : IS_OBJECT(v) ? PD_OBJECT : PD_TAG(v))
 
 // Singleton Constants, booleans and null
 #define TRUE_VALUE ((pd_value)(uint64_t)(QNAN | PD_TRUE))
@@ -75,6 +99,30 @@ typedef enum {
 // Not needed but allows us to change value representations anytime and not redo the checks.
 #define IS_NULL(v) ((v) == NULL_VALUE)
 
+// Short strings
+// Strings of up to PD_SSTR_MAX bytes are packed directly into the payload instead of being allocated on the heap.
+// They don't need an allocation, a GC trace or an entry in the interned strings table.
+// Their payload looks like:
+//
+// Bytes (40 Bits)                          unused (2 Bits)
+// |                                        |  Length (3 Bits)
+// |                                        |  |  Type tag (3 Bits)
+// |                                        |  |  |
+// MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM MM LLL TTT
+//
+// The first byte of the string is the lowest byte right after the length.
+// A string that fits is *always* stored this way (see pd_str_new()) so two equal strings always have the same bits
+// regardless of which representation they use, that keeps equality a plain comparison like interned strings.
+#define PD_SSTR_MAX 5
+
+#define IS_SHORT_STRING(v) (((v) & (QNAN | SIGN_BIT | TAG_MASK)) == (QNAN | PD_SHORT_STRING))
+
+// Length of a short string.
+#define PD_SSTR_LEN(v) ((int)(((v) >> 3) & 0x7))
+
+// Get the i'th byte of a short string.
+#define PD_SSTR_BYTE(v, i) ((char)(((v) >> (8 + 8 * (i))) & 0xFF))
+
 // Converts a C boolean to a value.
 #define BOOL_VAL(v) ((v) ? TRUE_VALUE : FALSE_VALUE)
 
@@ -90,12 +138,12 @@ typedef enum {
 // Unboxes a value to an object pointer
 #define AS_OBJECT(ptr) ((pd_object*)(uintptr_t)((ptr) & ~(SIGN_BIT | QNAN)))
 
-// Boxes a double.
+// Boxes a number, integral values become small ints.
 #define NUMBER_VAL(n) (pd_number_value((n)))
 
-// Unboxes a double
+// Unboxes a number as a double, works for both representations.
 #define AS_DOUBLE(v) (pd_as_double((v)))
-// Boxes a double
+// Boxes a number, integral values become small ints.
 #define DOUBLE_VAL(v) (pd_number_value((v)))
 
 // The annoying part of NaN boxing is the casting of double to bits and the other way.
@@ -122,11 +170,18 @@ union pd_double_bits {
 static PD_INLINE pd_value pd_number_value(double n) {
   union pd_double_bits bits;
   bits.num = n;
+  // The range check comes first so the int conversion is safe, it also rules out NaN.
+  // -0 stays a double since an int can't hold the sign.
+  if(n >= INT32_MIN && n <= INT32_MAX) {
+    int32_t i = (int32_t)n;
+    if((double)i == n && (i != 0 || bits.bits == 0)) return INT_VAL(i);
+  }
   return bits.bits;
 }
 
 static PD_INLINE double pd_as_double(pd_value value) {
-  pd_assert(IS_DOUBLE(value), "Attempt to get double value out of a non-double value.");
+  if(IS_INT(value)) return (double)AS_INT(value);
+  pd_assert(IS_DOUBLE(value), "Attempt to get double value out of a non-number value.");
   union pd_double_bits bits;
   bits.bits = value;
   return bits.num;
@@ -137,7 +192,52 @@ static PD_INLINE double pd_as_double(pd_value value) {
 // e.g AS_BOOL(pvm_pop(vm)) would pop more than once!
 // So we put it in a function and hope the compiler will inline it for us.
 static PD_INLINE bool AS_BOOL(pd_value value) {
-  return (PD_TAG(value) != PD_FALSE && PD_TAG(value) != PD_NULL && (IS_DOUBLE(value) ? AS_DOUBLE(value) != 0.0 : true));
+  // Numbers are checked first, the low bits of a double aren't a tag and could look like false or null.
+  if(IS_INT(value)) return value != INT_VAL(0);
+  if(IS_DOUBLE(value)) return AS_DOUBLE(value) != 0.0;
+  return value != FALSE_VALUE && value != NULL_VALUE;
+}
+
+// Bitwise operators work on 32 bit ints the way JavaScript's do, so the result never depends on the C compiler.
+// Numbers wrap around into int32 range (NaN and infinities become 0) and shift counts only use their low 5 bits.
+static PD_INLINE int32_t pd_to_int32(double value) {
+  // Anything from 2^84 up is a multiple of 2^32, that includes the infinities. NaN fails every comparison.
+  if(!(value > -19342813113834066795298816.0 && value < 19342813113834066795298816.0)) return 0;
+  // Take off the multiples of 2^32 first when it's outside of int64 range, that's all exact.
+  if(value <= -9223372036854775808.0 || value >= 9223372036854775808.0) {
+    value -= (double)(int64_t)(value / 4294967296.0) * 4294967296.0;
+  }
+  return (int32_t)(uint32_t)(int64_t)value;
+}
+
+static PD_INLINE int32_t pd_shl(int32_t a, int32_t b) {
+  return (int32_t)((uint32_t)a << (b & 31));
+}
+
+// Arithmetic, negative numbers stay negative. (C leaves >> on them up to the compiler)
+static PD_INLINE int32_t pd_shr(int32_t a, int32_t b) {
+  return a < 0 ? ~(~a >> (b & 31)) : a >> (b & 31);
+}
+
+// Packs [len] bytes into a short string, the caller makes sure len <= PD_SSTR_MAX.
+static PD_INLINE pd_value pd_sstr_value(const char* bytes, size_t len) {
+  pd_assert(len <= PD_SSTR_MAX, "String is too long to be a short string.");
+  pd_value value = QNAN | PD_SHORT_STRING | ((uint64_t)len << 3);
+  for(size_t i = 0; i < len; i++) {
+    value |= (uint64_t)(uint8_t)bytes[i] << (8 + 8 * i);
+  }
+  return value;
+}
+
+// Unpacks a short string to [out] and null terminates it, [out] must hold at least PD_SSTR_MAX + 1 bytes.
+// Returns the length.
+static PD_INLINE int pd_sstr_read(pd_value value, char* out) {
+  int len = PD_SSTR_LEN(value);
+  for(int i = 0; i < len; i++) {
+    out[i] = PD_SSTR_BYTE(value, i);
+  }
+  out[len] = '\0';
+  return len;
 }
 
 #ifdef __clang__
@@ -150,7 +250,7 @@ static PD_INLINE bool AS_BOOL(pd_value value) {
 typedef struct pvm_t pvm_t;
 
 // Dynamic array that holds values.
-// TODO: This is used for storing constants in a chunk, reuse this to also implement arrays in the language itself.
+// This is used for storing constants in a chunk and also backs the arrays in the language itself. (see array.h)
 PERIDOT_DEC_DYN_ARR(pd_value_array, pd_value)
 
 PERIDOT_EXTERN_C_END